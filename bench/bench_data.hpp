@@ -0,0 +1,123 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <string>
+#include <vector>
+#include "../src/log_generator.hpp"
+
+#ifdef _WIN32
+    #include <fcntl.h>
+    #include <io.h>
+#else
+    #include <fcntl.h>
+    #include <unistd.h>
+#endif
+
+// Inputs shared by the benchmarks, all from LogGenerator with a fixed seed
+// so runs are comparable; LOG_ANALYZER_BENCH_FILE points the file
+// benchmarks at a real log instead.
+namespace bench {
+
+// Small deterministic generator (xorshift64) for picking random lines
+class Rng {
+public:
+    explicit Rng(uint64_t seed) : state_(seed ? seed : 1) {}
+
+    uint64_t next() {
+        state_ ^= state_ << 13;
+        state_ ^= state_ >> 7;
+        state_ ^= state_ << 17;
+        return state_;
+    }
+
+    size_t below(size_t bound) { return static_cast<size_t>(next() % bound); }
+
+private:
+    uint64_t state_;
+};
+
+// Mixed-format generated log: one line in 100,000 contains "needle"
+inline GeneratorOptions logOptions(uint64_t bytes) {
+    GeneratorOptions options;
+    options.size = bytes;
+    options.seed = 42;
+    options.format = LogFormat::Generic;
+    options.needle_every = 100000;
+    options.needle = "needle";
+    return options;
+}
+
+// Size of the generated benchmark log
+constexpr uint64_t LOG_FILE_BYTES = 64 * 1024 * 1024;
+
+// A generated log of about LOG_FILE_BYTES, created once per process in the
+// temp directory and removed at exit
+inline const std::string& logFile() {
+    static const std::string path = []() {
+        if (const char* custom = std::getenv("LOG_ANALYZER_BENCH_FILE")) {
+            return std::string(custom);
+        }
+        std::string file = (std::filesystem::temp_directory_path() / "log_analyzer_bench.log").string();
+#ifdef _WIN32
+        int fd = _open(file.c_str(), _O_WRONLY | _O_CREAT | _O_TRUNC | _O_BINARY, 0644);
+#else
+        int fd = ::open(file.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+#endif
+        if (fd != -1) {
+            GeneratorResult result;
+            std::string error;
+            LogGenerator(logOptions(LOG_FILE_BYTES)).write(fd, result, error);
+#ifdef _WIN32
+            _close(fd);
+#else
+            ::close(fd);
+#endif
+        }
+        std::atexit([]() { std::filesystem::remove(path); });
+        return file;
+    }();
+    return path;
+}
+
+// The first `count` generated lines of a format, without terminators
+inline std::vector<std::string> sampleLines(size_t count, LogFormat format = LogFormat::Generic) {
+    GeneratorOptions options = logOptions(0);
+    options.format = format;
+    LogGenerator generator(options);
+
+    std::string block;
+    std::vector<NeedleLine> needles;
+    std::vector<std::string> lines;
+    for (uint64_t b = 0; lines.size() < count; ++b) {
+        block.clear();
+        generator.generateBlock(b, block, needles);
+        size_t start = 0;
+        for (size_t end; lines.size() < count && (end = block.find('\n', start)) != std::string::npos;
+             start = end + 1) {
+            lines.push_back(block.substr(start, end - start));
+        }
+    }
+    return lines;
+}
+
+// One line of `bytes` bytes built from generated lines (minified JSON
+// dumps and stack traces end up like this)
+inline std::string longLine(size_t bytes) {
+    std::string line;
+    for (const std::string& part : sampleLines(LogGenerator::LINES_PER_BLOCK)) {
+        line += part;
+        line += ' ';
+        if (line.size() >= bytes) {
+            break;
+        }
+    }
+    while (line.size() < bytes) {
+        line += line.substr(0, bytes - line.size());
+    }
+    line.resize(bytes);
+    return line;
+}
+
+} // namespace bench
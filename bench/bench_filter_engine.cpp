@@ -0,0 +1,56 @@
+#include <benchmark/benchmark.h>
+#include "bench_data.hpp"
+#include "../src/filter_engine.hpp"
+#include "../src/log_reader.hpp"
+
+namespace {
+
+const char* const PATTERNS[] = {
+    "needle",                   // Selective literal: one line in 100,000
+    "ERROR",                    // Broad literal: a few percent of lines
+    "needle#\\d+",              // Selective regex
+    "\"status\": [45]\\d\\d",   // Broad regex
+    "json: status >= 500",      // Field query
+};
+
+} // namespace
+
+// Whole file on one thread (state.range(0): pattern, state.range(1): threads)
+static void BM_Filter(benchmark::State& state) {
+    LogReader reader;
+    if (!reader.open(bench::logFile())) {
+        state.SkipWithError("cannot open the benchmark log");
+        return;
+    }
+    FilterEngine filter;
+    const char* pattern = PATTERNS[state.range(0)];
+    if (!filter.setPattern(pattern)) {
+        state.SkipWithError(filter.getError().c_str());
+        return;
+    }
+    state.SetLabel(pattern);
+
+    size_t matched = 0;
+    for (auto _ : state) {
+        auto matches = filter.filterLines(reader, 0, reader.getLineCount(),
+                                          static_cast<size_t>(state.range(1)));
+        matched = matches.size();
+        benchmark::DoNotOptimize(matches.data());
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * reader.getFileSize()));
+    state.counters["lines/s"] = benchmark::Counter(
+        static_cast<double>(state.iterations() * reader.getLineCount()), benchmark::Counter::kIsRate);
+    state.counters["matched"] = static_cast<double>(matched);
+}
+
+BENCHMARK(BM_Filter)
+    ->ArgsProduct({{0, 1, 2, 3, 4}, {1}})
+    ->ArgNames({"pattern", "threads"})
+    ->Unit(benchmark::kMillisecond);
+
+// The same scans with one thread per core, as batch mode runs them
+BENCHMARK(BM_Filter)
+    ->ArgsProduct({{0, 3}, {0}})
+    ->ArgNames({"pattern", "threads"})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
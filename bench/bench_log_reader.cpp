@@ -0,0 +1,107 @@
+#include <benchmark/benchmark.h>
+#include "bench_data.hpp"
+#include "../src/filter_engine.hpp"
+#include "../src/log_reader.hpp"
+
+// open() maps the file and builds the line index; the index is what costs
+static void BM_IndexLines(benchmark::State& state) {
+    const std::string& path = bench::logFile();
+    size_t lines = 0;
+    size_t bytes = 0;
+    for (auto _ : state) {
+        LogReader reader;
+        if (!reader.open(path)) {
+            state.SkipWithError("cannot open the benchmark log");
+            return;
+        }
+        lines = reader.getLineCount();
+        bytes = reader.getFileSize();
+        benchmark::DoNotOptimize(lines);
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * bytes));
+    state.counters["lines/s"] = benchmark::Counter(static_cast<double>(state.iterations() * lines),
+                                                   benchmark::Counter::kIsRate);
+}
+BENCHMARK(BM_IndexLines)->Unit(benchmark::kMillisecond);
+
+// Scrolling and jumping around: lines fetched at random positions
+static void BM_GetLineRandom(benchmark::State& state) {
+    LogReader reader;
+    if (!reader.open(bench::logFile())) {
+        state.SkipWithError("cannot open the benchmark log");
+        return;
+    }
+    const size_t count = reader.getLineCount();
+    bench::Rng rng(1);
+
+    size_t bytes = 0;
+    for (auto _ : state) {
+        auto line = reader.getLine(rng.below(count));
+        bytes += line.size();
+        benchmark::DoNotOptimize(line.data());
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(bytes));
+    state.counters["lines/s"] = benchmark::Counter(static_cast<double>(state.iterations()),
+                                                   benchmark::Counter::kIsRate);
+}
+BENCHMARK(BM_GetLineRandom);
+
+#ifndef _WIN32
+
+// Open and filter a file that is not in the page cache, the first look at a
+// log on NFS or a cold disk (state.range(0): 0 mmap, 1 read with io_uring,
+// 2 read with pread threads). Dropping the cache needs the file's pages to be
+// clean; point LOG_ANALYZER_BENCH_FILE at a network mount to measure one.
+static void BM_ColdOpenAndFilter(benchmark::State& state) {
+    const std::string& path = bench::logFile();
+    ReadOptions options;
+    options.backend = state.range(0) == 0 ? ReadBackend::Mmap : ReadBackend::Read;
+    options.use_io_uring = state.range(0) == 1;
+
+    FilterEngine filter;
+    filter.setPattern("needle");
+    size_t bytes = 0;
+    for (auto _ : state) {
+        state.PauseTiming();
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd != -1) {
+            fdatasync(fd);
+            posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+            ::close(fd);
+        }
+        state.ResumeTiming();
+
+        LogReader reader;
+        if (!reader.open(path, options)) {
+            state.SkipWithError("cannot open the benchmark log");
+            return;
+        }
+        // Lines read in blocks are filtered as they arrive, as batch mode does
+        size_t scanned = 0;
+        while (true) {
+            bool growing = reader.isGrowing();
+            size_t line_count = reader.getLineCount();
+            auto matches = filter.filterLines(reader, scanned, line_count);
+            benchmark::DoNotOptimize(matches.data());
+            scanned = line_count;
+            if (!growing) {
+                break;
+            }
+            reader.waitForLines(scanned, std::chrono::milliseconds(100));
+        }
+        bytes = reader.getFileSize();
+        if (reader.getBackend() == ReadBackend::Read) {
+            state.SetLabel(ioEngineName(reader.getIoEngine()));
+        }
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * bytes));
+}
+BENCHMARK(BM_ColdOpenAndFilter)
+    ->ArgName("backend")
+    ->Arg(0)
+    ->Arg(1)
+    ->Arg(2)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+#endif
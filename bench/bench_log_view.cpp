@@ -0,0 +1,80 @@
+#include <benchmark/benchmark.h>
+#include "bench_data.hpp"
+#include "../src/log_view.hpp"
+#include "ftxui/dom/elements.hpp"
+#include "ftxui/screen/screen.hpp"
+
+using namespace ftxui;
+
+// One full frame of the log area as TuiDisplay paints it: every row with
+// tokens and a filter match, on a 200x60 terminal (state.range(0): with or
+// without highlighting)
+static void BM_RenderLogArea(benchmark::State& state) {
+    constexpr int WIDTH = 200;
+    constexpr int HEIGHT = 60;
+    const bool highlight = state.range(0) != 0;
+
+    SyntaxHighlighter highlighter;
+    std::vector<std::string> lines = bench::sampleLines(HEIGHT);
+    std::vector<LogView::Tokens> tokens(HEIGHT);
+    std::vector<std::vector<MatchSpan>> matches(HEIGHT);
+    std::vector<LineLayout> layouts;  // Cached across frames, as in the TUI
+    for (int i = 0; i < HEIGHT; ++i) {
+        highlighter.tokenize(lines[i], tokens[i]);
+        matches[i].push_back({22, 4});
+        layouts.emplace_back(lines[i]);
+    }
+
+    auto screen = Screen::Create(Dimension::Fixed(WIDTH), Dimension::Fixed(HEIGHT));
+    size_t bytes = 0;
+    for (auto _ : state) {
+        LogView::Frame frame;
+        frame.rows.reserve(HEIGHT);
+        for (int i = 0; i < HEIGHT; ++i) {
+            LogView::Row row;
+            row.line_number = static_cast<size_t>(i + 1);
+            row.text = lines[i];
+            row.matches = matches[i];
+            row.selected = i == 10;
+            row.layout = &layouts[i];
+            if (highlight) {
+                row.tokens = tokens[i];
+            }
+            frame.rows.push_back(row);
+            bytes += lines[i].size();
+        }
+        Render(screen, logView(std::move(frame)));
+        benchmark::DoNotOptimize(screen.PixelAt(0, 0));
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(bytes));
+    state.counters["frames/s"] = benchmark::Counter(static_cast<double>(state.iterations()),
+                                                    benchmark::Counter::kIsRate);
+    state.counters["lines/s"] = benchmark::Counter(static_cast<double>(state.iterations() * HEIGHT),
+                                                   benchmark::Counter::kIsRate);
+}
+BENCHMARK(BM_RenderLogArea)->ArgName("highlight")->Arg(0)->Arg(1);
+
+// Column layout of a line, built once per line on a cache miss: pure ASCII
+// (one SIMD pass, nothing stored) or with multi-byte text every few words
+static void BM_BuildLineLayout(benchmark::State& state) {
+    const bool ascii = state.range(0) != 0;
+    std::vector<std::string> lines = bench::sampleLines(1000);
+    if (!ascii) {
+        for (auto& line : lines) {
+            for (size_t pos = 16; pos < line.size(); pos += 24) {
+                line.replace(pos, 1, "ж");
+            }
+        }
+    }
+
+    size_t bytes = 0;
+    for (auto _ : state) {
+        for (const auto& line : lines) {
+            LineLayout layout(line);
+            benchmark::DoNotOptimize(layout.columns());
+            bytes += line.size();
+        }
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(bytes));
+}
+BENCHMARK(BM_BuildLineLayout)->ArgName("ascii")->Arg(1)->Arg(0);
@@ -0,0 +1,83 @@
+#include <benchmark/benchmark.h>
+#include "bench_data.hpp"
+#include "../src/syntax_highlighter.hpp"
+
+namespace {
+
+std::vector<std::string> shortLines() {
+    return bench::sampleLines(1024);
+}
+
+void setRates(benchmark::State& state, size_t bytes, size_t lines) {
+    state.SetBytesProcessed(static_cast<int64_t>(bytes));
+    state.counters["lines/s"] = benchmark::Counter(static_cast<double>(lines), benchmark::Counter::kIsRate);
+}
+
+} // namespace
+
+// Tokens only, as the highlight cache computes them
+static void BM_TokenizeShort(benchmark::State& state) {
+    auto lines = shortLines();
+    SyntaxHighlighter highlighter;
+    std::vector<SyntaxHighlighter::Token> tokens;
+    size_t bytes = 0;
+    size_t i = 0;
+    for (auto _ : state) {
+        const std::string& line = lines[i++ % lines.size()];
+        tokens.clear();
+        highlighter.tokenize(line, tokens);
+        benchmark::DoNotOptimize(tokens.data());
+        bytes += line.size();
+    }
+    setRates(state, bytes, state.iterations());
+}
+BENCHMARK(BM_TokenizeShort);
+
+// Tokens plus the FTXUI element tree
+static void BM_HighlightShort(benchmark::State& state) {
+    auto lines = shortLines();
+    SyntaxHighlighter highlighter;
+    size_t bytes = 0;
+    size_t i = 0;
+    for (auto _ : state) {
+        const std::string& line = lines[i++ % lines.size()];
+        auto element = highlighter.highlight(line);
+        benchmark::DoNotOptimize(element);
+        bytes += line.size();
+    }
+    setRates(state, bytes, state.iterations());
+}
+BENCHMARK(BM_HighlightShort);
+
+// Whole very long lines (state.range(0) bytes)
+static void BM_TokenizeLong(benchmark::State& state) {
+    std::string line = bench::longLine(static_cast<size_t>(state.range(0)));
+    SyntaxHighlighter highlighter;
+    std::vector<SyntaxHighlighter::Token> tokens;
+    for (auto _ : state) {
+        tokens.clear();
+        highlighter.tokenize(line, tokens);
+        benchmark::DoNotOptimize(tokens.data());
+    }
+    setRates(state, state.iterations() * line.size(), state.iterations());
+}
+BENCHMARK(BM_TokenizeLong)->Arg(64 << 10)->Arg(1 << 20)->Arg(16 << 20)->Unit(benchmark::kMicrosecond);
+
+// What the viewer does for such lines: one screen-wide window near the end,
+// resumed from a checkpoint
+static void BM_TokenizeWindowLong(benchmark::State& state) {
+    std::string line = bench::longLine(static_cast<size_t>(state.range(0)));
+    SyntaxHighlighter highlighter;
+    std::vector<uint32_t> checkpoints;
+    highlighter.buildCheckpoints(line, checkpoints);
+    std::vector<SyntaxHighlighter::Token> tokens;
+
+    const size_t begin = line.size() - 300;
+    for (auto _ : state) {
+        tokens.clear();
+        highlighter.tokenizeWindow(line, checkpoints, begin, begin + 200, tokens);
+        benchmark::DoNotOptimize(tokens.data());
+    }
+    setRates(state, state.iterations() * 200, state.iterations());
+}
+BENCHMARK(BM_TokenizeWindowLong)->Arg(1 << 20)->Arg(16 << 20);
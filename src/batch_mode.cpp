@@ -0,0 +1,206 @@
+#include "batch_mode.hpp"
+#include "trace.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <chrono>
+#include <climits>
+#include <cstring>
+
+#ifdef _WIN32
+    #include <io.h>
+#else
+    #include <unistd.h>
+#endif
+
+namespace {
+
+// Lines scanned per round; bounds the memory held for match indices while
+// output for earlier rounds is already being written
+constexpr size_t BATCH_WINDOW = 1 << 20;
+
+// How long to wait for a stream to deliver more lines before checking again
+constexpr std::chrono::milliseconds STREAM_POLL{200};
+
+} // namespace
+
+OutputBuffer::OutputBuffer(int fd, size_t capacity)
+    : fd_(fd)
+    , buffer_(std::max<size_t>(capacity, 64))
+    , used_(0)
+    , failed_(false) {
+}
+
+OutputBuffer::~OutputBuffer() {
+    flush();
+}
+
+void OutputBuffer::append(std::string_view data) {
+    if (used_ + data.size() <= buffer_.size()) {
+        std::memcpy(buffer_.data() + used_, data.data(), data.size());
+        used_ += data.size();
+        return;
+    }
+
+    flush();
+    if (data.size() >= buffer_.size()) {
+        writeAll(data.data(), data.size());  // Large runs skip the copy
+    } else {
+        std::memcpy(buffer_.data(), data.data(), data.size());
+        used_ = data.size();
+    }
+}
+
+void OutputBuffer::appendNumber(size_t value) {
+    char digits[24];
+    auto result = std::to_chars(digits, digits + sizeof(digits), value);
+    append(std::string_view(digits, static_cast<size_t>(result.ptr - digits)));
+}
+
+bool OutputBuffer::flush() {
+    if (used_ > 0) {
+        writeAll(buffer_.data(), used_);
+        used_ = 0;
+    }
+    return !failed_;
+}
+
+void OutputBuffer::writeAll(const char* data, size_t size) {
+    while (size > 0 && !failed_) {
+#ifdef _WIN32
+        int written = _write(fd_, data, static_cast<unsigned>(std::min<size_t>(size, INT_MAX)));
+#else
+        ssize_t written = ::write(fd_, data, size);
+#endif
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            failed_ = true;
+            return;
+        }
+        data += written;
+        size -= static_cast<size_t>(written);
+    }
+}
+
+int runBatch(const LogReader& reader, FilterEngine& filter, const BatchOptions& options,
+             int output_fd, std::string& error) {
+    if (!filter.setPattern(options.pattern)) {
+        error = filter.getError();
+        return BATCH_ERROR;
+    }
+
+    GroupSpec group_spec;
+    bool grouping = !options.group_by.empty();
+    if (grouping && !parseGroupSpec(options.group_by, group_spec, error)) {
+        return BATCH_ERROR;
+    }
+    if (grouping && group_spec.maxCapture() > filter.captureCount()) {
+        error = "--group-by refers to $" + std::to_string(group_spec.maxCapture()) +
+                " but the filter has " + std::to_string(filter.captureCount()) + " capture groups";
+        return BATCH_ERROR;
+    }
+    GroupTable groups;
+
+    // Numbered and counted output is formatted here; plain matching lines
+    // go from the file to the output as coalesced byte ranges
+    OutputBuffer output(output_fd);
+    RangeExporter ranges(reader, output_fd);
+    size_t total_matches = 0;
+    size_t scanned = 0;
+
+    while (!output.failed() && !ranges.failed()) {
+        // Streams (stdin, pipes) are filtered as they arrive, like grep on a pipe
+        bool growing = reader.isGrowing();
+        size_t line_count = reader.getLineCount();
+        if (scanned == line_count) {
+            if (!growing) {
+                break;
+            }
+            // Let the consumer see what matched so far
+            output.flush();
+            ranges.flush();
+            reader.waitForLines(scanned, STREAM_POLL);
+            continue;
+        }
+
+        size_t window = scanned;
+        scanned = std::min(window + BATCH_WINDOW, line_count);
+        TRACE_SCOPE_ARG("batch window", "lines", scanned - window);
+        if (grouping) {
+            total_matches += filter.groupLines(reader, window, scanned, group_spec, groups,
+                                               options.threads);
+            continue;
+        }
+        auto matches = filter.filterLines(reader, window, scanned, options.threads);
+        total_matches += matches.size();
+        if (options.count) {
+            continue;
+        }
+
+        if (!options.line_numbers) {
+            for (size_t line : matches) {
+                ranges.addLine(line);
+            }
+            continue;
+        }
+
+        for (size_t line : matches) {
+            if (reader.isMerged()) {
+                // grep -n over several files: "file:line:"
+                LineSource from = reader.getLineSource(line);
+                output.append(reader.getSource(from.source).getFilename());
+                output.append(":");
+                output.appendNumber(from.line + 1);
+            } else {
+                output.appendNumber(line + 1);
+            }
+            output.append(":");
+            // Raw bytes, terminator included: CRLF stays CRLF
+            auto bytes = reader.getRawLine(line);
+            output.append(bytes);
+            if (bytes.empty() || bytes.back() != '\n') {
+                output.append("\n");  // Last line without a newline
+            }
+        }
+    }
+
+    if (!ranges.flush()) {
+        error = "Write failed: " + ranges.getError();
+        return BATCH_ERROR;
+    }
+
+    if (options.count && !grouping) {
+        output.appendNumber(total_matches);
+        output.append("\n");
+    }
+
+    if (grouping) {
+        for (const auto& row : groups.rows(GroupColumn::Count, true)) {
+            output.append(row.key);
+            output.append("\t");
+            output.appendNumber(row.stats.count);
+            if (group_spec.hasValue()) {
+                bool any = row.stats.values > 0;
+                for (double value : {row.stats.sum, row.stats.min, row.stats.max, row.stats.average()}) {
+                    output.append("\t");
+                    output.append(any ? formatGroupNumber(value) : "-");
+                }
+            }
+            output.append("\n");
+        }
+    }
+
+    if (!output.flush()) {
+        error = std::string("Write failed: ") + std::strerror(errno);
+        return BATCH_ERROR;
+    }
+    // Input that ended early: what matched was printed, but it is not all
+    std::string read_error = reader.getReadError();
+    if (!read_error.empty()) {
+        error = "Read failed: " + read_error;
+        return BATCH_ERROR;
+    }
+    return total_matches > 0 ? BATCH_MATCHED : BATCH_NO_MATCH;
+}
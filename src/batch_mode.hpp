@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "log_reader.hpp"
+#include "filter_engine.hpp"
+#include "range_export.hpp"
+
+// Non-interactive filtering for scripts, cron jobs and pipelines:
+//   log_analyzer --filter PATTERN [--count] [--line-numbers] [-o out] file
+//   log_analyzer --filter PATTERN --group-by SPEC file
+// Same index, pattern syntax and parallel scan as the TUI. Exit status
+// follows grep: 0 when a line matched, 1 when none did, 2 on errors.
+enum BatchStatus : int {
+    BATCH_MATCHED = 0,
+    BATCH_NO_MATCH = 1,
+    BATCH_ERROR = 2
+};
+
+struct BatchOptions {
+    std::string pattern;        // Regex or "json:" query; empty matches every line
+    bool count = false;         // Print the number of matching lines instead of the lines
+    bool line_numbers = false;  // Prefix each line with "N:" (1-based)
+    size_t threads = 0;         // Scan workers, 0: one per core
+    std::string group_by;       // Group spec ("$1 $2", "level"...): print one
+                                // "key<TAB>count[<TAB>sum min max avg]" row per
+                                // key, most frequent first, instead of the lines
+};
+
+// Output collected into large blocks, each handed to write(2) in one call.
+// Data at least as large as the buffer goes straight to the descriptor.
+class OutputBuffer {
+public:
+    static constexpr size_t DEFAULT_CAPACITY = 1024 * 1024;
+
+    explicit OutputBuffer(int fd, size_t capacity = DEFAULT_CAPACITY);
+    ~OutputBuffer();
+
+    OutputBuffer(const OutputBuffer&) = delete;
+    OutputBuffer& operator=(const OutputBuffer&) = delete;
+
+    void append(std::string_view data);
+    void appendNumber(size_t value);
+
+    // Write out whatever is buffered; false once any write failed
+    bool flush();
+    bool failed() const { return failed_; }
+
+private:
+    void writeAll(const char* data, size_t size);
+
+    int fd_;
+    std::vector<char> buffer_;
+    size_t used_;
+    bool failed_;
+};
+
+// Filter the whole file and write the result to `output_fd`. On failure
+// `error` says why and BATCH_ERROR is returned.
+int runBatch(const LogReader& reader, FilterEngine& filter, const BatchOptions& options,
+             int output_fd, std::string& error);
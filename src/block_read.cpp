@@ -0,0 +1,513 @@
+#include "block_read.hpp"
+#include "trace.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#ifndef _WIN32
+    #include <sys/mman.h>
+    #include <unistd.h>
+#endif
+
+#if defined(__linux__)
+    #include <sys/vfs.h>
+#elif defined(__APPLE__)
+    #include <sys/mount.h>
+    #include <sys/param.h>
+#endif
+
+// io_uring through its system calls; liburing is not needed for one opcode
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+    #include <linux/io_uring.h>
+    #include <sys/mman.h>
+    #include <sys/syscall.h>
+    #include <sys/uio.h>
+    #if defined(__NR_io_uring_setup) && defined(__NR_io_uring_enter)
+        #define BLOCK_READ_IO_URING 1
+    #endif
+#endif
+
+namespace {
+
+// Block requests of a whole file; block b is read into buffer b % depth
+struct BlockPlan {
+    size_t size;
+    size_t block_size;
+    size_t blocks;
+    size_t depth;
+
+    size_t offset(size_t block) const { return block * block_size; }
+    size_t length(size_t block) const { return std::min(block_size, size - offset(block)); }
+    size_t buffer(size_t block) const { return (block % depth) * block_size; }
+};
+
+#ifndef _WIN32
+
+BlockPlan planBlocks(size_t size, const ReadOptions& options) {
+    // Whole pages: requests start page aligned in page-aligned buffers
+    size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    size_t block_size = std::max(options.block_size, page);
+    block_size = (block_size + page - 1) / page * page;
+
+    BlockPlan plan;
+    plan.size = size;
+    plan.block_size = block_size;
+    plan.blocks = (size + block_size - 1) / block_size;
+    plan.depth = std::clamp<size_t>(options.queue_depth, 1, ReadOptions::MAX_QUEUE_DEPTH);
+    plan.depth = std::min(plan.depth, std::max<size_t>(plan.blocks, 1));
+    return plan;
+}
+
+// The plan's depth buffers, one page-aligned allocation
+class BlockBuffers {
+public:
+    explicit BlockBuffers(const BlockPlan& plan) : size_(plan.depth * plan.block_size) {
+        void* data = mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        data_ = data == MAP_FAILED ? nullptr : static_cast<char*>(data);
+    }
+    ~BlockBuffers() {
+        if (data_ != nullptr) {
+            munmap(data_, size_);
+        }
+    }
+    BlockBuffers(const BlockBuffers&) = delete;
+    BlockBuffers& operator=(const BlockBuffers&) = delete;
+
+    char* data() const { return data_; }
+
+private:
+    size_t size_;
+    char* data_;
+};
+
+// Threads taking the next block and pread()ing it whole once its buffer is
+// free; the caller hands finished blocks to `on_block` in order
+bool readWithThreads(int fd, char* buffers, const BlockPlan& plan,
+                     const BlockCallback& on_block, std::string& error) {
+    std::mutex mutex;
+    std::condition_variable changed;  // A block finished or was handed over
+    std::vector<char> finished(plan.blocks, 0);
+    size_t delivered = 0;  // Blocks handed to on_block; their buffers are free
+    std::string failure;
+    std::atomic<size_t> next{0};
+    std::atomic<bool> stop{false};
+
+    auto work = [&]() {
+        for (size_t block = next++; block < plan.blocks && !stop; block = next++) {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                changed.wait(lock, [&]() { return block < delivered + plan.depth || stop; });
+                if (stop) {
+                    return;
+                }
+            }
+            char* dest = buffers + plan.buffer(block);
+            size_t offset = plan.offset(block);
+            size_t length = plan.length(block);
+            size_t done = 0;
+            while (done < length) {
+                ssize_t n = pread(fd, dest + done, length - done, static_cast<off_t>(offset + done));
+                if (n > 0) {
+                    done += static_cast<size_t>(n);
+                    continue;
+                }
+                if (n < 0 && errno == EINTR) {
+                    continue;
+                }
+                std::lock_guard<std::mutex> lock(mutex);
+                if (failure.empty()) {
+                    failure = n == 0 ? "the file got shorter while reading"
+                                     : std::string("read failed: ") + std::strerror(errno);
+                }
+                stop = true;
+                changed.notify_all();
+                return;
+            }
+            std::lock_guard<std::mutex> lock(mutex);
+            finished[block] = 1;
+            changed.notify_all();
+        }
+    };
+
+    std::vector<std::thread> pool;
+    pool.reserve(plan.depth);
+    for (size_t i = 0; i < plan.depth; ++i) {
+        pool.emplace_back([&work]() {
+            TRACE_THREAD_NAME("read worker");
+            work();
+        });
+    }
+
+    for (size_t block = 0; block < plan.blocks; ++block) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            changed.wait(lock, [&]() { return finished[block] || stop; });
+            if (!finished[block]) {
+                break;
+            }
+        }
+        if (!on_block(plan.offset(block), buffers + plan.buffer(block), plan.length(block))) {
+            break;
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        ++delivered;
+        changed.notify_all();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stop = true;
+        changed.notify_all();
+    }
+    for (auto& worker : pool) {
+        worker.join();
+    }
+    if (!failure.empty()) {
+        error = failure;
+        return false;
+    }
+    return true;
+}
+
+#endif
+
+#if defined(BLOCK_READ_IO_URING)
+
+// The submission and completion rings of one io_uring instance
+class Ring {
+public:
+    ~Ring() {
+        if (sqes_ != nullptr) {
+            munmap(sqes_, sqes_size_);
+        }
+        if (cq_ptr_ != nullptr) {
+            munmap(cq_ptr_, cq_size_);
+        }
+        if (sq_ptr_ != nullptr) {
+            munmap(sq_ptr_, sq_size_);
+        }
+        if (fd_ != -1) {
+            ::close(fd_);
+        }
+    }
+
+    // False when the kernel has no io_uring or does not let us use it
+    bool setup(unsigned entries) {
+        io_uring_params params;
+        std::memset(&params, 0, sizeof(params));
+        fd_ = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+        if (fd_ < 0) {
+            fd_ = -1;
+            return false;
+        }
+
+        sq_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cq_size_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+        sq_ptr_ = map(sq_size_, IORING_OFF_SQ_RING);
+        cq_ptr_ = map(cq_size_, IORING_OFF_CQ_RING);
+        sqes_ = static_cast<io_uring_sqe*>(map(sqes_size_, IORING_OFF_SQES));
+        if (sq_ptr_ == nullptr || cq_ptr_ == nullptr || sqes_ == nullptr) {
+            return false;
+        }
+
+        char* sq = static_cast<char*>(sq_ptr_);
+        sq_tail_ = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+        sq_mask_ = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+        sq_array_ = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+        char* cq = static_cast<char*>(cq_ptr_);
+        cq_head_ = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+        cq_tail_ = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+        cq_mask_ = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+        cqes_ = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+        return true;
+    }
+
+    // Queue a readv of `iov` at `offset`; sent with the next enter()
+    void pushRead(int fd, const iovec* iov, size_t offset, uint64_t user_data) {
+        unsigned tail = *sq_tail_;  // Only we write the tail
+        unsigned index = tail & sq_mask_;
+        io_uring_sqe& sqe = sqes_[index];
+        std::memset(&sqe, 0, sizeof(sqe));
+        sqe.opcode = IORING_OP_READV;  // Since 5.1, unlike IORING_OP_READ
+        sqe.fd = fd;
+        sqe.addr = reinterpret_cast<uint64_t>(iov);
+        sqe.len = 1;
+        sqe.off = offset;
+        sqe.user_data = user_data;
+        sq_array_[index] = index;
+        std::atomic_ref<unsigned>(*sq_tail_).store(tail + 1, std::memory_order_release);
+        ++unsubmitted_;
+    }
+
+    // Submit what is queued and wait for at least one completion
+    bool enter(std::string& error) {
+        while (true) {
+            long submitted = syscall(__NR_io_uring_enter, fd_, unsubmitted_, 1,
+                                     IORING_ENTER_GETEVENTS, nullptr, 0);
+            if (submitted >= 0) {
+                unsubmitted_ -= static_cast<unsigned>(submitted);
+                return true;
+            }
+            if (errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+                error = std::string("io_uring_enter failed: ") + std::strerror(errno);
+                return false;
+            }
+        }
+    }
+
+    bool pop(io_uring_cqe& cqe) {
+        unsigned head = *cq_head_;  // Only we move the head
+        if (head == std::atomic_ref<unsigned>(*cq_tail_).load(std::memory_order_acquire)) {
+            return false;
+        }
+        cqe = cqes_[head & cq_mask_];
+        std::atomic_ref<unsigned>(*cq_head_).store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+private:
+    void* map(size_t size, off_t offset) {
+        void* ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd_, offset);
+        return ptr == MAP_FAILED ? nullptr : ptr;
+    }
+
+    int fd_ = -1;
+    void* sq_ptr_ = nullptr;
+    void* cq_ptr_ = nullptr;
+    io_uring_sqe* sqes_ = nullptr;
+    size_t sq_size_ = 0;
+    size_t cq_size_ = 0;
+    size_t sqes_size_ = 0;
+    unsigned* sq_tail_ = nullptr;
+    unsigned* sq_array_ = nullptr;
+    unsigned sq_mask_ = 0;
+    unsigned* cq_head_ = nullptr;
+    unsigned* cq_tail_ = nullptr;
+    unsigned cq_mask_ = 0;
+    io_uring_cqe* cqes_ = nullptr;
+    unsigned unsubmitted_ = 0;
+};
+
+// One request slot per queue entry and buffer; a short read is resubmitted
+// for the rest, and a finished block keeps its slot until it is handed over
+struct Slot {
+    size_t block;
+    size_t done;
+    iovec iov;
+};
+
+enum class UringResult { Done, Failed, Unavailable };
+
+UringResult readWithIoUring(int fd, char* buffers, const BlockPlan& plan,
+                            const BlockCallback& on_block, std::string& error) {
+    Ring ring;
+    if (!ring.setup(static_cast<unsigned>(plan.depth))) {
+        return UringResult::Unavailable;
+    }
+
+    std::vector<Slot> slots(plan.depth);
+    std::vector<char> finished(plan.blocks, 0);
+    size_t next_block = 0;
+    size_t next_delivery = 0;
+    size_t in_flight = 0;
+    std::string failure;
+    bool stopped = false;
+
+    auto submit = [&](size_t slot) {
+        Slot& s = slots[slot];
+        s.iov.iov_base = buffers + plan.buffer(s.block) + s.done;
+        s.iov.iov_len = plan.length(s.block) - s.done;
+        ring.pushRead(fd, &s.iov, plan.offset(s.block) + s.done, slot);
+    };
+    // Block b always uses slot b % depth, freed when block b - depth is handed over
+    auto startNext = [&](size_t slot) {
+        if (next_block < plan.blocks && failure.empty() && !stopped) {
+            slots[slot] = {next_block++, 0, {}};
+            submit(slot);
+            ++in_flight;
+        }
+    };
+
+    for (size_t slot = 0; slot < plan.depth; ++slot) {
+        startNext(slot);
+    }
+
+    // After a failure or a stop, wait for the requests still writing into the buffers
+    while (in_flight > 0) {
+        if (!ring.enter(error)) {
+            return UringResult::Failed;  // Closing the ring cancels what is in flight
+        }
+        io_uring_cqe cqe;
+        while (ring.pop(cqe)) {
+            size_t slot = static_cast<size_t>(cqe.user_data);
+            Slot& s = slots[slot];
+            if (cqe.res == -EINTR || cqe.res == -EAGAIN) {
+                submit(slot);
+                continue;
+            }
+            if (cqe.res <= 0) {
+                if (failure.empty()) {
+                    failure = cqe.res == 0 ? "the file got shorter while reading"
+                                           : std::string("read failed: ") + std::strerror(-cqe.res);
+                }
+                --in_flight;
+                continue;
+            }
+
+            s.done += static_cast<size_t>(cqe.res);
+            if (s.done < plan.length(s.block) && failure.empty()) {
+                submit(slot);
+                continue;
+            }
+            finished[s.block] = 1;
+            --in_flight;
+        }
+
+        // Hand over what is complete while the next blocks are in flight,
+        // then read the next block into the freed slot
+        while (failure.empty() && !stopped && next_delivery < plan.blocks && finished[next_delivery]) {
+            size_t block = next_delivery++;
+            if (!on_block(plan.offset(block), buffers + plan.buffer(block), plan.length(block))) {
+                stopped = true;
+                break;
+            }
+            startNext(block % plan.depth);
+        }
+    }
+
+    if (!failure.empty()) {
+        error = failure;
+        return UringResult::Failed;
+    }
+    return UringResult::Done;
+}
+
+#endif
+
+} // namespace
+
+std::string_view remoteFilesystem(int fd) {
+#if defined(__linux__)
+    struct statfs fs;
+    if (fstatfs(fd, &fs) != 0) {
+        return {};
+    }
+    switch (static_cast<uint32_t>(fs.f_type)) {
+        case 0x6969: return "nfs";
+        case 0x517B: return "smb";
+        case 0xFF534D42: return "cifs";
+        case 0xFE534D42: return "smb2";
+        case 0x65735546: return "fuse";
+        case 0x00C36400: return "ceph";
+        case 0x01021997: return "9p";
+        case 0x5346414F: return "afs";
+        case 0x0BD00BD0: return "lustre";
+        case 0x47504653: return "gpfs";
+        default: return {};
+    }
+#elif defined(__APPLE__)
+    struct statfs fs;
+    if (fstatfs(fd, &fs) != 0) {
+        return {};
+    }
+    for (std::string_view name : {"nfs", "smbfs", "afpfs", "webdav", "macfuse", "osxfuse"}) {
+        if (name == fs.f_fstypename) {
+            return name;
+        }
+    }
+    return {};
+#else
+    (void)fd;
+    return {};
+#endif
+}
+
+ReadBackend chooseBackend(int fd, const ReadOptions& options) {
+#ifdef _WIN32
+    (void)fd;
+    (void)options;
+    return ReadBackend::Mmap;
+#else
+    if (options.backend != ReadBackend::Auto) {
+        return options.backend;
+    }
+    return remoteFilesystem(fd).empty() ? ReadBackend::Mmap : ReadBackend::Read;
+#endif
+}
+
+size_t blockBufferSize(const ReadOptions& options) {
+#ifdef _WIN32
+    (void)options;
+    return 0;
+#else
+    BlockPlan plan = planBlocks(SIZE_MAX / 2, options);
+    return plan.depth * plan.block_size;
+#endif
+}
+
+bool readBlocks(int fd, size_t size, const ReadOptions& options, const BlockCallback& on_block,
+                IoEngine& engine, std::string& error) {
+#ifdef _WIN32
+    (void)fd;
+    (void)size;
+    (void)options;
+    (void)on_block;
+    engine = IoEngine::PreadPool;
+    error = "block reads are not supported on Windows";
+    return false;
+#else
+    TRACE_SCOPE_ARG("readBlocks", "bytes", size);
+    BlockPlan plan = planBlocks(size, options);
+    if (plan.blocks == 0) {
+        engine = IoEngine::PreadPool;
+        return true;
+    }
+    BlockBuffers buffers(plan);
+    if (buffers.data() == nullptr) {
+        error = std::string("cannot allocate read buffers: ") + std::strerror(errno);
+        return false;
+    }
+
+#if defined(BLOCK_READ_IO_URING)
+    if (options.use_io_uring) {
+        engine = IoEngine::IoUring;
+        switch (readWithIoUring(fd, buffers.data(), plan, on_block, error)) {
+            case UringResult::Done: return true;
+            case UringResult::Failed: return false;
+            case UringResult::Unavailable: break;  // Old kernel or seccomp: use threads
+        }
+    }
+#endif
+
+    engine = IoEngine::PreadPool;
+    return readWithThreads(fd, buffers.data(), plan, on_block, error);
+#endif
+}
+
+const char* ioEngineName(IoEngine engine) {
+    switch (engine) {
+        case IoEngine::IoUring: return "io_uring";
+        case IoEngine::PreadPool: return "pread";
+    }
+    return "?";
+}
+
+bool parseReadBackend(std::string_view text, ReadBackend& backend) {
+    if (text == "auto") {
+        backend = ReadBackend::Auto;
+    } else if (text == "mmap") {
+        backend = ReadBackend::Mmap;
+    } else if (text == "read") {
+        backend = ReadBackend::Read;
+    } else {
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <string_view>
+
+// Reading a file with large overlapping requests instead of mmap page
+// faults. On network filesystems (NFS, SMB, FUSE) and cold spinning disks
+// each fault is a serialised round trip of at most the readahead window;
+// keeping several big requests in flight lets the server and the disk
+// stream. Requests go through io_uring when the kernel allows it, otherwise
+// through a pool of threads calling pread(). Blocks land in a fixed set of
+// buffers, so memory stays bounded whatever the file size.
+
+// How LogReader::open() gets a file's bytes
+enum class ReadBackend {
+    Auto,  // Read on a network filesystem (see remoteFilesystem()), mmap elsewhere
+    Mmap,  // Map the file; pages are faulted in on first touch
+    Read,  // Map the file, but index it in the background from readBlocks()
+};
+
+// What carried the requests of a readBlocks() call
+enum class IoEngine {
+    IoUring,
+    PreadPool,
+};
+
+struct ReadOptions {
+    static constexpr size_t DEFAULT_BLOCK_SIZE = 1024 * 1024;
+    static constexpr size_t DEFAULT_QUEUE_DEPTH = 8;
+    static constexpr size_t MAX_QUEUE_DEPTH = 256;
+
+    ReadBackend backend = ReadBackend::Auto;
+    size_t block_size = DEFAULT_BLOCK_SIZE;    // Bytes per request, rounded up to whole pages
+    size_t queue_depth = DEFAULT_QUEUE_DEPTH;  // Requests in flight (pread threads)
+    bool use_io_uring = true;                  // false: always the pread pool
+};
+
+// Short name of the filesystem holding `fd` if it is a network or FUSE
+// one ("nfs", "smb", "fuse"...), empty for local filesystems
+std::string_view remoteFilesystem(int fd);
+
+// Backend Auto resolves to for the file open as `fd`
+ReadBackend chooseBackend(int fd, const ReadOptions& options);
+
+// Called with each block's file offset, bytes and length; false stops the read
+using BlockCallback = std::function<bool(size_t offset, const char* data, size_t length)>;
+
+// Read bytes [0, size) of `fd` with up to queue_depth block requests in
+// flight, each into one of queue_depth buffers of block_size bytes.
+// `on_block` runs on the calling thread for every finished block, in file
+// order, while the following blocks are still being read; its buffer is
+// reused once it returns. Fails if the file ends early; a read stopped by
+// `on_block` succeeds.
+bool readBlocks(int fd, size_t size, const ReadOptions& options, const BlockCallback& on_block,
+                IoEngine& engine, std::string& error);
+
+// Bytes of buffers readBlocks() allocates for `options`
+size_t blockBufferSize(const ReadOptions& options);
+
+const char* ioEngineName(IoEngine engine);
+
+// "auto", "mmap" or "read" as on the command line
+bool parseReadBackend(std::string_view text, ReadBackend& backend);
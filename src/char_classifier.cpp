@@ -0,0 +1,183 @@
+#include "char_classifier.hpp"
+#include <cstring>
+
+#if defined(__AVX2__)
+    #include <immintrin.h>
+    #define CHAR_CLASSIFIER_AVX2 1
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #include <emmintrin.h>
+    #define CHAR_CLASSIFIER_SSE2 1
+#endif
+
+#if defined(_MSC_VER)
+    #include <intrin.h>
+#endif
+
+namespace {
+
+#if defined(CHAR_CLASSIFIER_AVX2)
+
+struct Classes32 {
+    uint32_t special, double_quote, single_quote, whitespace, digit;
+};
+
+inline uint32_t movemask(__m256i v) {
+    return static_cast<uint32_t>(_mm256_movemask_epi8(v));
+}
+
+Classes32 classify32(const char* data) {
+    const __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data));
+    auto eq = [&](char c) { return _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8(c)); };
+
+    __m256i special = _mm256_or_si256(
+        _mm256_or_si256(_mm256_or_si256(eq('{'), eq('}')), _mm256_or_si256(eq('['), eq(']'))),
+        _mm256_or_si256(_mm256_or_si256(eq('('), eq(')')),
+                        _mm256_or_si256(_mm256_or_si256(eq(','), eq(':')),
+                                        _mm256_or_si256(eq(';'), eq('=')))));
+
+    // '\t'..'\r' via signed compares (bytes >= 0x80 are negative and excluded)
+    __m256i control_space = _mm256_and_si256(
+        _mm256_cmpgt_epi8(chunk, _mm256_set1_epi8('\t' - 1)),
+        _mm256_cmpgt_epi8(_mm256_set1_epi8('\r' + 1), chunk));
+    __m256i digit = _mm256_and_si256(
+        _mm256_cmpgt_epi8(chunk, _mm256_set1_epi8('0' - 1)),
+        _mm256_cmpgt_epi8(_mm256_set1_epi8('9' + 1), chunk));
+
+    return {
+        movemask(special),
+        movemask(eq('"')),
+        movemask(eq('\'')),
+        movemask(_mm256_or_si256(eq(' '), control_space)),
+        movemask(digit)
+    };
+}
+
+#elif defined(CHAR_CLASSIFIER_SSE2)
+
+struct Classes16 {
+    uint32_t special, double_quote, single_quote, whitespace, digit;
+};
+
+inline uint32_t movemask(__m128i v) {
+    return static_cast<uint32_t>(_mm_movemask_epi8(v));
+}
+
+Classes16 classify16(const char* data) {
+    const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+    auto eq = [&](char c) { return _mm_cmpeq_epi8(chunk, _mm_set1_epi8(c)); };
+
+    __m128i special = _mm_or_si128(
+        _mm_or_si128(_mm_or_si128(eq('{'), eq('}')), _mm_or_si128(eq('['), eq(']'))),
+        _mm_or_si128(_mm_or_si128(eq('('), eq(')')),
+                     _mm_or_si128(_mm_or_si128(eq(','), eq(':')),
+                                  _mm_or_si128(eq(';'), eq('=')))));
+
+    // '\t'..'\r' via signed compares (bytes >= 0x80 are negative and excluded)
+    __m128i control_space = _mm_and_si128(
+        _mm_cmpgt_epi8(chunk, _mm_set1_epi8('\t' - 1)),
+        _mm_cmpgt_epi8(_mm_set1_epi8('\r' + 1), chunk));
+    __m128i digit = _mm_and_si128(
+        _mm_cmpgt_epi8(chunk, _mm_set1_epi8('0' - 1)),
+        _mm_cmpgt_epi8(_mm_set1_epi8('9' + 1), chunk));
+
+    return {
+        movemask(special),
+        movemask(eq('"')),
+        movemask(eq('\'')),
+        movemask(_mm_or_si128(eq(' '), control_space)),
+        movemask(digit)
+    };
+}
+
+#else
+
+enum ClassBits : uint8_t {
+    CLASS_SPECIAL = 1,
+    CLASS_DOUBLE_QUOTE = 2,
+    CLASS_SINGLE_QUOTE = 4,
+    CLASS_WHITESPACE = 8,
+    CLASS_DIGIT = 16
+};
+
+struct ClassTable {
+    uint8_t bits[256] = {};
+
+    constexpr ClassTable() {
+        for (unsigned char c : {'{', '}', '[', ']', '(', ')', ',', ':', ';', '='}) {
+            bits[c] = CLASS_SPECIAL;
+        }
+        bits[static_cast<unsigned char>('"')] = CLASS_DOUBLE_QUOTE;
+        bits[static_cast<unsigned char>('\'')] = CLASS_SINGLE_QUOTE;
+        for (unsigned char c : {' ', '\t', '\n', '\v', '\f', '\r'}) {
+            bits[c] = CLASS_WHITESPACE;
+        }
+        for (unsigned char c = '0'; c <= '9'; ++c) {
+            bits[c] = CLASS_DIGIT;
+        }
+    }
+};
+
+constexpr ClassTable CLASS_TABLE;
+
+#endif
+
+} // namespace
+
+CharClassMasks CharClassifier::classifyFullBlock(const char* data) {
+    CharClassMasks masks{};
+
+#if defined(CHAR_CLASSIFIER_AVX2)
+    for (int half = 0; half < 2; ++half) {
+        Classes32 c = classify32(data + half * 32);
+        int shift = half * 32;
+        masks.special |= static_cast<uint64_t>(c.special) << shift;
+        masks.double_quote |= static_cast<uint64_t>(c.double_quote) << shift;
+        masks.single_quote |= static_cast<uint64_t>(c.single_quote) << shift;
+        masks.whitespace |= static_cast<uint64_t>(c.whitespace) << shift;
+        masks.digit |= static_cast<uint64_t>(c.digit) << shift;
+    }
+#elif defined(CHAR_CLASSIFIER_SSE2)
+    for (int quarter = 0; quarter < 4; ++quarter) {
+        Classes16 c = classify16(data + quarter * 16);
+        int shift = quarter * 16;
+        masks.special |= static_cast<uint64_t>(c.special) << shift;
+        masks.double_quote |= static_cast<uint64_t>(c.double_quote) << shift;
+        masks.single_quote |= static_cast<uint64_t>(c.single_quote) << shift;
+        masks.whitespace |= static_cast<uint64_t>(c.whitespace) << shift;
+        masks.digit |= static_cast<uint64_t>(c.digit) << shift;
+    }
+#else
+    for (size_t i = 0; i < BLOCK_SIZE; ++i) {
+        uint8_t bits = CLASS_TABLE.bits[static_cast<unsigned char>(data[i])];
+        uint64_t bit = 1ULL << i;
+        if (bits & CLASS_SPECIAL) masks.special |= bit;
+        if (bits & CLASS_DOUBLE_QUOTE) masks.double_quote |= bit;
+        if (bits & CLASS_SINGLE_QUOTE) masks.single_quote |= bit;
+        if (bits & CLASS_WHITESPACE) masks.whitespace |= bit;
+        if (bits & CLASS_DIGIT) masks.digit |= bit;
+    }
+#endif
+
+    return masks;
+}
+
+CharClassMasks CharClassifier::classify(const char* data, size_t length) {
+    if (length >= BLOCK_SIZE) {
+        return classifyFullBlock(data);
+    }
+
+    // Tail: zero padding classifies as nothing
+    char padded[BLOCK_SIZE] = {};
+    std::memcpy(padded, data, length);
+    return classifyFullBlock(padded);
+}
+
+const char* CharClassifier::implementation() {
+#if defined(CHAR_CLASSIFIER_AVX2)
+    return "avx2";
+#elif defined(CHAR_CLASSIFIER_SSE2)
+    return "sse2";
+#else
+    return "scalar";
+#endif
+}
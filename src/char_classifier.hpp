@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#if defined(_MSC_VER)
+    #include <intrin.h>
+#endif
+
+// Bit i of each mask describes byte i of a block of up to 64 bytes
+// (in the style of simdjson's structural indexing).
+struct CharClassMasks {
+    uint64_t special;        // { } [ ] ( ) , : ; =
+    uint64_t double_quote;   // "
+    uint64_t single_quote;   // '
+    uint64_t whitespace;     // std::isspace in the "C" locale
+    uint64_t digit;          // 0-9
+
+    uint64_t structural() const {
+        return special | double_quote | single_quote | whitespace;
+    }
+};
+
+class CharClassifier {
+public:
+    static constexpr size_t BLOCK_SIZE = 64;
+
+    // Classify `length` bytes (at most BLOCK_SIZE); bits past length are zero
+    static CharClassMasks classify(const char* data, size_t length);
+
+    // Name of the vector path compiled in ("avx2", "sse2" or "scalar")
+    static const char* implementation();
+
+private:
+    static CharClassMasks classifyFullBlock(const char* data);
+};
+
+inline int lowestBitIndex(uint64_t mask) {
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward64(&index, mask);
+    return static_cast<int>(index);
+#else
+    return __builtin_ctzll(mask);
+#endif
+}
+
+// Mask of bits strictly above `bit` (bit in [0, 63])
+inline uint64_t bitsAbove(int bit) {
+    return bit >= 63 ? 0 : (~0ULL << (bit + 1));
+}
+
+// Mask of bits in [from, to) (0 <= from <= to <= 64)
+inline uint64_t bitRange(size_t from, size_t to) {
+    uint64_t upper = to >= 64 ? ~0ULL : ((1ULL << to) - 1);
+    uint64_t lower = from >= 64 ? ~0ULL : ((1ULL << from) - 1);
+    return upper & ~lower;
+}
@@ -1,9 +1,31 @@
 #include "filter_engine.hpp"
+#include "parallel.hpp"
+#include "trace.hpp"
 #include <algorithm>
 #include <execution>
 
+namespace {
+
+// The groups of a regex match as views into the line
+template <typename Match>
+void copyCaptures(const Match& match, std::string_view line, std::vector<std::string_view>& captures) {
+    captures.clear();
+    for (size_t group = 0; group < match.size(); ++group) {
+        if (match[group].matched) {
+            captures.emplace_back(line.data() + (match[group].first - line.begin()),
+                                  static_cast<size_t>(match[group].length()));
+        } else {
+            captures.emplace_back();
+        }
+    }
+}
+
+} // namespace
+
 FilterEngine::FilterEngine()
-    : has_valid_pattern_(false) {
+    : mode_(Mode::Regex)
+    , literal_(false)
+    , has_valid_pattern_(false) {
 }
 
 FilterEngine::~FilterEngine() = default;
@@ -12,6 +34,8 @@ bool FilterEngine::setPattern(const std::string& pattern) {
     std::lock_guard<std::mutex> lock(mutex_);
 
     pattern_ = pattern;
+    mode_ = Mode::Regex;
+    literal_ = false;
     error_message_.clear();
 
     if (pattern.empty()) {
@@ -19,6 +43,26 @@ bool FilterEngine::setPattern(const std::string& pattern) {
         return true;
     }
 
+    // JSON field predicates: "json: endpoint == \"/api/users\" && body.age > 25"
+    if (std::string_view(pattern).substr(0, JSON_QUERY_PREFIX.size()) == JSON_QUERY_PREFIX) {
+        mode_ = Mode::JsonQuery;
+        if (!json_query_.compile(std::string_view(pattern).substr(JSON_QUERY_PREFIX.size()))) {
+            error_message_ = "Query error: " + json_query_.getError();
+            has_valid_pattern_ = false;
+            return false;
+        }
+        has_valid_pattern_ = true;
+        return true;
+    }
+
+    // Plain words skip the regex engine entirely
+    if (LiteralSearcher::isLiteralPattern(pattern)) {
+        literal_ = true;
+        literal_searcher_ = LiteralSearcher(pattern);
+        has_valid_pattern_ = true;
+        return true;
+    }
+
     try {
         regex_ = std::regex(pattern,
             std::regex_constants::ECMAScript |
@@ -35,25 +79,271 @@ bool FilterEngine::setPattern(const std::string& pattern) {
 void FilterEngine::clearPattern() {
     std::lock_guard<std::mutex> lock(mutex_);
     pattern_.clear();
+    mode_ = Mode::Regex;
+    literal_ = false;
     has_valid_pattern_ = false;
     error_message_.clear();
 }
 
 bool FilterEngine::matches(std::string_view line) const {
     std::lock_guard<std::mutex> lock(mutex_);
+    return matchesLocked(line);
+}
+
+bool FilterEngine::matchesLocked(std::string_view line, std::vector<std::string_view>* captures) const {
+    if (captures != nullptr) {
+        captures->clear();
+    }
 
     if (!has_valid_pattern_) {
         return true;  // No filter means all lines match
     }
 
+    if (mode_ == Mode::JsonQuery) {
+        return json_query_.matches(line);
+    }
+
+    if (literal_) {
+        size_t pos = literal_searcher_.find(line);
+        if (pos != LiteralSearcher::npos && captures != nullptr) {
+            captures->push_back(line.substr(pos, pattern_.size()));
+        }
+        return pos != LiteralSearcher::npos;
+    }
+
+    try {
+        if (captures == nullptr) {
+            return std::regex_search(line.begin(), line.end(), regex_);
+        }
+        std::match_results<std::string_view::const_iterator> match;
+        if (!std::regex_search(line.begin(), line.end(), match, regex_)) {
+            return false;
+        }
+        copyCaptures(match, line, *captures);
+        return true;
+    } catch (const std::regex_error&) {
+        return false;
+    }
+}
+
+size_t FilterEngine::captureCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!has_valid_pattern_ || mode_ != Mode::Regex || literal_) {
+        return 0;
+    }
+    return regex_.mark_count();
+}
+
+bool FilterEngine::findMatches(std::string_view line, std::vector<MatchSpan>& spans) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return findMatchesLocked(line, spans, nullptr);
+}
+
+bool FilterEngine::findMatches(std::string_view line, std::vector<MatchSpan>& spans,
+                               const GroupSpec& spec, GroupTable& groups) const {
+    thread_local std::vector<std::string_view> captures;
+    captures.clear();
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!findMatchesLocked(line, spans, spec.maxCapture() > 0 ? &captures : nullptr)) {
+        return false;
+    }
+    groups.add(spec, line, captures);
+    return true;
+}
+
+bool FilterEngine::findMatchesLocked(std::string_view line, std::vector<MatchSpan>& spans,
+                                     std::vector<std::string_view>* captures) const {
+    if (captures != nullptr) {
+        captures->clear();
+    }
+
+    if (!has_valid_pattern_) {
+        return true;
+    }
+
+    if (mode_ == Mode::JsonQuery) {
+        if (!json_query_.matches(line)) {
+            return false;
+        }
+        for (const auto& literal : json_query_.requiredLiterals()) {
+            size_t pos = line.find(literal);
+            if (pos != std::string_view::npos && spans.size() < MAX_SPANS_PER_LINE) {
+                spans.push_back({static_cast<uint32_t>(pos), static_cast<uint32_t>(literal.size())});
+            }
+        }
+        std::sort(spans.begin(), spans.end(), [](const MatchSpan& a, const MatchSpan& b) {
+            return a.offset < b.offset;
+        });
+        return true;
+    }
+
+    if (literal_) {
+        const size_t length = pattern_.size();
+        size_t pos = literal_searcher_.find(line);
+        if (pos == LiteralSearcher::npos) {
+            return false;
+        }
+        if (captures != nullptr) {
+            captures->push_back(line.substr(pos, length));
+        }
+        while (pos != LiteralSearcher::npos && spans.size() < MAX_SPANS_PER_LINE) {
+            spans.push_back({static_cast<uint32_t>(pos), static_cast<uint32_t>(length)});
+            pos = literal_searcher_.find(line, pos + length);
+        }
+        return true;
+    }
+
     try {
-        std::string line_str(line);
-        return std::regex_search(line_str, regex_);
+        // Iterate the view directly: no copy of the line
+        using Iterator = std::regex_iterator<std::string_view::const_iterator>;
+        bool matched = false;
+        for (Iterator it(line.begin(), line.end(), regex_), end; it != end; ++it) {
+            if (!matched && captures != nullptr) {
+                copyCaptures(*it, line, *captures);
+            }
+            matched = true;
+            if (it->length(0) > 0) {
+                spans.push_back({static_cast<uint32_t>(it->position(0)),
+                                 static_cast<uint32_t>(it->length(0))});
+            }
+            if (spans.size() >= MAX_SPANS_PER_LINE) {
+                break;
+            }
+        }
+        return matched;
     } catch (const std::regex_error&) {
         return false;
     }
 }
 
+std::vector<size_t> FilterEngine::filterLines(const LogReader& reader, size_t begin, size_t end,
+                                              size_t threads) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    end = std::min(end, reader.getLineCount());
+    std::vector<size_t> matching_indices;
+    if (begin >= end) {
+        return matching_indices;
+    }
+
+    if (!has_valid_pattern_) {
+        matching_indices.resize(end - begin);
+        for (size_t i = begin; i < end; ++i) {
+            matching_indices[i - begin] = i;
+        }
+        return matching_indices;
+    }
+
+    size_t slices = workerCount(end - begin, MIN_LINES_PER_THREAD, threads);
+
+    // Contiguous slices, so concatenating the results keeps file order.
+    // Matching only reads the compiled pattern, which is safe to share.
+    std::vector<std::vector<size_t>> results(slices);
+    parallelFor(end - begin, slices, [&](size_t slice, size_t first, size_t last) {
+        TRACE_SCOPE_ARG("filter slice", "lines", last - first);
+        for (size_t i = begin + first; i < begin + last; ++i) {
+            if (matchesLocked(reader.getLine(i))) {
+                results[slice].push_back(i);
+            }
+        }
+    }, "filter worker");
+
+    size_t total = 0;
+    for (const auto& result : results) {
+        total += result.size();
+    }
+    matching_indices.reserve(total);
+    for (const auto& result : results) {
+        matching_indices.insert(matching_indices.end(), result.begin(), result.end());
+    }
+    return matching_indices;
+}
+
+size_t FilterEngine::groupLines(const LogReader& reader, size_t begin, size_t end,
+                                const GroupSpec& spec, GroupTable& groups, size_t threads) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ScanResult found = scanLocked(reader, begin, end, &spec, threads, false);
+    groups.merge(found.groups);
+    return found.matched;
+}
+
+std::span<const MatchSpan> FilterEngine::ScanResult::spansOf(size_t match) const {
+    size_t span_begin = first_span[match];
+    size_t span_end = match + 1 < first_span.size() ? first_span[match + 1] : spans.size();
+    return std::span<const MatchSpan>(spans).subspan(span_begin, span_end - span_begin);
+}
+
+FilterEngine::ScanResult FilterEngine::scanLines(const LogReader& reader, size_t begin, size_t end,
+                                                 const GroupSpec* spec, size_t threads) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return scanLocked(reader, begin, end, spec, threads, true);
+}
+
+FilterEngine::ScanResult FilterEngine::scanLocked(const LogReader& reader, size_t begin, size_t end,
+                                                  const GroupSpec* spec, size_t threads,
+                                                  bool collect) const {
+    ScanResult result;
+    end = std::min(end, reader.getLineCount());
+    if (begin >= end) {
+        return result;
+    }
+
+    // Captures are only taken when the spec uses them
+    bool use_captures = spec != nullptr && spec->maxCapture() > 0;
+    size_t slices = workerCount(end - begin, MIN_LINES_PER_THREAD, threads);
+    std::vector<ScanResult> partials(slices);
+    parallelFor(end - begin, slices, [&](size_t slice, size_t first, size_t last) {
+        TRACE_SCOPE_ARG("scan slice", "lines", last - first);
+        ScanResult& partial = partials[slice];
+        std::vector<std::string_view> captures;
+        std::vector<MatchSpan> line_spans;  // Per line: the span cap counts one line
+        for (size_t i = begin + first; i < begin + last; ++i) {
+            auto line = reader.getLine(i);
+            auto* line_captures = use_captures ? &captures : nullptr;
+            if (collect) {
+                line_spans.clear();
+                if (!findMatchesLocked(line, line_spans, line_captures)) {
+                    continue;
+                }
+                partial.lines.push_back(i);
+                partial.first_span.push_back(partial.spans.size());
+                partial.spans.insert(partial.spans.end(), line_spans.begin(), line_spans.end());
+            } else if (!matchesLocked(line, line_captures)) {
+                continue;  // Nothing to keep but the groups: the first match is enough
+            }
+            ++partial.matched;
+            if (spec != nullptr) {
+                partial.groups.add(*spec, line, captures);
+            }
+        }
+    }, "filter worker");
+
+    if (slices == 1) {
+        return std::move(partials[0]);
+    }
+
+    size_t lines = 0;
+    size_t spans = 0;
+    for (const auto& partial : partials) {
+        lines += partial.lines.size();
+        spans += partial.spans.size();
+    }
+    result.lines.reserve(lines);
+    result.first_span.reserve(lines);
+    result.spans.reserve(spans);
+    for (const auto& partial : partials) {
+        size_t span_base = result.spans.size();
+        result.lines.insert(result.lines.end(), partial.lines.begin(), partial.lines.end());
+        for (size_t first : partial.first_span) {
+            result.first_span.push_back(span_base + first);
+        }
+        result.spans.insert(result.spans.end(), partial.spans.begin(), partial.spans.end());
+        result.groups.merge(partial.groups);
+        result.matched += partial.matched;
+    }
+    return result;
+}
+
 std::vector<size_t> FilterEngine::filter(const std::vector<std::string_view>& lines) {
     return filterImpl(lines);
 }
@@ -83,20 +373,10 @@ std::vector<size_t> FilterEngine::filterImpl(const std::vector<std::string_view>
     // Reserve space (assume ~10% match rate)
     matching_indices.reserve(lines.size() / 10);
 
-    // Filter lines using regex
+    // Filter lines using regex or JSON field predicates
     for (size_t i = 0; i < lines.size(); ++i) {
-        const auto& line = lines[i];
-
-        // Convert string_view to string for regex matching
-        std::string line_str(line);
-
-        try {
-            if (std::regex_search(line_str, regex_)) {
-                matching_indices.push_back(i);
-            }
-        } catch (const std::regex_error&) {
-            // Skip lines that cause regex errors
-            continue;
+        if (matchesLocked(lines[i])) {
+            matching_indices.push_back(i);
         }
     }
 
@@ -4,14 +4,28 @@
 #include <vector>
 #include <regex>
 #include <string_view>
+#include <span>
 #include <memory>
 #include <thread>
 #include <mutex>
 #include <atomic>
 #include <future>
+#include "json_query.hpp"
+#include "group_by.hpp"
+#include "match_index.hpp"
+#include "log_reader.hpp"
+#include "literal_search.hpp"
 
 class FilterEngine {
 public:
+    // Patterns starting with this prefix are JSON field queries, not regexes
+    static constexpr std::string_view JSON_QUERY_PREFIX = "json:";
+
+    enum class Mode {
+        Regex,
+        JsonQuery
+    };
+
     FilterEngine();
     ~FilterEngine();
 
@@ -32,6 +46,9 @@ public:
     // Get current pattern
     const std::string& getPattern() const { return pattern_; }
 
+    // Get how the current pattern is interpreted
+    Mode getMode() const { return mode_; }
+
     // Get last error message
     const std::string& getError() const { return error_message_; }
 
@@ -41,12 +58,75 @@ public:
     // Check if a single line matches the current pattern
     bool matches(std::string_view line) const;
 
+    // Like matches(), but also appends where the pattern matched (at most
+    // MAX_SPANS_PER_LINE spans). JSON queries report their key literals.
+    bool findMatches(std::string_view line, std::vector<MatchSpan>& spans) const;
+
+    static constexpr size_t MAX_SPANS_PER_LINE = 256;
+
+    // Like findMatches(), and a matching line is also added to `groups`
+    // under the key `spec` takes from it (captures of the first match)
+    bool findMatches(std::string_view line, std::vector<MatchSpan>& spans,
+                     const GroupSpec& spec, GroupTable& groups) const;
+
+    // Capture groups a group spec may refer to: those of a regex pattern,
+    // none for plain words and JSON queries
+    size_t captureCount() const;
+
+    // Indices of the matching lines among [begin, end) of `reader`, in file
+    // order. The range is split across `threads` workers (0: one per core)
+    // and the pattern is locked once for the whole scan, not per line.
+    std::vector<size_t> filterLines(const LogReader& reader, size_t begin, size_t end,
+                                    size_t threads = 0) const;
+
+    // Aggregate the matching lines among [begin, end) into `groups` in the
+    // same parallel scan: each worker fills its own table and the tables are
+    // merged at the end. Returns the number of matching lines.
+    size_t groupLines(const LogReader& reader, size_t begin, size_t end,
+                      const GroupSpec& spec, GroupTable& groups, size_t threads = 0) const;
+
+    // What scanLines() found in a range
+    struct ScanResult {
+        std::vector<size_t> lines;       // Matching lines, in file order
+        std::vector<size_t> first_span;  // Start of each line's spans in `spans`
+        std::vector<MatchSpan> spans;
+        GroupTable groups;               // Empty without a group spec
+        size_t matched = 0;              // Matching lines, also when not kept
+
+        // Spans of the `match`-th matching line
+        std::span<const MatchSpan> spansOf(size_t match) const;
+    };
+
+    // The matching lines among [begin, end) with their match spans, and
+    // their groups when `spec` is given: findMatches() over a whole range.
+    // The pattern is locked once; each worker keeps its own lines, spans and
+    // table, and the partial results are merged in slice order.
+    ScanResult scanLines(const LogReader& reader, size_t begin, size_t end,
+                         const GroupSpec* spec = nullptr, size_t threads = 0) const;
+
+    // Below this many lines per worker a range is not worth splitting
+    static constexpr size_t MIN_LINES_PER_THREAD = 16384;
+
 private:
     std::vector<size_t> filterImpl(const std::vector<std::string_view>& lines);
+    // `captures`, if given, receives the groups of the first match ([0] is
+    // the whole match; groups that did not take part are null views)
+    bool matchesLocked(std::string_view line, std::vector<std::string_view>* captures = nullptr) const;
+    bool findMatchesLocked(std::string_view line, std::vector<MatchSpan>& spans,
+                           std::vector<std::string_view>* captures) const;
+
+    // The parallel scan behind scanLines() and groupLines(). `collect`: keep
+    // the matching lines and their spans, not only groups and the count
+    ScanResult scanLocked(const LogReader& reader, size_t begin, size_t end,
+                          const GroupSpec* spec, size_t threads, bool collect) const;
 
     std::string pattern_;
+    Mode mode_;
     std::regex regex_;
+    bool literal_;              // Regex without metacharacters: plain substring search
+    LiteralSearcher literal_searcher_;
+    JsonQuery json_query_;
     bool has_valid_pattern_;
     std::string error_message_;
-    std::mutex mutex_;
+    mutable std::mutex mutex_;
 };
@@ -0,0 +1,142 @@
+#include "format_sniffer.hpp"
+#include "log_reader.hpp"
+#include "keyword_table.hpp"
+#include <algorithm>
+
+namespace {
+
+// Statements that only show up in SQL-heavy logs (matched upper-case only)
+constexpr auto SQL_STATEMENTS = makeKeywordTable(std::to_array<KeywordEntry>({
+    {"SELECT", 1}, {"INSERT", 1}, {"UPDATE", 1}, {"DELETE", 1},
+    {"CREATE", 1}, {"ALTER", 1}, {"DROP", 1}, {"FROM", 1}, {"WHERE", 1},
+    {"JOIN", 1}, {"VALUES", 1}, {"COMMIT", 1}, {"ROLLBACK", 1}
+}));
+
+inline bool isWordChar(char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+           (c >= '0' && c <= '9') || c == '_';
+}
+
+inline bool isUpperWord(std::string_view word) {
+    for (char c : word) {
+        if (c >= 'a' && c <= 'z') {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool looksLikeJson(std::string_view line) {
+    size_t brace = line.find('{');
+    return brace != std::string_view::npos &&
+           line.find("\":", brace) != std::string_view::npos;
+}
+
+bool looksLikeLogfmt(std::string_view line) {
+    // At least three "key=" pairs where key is an identifier preceded by a space
+    int pairs = 0;
+    for (size_t i = 1; i < line.size(); ++i) {
+        if (line[i] != '=' || !isWordChar(line[i - 1])) {
+            continue;
+        }
+        size_t key_start = i;
+        while (key_start > 0 && (isWordChar(line[key_start - 1]) || line[key_start - 1] == '.')) {
+            --key_start;
+        }
+        if (key_start == 0 || line[key_start - 1] == ' ') {
+            ++pairs;
+        }
+    }
+    return pairs >= 3;
+}
+
+int countSqlStatements(std::string_view line) {
+    int count = 0;
+    size_t i = 0;
+    while (i < line.size()) {
+        while (i < line.size() && !isWordChar(line[i])) {
+            ++i;
+        }
+        size_t start = i;
+        while (i < line.size() && isWordChar(line[i])) {
+            ++i;
+        }
+        std::string_view word = line.substr(start, i - start);
+        if (!word.empty() && isUpperWord(word) && SQL_STATEMENTS.contains(word)) {
+            ++count;
+        }
+    }
+    return count;
+}
+
+} // namespace
+
+std::string_view formatName(LogFormat format) {
+    switch (format) {
+        case LogFormat::JsonLines: return "JSON";
+        case LogFormat::Logfmt:    return "logfmt";
+        case LogFormat::Sql:       return "SQL";
+        case LogFormat::PlainText: return "text";
+        case LogFormat::Generic:
+        default:                   return "generic";
+    }
+}
+
+LogFormat detectFormat(const std::vector<std::string_view>& sample) {
+    size_t lines = 0;
+    size_t json_lines = 0;
+    size_t logfmt_lines = 0;
+    size_t sql_lines = 0;
+
+    for (auto line : sample) {
+        if (line.empty()) {
+            continue;
+        }
+        ++lines;
+        if (looksLikeJson(line)) {
+            ++json_lines;
+        } else if (looksLikeLogfmt(line)) {
+            ++logfmt_lines;
+        }
+        // Two statement keywords (SELECT ... FROM) make a line SQL
+        if (countSqlStatements(line) >= 2) {
+            ++sql_lines;
+        }
+    }
+
+    if (lines == 0) {
+        return LogFormat::Generic;
+    }
+    if (json_lines * 2 >= lines) {
+        return LogFormat::JsonLines;
+    }
+    if (logfmt_lines * 2 >= lines) {
+        return LogFormat::Logfmt;
+    }
+    if (sql_lines * 5 >= lines) {
+        return LogFormat::Sql;
+    }
+    return LogFormat::PlainText;
+}
+
+LogFormat detectFormat(const LogReader& reader, size_t sample_lines) {
+    size_t total = reader.getLineCount();
+    if (total == 0 || sample_lines == 0) {
+        return LogFormat::Generic;
+    }
+
+    std::vector<std::string_view> sample;
+    sample.reserve(sample_lines);
+
+    // Half from the head of the file, half spread over the rest
+    size_t head = std::min(total, sample_lines / 2);
+    for (size_t i = 0; i < head; ++i) {
+        sample.push_back(reader.getLine(i));
+    }
+    size_t spread = std::min(total - head, sample_lines - head);
+    for (size_t k = 0; k < spread; ++k) {
+        sample.push_back(reader.getLine(head + (total - head) * k / spread));
+    }
+
+    return detectFormat(sample);
+}
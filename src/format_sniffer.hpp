@@ -0,0 +1,28 @@
+#pragma once
+
+#include <string_view>
+#include <vector>
+#include <cstddef>
+
+class LogReader;
+
+// Dominant content format of a log file, used to pick a specialised tokenizer
+enum class LogFormat {
+    Generic,    // Every heuristic at once (JSON + SQL + protocols); used before sniffing
+    JsonLines,  // Lines carrying JSON objects
+    Logfmt,     // key=value pairs
+    Sql,        // Query logs
+    PlainText   // Prose messages: no SQL keywords, upper-case levels only
+};
+
+// Lines sampled from a file to guess its format
+constexpr size_t FORMAT_SAMPLE_LINES = 256;
+
+// Human-readable name for the status bar
+std::string_view formatName(LogFormat format);
+
+// Guess the format from a sample of lines
+LogFormat detectFormat(const std::vector<std::string_view>& sample);
+
+// Sample the head and evenly spaced lines of an opened file and guess its format
+LogFormat detectFormat(const LogReader& reader, size_t sample_lines = FORMAT_SAMPLE_LINES);
@@ -0,0 +1,280 @@
+#include "group_by.hpp"
+#include "json_query.hpp"
+#include "log_fields.hpp"
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstdio>
+
+namespace {
+
+constexpr std::string_view JSON_FIELD_PREFIX = "json:";
+
+// Characters std::string keeps inline (libstdc++ and libc++ both hold 15+)
+constexpr size_t INLINE_KEY_BYTES = 15;
+
+bool parseField(std::string_view word, GroupField& field, std::string& error) {
+    field = GroupField();
+    if (word.size() > 1 && word[0] == '$') {
+        size_t capture = 0;
+        auto result = std::from_chars(word.data() + 1, word.data() + word.size(), capture);
+        if (result.ec != std::errc() || result.ptr != word.data() + word.size() || capture == 0) {
+            error = "Bad capture group: " + std::string(word);
+            return false;
+        }
+        field.kind = GroupField::Kind::Capture;
+        field.capture = capture;
+        return true;
+    }
+    if (word.substr(0, JSON_FIELD_PREFIX.size()) == JSON_FIELD_PREFIX) {
+        std::string_view path = word.substr(JSON_FIELD_PREFIX.size());
+        bool valid = !path.empty();
+        while (valid) {
+            size_t dot = path.find('.');
+            field.path.emplace_back(path.substr(0, dot));
+            valid = !field.path.back().empty();
+            if (dot == std::string_view::npos) {
+                break;
+            }
+            path = path.substr(dot + 1);
+        }
+        if (!valid) {
+            error = "Bad JSON path: " + std::string(word);
+            return false;
+        }
+        field.kind = GroupField::Kind::Json;
+        return true;
+    }
+    if (word == "level") {
+        field.kind = GroupField::Kind::Level;
+    } else if (word == "minute") {
+        field.kind = GroupField::Kind::Minute;
+    } else if (word == "hour") {
+        field.kind = GroupField::Kind::Hour;
+    } else {
+        error = "Unknown group field: " + std::string(word) +
+                " (use $N, level, minute, hour or json:PATH)";
+        return false;
+    }
+    return true;
+}
+
+// Text of a field in a line, in `out` (which may point into `scratch`);
+// false when the line does not have it
+bool extractField(const GroupField& field, std::string_view line,
+                  std::span<const std::string_view> captures,
+                  std::string& scratch, std::string_view& out) {
+    switch (field.kind) {
+        case GroupField::Kind::None:
+            return false;
+        case GroupField::Kind::Capture:
+            if (field.capture >= captures.size() || captures[field.capture].data() == nullptr) {
+                return false;  // The group did not take part in the match
+            }
+            out = captures[field.capture];
+            return true;
+        case GroupField::Kind::Json: {
+            auto value = JsonScanner::findInLine(line, field.path);
+            out = value.raw;
+            return value.type != JsonScanner::ValueType::None;
+        }
+        case GroupField::Kind::Level:
+            out = levelName(parseLineFields(line).level);
+            return !out.empty();
+        case GroupField::Kind::Minute:
+        case GroupField::Kind::Hour: {
+            int64_t timestamp = parseLineFields(line).timestamp;
+            if (timestamp == LineFields::NO_TIMESTAMP) {
+                return false;
+            }
+            // "YYYY-MM-DD HH:MM" / "YYYY-MM-DD HH": text order is time order.
+            // Formatted in place: scratch keeps its capacity between lines
+            scratch.resize(TIMESTAMP_BUFFER_SIZE);
+            size_t length = formatTimestamp(timestamp, scratch.data());
+            out = std::string_view(scratch.data(), length)
+                      .substr(0, field.kind == GroupField::Kind::Minute ? 16 : 13);
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace
+
+size_t GroupSpec::maxCapture() const {
+    size_t result = 0;
+    for (const GroupField* field : {&key, &value}) {
+        if (field->kind == GroupField::Kind::Capture) {
+            result = std::max(result, field->capture);
+        }
+    }
+    return result;
+}
+
+bool parseGroupSpec(std::string_view text, GroupSpec& spec, std::string& error) {
+    std::vector<std::string_view> words;
+    size_t pos = 0;
+    while (pos < text.size()) {
+        size_t start = text.find_first_not_of(" \t", pos);
+        if (start == std::string_view::npos) {
+            break;
+        }
+        size_t end = std::min(text.find_first_of(" \t", start), text.size());
+        words.push_back(text.substr(start, end - start));
+        pos = end;
+    }
+
+    if (words.empty() || words.size() > 2) {
+        error = "Group by needs a key and at most one value, e.g. \"$1 $2\"";
+        return false;
+    }
+
+    GroupSpec parsed;
+    if (!parseField(words[0], parsed.key, error)) {
+        return false;
+    }
+    if (words.size() == 2) {
+        if (!parseField(words[1], parsed.value, error)) {
+            return false;
+        }
+        if (parsed.value.kind != GroupField::Kind::Capture &&
+            parsed.value.kind != GroupField::Kind::Json) {
+            error = "A group value must be a capture group or a JSON field";
+            return false;
+        }
+    }
+    spec = std::move(parsed);
+    return true;
+}
+
+bool parseLeadingNumber(std::string_view text, double& value) {
+    const char* begin = text.data();
+    const char* end = text.data() + text.size();
+    if (begin != end && *begin == '+') {
+        ++begin;  // from_chars takes a minus sign only
+    }
+    auto result = std::from_chars(begin, end, value);
+    return result.ec == std::errc() && std::isfinite(value);
+}
+
+void GroupStats::merge(const GroupStats& other) {
+    count += other.count;
+    values += other.values;
+    sum += other.sum;
+    min = std::min(min, other.min);
+    max = std::max(max, other.max);
+}
+
+void GroupTable::add(const GroupSpec& spec, std::string_view line,
+                     std::span<const std::string_view> captures) {
+    std::string_view key;
+    if (extractField(spec.key, line, captures, scratch_, key)) {
+        key_.assign(key);
+    } else {
+        key_.clear();
+    }
+
+    std::string_view value_text;
+    double value = 0.0;
+    bool has_value = spec.hasValue() &&
+                     extractField(spec.value, line, captures, scratch_, value_text) &&
+                     parseLeadingNumber(value_text, value);
+    addKey(has_value ? &value : nullptr);
+}
+
+void GroupTable::add(std::string_view key, const double* value) {
+    key_.assign(key);
+    addKey(value);
+}
+
+void GroupTable::addKey(const double* value) {
+    // Looked up through the reused buffer: no allocation for known keys
+    auto it = groups_.find(key_);
+    if (it == groups_.end()) {
+        it = groups_.emplace(key_, GroupStats()).first;
+        if (key_.size() > INLINE_KEY_BYTES) {
+            key_bytes_ += key_.size() + 1;
+        }
+    }
+
+    GroupStats& stats = it->second;
+    ++stats.count;
+    ++total_;
+    if (value != nullptr) {
+        ++stats.values;
+        stats.sum += *value;
+        stats.min = std::min(stats.min, *value);
+        stats.max = std::max(stats.max, *value);
+    }
+}
+
+void GroupTable::merge(const GroupTable& other) {
+    for (const auto& [key, stats] : other.groups_) {
+        auto [it, inserted] = groups_.try_emplace(key);
+        if (inserted && key.size() > INLINE_KEY_BYTES) {
+            key_bytes_ += key.size() + 1;
+        }
+        it->second.merge(stats);
+    }
+    total_ += other.total_;
+}
+
+void GroupTable::clear() {
+    groups_ = {};  // Releases the buckets, unlike clear()
+    key_bytes_ = 0;
+    total_ = 0;
+}
+
+const GroupStats* GroupTable::find(std::string_view key) const {
+    auto it = groups_.find(std::string(key));
+    return it == groups_.end() ? nullptr : &it->second;
+}
+
+size_t GroupTable::memoryUsage() const {
+    // A node holds the key, the stats, the next pointer and the cached hash
+    constexpr size_t NODE_BYTES = sizeof(std::string) + sizeof(GroupStats) + 2 * sizeof(void*);
+    return groups_.size() * NODE_BYTES + groups_.bucket_count() * sizeof(void*) + key_bytes_;
+}
+
+std::vector<GroupTable::Row> GroupTable::rows(GroupColumn column, bool descending) const {
+    std::vector<Row> result;
+    result.reserve(groups_.size());
+    for (const auto& [key, stats] : groups_) {
+        result.push_back({key, stats});
+    }
+
+    auto value = [column](const GroupStats& stats) {
+        switch (column) {
+            case GroupColumn::Count: return static_cast<double>(stats.count);
+            case GroupColumn::Sum: return stats.sum;
+            case GroupColumn::Min: return stats.values > 0 ? stats.min : 0.0;
+            case GroupColumn::Max: return stats.values > 0 ? stats.max : 0.0;
+            case GroupColumn::Average: return stats.average();
+            case GroupColumn::Key: break;
+        }
+        return 0.0;
+    };
+
+    std::sort(result.begin(), result.end(), [&](const Row& a, const Row& b) {
+        if (column != GroupColumn::Key) {
+            double left = value(a.stats);
+            double right = value(b.stats);
+            if (left != right) {
+                return descending ? left > right : left < right;
+            }
+            return a.key < b.key;
+        }
+        return descending ? a.key > b.key : a.key < b.key;
+    });
+    return result;
+}
+
+std::string formatGroupNumber(double value) {
+    char buffer[64];
+    if (std::abs(value) < 1e15 && value == std::floor(value)) {
+        std::snprintf(buffer, sizeof(buffer), "%.0f", value);
+    } else {
+        std::snprintf(buffer, sizeof(buffer), "%.2f", value);
+    }
+    return buffer;
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Aggregation of matching lines by a key ("errors per endpoint / per host /
+// per minute"), computed in the filter scan itself. A spec is a key and an
+// optional numeric value:
+//
+//   $1            first capture group of the filter regex
+//   level         log level; minute / hour: timestamp truncated
+//   json:a.b      field of the line's JSON payload
+//
+//   "$1 $2"       count, sum, min, max and average of capture 2 per capture 1
+//
+// A value is the leading number of its text, so "45ms" counts as 45.
+struct GroupField {
+    enum class Kind { None, Capture, Level, Minute, Hour, Json };
+
+    Kind kind = Kind::None;
+    size_t capture = 0;             // Capture: group number
+    std::vector<std::string> path;  // Json: dotted path, split
+};
+
+struct GroupSpec {
+    GroupField key;
+    GroupField value;  // Kind::None: count only
+
+    bool hasValue() const { return value.kind != GroupField::Kind::None; }
+
+    // Highest capture group the spec refers to (0: none)
+    size_t maxCapture() const;
+};
+
+// Parse "KEY [VALUE]"; false with `error` set on bad input
+bool parseGroupSpec(std::string_view text, GroupSpec& spec, std::string& error);
+
+// Leading decimal number of `text` ("45ms", "-0.5s", "1e3"); false if none
+bool parseLeadingNumber(std::string_view text, double& value);
+
+struct GroupStats {
+    uint64_t count = 0;   // Lines with this key
+    uint64_t values = 0;  // Of those, lines with a numeric value
+    double sum = 0.0;
+    double min = std::numeric_limits<double>::infinity();
+    double max = -std::numeric_limits<double>::infinity();
+
+    double average() const { return values > 0 ? sum / static_cast<double>(values) : 0.0; }
+    void merge(const GroupStats& other);
+};
+
+enum class GroupColumn { Key, Count, Sum, Min, Max, Average };
+
+// Per-key aggregates. Not thread-safe: every scan worker fills its own
+// table and the tables are merged when the workers are done.
+class GroupTable {
+public:
+    struct Row {
+        std::string key;  // Empty: lines where the key was missing
+        GroupStats stats;
+    };
+
+    // Add a matching line; `captures` are the filter's groups, [0] the whole
+    // match (empty when the pattern has none)
+    void add(const GroupSpec& spec, std::string_view line, std::span<const std::string_view> captures);
+
+    void add(std::string_view key, const double* value);
+    void merge(const GroupTable& other);
+    void clear();
+
+    size_t size() const { return groups_.size(); }
+    bool empty() const { return groups_.empty(); }
+    uint64_t totalCount() const { return total_; }
+    const GroupStats* find(std::string_view key) const;
+
+    // Approximate heap bytes held
+    size_t memoryUsage() const;
+
+    // Every group ordered by a column; ties are ordered by key
+    std::vector<Row> rows(GroupColumn column, bool descending) const;
+
+private:
+    // Count a line under key_, with a value unless null
+    void addKey(const double* value);
+
+    std::unordered_map<std::string, GroupStats> groups_;
+    std::string key_;         // Reused lookup buffer
+    std::string scratch_;     // Formatted fields (minute, hour)
+    size_t key_bytes_ = 0;    // Key characters stored outside the strings
+    uint64_t total_ = 0;
+};
+
+// "123", "45.25"; integers without a fraction
+std::string formatGroupNumber(double value);
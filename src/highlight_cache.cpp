@@ -0,0 +1,261 @@
+#include "highlight_cache.hpp"
+#include "trace.hpp"
+
+HighlightCache::HighlightCache(std::shared_ptr<LogReader> reader,
+                               std::shared_ptr<SyntaxHighlighter> highlighter,
+                               size_t capacity)
+    : reader_(reader)
+    , highlighter_(highlighter)
+    , capacity_(capacity > 0 ? capacity : 1)
+    , memory_limit_(SIZE_MAX)
+    , bytes_(0)
+    , generation_(0)
+    , stop_(false) {
+    index_.reserve(capacity_);
+    worker_ = std::thread([this]() { workerLoop(); });
+}
+
+HighlightCache::~HighlightCache() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+        pending_.clear();
+    }
+    work_available_.notify_all();
+    if (worker_.joinable()) {
+        worker_.join();
+    }
+}
+
+std::shared_ptr<const HighlightCache::Tokens> HighlightCache::tokenizeLine(
+    std::string_view line) const {
+    auto tokens = std::make_shared<Tokens>();
+    highlighter_->tokenize(line, *tokens);
+    tokens->shrink_to_fit();
+    return tokens;
+}
+
+std::shared_ptr<const HighlightCache::Checkpoints> HighlightCache::checkpointLine(
+    std::string_view line) const {
+    auto checkpoints = std::make_shared<Checkpoints>();
+    highlighter_->buildCheckpoints(line, *checkpoints);
+    checkpoints->shrink_to_fit();
+    return checkpoints;
+}
+
+size_t HighlightCache::entryBytes(const Entry& entry) {
+    // The list and hash map nodes cost about as much as the entry again
+    size_t bytes = 2 * sizeof(Entry);
+    if (entry.tokens) {
+        bytes += entry.tokens->capacity() * sizeof(SyntaxHighlighter::Token);
+    }
+    if (entry.checkpoints) {
+        bytes += entry.checkpoints->capacity() * sizeof(uint32_t);
+    }
+    if (entry.layout) {
+        bytes += sizeof(LineLayout) + entry.layout->memoryUsage();
+    }
+    return bytes;
+}
+
+HighlightCache::Entry* HighlightCache::lookupLocked(size_t line_index, size_t line_length) {
+    auto it = index_.find(line_index);
+    if (it == index_.end()) {
+        return nullptr;
+    }
+    if (it->second->line_length != line_length) {
+        bytes_ -= entryBytes(*it->second);
+        lru_.erase(it->second);
+        index_.erase(it);
+        return nullptr;
+    }
+    lru_.splice(lru_.begin(), lru_, it->second);
+    return &*it->second;
+}
+
+void HighlightCache::insertLocked(size_t line_index, size_t line_length,
+                                  std::shared_ptr<const Tokens> tokens,
+                                  std::shared_ptr<const Checkpoints> checkpoints,
+                                  std::shared_ptr<const LineLayout> layout) {
+    auto it = index_.find(line_index);
+    if (it != index_.end()) {
+        lru_.splice(lru_.begin(), lru_, it->second);
+        bytes_ -= entryBytes(lru_.front());
+        if (lru_.front().line_length != line_length) {
+            lru_.front() = {line_index, line_length, nullptr, nullptr, nullptr};
+        }
+    } else {
+        lru_.push_front({line_index, line_length, nullptr, nullptr, nullptr});
+        index_[line_index] = lru_.begin();
+    }
+
+    Entry& entry = lru_.front();
+    if (tokens) {
+        entry.tokens = std::move(tokens);
+    }
+    if (checkpoints) {
+        entry.checkpoints = std::move(checkpoints);
+    }
+    if (layout) {
+        entry.layout = std::move(layout);
+    }
+    bytes_ += entryBytes(entry);
+    evictLocked();
+}
+
+void HighlightCache::evictLocked() {
+    // Under a tight memory limit even the newest entry goes; callers keep
+    // their own reference to what they just computed
+    while (!lru_.empty() && (lru_.size() > capacity_ || bytes_ > memory_limit_)) {
+        bytes_ -= entryBytes(lru_.back());
+        index_.erase(lru_.back().line_index);
+        lru_.pop_back();
+    }
+}
+
+std::shared_ptr<const HighlightCache::Tokens> HighlightCache::get(size_t line_index) {
+    auto line = reader_->getLine(line_index);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto* entry = lookupLocked(line_index, line.size());
+        if (entry && entry->tokens) {
+            return entry->tokens;
+        }
+    }
+
+    // Miss: tokenize outside the lock so the worker is never blocked on us
+    auto tokens = tokenizeLine(line);
+    std::lock_guard<std::mutex> lock(mutex_);
+    insertLocked(line_index, line.size(), tokens, nullptr);
+    return tokens;
+}
+
+std::shared_ptr<const HighlightCache::Tokens> HighlightCache::find(size_t line_index) {
+    auto line = reader_->getLine(line_index);
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto* entry = lookupLocked(line_index, line.size());
+    return entry ? entry->tokens : nullptr;
+}
+
+std::shared_ptr<const HighlightCache::Checkpoints> HighlightCache::checkpoints(size_t line_index) {
+    auto line = reader_->getLine(line_index);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto* entry = lookupLocked(line_index, line.size());
+        if (entry && entry->checkpoints) {
+            return entry->checkpoints;
+        }
+    }
+
+    auto checkpoints = checkpointLine(line);
+    std::lock_guard<std::mutex> lock(mutex_);
+    insertLocked(line_index, line.size(), nullptr, checkpoints);
+    return checkpoints;
+}
+
+std::shared_ptr<const LineLayout> HighlightCache::layout(size_t line_index) {
+    auto line = reader_->getLine(line_index);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto* entry = lookupLocked(line_index, line.size());
+        if (entry && entry->layout) {
+            return entry->layout;
+        }
+    }
+
+    auto layout = std::make_shared<const LineLayout>(line);
+    std::lock_guard<std::mutex> lock(mutex_);
+    insertLocked(line_index, line.size(), nullptr, nullptr, layout);
+    return layout;
+}
+
+void HighlightCache::prefetch(std::vector<size_t> line_indices) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        pending_ = std::move(line_indices);
+    }
+    work_available_.notify_one();
+}
+
+void HighlightCache::invalidate() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++generation_;
+    pending_.clear();
+    lru_.clear();
+    index_.clear();
+    bytes_ = 0;
+}
+
+size_t HighlightCache::size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return lru_.size();
+}
+
+size_t HighlightCache::memoryUsage() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return bytes_;
+}
+
+void HighlightCache::setMemoryLimit(size_t bytes) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    memory_limit_ = bytes;
+    evictLocked();
+}
+
+void HighlightCache::workerLoop() {
+    TRACE_THREAD_NAME("highlight");
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    while (true) {
+        work_available_.wait(lock, [this]() { return stop_ || !pending_.empty(); });
+        if (stop_) {
+            return;
+        }
+
+        // With the memory limit reached, prefetching would only evict the page on screen
+        if (bytes_ >= memory_limit_) {
+            pending_.clear();
+            continue;
+        }
+
+        // Take the most urgent line; a newer prefetch() replaces the rest
+        size_t line_index = pending_.front();
+        pending_.erase(pending_.begin());
+        uint64_t generation = generation_;
+
+        if (line_index >= reader_->getLineCount()) {
+            continue;
+        }
+        auto line = reader_->getLine(line_index);
+        if (index_.count(line_index) > 0) {
+            continue;
+        }
+
+        // Long lines are only rendered through windows: checkpoint them instead
+        if (isLongLine(line)) {
+            lock.unlock();
+            TRACE_SCOPE_ARG("checkpoint line", "bytes", line.size());
+            auto started = std::chrono::steady_clock::now();
+            auto checkpoints = checkpointLine(line);
+            auto layout = std::make_shared<const LineLayout>(line);
+            worker_busy_.add(std::chrono::steady_clock::now() - started);
+            lock.lock();
+            if (generation == generation_) {
+                insertLocked(line_index, line.size(), nullptr, std::move(checkpoints), std::move(layout));
+            }
+            continue;
+        }
+
+        lock.unlock();
+        auto started = std::chrono::steady_clock::now();
+        auto tokens = tokenizeLine(line);
+        auto layout = std::make_shared<const LineLayout>(line);
+        worker_busy_.add(std::chrono::steady_clock::now() - started);
+        lock.lock();
+
+        // Results computed before an invalidate() are stale
+        if (generation == generation_) {
+            insertLocked(line_index, line.size(), std::move(tokens), nullptr, std::move(layout));
+        }
+    }
+}
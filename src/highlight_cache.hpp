@@ -0,0 +1,111 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <unordered_map>
+#include <vector>
+#include "log_reader.hpp"
+#include "perf_stats.hpp"
+#include "syntax_highlighter.hpp"
+#include "utf8_text.hpp"
+
+// Bounded LRU cache of token spans keyed by line index, plus a background
+// worker that pre-tokenizes neighbouring pages so scrolling rarely has to
+// tokenize on the UI thread. Lines longer than LONG_LINE_THRESHOLD keep only
+// tokenizer checkpoints; their visible window is tokenized on demand. Every
+// entry can also hold the line's column layout, which the worker builds
+// along with the tokens.
+class HighlightCache {
+public:
+    using Tokens = std::vector<SyntaxHighlighter::Token>;
+    using Checkpoints = std::vector<uint32_t>;
+
+    static constexpr size_t DEFAULT_CAPACITY = 4096;  // Lines
+    static constexpr size_t LONG_LINE_THRESHOLD = 16 * 1024;  // Bytes
+
+    static bool isLongLine(std::string_view line) { return line.size() > LONG_LINE_THRESHOLD; }
+
+    HighlightCache(std::shared_ptr<LogReader> reader,
+                   std::shared_ptr<SyntaxHighlighter> highlighter,
+                   size_t capacity = DEFAULT_CAPACITY);
+    ~HighlightCache();
+
+    HighlightCache(const HighlightCache&) = delete;
+    HighlightCache& operator=(const HighlightCache&) = delete;
+
+    // Tokens for a line; tokenizes on the calling thread on a miss
+    std::shared_ptr<const Tokens> get(size_t line_index);
+
+    // Tokens for a line if already cached, nullptr otherwise
+    std::shared_ptr<const Tokens> find(size_t line_index);
+
+    // Tokenizer resume points for a line; computed on the calling thread on a miss
+    std::shared_ptr<const Checkpoints> checkpoints(size_t line_index);
+
+    // Screen column layout of a line; built on the calling thread on a miss
+    std::shared_ptr<const LineLayout> layout(size_t line_index);
+
+    // Replace the pending background work with these lines (most urgent first)
+    void prefetch(std::vector<size_t> line_indices);
+
+    // Drop everything (file reopened or changed)
+    void invalidate();
+
+    size_t size() const;
+    size_t capacity() const { return capacity_; }
+
+    // Approximate bytes held by cached tokens, checkpoints and layouts
+    size_t memoryUsage() const;
+
+    // Evict down to `bytes` now and stay under it (SIZE_MAX: lines only)
+    void setMemoryLimit(size_t bytes);
+
+    // Time the background worker spent tokenizing
+    const BusyMeter& workerBusy() const { return worker_busy_; }
+
+private:
+    struct Entry {
+        size_t line_index;
+        size_t line_length;  // Detects lines that changed (e.g. still being written)
+        std::shared_ptr<const Tokens> tokens;            // May be null for long lines
+        std::shared_ptr<const Checkpoints> checkpoints;  // Long lines only
+        std::shared_ptr<const LineLayout> layout;
+    };
+
+    std::shared_ptr<const Tokens> tokenizeLine(std::string_view line) const;
+    std::shared_ptr<const Checkpoints> checkpointLine(std::string_view line) const;
+    static size_t entryBytes(const Entry& entry);
+    Entry* lookupLocked(size_t line_index, size_t line_length);
+
+    // Store tokens, checkpoints or a layout (null keeps what the entry has)
+    void insertLocked(size_t line_index, size_t line_length,
+                      std::shared_ptr<const Tokens> tokens,
+                      std::shared_ptr<const Checkpoints> checkpoints,
+                      std::shared_ptr<const LineLayout> layout = nullptr);
+    void evictLocked();
+    void workerLoop();
+
+    std::shared_ptr<LogReader> reader_;
+    std::shared_ptr<SyntaxHighlighter> highlighter_;
+    size_t capacity_;
+    size_t memory_limit_;
+    size_t bytes_;  // entryBytes() summed over lru_
+
+    // LRU order: front is most recently used
+    std::list<Entry> lru_;
+    std::unordered_map<size_t, std::list<Entry>::iterator> index_;
+    mutable std::mutex mutex_;
+
+    // Background pre-tokenization
+    std::vector<size_t> pending_;
+    uint64_t generation_;
+    bool stop_;
+    std::condition_variable work_available_;
+    BusyMeter worker_busy_;
+    std::thread worker_;
+};
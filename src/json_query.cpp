@@ -0,0 +1,712 @@
+#include "json_query.hpp"
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #include <emmintrin.h>
+    #define JSON_QUERY_HAVE_SSE2 1
+#endif
+
+#if defined(_MSC_VER)
+    #include <intrin.h>
+#endif
+
+namespace {
+
+inline bool isJsonWhitespace(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+inline int countTrailingZeros(unsigned mask) {
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return static_cast<int>(index);
+#else
+    return __builtin_ctz(mask);
+#endif
+}
+
+// Decodes a raw (escaped) JSON string byte by byte without allocating
+class EscapedStringReader {
+public:
+    explicit EscapedStringReader(std::string_view raw)
+        : p_(raw.data()), end_(raw.data() + raw.size()) {}
+
+    bool next(char& out) {
+        if (pending_pos_ < pending_len_) {
+            out = pending_[pending_pos_++];
+            return true;
+        }
+        if (p_ >= end_) {
+            return false;
+        }
+
+        char c = *p_++;
+        if (c != '\\' || p_ >= end_) {
+            out = c;
+            return true;
+        }
+
+        char e = *p_++;
+        switch (e) {
+            case 'b': out = '\b'; return true;
+            case 'f': out = '\f'; return true;
+            case 'n': out = '\n'; return true;
+            case 'r': out = '\r'; return true;
+            case 't': out = '\t'; return true;
+            case 'u': return decodeUnicode(out);
+            default:  out = e;    return true;  // \" \\ \/ and unknown escapes
+        }
+    }
+
+private:
+    bool decodeUnicode(char& out) {
+        if (end_ - p_ < 4) {
+            out = 'u';
+            return true;
+        }
+
+        unsigned code = 0;
+        for (int i = 0; i < 4; ++i) {
+            char h = p_[i];
+            code <<= 4;
+            if (h >= '0' && h <= '9') code |= static_cast<unsigned>(h - '0');
+            else if (h >= 'a' && h <= 'f') code |= static_cast<unsigned>(h - 'a' + 10);
+            else if (h >= 'A' && h <= 'F') code |= static_cast<unsigned>(h - 'A' + 10);
+            else { out = 'u'; return true; }
+        }
+        p_ += 4;
+
+        // Encode as UTF-8 (surrogates are passed through individually)
+        pending_pos_ = 0;
+        if (code < 0x80) {
+            pending_len_ = 0;
+            out = static_cast<char>(code);
+            return true;
+        } else if (code < 0x800) {
+            pending_[0] = static_cast<char>(0x80 | (code & 0x3F));
+            pending_len_ = 1;
+            out = static_cast<char>(0xC0 | (code >> 6));
+        } else {
+            pending_[0] = static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+            pending_[1] = static_cast<char>(0x80 | (code & 0x3F));
+            pending_len_ = 2;
+            out = static_cast<char>(0xE0 | (code >> 12));
+        }
+        return true;
+    }
+
+    const char* p_;
+    const char* end_;
+    char pending_[2] = {0, 0};
+    int pending_len_ = 0;
+    int pending_pos_ = 0;
+};
+
+// Three-way comparison of a raw JSON string with a decoded literal
+int compareJsonString(std::string_view raw, std::string_view literal) {
+    if (raw.find('\\') == std::string_view::npos) {
+        return raw.compare(literal);
+    }
+
+    EscapedStringReader reader(raw);
+    size_t i = 0;
+    char c;
+    while (reader.next(c)) {
+        if (i >= literal.size()) {
+            return 1;
+        }
+        auto a = static_cast<unsigned char>(c);
+        auto b = static_cast<unsigned char>(literal[i]);
+        if (a != b) {
+            return a < b ? -1 : 1;
+        }
+        ++i;
+    }
+    return i < literal.size() ? -1 : 0;
+}
+
+bool parseNumber(std::string_view raw, double& out) {
+    const char* begin = raw.data();
+    const char* end = raw.data() + raw.size();
+    auto result = std::from_chars(begin, end, out);
+    return result.ec == std::errc() && result.ptr == end;
+}
+
+} // namespace
+
+// === JsonScanner ===
+
+const char* JsonScanner::findQuoteOrBackslash(const char* p, const char* end) {
+#ifdef JSON_QUERY_HAVE_SSE2
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    while (end - p >= 16) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        __m128i hits = _mm_or_si128(_mm_cmpeq_epi8(chunk, quote),
+                                    _mm_cmpeq_epi8(chunk, backslash));
+        unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(hits));
+        if (mask != 0) {
+            return p + countTrailingZeros(mask);
+        }
+        p += 16;
+    }
+#endif
+    while (p < end && *p != '"' && *p != '\\') {
+        ++p;
+    }
+    return p;
+}
+
+const char* JsonScanner::findStructural(const char* p, const char* end) {
+#ifdef JSON_QUERY_HAVE_SSE2
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i open_brace = _mm_set1_epi8('{');
+    const __m128i close_brace = _mm_set1_epi8('}');
+    const __m128i open_bracket = _mm_set1_epi8('[');
+    const __m128i close_bracket = _mm_set1_epi8(']');
+    while (end - p >= 16) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        __m128i hits = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(chunk, quote), _mm_cmpeq_epi8(chunk, open_brace)),
+            _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, close_brace),
+                                      _mm_cmpeq_epi8(chunk, open_bracket)),
+                         _mm_cmpeq_epi8(chunk, close_bracket)));
+        unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(hits));
+        if (mask != 0) {
+            return p + countTrailingZeros(mask);
+        }
+        p += 16;
+    }
+#endif
+    while (p < end && *p != '"' && *p != '{' && *p != '}' && *p != '[' && *p != ']') {
+        ++p;
+    }
+    return p;
+}
+
+std::string_view JsonScanner::payload(std::string_view line) {
+    return payloadFrom(line, 0);
+}
+
+std::string_view JsonScanner::nextPayload(std::string_view line, std::string_view json) {
+    // Past the whole object, so its nested objects are not tried on their own
+    const char* after = skipContainer(json.data(), line.data() + line.size());
+    return payloadFrom(line, static_cast<size_t>(after - line.data()));
+}
+
+JsonScanner::Value JsonScanner::findInLine(std::string_view line,
+                                           const std::vector<std::string>& path) {
+    for (auto json = payload(line); !json.empty(); json = nextPayload(line, json)) {
+        Value value = find(json, path);
+        if (value.type != ValueType::None) {
+            return value;
+        }
+    }
+    return {};
+}
+
+std::string_view JsonScanner::payloadFrom(std::string_view line, size_t from) {
+    // Braces in a plain-text prefix ("ctx={id=42}") are not an object: an
+    // object opens with a key or closes at once
+    const char* end = line.data() + line.size();
+    for (size_t start = line.find('{', from); start != std::string_view::npos; start = line.find('{', start + 1)) {
+        const char* next = skipWhitespace(line.data() + start + 1, end);
+        if (next < end && (*next == '"' || *next == '}')) {
+            return line.substr(start);
+        }
+    }
+    return std::string_view();
+}
+
+const char* JsonScanner::skipWhitespace(const char* p, const char* end) {
+    while (p < end && isJsonWhitespace(*p)) {
+        ++p;
+    }
+    return p;
+}
+
+// p points just after the opening quote; returns position of the closing quote
+const char* JsonScanner::skipString(const char* p, const char* end) {
+    while (p < end) {
+        p = findQuoteOrBackslash(p, end);
+        if (p >= end) {
+            return end;
+        }
+        if (*p == '"') {
+            return p;
+        }
+        p = end - p > 2 ? p + 2 : end;  // Skip the escaped character; never past a trailing backslash
+    }
+    return end;
+}
+
+// p points at '{' or '['; returns position just after the matching bracket
+const char* JsonScanner::skipContainer(const char* p, const char* end) {
+    int depth = 0;
+    while (p < end) {
+        p = findStructural(p, end);
+        if (p >= end) {
+            return end;
+        }
+        switch (*p) {
+            case '"':
+                p = skipString(p + 1, end);
+                if (p >= end) {
+                    return end;
+                }
+                break;
+            case '{':
+            case '[':
+                ++depth;
+                break;
+            default:  // '}' or ']'
+                if (--depth == 0) {
+                    return p + 1;
+                }
+                break;
+        }
+        ++p;
+    }
+    return end;
+}
+
+// p points at the first character of a value; returns position just after it
+const char* JsonScanner::skipValue(const char* p, const char* end) {
+    if (p >= end) {
+        return end;
+    }
+    if (*p == '"') {
+        const char* close = skipString(p + 1, end);
+        return close < end ? close + 1 : end;
+    }
+    if (*p == '{' || *p == '[') {
+        return skipContainer(p, end);
+    }
+    // Number or literal: runs until a delimiter
+    while (p < end && *p != ',' && *p != '}' && *p != ']' && !isJsonWhitespace(*p)) {
+        ++p;
+    }
+    return p;
+}
+
+JsonScanner::Value JsonScanner::find(std::string_view json,
+                                     const std::vector<std::string>& path) {
+    const char* p = json.data();
+    const char* end = json.data() + json.size();
+
+    for (size_t depth = 0; depth < path.size(); ++depth) {
+        p = skipWhitespace(p, end);
+        if (p >= end || *p != '{') {
+            return {};
+        }
+        ++p;
+
+        const std::string& key = path[depth];
+        bool found = false;
+
+        // Walk the members of this object until the key is found
+        while (p < end) {
+            p = skipWhitespace(p, end);
+            if (p >= end || *p == '}') {
+                return {};
+            }
+            if (*p != '"') {
+                return {};
+            }
+
+            const char* key_begin = p + 1;
+            const char* key_end = skipString(key_begin, end);
+            if (key_end >= end) {
+                return {};
+            }
+            std::string_view member(key_begin, static_cast<size_t>(key_end - key_begin));
+
+            p = skipWhitespace(key_end + 1, end);
+            if (p >= end || *p != ':') {
+                return {};
+            }
+            p = skipWhitespace(p + 1, end);
+
+            if (compareJsonString(member, key) == 0) {
+                found = true;
+                break;
+            }
+
+            p = skipWhitespace(skipValue(p, end), end);
+            if (p < end && *p == ',') {
+                ++p;
+            }
+        }
+
+        if (!found) {
+            return {};
+        }
+    }
+
+    // p points at the value for the final key (or the root for an empty path)
+    p = skipWhitespace(p, end);
+    if (p >= end) {
+        return {};
+    }
+
+    Value value;
+    if (*p == '"') {
+        // An unterminated string is no value rather than a truncated one
+        const char* close = skipString(p + 1, end);
+        if (close >= end) {
+            return {};
+        }
+        value.type = ValueType::String;
+        value.raw = std::string_view(p + 1, static_cast<size_t>(close - (p + 1)));
+        return value;
+    }
+
+    const char* value_end = skipValue(p, end);
+    switch (*p) {
+        case '{': value.type = ValueType::Object; break;
+        case '[': value.type = ValueType::Array; break;
+        case 't': value.type = ValueType::True; break;
+        case 'f': value.type = ValueType::False; break;
+        case 'n': value.type = ValueType::Null; break;
+        default:  value.type = ValueType::Number; break;
+    }
+    value.raw = std::string_view(p, static_cast<size_t>(value_end - p));
+    return value;
+}
+
+// === JsonQuery parser ===
+
+struct JsonQuery::Parser {
+    std::string_view input;
+    size_t pos = 0;
+    std::vector<Node>& nodes;
+    std::string error;
+
+    Parser(std::string_view text, std::vector<Node>& out) : input(text), nodes(out) {}
+
+    void skipSpaces() {
+        while (pos < input.size() && (input[pos] == ' ' || input[pos] == '\t')) {
+            ++pos;
+        }
+    }
+
+    bool consume(std::string_view token) {
+        skipSpaces();
+        if (input.substr(pos, token.size()) == token) {
+            pos += token.size();
+            return true;
+        }
+        return false;
+    }
+
+    bool fail(const std::string& message) {
+        if (error.empty()) {
+            error = message + " at position " + std::to_string(pos);
+        }
+        return false;
+    }
+
+    static bool isIdentChar(char c) {
+        return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+               (c >= '0' && c <= '9') || c == '_' || c == '-' || c == '$' || c == '@';
+    }
+
+    bool parseQuoted(std::string& out) {
+        // input[pos] == '"'
+        ++pos;
+        size_t start = pos;
+        while (pos < input.size() && input[pos] != '"') {
+            if (input[pos] == '\\') {
+                ++pos;
+            }
+            ++pos;
+        }
+        if (pos >= input.size()) {
+            return fail("Unterminated string");
+        }
+
+        EscapedStringReader reader(input.substr(start, pos - start));
+        char c;
+        while (reader.next(c)) {
+            out.push_back(c);
+        }
+        ++pos;
+        return true;
+    }
+
+    bool parsePath(std::vector<std::string>& path) {
+        skipSpaces();
+        while (true) {
+            std::string key;
+            if (pos < input.size() && input[pos] == '"') {
+                if (!parseQuoted(key)) {
+                    return false;
+                }
+            } else {
+                size_t start = pos;
+                while (pos < input.size() && isIdentChar(input[pos])) {
+                    ++pos;
+                }
+                if (pos == start) {
+                    return fail("Expected field name");
+                }
+                key = std::string(input.substr(start, pos - start));
+            }
+            path.push_back(std::move(key));
+
+            if (pos >= input.size() || input[pos] != '.') {
+                return true;
+            }
+            ++pos;
+        }
+    }
+
+    bool parseLiteral(Literal& literal) {
+        skipSpaces();
+        if (pos >= input.size()) {
+            return fail("Expected value");
+        }
+        if (input[pos] == '"') {
+            literal.type = JsonScanner::ValueType::String;
+            return parseQuoted(literal.text);
+        }
+        if (consume("true")) { literal.type = JsonScanner::ValueType::True; return true; }
+        if (consume("false")) { literal.type = JsonScanner::ValueType::False; return true; }
+        if (consume("null")) { literal.type = JsonScanner::ValueType::Null; return true; }
+
+        size_t start = pos;
+        while (pos < input.size() &&
+               ((input[pos] >= '0' && input[pos] <= '9') || input[pos] == '-' ||
+                input[pos] == '+' || input[pos] == '.' || input[pos] == 'e' ||
+                input[pos] == 'E')) {
+            ++pos;
+        }
+        if (pos == start || !parseNumber(input.substr(start, pos - start), literal.number)) {
+            return fail("Expected string, number, true, false or null");
+        }
+        literal.type = JsonScanner::ValueType::Number;
+        return true;
+    }
+
+    int addNode(Node node) {
+        nodes.push_back(std::move(node));
+        return static_cast<int>(nodes.size()) - 1;
+    }
+
+    int parsePredicate() {
+        Node node;
+        node.kind = NodeKind::Predicate;
+        if (!parsePath(node.path)) {
+            return -1;
+        }
+
+        skipSpaces();
+        static const std::pair<std::string_view, Op> ops[] = {
+            {"==", Op::Eq}, {"!=", Op::Ne}, {"<=", Op::Le},
+            {">=", Op::Ge}, {"<", Op::Lt}, {">", Op::Gt}
+        };
+        node.op = Op::Exists;
+        for (const auto& [token, op] : ops) {
+            if (consume(token)) {
+                node.op = op;
+                break;
+            }
+        }
+
+        if (node.op != Op::Exists && !parseLiteral(node.literal)) {
+            return -1;
+        }
+        return addNode(std::move(node));
+    }
+
+    int parseUnary() {
+        if (consume("!")) {
+            int operand = parseUnary();
+            if (operand < 0) {
+                return -1;
+            }
+            Node node;
+            node.kind = NodeKind::Not;
+            node.lhs = operand;
+            return addNode(std::move(node));
+        }
+        if (consume("(")) {
+            int inner = parseOr();
+            if (inner < 0) {
+                return -1;
+            }
+            if (!consume(")")) {
+                fail("Expected ')'");
+                return -1;
+            }
+            return inner;
+        }
+        return parsePredicate();
+    }
+
+    int parseBinary(NodeKind kind, std::string_view token, int (Parser::*next)()) {
+        int lhs = (this->*next)();
+        while (lhs >= 0 && consume(token)) {
+            int rhs = (this->*next)();
+            if (rhs < 0) {
+                return -1;
+            }
+            Node node;
+            node.kind = kind;
+            node.lhs = lhs;
+            node.rhs = rhs;
+            lhs = addNode(std::move(node));
+        }
+        return lhs;
+    }
+
+    int parseAnd() { return parseBinary(NodeKind::And, "&&", &Parser::parseUnary); }
+    int parseOr() { return parseBinary(NodeKind::Or, "||", &Parser::parseAnd); }
+};
+
+bool JsonQuery::compile(std::string_view expression) {
+    nodes_.clear();
+    required_literals_.clear();
+    error_message_.clear();
+    root_ = -1;
+
+    Parser parser(expression, nodes_);
+    int root = parser.parseOr();
+    parser.skipSpaces();
+    if (root >= 0 && parser.pos != expression.size()) {
+        parser.fail("Unexpected input");
+        root = -1;
+    }
+    if (root < 0) {
+        error_message_ = parser.error.empty() ? "Invalid query" : parser.error;
+        nodes_.clear();
+        return false;
+    }
+
+    root_ = root;
+    required_literals_ = collectRequired(root_);
+    return true;
+}
+
+// Keys that must literally occur in any line satisfying the subtree
+std::vector<std::string> JsonQuery::collectRequired(int index) const {
+    const Node& node = nodes_[index];
+    switch (node.kind) {
+        case NodeKind::Predicate: {
+            std::vector<std::string> literals;
+            for (const auto& key : node.path) {
+                // Keys containing escapable characters may be spelled differently
+                if (key.find_first_of("\"\\/") == std::string::npos &&
+                    std::all_of(key.begin(), key.end(),
+                                [](char c) { return static_cast<unsigned char>(c) >= 0x20; })) {
+                    literals.push_back("\"" + key + "\"");
+                }
+            }
+            return literals;
+        }
+        case NodeKind::And: {
+            auto lhs = collectRequired(node.lhs);
+            auto rhs = collectRequired(node.rhs);
+            for (auto& literal : rhs) {
+                if (std::find(lhs.begin(), lhs.end(), literal) == lhs.end()) {
+                    lhs.push_back(std::move(literal));
+                }
+            }
+            return lhs;
+        }
+        case NodeKind::Or: {
+            auto lhs = collectRequired(node.lhs);
+            auto rhs = collectRequired(node.rhs);
+            std::vector<std::string> common;
+            for (auto& literal : lhs) {
+                if (std::find(rhs.begin(), rhs.end(), literal) != rhs.end()) {
+                    common.push_back(std::move(literal));
+                }
+            }
+            return common;
+        }
+        case NodeKind::Not:
+        default:
+            return {};
+    }
+}
+
+bool JsonQuery::matches(std::string_view line) const {
+    if (root_ < 0) {
+        return false;
+    }
+
+    // Cheap literal prefilter before touching the JSON structure
+    for (const auto& literal : required_literals_) {
+        if (line.find(literal) == std::string_view::npos) {
+            return false;
+        }
+    }
+
+    // "msg={} {...}": an object that fails is not the last word
+    for (auto json = JsonScanner::payload(line); !json.empty(); json = JsonScanner::nextPayload(line, json)) {
+        if (evaluate(root_, json)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool JsonQuery::evaluate(int index, std::string_view json) const {
+    const Node& node = nodes_[index];
+    switch (node.kind) {
+        case NodeKind::And:
+            return evaluate(node.lhs, json) && evaluate(node.rhs, json);
+        case NodeKind::Or:
+            return evaluate(node.lhs, json) || evaluate(node.rhs, json);
+        case NodeKind::Not:
+            return !evaluate(node.lhs, json);
+        case NodeKind::Predicate:
+        default:
+            return evaluatePredicate(node, json);
+    }
+}
+
+bool JsonQuery::evaluatePredicate(const Node& node, std::string_view json) const {
+    using ValueType = JsonScanner::ValueType;
+
+    JsonScanner::Value value = JsonScanner::find(json, node.path);
+    if (value.type == ValueType::None) {
+        return false;  // Missing fields never match, not even "!="
+    }
+    if (node.op == Op::Exists) {
+        return true;
+    }
+
+    const Literal& literal = node.literal;
+    int order = 0;
+    bool comparable = false;
+
+    if (value.type == ValueType::String && literal.type == ValueType::String) {
+        order = compareJsonString(value.raw, literal.text);
+        comparable = true;
+    } else if (value.type == ValueType::Number && literal.type == ValueType::Number) {
+        double number = 0.0;
+        if (parseNumber(value.raw, number)) {
+            order = number < literal.number ? -1 : (number > literal.number ? 1 : 0);
+            comparable = true;
+        }
+    } else if (value.type == literal.type &&
+               (value.type == ValueType::True || value.type == ValueType::False ||
+                value.type == ValueType::Null)) {
+        comparable = true;
+    }
+
+    switch (node.op) {
+        case Op::Eq: return comparable && order == 0;
+        case Op::Ne: return !comparable || order != 0;
+        case Op::Lt: return comparable && order < 0;
+        case Op::Le: return comparable && order <= 0;
+        case Op::Gt: return comparable && order > 0;
+        case Op::Ge: return comparable && order >= 0;
+        default:     return true;
+    }
+}
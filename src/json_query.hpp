@@ -0,0 +1,109 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+// Lazy, allocation-free scanner for the JSON payload embedded in a log line.
+// It never builds a DOM: it walks the object only as far as the requested
+// path and skips every other value with SIMD-accelerated scanning.
+class JsonScanner {
+public:
+    enum class ValueType {
+        None,      // Path not found / malformed input
+        Object,
+        Array,
+        String,    // raw points at the contents between the quotes (still escaped)
+        Number,
+        True,
+        False,
+        Null
+    };
+
+    struct Value {
+        ValueType type = ValueType::None;
+        std::string_view raw;
+    };
+
+    // Locate the JSON object inside a log line: the first '{' followed by a
+    // key or '}', up to the end of the line. Empty if none
+    static std::string_view payload(std::string_view line);
+
+    // The next object of `line` after `json` (one of its payloads), empty
+    // if none: a line such as msg={} {"status": 500} carries two
+    static std::string_view nextPayload(std::string_view line, std::string_view json);
+
+    // find() in each payload of the line in turn, until one has the path
+    static Value findInLine(std::string_view line, const std::vector<std::string>& path);
+
+    // Resolve a dotted path (already split into keys) inside a JSON object
+    static Value find(std::string_view json, const std::vector<std::string>& path);
+
+    // Position of the next '"' or '\\' at or after p (end if none)
+    static const char* findQuoteOrBackslash(const char* p, const char* end);
+
+    // Position of the next '"', '{', '}', '[' or ']' at or after p (end if none)
+    static const char* findStructural(const char* p, const char* end);
+
+private:
+    static std::string_view payloadFrom(std::string_view line, size_t from);
+    static const char* skipWhitespace(const char* p, const char* end);
+    static const char* skipString(const char* p, const char* end);
+    static const char* skipValue(const char* p, const char* end);
+    static const char* skipContainer(const char* p, const char* end);
+};
+
+// Field predicates over the JSON part of a line, e.g.
+//   endpoint == "/api/users" && body.age > 25
+// Supported: == != < <= > >=, bare paths (existence), &&, ||, !, parentheses.
+// Literals: "strings", numbers, true, false, null.
+class JsonQuery {
+public:
+    JsonQuery() = default;
+
+    // Parse expression; returns false and sets error on syntax errors
+    bool compile(std::string_view expression);
+
+    // Evaluate the query against a whole log line: true if any of its
+    // JSON objects satisfies it
+    bool matches(std::string_view line) const;
+
+    // Key literals ("key" with quotes) every matching line must contain
+    const std::vector<std::string>& requiredLiterals() const { return required_literals_; }
+
+    bool isValid() const { return root_ >= 0; }
+    const std::string& getError() const { return error_message_; }
+
+private:
+    enum class Op : uint8_t { Exists, Eq, Ne, Lt, Le, Gt, Ge };
+    enum class NodeKind : uint8_t { Predicate, And, Or, Not };
+
+    struct Literal {
+        JsonScanner::ValueType type = JsonScanner::ValueType::None;
+        std::string text;    // Decoded string for String literals
+        double number = 0.0;
+    };
+
+    struct Node {
+        NodeKind kind = NodeKind::Predicate;
+        int lhs = -1;
+        int rhs = -1;
+        Op op = Op::Exists;
+        std::vector<std::string> path;
+        Literal literal;
+    };
+
+    // Recursive-descent parser state
+    struct Parser;
+
+    bool evaluate(int node, std::string_view json) const;
+    bool evaluatePredicate(const Node& node, std::string_view json) const;
+    std::vector<std::string> collectRequired(int node) const;
+
+    std::vector<Node> nodes_;
+    int root_ = -1;
+    std::vector<std::string> required_literals_;
+    std::string error_message_;
+};
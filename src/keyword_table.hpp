@@ -0,0 +1,159 @@
+#pragma once
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <utility>
+
+// Case-insensitive perfect hash table built entirely at compile time.
+// Lookups hash the word twice (bucket seed, then slot), probe a single slot
+// and compare in place, so classifying a token never allocates or upper-cases
+// a copy.
+
+struct KeywordEntry {
+    std::string_view word;
+    uint8_t value;
+};
+
+constexpr char asciiUpper(char c) {
+    return (c >= 'a' && c <= 'z') ? static_cast<char>(c - 'a' + 'A') : c;
+}
+
+constexpr bool equalsIgnoreCase(std::string_view a, std::string_view b) {
+    if (a.size() != b.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (asciiUpper(a[i]) != asciiUpper(b[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+constexpr uint32_t keywordHash(std::string_view word, uint32_t seed) {
+    uint32_t hash = 2166136261u ^ seed;
+    for (char c : word) {
+        hash ^= static_cast<uint8_t>(asciiUpper(c));
+        hash *= 16777619u;
+    }
+    hash ^= hash >> 15;
+    hash *= 0x2c1b3c6du;
+    hash ^= hash >> 12;
+    return hash;
+}
+
+template <size_t Size>
+class KeywordTable {
+public:
+    static constexpr int NOT_FOUND = -1;
+    static constexpr size_t BUCKETS = Size / 2;
+
+    // Returns the entry value, or NOT_FOUND
+    constexpr int find(std::string_view word) const {
+        if (word.empty() || word.size() > max_length_) {
+            return NOT_FOUND;
+        }
+        uint32_t seed = seeds_[keywordHash(word, 0) & (BUCKETS - 1)];
+        size_t slot = keywordHash(word, seed) & (Size - 1);
+        if (used_[slot] && equalsIgnoreCase(keys_[slot], word)) {
+            return values_[slot];
+        }
+        return NOT_FOUND;
+    }
+
+    constexpr bool contains(std::string_view word) const {
+        return find(word) != NOT_FOUND;
+    }
+
+    template <size_t N>
+    friend consteval auto makeKeywordTable(const std::array<KeywordEntry, N>& entries);
+
+private:
+    std::array<std::string_view, Size> keys_{};
+    std::array<uint8_t, Size> values_{};
+    std::array<bool, Size> used_{};
+    std::array<uint32_t, BUCKETS> seeds_{};
+    size_t max_length_ = 0;
+};
+
+// Hash-and-displace construction: entries are grouped into buckets by a
+// first hash, then each bucket (largest first) searches for a seed that puts
+// all of its entries into free slots. Runs in the compiler; a set that cannot
+// be hashed is a compile error, not a runtime one.
+template <size_t N>
+consteval auto makeKeywordTable(const std::array<KeywordEntry, N>& entries) {
+    constexpr size_t size = std::bit_ceil(N * 2);
+    using Table = KeywordTable<size>;
+    Table table;
+
+    std::array<size_t, N> bucket_of{};
+    std::array<size_t, Table::BUCKETS> bucket_size{};
+    for (size_t i = 0; i < N; ++i) {
+        bucket_of[i] = keywordHash(entries[i].word, 0) & (Table::BUCKETS - 1);
+        ++bucket_size[bucket_of[i]];
+        if (entries[i].word.size() > table.max_length_) {
+            table.max_length_ = entries[i].word.size();
+        }
+    }
+
+    std::array<size_t, Table::BUCKETS> order{};
+    for (size_t b = 0; b < Table::BUCKETS; ++b) {
+        order[b] = b;
+    }
+    for (size_t i = 0; i < Table::BUCKETS; ++i) {
+        for (size_t j = i + 1; j < Table::BUCKETS; ++j) {
+            if (bucket_size[order[j]] > bucket_size[order[i]]) {
+                std::swap(order[i], order[j]);
+            }
+        }
+    }
+
+    for (size_t bucket : order) {
+        if (bucket_size[bucket] == 0) {
+            break;
+        }
+
+        bool placed = false;
+        for (uint32_t seed = 1; seed < 100000 && !placed; ++seed) {
+            std::array<size_t, N> slots{};
+            size_t count = 0;
+            bool collision = false;
+
+            for (size_t i = 0; i < N && !collision; ++i) {
+                if (bucket_of[i] != bucket) {
+                    continue;
+                }
+                size_t slot = keywordHash(entries[i].word, seed) & (size - 1);
+                collision = table.used_[slot];
+                for (size_t k = 0; k < count && !collision; ++k) {
+                    collision = slots[k] == slot;
+                }
+                slots[count++] = slot;
+            }
+
+            if (collision) {
+                continue;
+            }
+
+            table.seeds_[bucket] = seed;
+            for (size_t i = 0, k = 0; i < N; ++i) {
+                if (bucket_of[i] == bucket) {
+                    size_t slot = slots[k++];
+                    table.keys_[slot] = entries[i].word;
+                    table.values_[slot] = entries[i].value;
+                    table.used_[slot] = true;
+                }
+            }
+            placed = true;
+        }
+
+        if (!placed) {
+            throw "makeKeywordTable: no collision-free seed found";
+        }
+    }
+
+    return table;
+}
@@ -0,0 +1,164 @@
+#include "literal_search.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__AVX2__)
+    #include <immintrin.h>
+    #define LITERAL_SEARCH_AVX2 1
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #include <emmintrin.h>
+    #define LITERAL_SEARCH_SSE2 1
+#endif
+
+#if defined(_MSC_VER)
+    #include <intrin.h>
+#endif
+
+namespace {
+
+#if defined(LITERAL_SEARCH_AVX2) || defined(LITERAL_SEARCH_SSE2)
+    #define LITERAL_SEARCH_SIMD 1
+#endif
+
+#if defined(LITERAL_SEARCH_AVX2)
+
+constexpr size_t BLOCK = 32;
+
+// Bit i set when block[i] == first and block[i + distance] == last
+inline uint32_t candidates(const char* block, char first, char last, size_t distance) {
+    const __m256i head = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block));
+    const __m256i tail = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block + distance));
+    const __m256i both = _mm256_and_si256(_mm256_cmpeq_epi8(head, _mm256_set1_epi8(first)),
+                                          _mm256_cmpeq_epi8(tail, _mm256_set1_epi8(last)));
+    return static_cast<uint32_t>(_mm256_movemask_epi8(both));
+}
+
+#elif defined(LITERAL_SEARCH_SSE2)
+
+constexpr size_t BLOCK = 16;
+
+inline uint32_t candidates(const char* block, char first, char last, size_t distance) {
+    const __m128i head = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block));
+    const __m128i tail = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + distance));
+    const __m128i both = _mm_and_si128(_mm_cmpeq_epi8(head, _mm_set1_epi8(first)),
+                                       _mm_cmpeq_epi8(tail, _mm_set1_epi8(last)));
+    return static_cast<uint32_t>(_mm_movemask_epi8(both));
+}
+
+#endif
+
+#if defined(LITERAL_SEARCH_SIMD)
+
+inline int lowestBit(uint32_t mask) {
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return static_cast<int>(index);
+#else
+    return __builtin_ctz(mask);
+#endif
+}
+
+inline int highestBit(uint32_t mask) {
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanReverse(&index, mask);
+    return static_cast<int>(index);
+#else
+    return 31 - __builtin_clz(mask);
+#endif
+}
+
+#endif
+
+} // namespace
+
+LiteralSearcher::LiteralSearcher(std::string needle)
+    : needle_(std::move(needle)) {
+}
+
+bool LiteralSearcher::matchesAt(const char* candidate) const {
+    // First and last bytes are already known to match
+    return needle_.size() <= 2 ||
+           std::memcmp(candidate + 1, needle_.data() + 1, needle_.size() - 2) == 0;
+}
+
+size_t LiteralSearcher::find(std::string_view haystack, size_t from) const {
+    const size_t n = needle_.size();
+    if (n == 0) {
+        return from <= haystack.size() ? from : npos;
+    }
+    if (from >= haystack.size() || haystack.size() - from < n) {
+        return npos;
+    }
+
+    size_t i = from;
+
+#if defined(LITERAL_SEARCH_SIMD)
+    const char first = needle_.front();
+    const char last = needle_.back();
+    const char* data = haystack.data();
+
+    // Both loads of a block must stay inside the haystack
+    while (i + BLOCK + n - 1 <= haystack.size()) {
+        uint32_t mask = candidates(data + i, first, last, n - 1);
+        while (mask != 0) {
+            int bit = lowestBit(mask);
+            if (matchesAt(data + i + bit)) {
+                return i + static_cast<size_t>(bit);
+            }
+            mask &= mask - 1;
+        }
+        i += BLOCK;
+    }
+#endif
+
+    return haystack.find(needle_, i);
+}
+
+size_t LiteralSearcher::rfind(std::string_view haystack, size_t before) const {
+    const size_t n = needle_.size();
+    if (n == 0 || haystack.size() < n) {
+        return npos;
+    }
+
+    // Candidate starts are [0, limit)
+    size_t limit = std::min(before, haystack.size() - n + 1);
+    size_t i = limit;
+
+#if defined(LITERAL_SEARCH_SIMD)
+    const char first = needle_.front();
+    const char last = needle_.back();
+    const char* data = haystack.data();
+
+    while (i >= BLOCK) {
+        const char* block = data + i - BLOCK;
+        uint32_t mask = candidates(block, first, last, n - 1);
+        while (mask != 0) {
+            int bit = highestBit(mask);
+            if (matchesAt(block + bit)) {
+                return i - BLOCK + static_cast<size_t>(bit);
+            }
+            mask &= ~(1u << bit);
+        }
+        i -= BLOCK;
+    }
+#endif
+
+    if (i == 0) {
+        return npos;
+    }
+    // Remaining starts [0, i)
+    return haystack.substr(0, i - 1 + n).rfind(needle_);
+}
+
+const char* LiteralSearcher::implementation() {
+#if defined(LITERAL_SEARCH_AVX2)
+    return "avx2";
+#elif defined(LITERAL_SEARCH_SSE2)
+    return "sse2";
+#else
+    return "scalar";
+#endif
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+// Substring search over raw bytes. Candidate positions, where both the first
+// and the last byte of the needle match, are found 16/32 bytes at a time
+// (the "generic SIMD" strstr); only those are verified with memcmp.
+class LiteralSearcher {
+public:
+    static constexpr size_t npos = std::string_view::npos;
+
+    LiteralSearcher() = default;
+    explicit LiteralSearcher(std::string needle);
+
+    // First occurrence starting at or after `from`; npos if none
+    size_t find(std::string_view haystack, size_t from = 0) const;
+
+    // Last occurrence starting before `before`; npos if none
+    size_t rfind(std::string_view haystack, size_t before = npos) const;
+
+    const std::string& needle() const { return needle_; }
+    bool empty() const { return needle_.empty(); }
+
+    // True when a regex pattern has no metacharacters, i.e. matches itself
+    static bool isLiteralPattern(std::string_view pattern) {
+        return pattern.find_first_of(".^$|()[]{}*+?\\") == std::string_view::npos;
+    }
+
+    // Name of the vector path compiled in ("avx2", "sse2" or "scalar")
+    static const char* implementation();
+
+private:
+    bool matchesAt(const char* candidate) const;
+
+    std::string needle_;
+};
@@ -0,0 +1,348 @@
+#include "log_fields.hpp"
+#include "parallel.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <thread>
+
+namespace {
+
+constexpr int64_t MICROS_PER_SECOND = 1000000;
+constexpr int64_t SECONDS_PER_DAY = 86400;
+
+// Days between 1970-01-01 and a proleptic Gregorian date
+int64_t daysFromCivil(int64_t year, unsigned month, unsigned day) {
+    year -= month <= 2;
+    int64_t era = (year >= 0 ? year : year - 399) / 400;
+    unsigned year_of_era = static_cast<unsigned>(year - era * 400);
+    unsigned day_of_year = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+    unsigned day_of_era = year_of_era * 365 + year_of_era / 4 - year_of_era / 100 + day_of_year;
+    return era * 146097 + static_cast<int64_t>(day_of_era) - 719468;
+}
+
+void civilFromDays(int64_t days, int64_t& year, unsigned& month, unsigned& day) {
+    days += 719468;
+    int64_t era = (days >= 0 ? days : days - 146096) / 146097;
+    unsigned day_of_era = static_cast<unsigned>(days - era * 146097);
+    unsigned year_of_era = (day_of_era - day_of_era / 1460 + day_of_era / 36524 - day_of_era / 146096) / 365;
+    unsigned day_of_year = day_of_era - (365 * year_of_era + year_of_era / 4 - year_of_era / 100);
+    unsigned shifted_month = (5 * day_of_year + 2) / 153;
+    day = day_of_year - (153 * shifted_month + 2) / 5 + 1;
+    month = shifted_month < 10 ? shifted_month + 3 : shifted_month - 9;
+    year = static_cast<int64_t>(year_of_era) + era * 400 + (month <= 2);
+}
+
+// Fixed-width decimal field at `pos`
+bool readDigits(std::string_view text, size_t pos, size_t count, unsigned& value) {
+    if (pos + count > text.size()) {
+        return false;
+    }
+    value = 0;
+    for (size_t i = pos; i < pos + count; ++i) {
+        unsigned digit = static_cast<unsigned char>(text[i]) - '0';
+        if (digit > 9) {
+            return false;
+        }
+        value = value * 10 + digit;
+    }
+    return true;
+}
+
+// "YYYY-MM-DD[ T]HH:MM:SS[.fraction][Z|±HH:MM]" at `pos`; advances past it
+bool parseTimestamp(std::string_view line, size_t& pos, int64_t& micros) {
+    unsigned year, month, day, hour, minute, second;
+    size_t p = pos;
+    if (p + 19 > line.size()) {
+        return false;
+    }
+    if (!readDigits(line, p, 4, year) || line[p + 4] != '-' ||
+        !readDigits(line, p + 5, 2, month) || line[p + 7] != '-' ||
+        !readDigits(line, p + 8, 2, day) ||
+        (line[p + 10] != ' ' && line[p + 10] != 'T') ||
+        !readDigits(line, p + 11, 2, hour) || line[p + 13] != ':' ||
+        !readDigits(line, p + 14, 2, minute) || line[p + 16] != ':' ||
+        !readDigits(line, p + 17, 2, second)) {
+        return false;
+    }
+    if (month < 1 || month > 12 || day < 1 || day > 31 || hour > 23 || minute > 59 || second > 60) {
+        return false;
+    }
+    p += 19;
+
+    // Fraction: keep microseconds, skip finer digits
+    int64_t fraction = 0;
+    if (p < line.size() && (line[p] == '.' || line[p] == ',')) {
+        ++p;
+        int64_t scale = 100000;
+        while (p < line.size() && line[p] >= '0' && line[p] <= '9') {
+            fraction += (line[p] - '0') * scale;
+            scale /= 10;
+            ++p;
+        }
+    }
+
+    int64_t offset_seconds = 0;
+    if (p < line.size() && line[p] == 'Z') {
+        ++p;
+    } else if (p < line.size() && (line[p] == '+' || line[p] == '-')) {
+        unsigned offset_hours, offset_minutes;
+        size_t minutes_at = p + 3 < line.size() && line[p + 3] == ':' ? p + 4 : p + 3;
+        if (readDigits(line, p + 1, 2, offset_hours) && readDigits(line, minutes_at, 2, offset_minutes)) {
+            offset_seconds = (offset_hours * 3600 + offset_minutes * 60) * (line[p] == '+' ? 1 : -1);
+            p = minutes_at + 2;
+        }
+    }
+
+    int64_t seconds = daysFromCivil(year, month, day) * SECONDS_PER_DAY +
+                      hour * 3600 + minute * 60 + second - offset_seconds;
+    micros = seconds * MICROS_PER_SECOND + fraction;
+    pos = p;
+    return true;
+}
+
+// Level word at `pos` ("ERROR", "[warn]", "Info"); advances past it
+bool parseLevel(std::string_view line, size_t& pos, LogLevel& level) {
+    static const std::pair<std::string_view, LogLevel> NAMES[] = {
+        {"TRACE", LogLevel::Trace}, {"DEBUG", LogLevel::Debug}, {"INFO", LogLevel::Info},
+        {"WARN", LogLevel::Warn}, {"WARNING", LogLevel::Warn}, {"ERROR", LogLevel::Error},
+        {"FATAL", LogLevel::Fatal}, {"CRITICAL", LogLevel::Fatal},
+    };
+
+    size_t p = pos;
+    bool bracketed = p < line.size() && line[p] == '[';
+    p += bracketed;
+
+    char word[8];
+    size_t length = 0;
+    while (p + length < line.size() && length < sizeof(word)) {
+        char c = line[p + length];
+        if (c >= 'a' && c <= 'z') {
+            c = static_cast<char>(c - 'a' + 'A');
+        } else if (c < 'A' || c > 'Z') {
+            break;
+        }
+        word[length++] = c;
+    }
+
+    // A level is a whole word: "INFORMATION" is not INFO
+    if (p + length < line.size()) {
+        char next = line[p + length];
+        if ((next >= 'a' && next <= 'z') || (next >= 'A' && next <= 'Z')) {
+            return false;
+        }
+    }
+
+    for (const auto& [name, value] : NAMES) {
+        if (std::string_view(word, length) == name) {
+            p += length;
+            if (bracketed) {
+                if (p >= line.size() || line[p] != ']') {
+                    return false;
+                }
+                ++p;
+            }
+            level = value;
+            pos = p;
+            return true;
+        }
+    }
+    return false;
+}
+
+struct SortKey {
+    int64_t value;  // MISSING_KEY: the line has no such field
+    size_t line;
+};
+
+constexpr int64_t MISSING_KEY = INT64_MIN;
+
+// Sorted chunks merged pairwise; every round merges its pairs in parallel
+template <typename Less>
+void parallelSort(std::vector<SortKey>& keys, Less less, size_t workers) {
+    if (workers <= 1) {
+        std::sort(keys.begin(), keys.end(), less);
+        return;
+    }
+
+    std::vector<size_t> bounds;
+    for (size_t i = 0; i <= workers; ++i) {
+        bounds.push_back(keys.size() * i / workers);
+    }
+    parallelFor(workers, workers, [&](size_t, size_t first, size_t last) {
+        for (size_t chunk = first; chunk < last; ++chunk) {
+            std::sort(keys.begin() + static_cast<std::ptrdiff_t>(bounds[chunk]),
+                      keys.begin() + static_cast<std::ptrdiff_t>(bounds[chunk + 1]), less);
+        }
+    }, "sort worker");
+
+    std::vector<SortKey> merged(keys.size());
+    while (bounds.size() > 2) {
+        std::vector<size_t> next_bounds = {0};
+        std::vector<std::thread> pool;
+        for (size_t i = 0; i + 1 < bounds.size(); i += 2) {
+            // An odd run at the end is merged with nothing, i.e. copied
+            size_t begin = bounds[i];
+            size_t middle = bounds[i + 1];
+            size_t end = i + 2 < bounds.size() ? bounds[i + 2] : middle;
+            pool.emplace_back([&keys, &merged, &less, begin, middle, end]() {
+                std::merge(keys.begin() + static_cast<std::ptrdiff_t>(begin),
+                           keys.begin() + static_cast<std::ptrdiff_t>(middle),
+                           keys.begin() + static_cast<std::ptrdiff_t>(middle),
+                           keys.begin() + static_cast<std::ptrdiff_t>(end),
+                           merged.begin() + static_cast<std::ptrdiff_t>(begin), less);
+            });
+            next_bounds.push_back(end);
+        }
+        for (auto& worker : pool) {
+            worker.join();
+        }
+        keys.swap(merged);
+        bounds = std::move(next_bounds);
+    }
+}
+
+} // namespace
+
+LineFields parseLineFields(std::string_view line) {
+    LineFields fields;
+    size_t pos = 0;
+
+    bool bracketed = !line.empty() && line[0] == '[';
+    size_t after_bracket = bracketed ? 1 : 0;
+    if (parseTimestamp(line, after_bracket, fields.timestamp)) {
+        pos = after_bracket;
+        if (bracketed) {
+            if (pos >= line.size() || line[pos] != ']') {
+                return LineFields{};
+            }
+            ++pos;
+        }
+        while (pos < line.size() && line[pos] == ' ') {
+            ++pos;
+        }
+    }
+
+    if (parseLevel(line, pos, fields.level)) {
+        if (pos < line.size() && line[pos] == ':') {
+            ++pos;
+        }
+        while (pos < line.size() && line[pos] == ' ') {
+            ++pos;
+        }
+    }
+
+    fields.message = static_cast<uint32_t>(std::min<size_t>(pos, UINT32_MAX));
+    return fields;
+}
+
+std::string_view levelName(LogLevel level) {
+    switch (level) {
+        case LogLevel::None: return "";
+        case LogLevel::Trace: return "TRACE";
+        case LogLevel::Debug: return "DEBUG";
+        case LogLevel::Info: return "INFO";
+        case LogLevel::Warn: return "WARN";
+        case LogLevel::Error: return "ERROR";
+        case LogLevel::Fatal: return "FATAL";
+    }
+    return "";
+}
+
+std::string formatTimestamp(int64_t timestamp) {
+    char buffer[TIMESTAMP_BUFFER_SIZE];
+    return std::string(buffer, formatTimestamp(timestamp, buffer));
+}
+
+size_t formatTimestamp(int64_t timestamp, char* out) {
+    if (timestamp == LineFields::NO_TIMESTAMP) {
+        out[0] = '\0';
+        return 0;
+    }
+    int64_t seconds = timestamp / MICROS_PER_SECOND;
+    int64_t micros = timestamp % MICROS_PER_SECOND;
+    if (micros < 0) {
+        micros += MICROS_PER_SECOND;
+        --seconds;
+    }
+    int64_t days = seconds / SECONDS_PER_DAY;
+    int64_t second_of_day = seconds % SECONDS_PER_DAY;
+    if (second_of_day < 0) {
+        second_of_day += SECONDS_PER_DAY;
+        --days;
+    }
+
+    int64_t year;
+    unsigned month, day;
+    civilFromDays(days, year, month, day);
+
+    int length = std::snprintf(out, TIMESTAMP_BUFFER_SIZE, "%04lld-%02u-%02u %02d:%02d:%02d.%03d",
+                               static_cast<long long>(year), month, day,
+                               static_cast<int>(second_of_day / 3600),
+                               static_cast<int>(second_of_day / 60 % 60),
+                               static_cast<int>(second_of_day % 60), static_cast<int>(micros / 1000));
+    return std::min(static_cast<size_t>(std::max(length, 0)), TIMESTAMP_BUFFER_SIZE - 1);
+}
+
+void FieldColumns::extract(const LogReader& reader, const RowView& rows, size_t threads) {
+    size_t count = rows.size();
+    timestamps.resize(count);
+    levels.resize(count);
+    messages.resize(count);
+
+    size_t workers = workerCount(count, MIN_ROWS_PER_THREAD, threads);
+    parallelFor(count, workers, [&](size_t, size_t begin, size_t end) {
+        for (size_t row = begin; row < end; ++row) {
+            LineFields fields = parseLineFields(reader.getLine(rows.select(row)));
+            timestamps[row] = fields.timestamp;
+            levels[row] = static_cast<uint8_t>(fields.level);
+            messages[row] = fields.message;
+        }
+    }, "field worker");
+}
+
+RowView sortRows(const LogReader& reader, const RowView& rows, SortField field,
+                 bool descending, size_t threads) {
+    size_t count = rows.size();
+    size_t workers = workerCount(count, MIN_ROWS_PER_THREAD, threads);
+
+    std::vector<SortKey> keys(count);
+    if (field == SortField::Line) {
+        for (size_t row = 0; row < count; ++row) {
+            size_t line = rows.select(row);
+            keys[row] = {static_cast<int64_t>(line), line};
+        }
+    } else {
+        FieldColumns columns;
+        columns.extract(reader, rows, threads);
+        for (size_t row = 0; row < count; ++row) {
+            int64_t value = field == SortField::Timestamp
+                ? columns.timestamps[row]
+                : (columns.levels[row] == 0 ? MISSING_KEY : columns.levels[row]);
+            keys[row] = {value, rows.select(row)};
+        }
+    }
+
+    // Lines without the field go last either way; ties keep file order
+    parallelSort(keys, [descending](const SortKey& a, const SortKey& b) {
+        if (a.value != b.value) {
+            if (a.value == MISSING_KEY || b.value == MISSING_KEY) {
+                return b.value == MISSING_KEY;
+            }
+            return descending ? a.value > b.value : a.value < b.value;
+        }
+        return a.line < b.line;
+    }, workers);
+
+    std::vector<size_t> lines(count);
+    for (size_t row = 0; row < count; ++row) {
+        lines[row] = keys[row].line;
+    }
+
+    if (field == SortField::Line && !descending) {
+        // Distinct ascending lines covering the file are the identity
+        if (count == reader.getLineCount()) {
+            return RowView::identity(count);
+        }
+        return RowView::fromLines(std::move(lines));
+    }
+    return RowView::fromOrder(std::move(lines));
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "log_reader.hpp"
+#include "row_view.hpp"
+
+// Fields of lines laid out as "[2025-11-30 14:00:00.123] LEVEL: message"
+// (brackets optional, ISO 8601 with T/Z/offset accepted). Nothing is parsed
+// up front: the TUI parses the rows on screen per frame, and sorting
+// extracts columns for just the rows it orders.
+
+enum class LogLevel : uint8_t { None, Trace, Debug, Info, Warn, Error, Fatal };
+
+struct LineFields {
+    static constexpr int64_t NO_TIMESTAMP = INT64_MIN;
+
+    int64_t timestamp = NO_TIMESTAMP;  // Microseconds since the Unix epoch, UTC
+    LogLevel level = LogLevel::None;
+    uint32_t message = 0;  // Byte offset of the message within the line
+};
+
+LineFields parseLineFields(std::string_view line);
+
+// "TRACE", "DEBUG", ...; empty for None
+std::string_view levelName(LogLevel level);
+
+// "2025-11-30 14:00:00.123" (UTC); empty for NO_TIMESTAMP
+std::string formatTimestamp(int64_t timestamp);
+
+// The same into a caller's buffer of TIMESTAMP_BUFFER_SIZE bytes (NUL
+// included), for hot loops that reuse one; returns the length
+constexpr size_t TIMESTAMP_BUFFER_SIZE = 40;
+size_t formatTimestamp(int64_t timestamp, char* out);
+
+// The fields of a set of rows as parallel arrays, aligned with the rows
+struct FieldColumns {
+    std::vector<int64_t> timestamps;
+    std::vector<uint8_t> levels;  // LogLevel values
+    std::vector<uint32_t> messages;
+
+    // Parse every row of `rows`, split across `threads` workers (0: one per core)
+    void extract(const LogReader& reader, const RowView& rows, size_t threads = 0);
+
+    size_t size() const { return timestamps.size(); }
+};
+
+enum class SortField { Line, Timestamp, Level };
+
+// `rows` ordered by a field. Lines without the field go last and ties keep
+// file order, so the result is the same for any thread count. Keys are sorted
+// as integer columns in parallel chunks, then merged; the lines themselves
+// are never compared. Sorting by Line restores file order.
+RowView sortRows(const LogReader& reader, const RowView& rows, SortField field,
+                 bool descending, size_t threads = 0);
+
+// Below this many rows per worker extraction and sorting stay on one thread
+constexpr size_t MIN_ROWS_PER_THREAD = 65536;
@@ -0,0 +1,443 @@
+#include "log_generator.hpp"
+#include "parallel.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <climits>
+#include <cmath>
+#include <condition_variable>
+#include <cstring>
+#include <iterator>
+#include <mutex>
+#include <thread>
+
+#ifdef _WIN32
+    #include <io.h>
+#else
+    #include <unistd.h>
+#endif
+
+namespace {
+
+// splitmix64: cheap, good enough for text, and the same everywhere
+// (std::mt19937 distributions differ between standard libraries)
+class Rng {
+public:
+    explicit Rng(uint64_t seed) : state_(seed) {}
+
+    uint64_t next() {
+        uint64_t z = (state_ += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+
+    size_t below(size_t bound) { return bound == 0 ? 0 : static_cast<size_t>(next() % bound); }
+
+    // Uniform in [0, 1)
+    double unit() { return static_cast<double>(next() >> 11) * (1.0 / 9007199254740992.0); }
+
+    // Log-uniform in [low, high]: as many 20-40 byte values as 100-200 byte ones
+    size_t logUniform(size_t low, size_t high) {
+        if (high <= low) {
+            return low;
+        }
+        double lo = std::log(static_cast<double>(std::max<size_t>(low, 1)));
+        double hi = std::log(static_cast<double>(high) + 1.0);
+        return std::clamp(static_cast<size_t>(std::exp(lo + unit() * (hi - lo))), low, high);
+    }
+
+private:
+    uint64_t state_;
+};
+
+const char* const LEVEL_NAMES[] = {"DEBUG", "INFO", "WARN", "ERROR"};
+const char* const LOGFMT_LEVELS[] = {"debug", "info", "warn", "error"};
+
+const char* const WORDS[] = {
+    "request", "completed", "cache", "miss", "for", "user", "session", "connection",
+    "established", "to", "retrying", "operation", "after", "timeout", "worker", "queue",
+    "job", "processed", "failed", "upstream", "response", "payload", "validated", "token",
+    "refreshed", "disk", "usage", "threshold", "exceeded", "scheduler", "tick", "batch",
+    "committed", "shard", "rebalanced", "handshake", "with", "peer", "closed", "by",
+    "client", "config", "reloaded", "from", "file", "metrics", "flushed", "in",
+};
+
+const char* const HOSTS[] = {
+    "db.example.com:5432", "cache-01.internal:6379", "10.0.3.17:8080", "api.example.com:443",
+};
+
+const char* const TABLES[] = {"users", "orders", "products", "sessions", "payments", "audit_log"};
+const char* const COLUMNS[] = {"id", "user_id", "created_at", "status", "amount", "email"};
+
+const char* const SERVICES[] = {"api", "billing", "auth", "search", "worker"};
+
+void appendNumber(std::string& out, uint64_t value) {
+    char digits[24];
+    auto result = std::to_chars(digits, digits + sizeof(digits), value);
+    out.append(digits, result.ptr);
+}
+
+void appendPadded(std::string& out, unsigned value, int width) {
+    char digits[8];
+    for (int i = width - 1; i >= 0; --i) {
+        digits[i] = static_cast<char>('0' + value % 10);
+        value /= 10;
+    }
+    out.append(digits, static_cast<size_t>(width));
+}
+
+// Line i is stamped 2025-01-01 00:00:00 + i milliseconds
+void appendTimestamp(std::string& out, uint64_t line, bool iso) {
+    uint64_t ms = line % 1000;
+    uint64_t seconds = line / 1000;
+    // Days since 1970-01-01 -> civil date (H. Hinnant's algorithm)
+    int64_t z = static_cast<int64_t>(20089 + seconds / 86400) + 719468;
+    int64_t era = z / 146097;
+    unsigned doe = static_cast<unsigned>(z - era * 146097);
+    unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    unsigned mp = (5 * doy + 2) / 153;
+    unsigned day = doy - (153 * mp + 2) / 5 + 1;
+    unsigned month = mp < 10 ? mp + 3 : mp - 9;
+    unsigned year = static_cast<unsigned>(yoe + era * 400 + (month <= 2 ? 1 : 0));
+    unsigned second_of_day = static_cast<unsigned>(seconds % 86400);
+
+    appendPadded(out, year, 4);
+    out += '-';
+    appendPadded(out, month, 2);
+    out += '-';
+    appendPadded(out, day, 2);
+    out += iso ? 'T' : ' ';
+    appendPadded(out, second_of_day / 3600, 2);
+    out += ':';
+    appendPadded(out, second_of_day / 60 % 60, 2);
+    out += ':';
+    appendPadded(out, second_of_day % 60, 2);
+    out += '.';
+    appendPadded(out, static_cast<unsigned>(ms), 3);
+    if (iso) {
+        out += 'Z';
+    }
+}
+
+// Words until about `bytes` were added
+void appendWords(std::string& out, Rng& rng, size_t bytes) {
+    size_t target = out.size() + bytes;
+    bool first = true;
+    while (out.size() < target) {
+        if (!first) {
+            out += ' ';
+        }
+        first = false;
+        if (rng.below(8) == 0) {
+            out += HOSTS[rng.below(std::size(HOSTS))];
+        } else if (rng.below(6) == 0) {
+            appendNumber(out, rng.below(100000));
+        } else {
+            out += WORDS[rng.below(std::size(WORDS))];
+        }
+    }
+}
+
+// A JSON object of about `bytes` bytes
+void appendPayload(std::string& out, Rng& rng, size_t bytes) {
+    size_t target = out.size() + bytes;
+    out += "{\"request_id\": ";
+    appendNumber(out, rng.next() % 10000000);
+    out += ", \"service\": \"";
+    out += SERVICES[rng.below(std::size(SERVICES))];
+    out += "\", \"status\": ";
+    appendNumber(out, 200 + 100 * rng.below(4) + rng.below(5));
+    out += ", \"latency_ms\": ";
+    appendNumber(out, rng.logUniform(1, 5000));
+    if (out.size() + 16 < target) {
+        out += ", \"items\": [";
+        bool first = true;
+        while (out.size() + 40 < target) {
+            if (!first) {
+                out += ", ";
+            }
+            first = false;
+            out += "{\"id\": ";
+            appendNumber(out, rng.below(1000000));
+            out += ", \"name\": \"";
+            out += WORDS[rng.below(std::size(WORDS))];
+            out += "\"}";
+        }
+        out += ']';
+    }
+    out += '}';
+}
+
+// A query of about `bytes` bytes, WHERE conditions added until it fits
+void appendQuery(std::string& out, Rng& rng, size_t bytes) {
+    size_t target = out.size() + bytes;
+    const char* table = TABLES[rng.below(std::size(TABLES))];
+    switch (rng.below(4)) {
+    case 0:
+        out += "SELECT * FROM ";
+        out += table;
+        break;
+    case 1:
+        out += "UPDATE ";
+        out += table;
+        out += " SET status = 'done'";
+        break;
+    case 2:
+        out += "DELETE FROM ";
+        out += table;
+        break;
+    default:
+        out += "SELECT u.id, o.amount FROM users u LEFT JOIN ";
+        out += table;
+        out += " o ON u.id = o.user_id";
+        break;
+    }
+    out += " WHERE ";
+    out += COLUMNS[rng.below(std::size(COLUMNS))];
+    out += " = ";
+    appendNumber(out, rng.below(100000));
+    while (out.size() < target) {
+        out += rng.below(2) ? " AND " : " OR ";
+        out += COLUMNS[rng.below(std::size(COLUMNS))];
+        out += " > ";
+        appendNumber(out, rng.below(100000));
+    }
+}
+
+uint64_t blockSeed(uint64_t seed, uint64_t block) {
+    Rng mixer(seed ^ (block * 0xD1B54A32D192ED03ULL));
+    return mixer.next();
+}
+
+bool writeAll(int fd, const char* data, size_t size) {
+    while (size > 0) {
+#ifdef _WIN32
+        int written = _write(fd, data, static_cast<unsigned>(std::min<size_t>(size, INT_MAX)));
+#else
+        ssize_t written = ::write(fd, data, size);
+#endif
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data += written;
+        size -= static_cast<size_t>(written);
+    }
+    return true;
+}
+
+} // namespace
+
+LogGenerator::LogGenerator(GeneratorOptions options)
+    : options_(std::move(options))
+    , level_total_(0) {
+    for (unsigned weight : options_.level_weights) {
+        level_total_ += weight;
+    }
+    if (level_total_ == 0) {
+        options_.level_weights = {0, 1, 0, 0};
+        level_total_ = 1;
+    }
+    options_.max_message = std::max(options_.max_message, options_.min_message);
+    options_.max_payload = std::max(options_.max_payload, options_.min_payload);
+}
+
+void LogGenerator::generateBlock(uint64_t block, std::string& out,
+                                 std::vector<NeedleLine>& needles) const {
+    Rng rng(blockSeed(options_.seed, block));
+    const uint64_t first = block * LINES_PER_BLOCK;
+
+    for (uint64_t line = first; line < first + LINES_PER_BLOCK; ++line) {
+        const size_t line_start = out.size();
+
+        unsigned pick = static_cast<unsigned>(rng.below(level_total_));
+        size_t level = 0;
+        while (pick >= options_.level_weights[level]) {
+            pick -= options_.level_weights[level];
+            ++level;
+        }
+
+        LogFormat format = options_.format;
+        if (format == LogFormat::Generic) {
+            static constexpr LogFormat MIX[] = {LogFormat::PlainText, LogFormat::JsonLines,
+                                                LogFormat::Sql, LogFormat::Logfmt};
+            format = MIX[rng.below(std::size(MIX))];
+        }
+
+        size_t message = rng.logUniform(options_.min_message, options_.max_message);
+        bool long_line = options_.long_line_ratio > 0.0 && rng.unit() < options_.long_line_ratio;
+        bool needle = options_.needle_every != 0 && line % options_.needle_every == options_.needle_every - 1;
+
+        if (format == LogFormat::Logfmt) {
+            out += "ts=";
+            appendTimestamp(out, line, true);
+            out += " level=";
+            out += LOGFMT_LEVELS[level];
+            out += " service=";
+            out += SERVICES[rng.below(std::size(SERVICES))];
+            out += " msg=\"";
+            appendWords(out, rng, message);
+            out += "\" request_id=";
+            appendNumber(out, rng.next() % 10000000);
+            out += " duration_ms=";
+            appendNumber(out, rng.logUniform(1, 5000));
+        } else {
+            out += '[';
+            appendTimestamp(out, line, false);
+            out += "] ";
+            out += LEVEL_NAMES[level];
+            out += ": ";
+            if (format == LogFormat::Sql) {
+                if (rng.below(3) == 0) {
+                    out += "Query executed successfully in ";
+                    appendNumber(out, rng.logUniform(1, 3000));
+                    out += "ms, returned ";
+                    appendNumber(out, rng.logUniform(1, 10000));
+                    out += " rows";
+                } else {
+                    out += level >= 2 ? "Slow query detected: " : "Executing query: ";
+                    appendQuery(out, rng, message);
+                }
+            } else {
+                appendWords(out, rng, message);
+                if (format == LogFormat::JsonLines && options_.max_payload > 0) {
+                    out += ' ';
+                    appendPayload(out, rng, rng.logUniform(options_.min_payload, options_.max_payload));
+                }
+            }
+        }
+
+        if (needle) {
+            out += ' ';
+            out += options_.needle;
+            out += '#';
+            appendNumber(out, line / options_.needle_every + 1);
+            needles.push_back({line, line_start});
+        }
+
+        if (long_line) {
+            out += " dump=";
+            appendPayload(out, rng, options_.long_line_bytes);
+        }
+
+        if (options_.crlf_ratio > 0.0 && rng.unit() < options_.crlf_ratio) {
+            out += '\r';
+        }
+        out += '\n';
+    }
+}
+
+bool LogGenerator::write(int fd, GeneratorResult& result, std::string& error) const {
+    result = GeneratorResult();
+    if (options_.size == 0) {
+        return true;
+    }
+
+    size_t threads = threadCount(options_.threads);
+
+    // Workers fill a ring of blocks ahead of the writer, which writes them
+    // in order; the ring bounds memory to a few blocks per thread
+    struct Slot {
+        std::string data;
+        std::vector<NeedleLine> needles;
+        bool ready = false;
+    };
+    const uint64_t window = threads * 2;
+    std::vector<Slot> slots(window);
+    std::mutex mutex;
+    std::condition_variable produced;
+    std::condition_variable consumed;
+    uint64_t next_block = 0;
+    uint64_t written_blocks = 0;
+    bool done = false;
+
+    auto worker = [&]() {
+        std::string data;
+        std::vector<NeedleLine> needles;
+        while (true) {
+            uint64_t block;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                consumed.wait(lock, [&]() { return done || next_block < written_blocks + window; });
+                if (done) {
+                    return;
+                }
+                block = next_block++;
+            }
+
+            data.clear();
+            needles.clear();
+            generateBlock(block, data, needles);
+
+            std::lock_guard<std::mutex> lock(mutex);
+            Slot& slot = slots[block % window];
+            slot.data.swap(data);
+            slot.needles.swap(needles);
+            slot.ready = true;
+            produced.notify_all();
+        }
+    };
+
+    std::vector<std::thread> pool;
+    for (size_t i = 0; i < threads; ++i) {
+        pool.emplace_back(worker);
+    }
+
+    bool ok = true;
+    std::string data;
+    std::vector<NeedleLine> needles;
+    for (uint64_t block = 0; ; ++block) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            Slot& slot = slots[block % window];
+            produced.wait(lock, [&]() { return slot.ready; });
+            data.swap(slot.data);
+            needles.swap(slot.needles);
+            slot.ready = false;
+        }
+
+        // The last block stops at the first line end at or past the target
+        size_t keep = data.size();
+        uint64_t lines = LINES_PER_BLOCK;
+        bool last = result.bytes + data.size() >= options_.size;
+        if (last) {
+            size_t needed = static_cast<size_t>(options_.size - result.bytes);
+            const char* end = static_cast<const char*>(std::memchr(data.data() + needed - 1, '\n',
+                                                                   data.size() - needed + 1));
+            keep = static_cast<size_t>(end - data.data()) + 1;
+            lines = static_cast<uint64_t>(std::count(data.data(), data.data() + keep, '\n'));
+        }
+
+        for (const NeedleLine& needle : needles) {
+            if (needle.offset < keep) {
+                result.needles.push_back({needle.line, result.bytes + needle.offset});
+            }
+        }
+
+        if (!writeAll(fd, data.data(), keep)) {
+            error = std::string("write failed: ") + std::strerror(errno);
+            ok = false;
+            last = true;
+        } else {
+            result.bytes += keep;
+            result.lines += lines;
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        ++written_blocks;
+        done = last;
+        consumed.notify_all();
+        if (done) {
+            break;
+        }
+    }
+
+    for (auto& thread : pool) {
+        thread.join();
+    }
+    return ok;
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "format_sniffer.hpp"
+
+// Synthetic logs for performance work, in the formats the viewer detects.
+// Output depends only on the options and the seed: the log is cut into
+// blocks of LINES_PER_BLOCK lines, each generated from its own seed, so
+// blocks are produced in parallel and the result is identical for any
+// thread count.
+struct GeneratorOptions {
+    uint64_t size = 1ULL << 30;  // Bytes; generation stops at the first line end past this
+    uint64_t seed = 1;
+
+    // PlainText, JsonLines (message + JSON payload), Sql, Logfmt;
+    // Generic mixes all four line by line
+    LogFormat format = LogFormat::PlainText;
+
+    // Message length in bytes, drawn log-uniformly (many short, few long)
+    size_t min_message = 20;
+    size_t max_message = 200;
+
+    // Relative weights of DEBUG, INFO, WARN, ERROR
+    std::array<unsigned, 4> level_weights = {15, 70, 10, 5};
+
+    // JSON payload size in bytes, for JsonLines lines
+    size_t min_payload = 40;
+    size_t max_payload = 400;
+
+    // Every needle_every-th line (0: none) carries `needle` and its ordinal,
+    // e.g. "NEEDLE#3", a unique rare match at a known line
+    uint64_t needle_every = 0;
+    std::string needle = "NEEDLE";
+
+    // Pathologies: fraction of lines ending in CRLF, and of lines that are
+    // long_line_bytes long (minified JSON dumps)
+    double crlf_ratio = 0.0;
+    double long_line_ratio = 0.0;
+    size_t long_line_bytes = 1024 * 1024;
+
+    size_t threads = 0;  // 0: one per core
+};
+
+// Where a needle line ended up
+struct NeedleLine {
+    uint64_t line;    // 0-based line index
+    uint64_t offset;  // Byte offset of the line start
+};
+
+struct GeneratorResult {
+    uint64_t bytes = 0;
+    uint64_t lines = 0;
+    std::vector<NeedleLine> needles;
+};
+
+class LogGenerator {
+public:
+    static constexpr uint64_t LINES_PER_BLOCK = 16384;
+
+    explicit LogGenerator(GeneratorOptions options);
+
+    // Lines [block * LINES_PER_BLOCK, (block + 1) * LINES_PER_BLOCK),
+    // appended to `out`; needle lines are reported as offsets into `out`
+    void generateBlock(uint64_t block, std::string& out, std::vector<NeedleLine>& needles) const;
+
+    // Generate the whole log into `fd`. On failure `error` says why.
+    bool write(int fd, GeneratorResult& result, std::string& error) const;
+
+    const GeneratorOptions& options() const { return options_; }
+
+private:
+    GeneratorOptions options_;
+    unsigned level_total_;
+};
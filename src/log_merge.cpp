@@ -0,0 +1,158 @@
+#include "log_merge.hpp"
+#include "log_fields.hpp"
+#include "log_reader.hpp"
+#include "parallel.hpp"
+#include "trace.hpp"
+#include <algorithm>
+#include <atomic>
+#include <filesystem>
+#include <queue>
+#include <thread>
+
+namespace {
+
+// A source's next line in the merge heap
+struct Cursor {
+    int64_t key;
+    size_t source;
+    size_t line;
+};
+
+// Heap order: smallest key on top, the lower source on ties
+struct CursorAfter {
+    bool operator()(const Cursor& a, const Cursor& b) const {
+        return a.key != b.key ? a.key > b.key : a.source > b.source;
+    }
+};
+
+std::string truncateTag(std::string tag) {
+    if (tag.size() > MAX_SOURCE_TAG) {
+        tag.resize(MAX_SOURCE_TAG);
+    }
+    return tag;
+}
+
+} // namespace
+
+std::vector<int64_t> mergeKeys(const LogReader& reader) {
+    size_t count = reader.getLineCount();
+    TRACE_SCOPE_ARG("merge keys", "lines", count);
+    std::vector<int64_t> keys(count);
+    int64_t previous = LineFields::NO_TIMESTAMP;  // INT64_MIN: sorts first
+    for (size_t line = 0; line < count; ++line) {
+        int64_t timestamp = parseLineFields(reader.getLine(line)).timestamp;
+        if (timestamp != LineFields::NO_TIMESTAMP) {
+            previous = timestamp;
+        }
+        keys[line] = previous;
+    }
+    return keys;
+}
+
+std::vector<uint64_t> mergeByKey(const std::vector<std::vector<int64_t>>& keys) {
+    size_t total = 0;
+    std::priority_queue<Cursor, std::vector<Cursor>, CursorAfter> heap;
+    for (size_t source = 0; source < keys.size(); ++source) {
+        total += keys[source].size();
+        if (!keys[source].empty()) {
+            heap.push({keys[source][0], source, 0});
+        }
+    }
+
+    TRACE_SCOPE_ARG("merge by key", "lines", total);
+    std::vector<uint64_t> merged;
+    merged.reserve(total);
+    while (!heap.empty()) {
+        Cursor cursor = heap.top();
+        heap.pop();
+        const auto& source_keys = keys[cursor.source];
+
+        // Take the source's run while it stays ahead of every other source
+        int64_t limit = heap.empty() ? INT64_MAX : heap.top().key;
+        size_t rival = heap.empty() ? keys.size() : heap.top().source;
+        size_t line = cursor.line;
+        do {
+            merged.push_back(packLineSource(cursor.source, line));
+            ++line;
+        } while (line < source_keys.size() &&
+                 (source_keys[line] < limit || (source_keys[line] == limit && cursor.source < rival)));
+
+        if (line < source_keys.size()) {
+            heap.push({source_keys[line], cursor.source, line});
+        }
+    }
+    return merged;
+}
+
+std::vector<uint64_t> mergeByTimestamp(const std::vector<const LogReader*>& sources, size_t threads) {
+    size_t workers = std::clamp<size_t>(sources.size(), 1, threadCount(threads));
+
+    // One file per worker at a time; parsing dominates, the merge is linear
+    std::vector<std::vector<int64_t>> keys(sources.size());
+    std::atomic<size_t> next{0};
+    auto work = [&]() {
+        for (size_t source = next++; source < sources.size(); source = next++) {
+            keys[source] = mergeKeys(*sources[source]);
+        }
+    };
+
+    std::vector<std::thread> pool;
+    pool.reserve(workers - 1);
+    for (size_t i = 1; i < workers; ++i) {
+        pool.emplace_back([&work]() {
+            TRACE_THREAD_NAME("merge worker");
+            work();
+        });
+    }
+    work();
+    for (auto& worker : pool) {
+        worker.join();
+    }
+
+    return mergeByKey(keys);
+}
+
+std::vector<std::string> sourceTags(const std::vector<std::string>& filenames) {
+    std::vector<std::string> tags;
+    tags.reserve(filenames.size());
+    for (const auto& filename : filenames) {
+        tags.push_back(truncateTag(std::filesystem::path(filename).stem().string()));
+    }
+
+    // Each step rebuilds only the tags that still collide
+    auto collides = [&tags](size_t i) { return std::count(tags.begin(), tags.end(), tags[i]) > 1; };
+    auto refine = [&](const auto& tagOf) {
+        std::vector<bool> colliding(tags.size());
+        for (size_t i = 0; i < tags.size(); ++i) {
+            colliding[i] = collides(i);
+        }
+        for (size_t i = 0; i < tags.size(); ++i) {
+            if (colliding[i]) {
+                tags[i] = tagOf(i);
+            }
+        }
+    };
+    refine([&](size_t i) {
+        return truncateTag(std::filesystem::path(filenames[i]).filename().string());
+    });
+    refine([&](size_t i) {
+        std::filesystem::path path(filenames[i]);
+        return truncateTag((path.parent_path().filename() / path.filename()).generic_string());
+    });
+
+    // Same name in directories of the same name: number them by position
+    for (size_t round = 0; round < tags.size(); ++round) {
+        bool unique = true;
+        for (size_t i = 0; i < tags.size() && unique; ++i) {
+            unique = !collides(i);
+        }
+        if (unique) {
+            break;
+        }
+        refine([&](size_t i) {
+            std::string suffix = "#" + std::to_string(i + 1);
+            return tags[i].substr(0, MAX_SOURCE_TAG - std::min(MAX_SOURCE_TAG, suffix.size())) + suffix;
+        });
+    }
+    return tags;
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class LogReader;
+
+// Several logs (api.log, db.log, worker.log) shown as one, interleaved by
+// each line's leading timestamp. The merged view is nothing but an index of
+// (source, line) pairs packed into 64 bits; the lines stay in the sources'
+// mappings. Keys are parsed per source in parallel, then a k-way heap merge
+// interleaves them.
+
+struct LineSource {
+    size_t source;  // Index of the file among the merged ones
+    size_t line;    // Line index within that file
+};
+
+// Low 48 bits: line; high 16 bits: source
+constexpr unsigned MERGE_LINE_BITS = 48;
+constexpr size_t MAX_MERGE_SOURCES = size_t{1} << (64 - MERGE_LINE_BITS);
+constexpr uint64_t MERGE_LINE_MASK = (uint64_t{1} << MERGE_LINE_BITS) - 1;
+
+inline uint64_t packLineSource(size_t source, size_t line) {
+    return (static_cast<uint64_t>(source) << MERGE_LINE_BITS) | static_cast<uint64_t>(line);
+}
+
+inline LineSource unpackLineSource(uint64_t entry) {
+    return {static_cast<size_t>(entry >> MERGE_LINE_BITS), static_cast<size_t>(entry & MERGE_LINE_MASK)};
+}
+
+// Merge key of every line: its timestamp, or the previous line's when it has
+// none, so a stack trace stays under the message it belongs to. Lines before
+// the first timestamp of the file sort first.
+std::vector<int64_t> mergeKeys(const LogReader& reader);
+
+// Interleave the sources' keys in ascending order. Every source keeps its
+// own line order even where its timestamps go back; ties go to the lower
+// source, so the result does not depend on timing.
+std::vector<uint64_t> mergeByKey(const std::vector<std::vector<int64_t>>& keys);
+
+// Merge `sources` by timestamp, parsing up to `threads` files at a time
+// (0: one per core)
+std::vector<uint64_t> mergeByTimestamp(const std::vector<const LogReader*>& sources, size_t threads = 0);
+
+// Gutter tags: file names without directory and extension ("api"); where
+// those collide the whole file name, then with its directory ("a/api.log"),
+// then numbered by position ("log/api.lo#2"). At most MAX_SOURCE_TAG characters
+std::vector<std::string> sourceTags(const std::vector<std::string>& filenames);
+
+constexpr size_t MAX_SOURCE_TAG = 12;
@@ -1,10 +1,16 @@
 #include "log_reader.hpp"
+#include "trace.hpp"
+#include <algorithm>
 #include <iostream>
 #include <cstring>
 
 LogReader::LogReader()
     : mapped_data_(nullptr)
     , file_size_(0)
+    , indexed_lines_(0)
+    , offsets_(nullptr)
+    , line_count_(&indexed_lines_)
+    , backend_(ReadBackend::Mmap)
     , use_mmap_(true)
 #ifdef _WIN32
     , file_handle_(INVALID_HANDLE_VALUE)
@@ -19,11 +25,10 @@ LogReader::~LogReader() {
     close();
 }
 
-bool LogReader::open(const std::string& filename) {
+bool LogReader::open(const std::string& filename, const ReadOptions& options) {
+    TRACE_SCOPE("LogReader::open");
     close();  // Close any previously opened file
 
-    filename_ = filename;
-
 #ifdef _WIN32
     // Windows implementation using CreateFileMapping
     file_handle_ = CreateFileA(
@@ -60,6 +65,7 @@ bool LogReader::open(const std::string& filename) {
         CloseHandle(file_handle_);
         file_handle_ = INVALID_HANDLE_VALUE;
         mapped_data_ = nullptr;
+        filename_ = filename;
         return true;
     }
 
@@ -126,10 +132,12 @@ bool LogReader::open(const std::string& filename) {
         ::close(fd_);
         fd_ = -1;
         mapped_data_ = nullptr;
+        filename_ = filename;
         return true;
     }
 
-    // Map file into memory
+    // Map file into memory; with block reads the pages are cached by the
+    // reads before the mapping is used
     mapped_data_ = static_cast<char*>(
         mmap(nullptr, file_size_, PROT_READ, MAP_PRIVATE, fd_, 0)
     );
@@ -142,10 +150,22 @@ bool LogReader::open(const std::string& filename) {
         return false;
     }
 
+    backend_ = chooseBackend(fd_, options);
+    if (backend_ == ReadBackend::Read) {
+        filename_ = filename;
+        if (!readFile(options)) {
+            close();
+            return false;
+        }
+        return true;
+    }
+
     // Advise kernel about access pattern
     madvise(mapped_data_, file_size_, MADV_SEQUENTIAL);
 #endif
 
+    filename_ = filename;
+
     // Index all lines
     indexLines();
 
@@ -153,6 +173,13 @@ bool LogReader::open(const std::string& filename) {
 }
 
 void LogReader::close() {
+    if (spool_) {
+        spool_.reset();  // Stops the reading thread and unmaps a stream's data
+        if (backend_ != ReadBackend::Read) {
+            mapped_data_ = nullptr;  // Owned by the spool
+        }
+    }
+
 #ifdef _WIN32
     if (mapped_data_ != nullptr) {
         UnmapViewOfFile(mapped_data_);
@@ -180,26 +207,167 @@ void LogReader::close() {
     }
 #endif
 
+    sources_.clear();
+    source_tags_.clear();
+    merge_index_ = {};
+
     file_size_ = 0;
+    backend_ = ReadBackend::Mmap;
     line_offsets_.clear();
+    indexed_lines_ = 0;
+    offsets_ = nullptr;
+    line_count_ = &indexed_lines_;
     filename_.clear();
 }
 
-void LogReader::indexLines() {
-    line_offsets_.clear();
+bool LogReader::openStream(int fd, const std::string& name, size_t memory_budget) {
+    close();
+
+    auto spool = std::make_unique<StreamSpool>();
+    std::string error;
+    if (!spool->start(fd, memory_budget, error)) {
+        std::cerr << "Failed to read " << name << ": " << error << std::endl;
+        return false;
+    }
+
+    // The stream's data and index never move, so they are used in place
+    mapped_data_ = const_cast<char*>(spool->data());
+    offsets_ = spool->offsets();
+    line_count_ = &spool->lineCount();
+    spool_ = std::move(spool);
+    filename_ = name;
+    return true;
+}
+
+bool LogReader::openMerged(const std::vector<std::string>& filenames, size_t threads,
+                           const ReadOptions& options) {
+    TRACE_SCOPE("LogReader::openMerged");
+    close();
 
+    if (filenames.empty() || filenames.size() > MAX_MERGE_SOURCES) {
+        std::cerr << "Cannot merge " << filenames.size() << " files" << std::endl;
+        return false;
+    }
+
+    std::vector<std::unique_ptr<LogReader>> sources;
+    std::vector<const LogReader*> views;
+    size_t total_size = 0;
+    for (const auto& filename : filenames) {
+        auto source = std::make_unique<LogReader>();
+        if (!source->open(filename, options)) {
+            return false;  // open() said why
+        }
+        // Merging needs every line; a file read in blocks is waited for
+        while (source->isGrowing()) {
+            source->waitForLines(source->getLineCount(), std::chrono::milliseconds(200));
+        }
+        if (!source->getReadError().empty()) {
+            std::cerr << "Failed to read " << filename << ": " << source->getReadError() << std::endl;
+            return false;
+        }
+        if (source->getLineCount() > MERGE_LINE_MASK) {
+            std::cerr << "Too many lines to merge: " << filename << std::endl;
+            return false;
+        }
+        total_size += source->getFileSize();
+        views.push_back(source.get());
+        sources.push_back(std::move(source));
+    }
+
+    auto started = std::chrono::steady_clock::now();
+    merge_index_ = mergeByTimestamp(views, threads);
+
+    // Offsets as if the merged lines were one file, terminators included
+    line_offsets_.reserve(merge_index_.size() + 1);
+    size_t offset = 0;
+    for (uint64_t entry : merge_index_) {
+        line_offsets_.push_back(offset);
+        LineSource from = unpackLineSource(entry);
+        offset += sources[from.source]->getLineOffset(from.line + 1) -
+                  sources[from.source]->getLineOffset(from.line);
+    }
+    line_offsets_.push_back(offset);
+    offsets_ = line_offsets_.data();
+    indexed_lines_ = merge_index_.size();
+
+    index_rate_.bytes = total_size;
+    index_rate_.lines = merge_index_.size();
+    index_rate_.elapsed = std::chrono::steady_clock::now() - started;
+
+    source_tags_ = sourceTags(filenames);
+    sources_ = std::move(sources);
+    file_size_ = total_size;
+    for (const auto& filename : filenames) {
+        filename_ += (filename_.empty() ? "" : ", ") + filename;
+    }
+    return true;
+}
+
+size_t LogReader::waitForLines(size_t known, std::chrono::milliseconds timeout) const {
+    if (!spool_) {
+        return getLineCount();
+    }
+    return spool_->waitForLines(known, timeout);
+}
+
+void LogReader::setGrowthCallback(std::function<void()> callback) {
+    if (spool_) {
+        spool_->setGrowthCallback(std::move(callback));
+    }
+}
+
+void LogReader::indexLines() {
+    TRACE_SCOPE_ARG("LogReader::indexLines", "bytes", file_size_);
     if (file_size_ == 0) {
+        line_offsets_.clear();
+        index_rate_ = ScanRate();
         return;
     }
 
+    auto started = std::chrono::steady_clock::now();
+    beginIndex();
+    indexBlock(0, file_size_);
+    finishIndex(started);
+}
+
+#ifndef _WIN32
+bool LogReader::readFile(const ReadOptions& options) {
+    // The spool reads its own descriptor; ours stays for kernel copies
+    int fd = dup(fd_);
+    if (fd == -1) {
+        std::cerr << "Failed to read " << filename_ << ": " << std::strerror(errno) << std::endl;
+        return false;
+    }
+
+    // Lines are indexed from the read buffers and appear as blocks arrive,
+    // like a stream's
+    auto spool = std::make_unique<StreamSpool>();
+    std::string error;
+    if (!spool->startFile(fd, file_size_, options, error)) {
+        std::cerr << "Failed to read " << filename_ << ": " << error << std::endl;
+        return false;
+    }
+    offsets_ = spool->offsets();
+    line_count_ = &spool->lineCount();
+    spool_ = std::move(spool);
+    return true;
+}
+#endif
+
+void LogReader::beginIndex() {
+    line_offsets_.clear();
+    index_rate_ = ScanRate();
+
     // Reserve space for efficiency (estimate ~80 bytes per line)
     line_offsets_.reserve(file_size_ / 80);
 
     // First line always starts at 0
     line_offsets_.push_back(0);
+}
 
+void LogReader::indexBlock(size_t begin, size_t end) {
     // Scan for newlines
-    for (size_t i = 0; i < file_size_; ++i) {
+    for (size_t i = begin; i < end; ++i) {
         if (mapped_data_[i] == '\n') {
             if (i + 1 < file_size_) {
                 line_offsets_.push_back(i + 1);
@@ -208,19 +376,108 @@ void LogReader::indexLines() {
     }
 }
 
-std::string_view LogReader::getLine(size_t index) const {
-    if (index >= line_offsets_.size() || mapped_data_ == nullptr) {
+void LogReader::finishIndex(std::chrono::steady_clock::time_point started) {
+    // End of the last line, so every line is [offsets[i], offsets[i + 1])
+    line_offsets_.push_back(file_size_);
+    offsets_ = line_offsets_.data();
+    indexed_lines_ = line_offsets_.size() - 1;
+
+    index_rate_.bytes = file_size_;
+    index_rate_.lines = line_offsets_.size() - 1;
+    index_rate_.elapsed = std::chrono::steady_clock::now() - started;
+}
+
+void LogReader::trimIndex() {
+    for (auto& source : sources_) {
+        source->trimIndex();
+    }
+    if (spool_ || line_offsets_.empty()) {
+        return;  // A stream's index lives in the spool and is never over-allocated
+    }
+    line_offsets_.shrink_to_fit();
+    offsets_ = line_offsets_.data();
+}
+
+size_t LogReader::getIndexMemory() const {
+    if (spool_) {
+        return (getLineCount() + 1) * sizeof(size_t);
+    }
+    size_t bytes = line_offsets_.capacity() * sizeof(size_t) + merge_index_.capacity() * sizeof(uint64_t);
+    for (const auto& source : sources_) {
+        bytes += source->getIndexMemory();
+    }
+    return bytes;
+}
+
+size_t LogReader::getStreamMemory() const {
+    if (spool_) {
+        return spool_->memoryBytes();
+    }
+    size_t bytes = 0;
+    for (const auto& source : sources_) {
+        bytes += source->getStreamMemory();
+    }
+    return bytes;
+}
+
+int LogReader::getFileDescriptor() const {
+#ifdef _WIN32
+    return -1;
+#else
+    return fd_;
+#endif
+}
+
+bool LogReader::isOpen() const {
+    return !filename_.empty();
+}
+
+std::string_view LogReader::getData() const {
+    size_t line_count = getLineCount();
+    if (mapped_data_ == nullptr || line_count == 0) {
+        return std::string_view();
+    }
+    // Everything the index covers; a stream's partial last line is not included
+    return std::string_view(mapped_data_, offsets_[line_count]);
+}
+
+size_t LogReader::getDataSize() const {
+    size_t line_count = getLineCount();
+    return line_count == 0 ? 0 : offsets_[line_count];
+}
+
+std::string_view LogReader::getRawLine(size_t index) const {
+    if (index >= getLineCount()) {
+        return std::string_view();
+    }
+    if (!sources_.empty()) {
+        LineSource from = unpackLineSource(merge_index_[index]);
+        return sources_[from.source]->getRawLine(from.line);
+    }
+    if (mapped_data_ == nullptr) {
         return std::string_view();
     }
+    return std::string_view(mapped_data_ + offsets_[index], offsets_[index + 1] - offsets_[index]);
+}
 
-    size_t start = line_offsets_[index];
-    size_t end;
+size_t LogReader::lineAtOffset(size_t offset) const {
+    const size_t* begin = offsets_;
+    const size_t* end = offsets_ + getLineCount();
+    auto it = std::upper_bound(begin, end, offset);
+    return it == begin ? 0 : static_cast<size_t>(it - begin) - 1;
+}
 
-    if (index + 1 < line_offsets_.size()) {
-        end = line_offsets_[index + 1] - 1;  // -1 to exclude the newline
-    } else {
-        end = file_size_;
+std::string_view LogReader::getLine(size_t index) const {
+    if (!sources_.empty() && index < getLineCount()) {
+        LineSource from = unpackLineSource(merge_index_[index]);
+        return sources_[from.source]->getLine(from.line);
     }
+    if (index >= getLineCount() || mapped_data_ == nullptr) {
+        return std::string_view();
+    }
+
+    size_t start = offsets_[index];
+    size_t end = offsets_[index + 1];
 
     // Handle trailing newline
     if (end > start && mapped_data_[end - 1] == '\n') {
@@ -240,7 +497,8 @@ std::vector<std::string_view> LogReader::getLines(size_t start, size_t count) co
     std::vector<std::string_view> result;
     result.reserve(count);
 
-    for (size_t i = start; i < start + count && i < line_offsets_.size(); ++i) {
+    size_t line_count = getLineCount();
+    for (size_t i = start; i < start + count && i < line_count; ++i) {
         result.push_back(getLine(i));
     }
 
@@ -4,8 +4,15 @@
 #include <vector>
 #include <string_view>
 #include <memory>
+#include <atomic>
+#include <chrono>
+#include <functional>
 #include <cstddef>
 #include <fstream>
+#include "block_read.hpp"
+#include "log_merge.hpp"
+#include "perf_stats.hpp"
+#include "stream_spool.hpp"
 
 #ifdef _WIN32
     #define WIN32_LEAN_AND_MEAN
@@ -23,14 +30,56 @@ public:
     LogReader();
     ~LogReader();
 
-    // Open file using mmap for small files or buffered reading for large files
-    bool open(const std::string& filename);
+    // Open a file and index its lines. The bytes are mapped; with
+    // ReadBackend::Read they are also read with large overlapping requests
+    // (see block_read.hpp) and indexed in the background, lines becoming
+    // available as blocks arrive like a stream's. options.backend picks
+    // which, Auto decides by filesystem.
+    bool open(const std::string& filename, const ReadOptions& options = {});
+
+    // Read a stream (stdin, a pipe) that cannot be mapped. Takes ownership
+    // of `fd`; lines become available as they arrive, through the same API.
+    bool openStream(int fd, const std::string& name,
+                    size_t memory_budget = StreamSpool::DEFAULT_MEMORY_BUDGET);
+
+    // Open several files as one log with their lines interleaved by leading
+    // timestamp (see log_merge.hpp); `threads` parse the files in parallel.
+    // Line indices and offsets are those of the merged view. Each file is
+    // opened with `options`, so Auto decides per file.
+    bool openMerged(const std::vector<std::string>& filenames, size_t threads = 0,
+                    const ReadOptions& options = {});
+
+    // Opened with openMerged()
+    bool isMerged() const { return !sources_.empty(); }
+
+    // Merged view: the files, their gutter tags, and where a line comes from
+    size_t getSourceCount() const { return sources_.size(); }
+    const LogReader& getSource(size_t source) const { return *sources_[source]; }
+    const std::vector<std::string>& getSourceTags() const { return source_tags_; }
+    LineSource getLineSource(size_t index) const {
+        return sources_.empty() ? LineSource{0, index} : unpackLineSource(merge_index_[index]);
+    }
+
+    // Input is still arriving (stream not at its end yet, or a file still
+    // being read)
+    bool isGrowing() const { return spool_ && !spool_->finished(); }
+
+    // Why a stream or a block read ended early; empty if it did not
+    std::string getReadError() const { return spool_ ? spool_->getError() : std::string(); }
+
+    // Block until there are more than `known` lines, the input ends, or the
+    // timeout passes; returns the line count. Files return at once.
+    size_t waitForLines(size_t known, std::chrono::milliseconds timeout) const;
+
+    // Called from the reading thread whenever new lines arrived; waits
+    // for a call in progress before returning
+    void setGrowthCallback(std::function<void()> callback);
 
     // Close file and unmap memory
     void close();
 
     // Get total number of lines
-    size_t getLineCount() const { return line_offsets_.size(); }
+    size_t getLineCount() const { return line_count_->load(std::memory_order_acquire); }
 
     // Get line by index (zero-based)
     std::string_view getLine(size_t index) const;
@@ -38,8 +87,49 @@ public:
     // Get range of lines
     std::vector<std::string_view> getLines(size_t start, size_t count) const;
 
-    // Get file size
-    size_t getFileSize() const { return file_size_; }
+    // Get file size (bytes received so far for streams, all files when merged)
+    size_t getFileSize() const {
+        return spool_ && backend_ != ReadBackend::Read ? spool_->byteCount() : file_size_;
+    }
+
+    // All mapped bytes (empty when the file is not mapped, and for a merged
+    // view, whose lines live in several mappings)
+    std::string_view getData() const;
+
+    // Bytes the line index covers: getData().size(), or the merged lines'
+    // total length
+    size_t getDataSize() const;
+
+    // A line with its terminator, as it is in the file
+    std::string_view getRawLine(size_t index) const;
+
+    // Byte offset where a line starts; index == getLineCount() gives the
+    // end of the last line
+    size_t getLineOffset(size_t index) const { return offsets_[index]; }
+
+    // Index of the line containing a byte offset
+    size_t lineAtOffset(size_t offset) const;
+
+    // How long indexing the lines took (so far, while a file is being read)
+    ScanRate getIndexRate() const {
+        return backend_ == ReadBackend::Read && spool_ ? spool_->indexRate() : index_rate_;
+    }
+
+    // Bytes held by the line offset table (and a merged view's index)
+    size_t getIndexMemory() const;
+
+    // Give back the offset table's spare capacity (vector growth can leave
+    // up to half of it unused); costs one copy of the table
+    void trimIndex();
+
+    // Input held in anonymous memory: a stream's buffer (the rest is
+    // spilled to disk), or the read buffers of a file still being read
+    size_t getStreamMemory() const;
+
+    // How open() got the bytes (Mmap or Read, never Auto), and for Read
+    // what carries the requests
+    ReadBackend getBackend() const { return backend_; }
+    IoEngine getIoEngine() const { return spool_ ? spool_->ioEngine() : IoEngine::PreadPool; }
 
     // Check if file is opened
     bool isOpen() const;
@@ -47,8 +137,18 @@ public:
     // Get filename
     const std::string& getFilename() const { return filename_; }
 
+    // Descriptor of the mapped file for kernel-side copies; -1 for streams,
+    // empty files and on Windows
+    int getFileDescriptor() const;
+
 private:
     void indexLines();
+    bool readFile(const ReadOptions& options);
+
+    // Index bookkeeping of indexLines()
+    void beginIndex();
+    void indexBlock(size_t begin, size_t end);
+    void finishIndex(std::chrono::steady_clock::time_point started);
     void indexLinesLargeFile();
     std::string readLineFromFile(size_t offset, size_t length) const;
 
@@ -57,7 +157,22 @@ private:
     std::string filename_;
     char* mapped_data_;
     size_t file_size_;
-    std::vector<size_t> line_offsets_;  // Offset of each line start
+    std::vector<size_t> line_offsets_;  // Start of each line, then the end of the last one
+    std::atomic<size_t> indexed_lines_;
+
+    // Either line_offsets_ and indexed_lines_, or the spool's growing index
+    // (a stream, or a file opened with ReadBackend::Read)
+    const size_t* offsets_;
+    const std::atomic<size_t>* line_count_;
+    std::unique_ptr<StreamSpool> spool_;
+
+    // Merged view: line_offsets_ holds offsets as if the merged lines were
+    // one file, so searches and row positions work unchanged
+    std::vector<std::unique_ptr<LogReader>> sources_;
+    std::vector<std::string> source_tags_;
+    std::vector<uint64_t> merge_index_;  // packLineSource() per merged line
+    ScanRate index_rate_;
+    ReadBackend backend_;
     bool use_mmap_;  // true for small files, false for large files
 
     // For large file support
@@ -0,0 +1,272 @@
+#include "log_templates.hpp"
+#include "parallel.hpp"
+#include "trace.hpp"
+#include <algorithm>
+
+namespace {
+
+using Token = SyntaxHighlighter::Token;
+
+// Only the start of very long lines is tokenized; MAX_WORDS fit well within
+constexpr size_t MAX_LINE_BYTES = 4096;
+
+// Characters std::string keeps inline
+constexpr size_t INLINE_WORD_BYTES = 15;
+
+bool isDigit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+bool isHexDigit(char c) {
+    return isDigit(c) || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F');
+}
+
+// Numbers, addresses and times as the highlighter sees them, plus ids:
+// "0x1f3a", "a3f9c2e1", UUIDs and words such as "45ms" or "2025-01-01"
+bool isVariable(const Token& token, std::string_view text) {
+    switch (token.type) {
+        case Token::Type::Number:
+        case Token::Type::IPAddress:
+        case Token::Type::Timestamp:
+            return true;
+        case Token::Type::Normal:
+        case Token::Type::Key:
+            break;
+        default:
+            return false;
+    }
+    if (std::none_of(text.begin(), text.end(), isDigit)) {
+        return false;
+    }
+    if (isDigit(text[0]) || text.substr(0, 2) == "0x") {
+        return true;
+    }
+    return text.size() >= 8 && std::all_of(text.begin(), text.end(), [](char c) {
+        return isHexDigit(c) || c == '-';
+    });
+}
+
+bool isSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+bool isCancelled(const TemplateCancel& cancelled) {
+    return cancelled && cancelled();
+}
+
+} // namespace
+
+std::string LogTemplate::text() const {
+    std::string result;
+    for (const auto& word : words) {
+        if (!result.empty()) {
+            result += ' ';
+        }
+        result += word;
+    }
+    return result;
+}
+
+TemplateMiner::TemplateMiner(const SyntaxHighlighter& highlighter)
+    : highlighter_(highlighter) {
+}
+
+void TemplateMiner::add(std::string_view line) {
+    maskLine(line, buffer_, tokens_, words_);
+    addWords(words_, 1);
+}
+
+void TemplateMiner::merge(const TemplateMiner& other) {
+    std::vector<std::string_view> words;
+    for (const auto& log_template : other.templates_) {
+        words.assign(log_template.words.begin(), log_template.words.end());
+        addWords(words, log_template.count);
+    }
+}
+
+void TemplateMiner::addWords(const std::vector<std::string_view>& words, uint64_t count) {
+    lines_ += count;
+
+    // Bucket: word count and the first words (never wildcarded within it)
+    key_ = std::to_string(words.size());
+    for (size_t i = 0; i < std::min(words.size(), PREFIX_WORDS); ++i) {
+        key_ += '\x1f';
+        key_ += words[i];
+    }
+    auto& bucket = buckets_[key_];
+
+    // The most similar template; ties go to the more general one
+    int best = -1;
+    double best_similarity = -1.0;
+    size_t best_wildcards = 0;
+    for (uint32_t index : bucket) {
+        const LogTemplate& candidate = templates_[index];
+        size_t equal = 0;
+        size_t wildcards = 0;
+        for (size_t i = 0; i < words.size(); ++i) {
+            equal += candidate.words[i] == words[i];
+            wildcards += candidate.words[i] == WILDCARD;
+        }
+        double similarity = words.empty() ? 1.0 : static_cast<double>(equal) / static_cast<double>(words.size());
+        if (similarity > best_similarity || (similarity == best_similarity && wildcards > best_wildcards)) {
+            best = static_cast<int>(index);
+            best_similarity = similarity;
+            best_wildcards = wildcards;
+        }
+    }
+
+    if (best >= 0 && best_similarity >= SIMILARITY) {
+        LogTemplate& target = templates_[static_cast<size_t>(best)];
+        target.count += count;
+        for (size_t i = 0; i < words.size(); ++i) {
+            if (target.words[i] != words[i] && target.words[i] != WILDCARD) {
+                if (target.words[i].size() > INLINE_WORD_BYTES) {
+                    word_bytes_ -= target.words[i].size() + 1;
+                }
+                target.words[i] = WILDCARD;
+            }
+        }
+        return;
+    }
+
+    bucket.push_back(static_cast<uint32_t>(templates_.size()));
+    LogTemplate& created = templates_.emplace_back();
+    created.count = count;
+    created.words.reserve(words.size());
+    for (std::string_view word : words) {
+        created.words.emplace_back(word);
+        if (word.size() > INLINE_WORD_BYTES) {
+            word_bytes_ += word.size() + 1;
+        }
+    }
+}
+
+std::vector<LogTemplate> TemplateMiner::templates() const {
+    std::vector<LogTemplate> result = templates_;
+    std::stable_sort(result.begin(), result.end(), [](const LogTemplate& a, const LogTemplate& b) {
+        return a.count > b.count;
+    });
+    return result;
+}
+
+size_t TemplateMiner::memoryUsage() const {
+    size_t bytes = templates_.capacity() * sizeof(LogTemplate) + word_bytes_;
+    for (const auto& log_template : templates_) {
+        bytes += log_template.words.capacity() * sizeof(std::string);
+    }
+    // A bucket node holds its key, the index vector, the next pointer and the hash
+    constexpr size_t BUCKET_BYTES = sizeof(std::string) + sizeof(std::vector<uint32_t>) + 2 * sizeof(void*);
+    bytes += buckets_.size() * BUCKET_BYTES + buckets_.bucket_count() * sizeof(void*);
+    return bytes + templates_.size() * sizeof(uint32_t);
+}
+
+void TemplateMiner::maskLine(std::string_view line, std::string& buffer,
+                             std::vector<Token>& tokens,
+                             std::vector<std::string_view>& words) const {
+    line = line.substr(0, MAX_LINE_BYTES);
+    highlighter_.tokenize(line, tokens);
+
+    buffer.clear();
+    size_t pos = 0;
+    for (const Token& token : tokens) {
+        if (token.offset > pos) {
+            buffer.append(line.substr(pos, token.offset - pos));
+        }
+        std::string_view text = token.textIn(line);
+        if (isVariable(token, text)) {
+            buffer.append(WILDCARD);
+        } else {
+            buffer.append(text);
+        }
+        pos = token.offset + token.length;
+    }
+    if (pos < line.size()) {
+        buffer.append(line.substr(pos));
+    }
+
+    // Views are taken once the buffer is complete
+    words.clear();
+    std::string_view masked = buffer;
+    size_t i = 0;
+    while (i < masked.size() && words.size() < MAX_WORDS) {
+        while (i < masked.size() && isSpace(masked[i])) {
+            ++i;
+        }
+        size_t start = i;
+        while (i < masked.size() && !isSpace(masked[i])) {
+            ++i;
+        }
+        if (i > start) {
+            words.push_back(masked.substr(start, i - start));
+        }
+    }
+}
+
+bool TemplateMiner::matches(const LogTemplate& log_template, const std::vector<std::string_view>& words) {
+    if (words.size() != log_template.words.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < words.size(); ++i) {
+        if (log_template.words[i] != WILDCARD && log_template.words[i] != words[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::vector<LogTemplate> mineTemplates(const LogReader& reader, const RowView& rows,
+                                       const SyntaxHighlighter& highlighter, size_t threads,
+                                       const TemplateCancel& cancelled) {
+    size_t workers = workerCount(rows.size(), MIN_TEMPLATE_ROWS_PER_THREAD, threads);
+    std::vector<TemplateMiner> miners;
+    miners.reserve(workers);
+    for (size_t i = 0; i < workers; ++i) {
+        miners.emplace_back(highlighter);
+    }
+
+    parallelFor(rows.size(), workers, [&](size_t worker, size_t begin, size_t end) {
+        TRACE_SCOPE_ARG("mine templates", "rows", end - begin);
+        for (size_t row = begin; row < end; ++row) {
+            if ((row - begin) % TEMPLATE_CANCEL_CHECK_ROWS == 0 && isCancelled(cancelled)) {
+                return;
+            }
+            miners[worker].add(reader.getLine(rows.select(row)));
+        }
+    }, "template worker");
+
+    for (size_t i = 1; i < workers; ++i) {
+        miners[0].merge(miners[i]);
+    }
+    return miners[0].templates();
+}
+
+RowView templateRows(const LogReader& reader, const RowView& rows,
+                     const SyntaxHighlighter& highlighter, const LogTemplate& log_template,
+                     size_t threads, const TemplateCancel& cancelled) {
+    size_t workers = workerCount(rows.size(), MIN_TEMPLATE_ROWS_PER_THREAD, threads);
+    std::vector<std::vector<size_t>> results(workers);
+    TemplateMiner masker(highlighter);  // maskLine() only reads the highlighter
+
+    parallelFor(rows.size(), workers, [&](size_t worker, size_t begin, size_t end) {
+        TRACE_SCOPE_ARG("template rows", "rows", end - begin);
+        std::string buffer;
+        std::vector<Token> tokens;
+        std::vector<std::string_view> words;
+        for (size_t row = begin; row < end; ++row) {
+            if ((row - begin) % TEMPLATE_CANCEL_CHECK_ROWS == 0 && isCancelled(cancelled)) {
+                return;
+            }
+            size_t line = rows.select(row);
+            masker.maskLine(reader.getLine(line), buffer, tokens, words);
+            if (TemplateMiner::matches(log_template, words)) {
+                results[worker].push_back(line);
+            }
+        }
+    }, "template worker");
+
+    std::vector<size_t> lines;
+    for (const auto& result : results) {
+        lines.insert(lines.end(), result.begin(), result.end());
+    }
+    return rows.inFileOrder() ? RowView::fromLines(std::move(lines)) : RowView::fromOrder(std::move(lines));
+}
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "log_reader.hpp"
+#include "row_view.hpp"
+#include "syntax_highlighter.hpp"
+
+// Message templates mined from lines in the style of Drain (He et al.,
+// ICWS'17): variable tokens are masked first, lines are bucketed by word
+// count and their first words, and within a bucket a line joins the most
+// similar template, whose differing words become wildcards:
+//
+//   "user 42 logged in from 10.0.0.1"  ->  "user <*> logged in from <*>"
+//
+// Masking reuses the highlighter's classification (Number, IPAddress,
+// Timestamp) and adds hex ids and words starting with a digit ("45ms").
+
+struct LogTemplate {
+    std::vector<std::string> words;  // WILDCARD where lines differ
+    uint64_t count = 0;              // Lines clustered into it
+
+    // The words joined by spaces
+    std::string text() const;
+};
+
+class TemplateMiner {
+public:
+    static constexpr std::string_view WILDCARD = "<*>";
+
+    // Lines longer than this many words are clustered on their first ones
+    static constexpr size_t MAX_WORDS = 64;
+
+    // Words that identify a bucket, after the word count
+    static constexpr size_t PREFIX_WORDS = 2;
+
+    // Fraction of equal words a line needs to join a template
+    static constexpr double SIMILARITY = 0.5;
+
+    explicit TemplateMiner(const SyntaxHighlighter& highlighter);
+
+    // Cluster one line
+    void add(std::string_view line);
+
+    // Fold another miner's templates into this one, as if its lines had been
+    // added here; every worker of a parallel pass mines its own slice
+    void merge(const TemplateMiner& other);
+
+    // The templates, most frequent first (ties in order of appearance)
+    std::vector<LogTemplate> templates() const;
+
+    size_t size() const { return templates_.size(); }
+    uint64_t lineCount() const { return lines_; }
+
+    // Approximate heap bytes held
+    size_t memoryUsage() const;
+
+    // Words of `line` with variable tokens masked; the views point into
+    // `buffer`, `tokens` is scratch space
+    void maskLine(std::string_view line, std::string& buffer,
+                  std::vector<SyntaxHighlighter::Token>& tokens,
+                  std::vector<std::string_view>& words) const;
+
+    // Whether masked words fit a template
+    static bool matches(const LogTemplate& log_template, const std::vector<std::string_view>& words);
+
+private:
+    // Add `count` lines with these (masked) words
+    void addWords(const std::vector<std::string_view>& words, uint64_t count);
+
+    const SyntaxHighlighter& highlighter_;
+    std::vector<LogTemplate> templates_;
+    std::unordered_map<std::string, std::vector<uint32_t>> buckets_;  // Bucket key -> templates
+    uint64_t lines_ = 0;
+    size_t word_bytes_ = 0;  // Characters held by template words
+
+    // Scratch reused between add() calls
+    std::string buffer_;
+    std::string key_;
+    std::vector<SyntaxHighlighter::Token> tokens_;
+    std::vector<std::string_view> words_;
+};
+
+// Stop predicate for a long pass, polled by every worker each
+// TEMPLATE_CANCEL_CHECK_ROWS rows; empty: never stop
+using TemplateCancel = std::function<bool()>;
+
+// Mine the templates of `rows` across `threads` workers (0: one per core);
+// the workers' miners are merged in row order, so one thread count always
+// gives the same result. Once `cancelled` returns true the workers stop
+// and the result is partial, for the caller to discard.
+std::vector<LogTemplate> mineTemplates(const LogReader& reader, const RowView& rows,
+                                       const SyntaxHighlighter& highlighter, size_t threads = 0,
+                                       const TemplateCancel& cancelled = {});
+
+// The rows whose lines fit `log_template`, in the order of `rows`; partial
+// once `cancelled` returns true, as for mineTemplates()
+RowView templateRows(const LogReader& reader, const RowView& rows,
+                     const SyntaxHighlighter& highlighter, const LogTemplate& log_template,
+                     size_t threads = 0, const TemplateCancel& cancelled = {});
+
+// Below this many rows per worker mining stays on one thread
+constexpr size_t MIN_TEMPLATE_ROWS_PER_THREAD = 16384;
+
+// Rows a worker handles between two calls of the stop predicate
+constexpr size_t TEMPLATE_CANCEL_CHECK_ROWS = 4096;
@@ -0,0 +1,311 @@
+#include "log_view.hpp"
+#include "trace.hpp"
+#include <algorithm>
+#include <charconv>
+
+using namespace ftxui;
+
+namespace {
+
+constexpr int MIN_NUMBER_WIDTH = 8;
+constexpr std::string_view GUTTER_SEPARATOR = " │ ";
+constexpr std::string_view REPLACEMENT_GLYPH = "\xEF\xBF\xBD";  // U+FFFD
+
+// Source tags of a merged view, one colour per file in turn
+const Color SOURCE_COLORS[] = {Color::Cyan, Color::Magenta, Color::Yellow,
+                               Color::BlueLight, Color::RedLight, Color::White};
+
+// Bytes in the UTF-8 sequence starting with `lead`; 0 for a continuation byte
+inline size_t sequenceLength(unsigned char lead) {
+    if (lead < 0x80) return 1;
+    if (lead < 0xC0) return 0;
+    if (lead < 0xE0) return 2;
+    if (lead < 0xF0) return 3;
+    if (lead < 0xF8) return 4;
+    return 0;
+}
+
+struct CellStyle {
+    Color foreground = Color::Default;
+    Color background = Color::Default;
+    bool bold = false;
+    bool inverted = false;
+    bool underlined = false;
+};
+
+// Overwrite every attribute so nothing from the previous frame leaks through
+inline void paint(Screen& screen, int x, int y, std::string_view glyph, const CellStyle& style) {
+    Pixel& pixel = screen.PixelAt(x, y);
+    // Most cells keep their glyph from frame to frame; skipping the equal
+    // ones also keeps GCC's -Wrestrict false positive on assign() away
+    if (pixel.character != glyph) {
+        pixel.character.clear();
+        pixel.character.append(glyph.data(), glyph.size());
+    }
+    pixel.foreground_color = style.foreground;
+    pixel.background_color = style.background;
+    pixel.bold = style.bold;
+    pixel.inverted = style.inverted;
+    pixel.underlined = style.underlined;
+    pixel.dim = false;
+    pixel.blink = false;
+    pixel.underlined_double = false;
+    pixel.strikethrough = false;
+}
+
+// Paint `text` glyph by glyph from `x`; returns the column after it
+int paintText(Screen& screen, int x, int x_max, int y, std::string_view text, const CellStyle& style) {
+    for (size_t i = 0; i < text.size() && x <= x_max;) {
+        size_t glyph = std::max<size_t>(1, sequenceLength(static_cast<unsigned char>(text[i])));
+        paint(screen, x++, y, text.substr(i, glyph), style);
+        i += glyph;
+    }
+    return x;
+}
+
+inline int digitCount(size_t value) {
+    int digits = 1;
+    while (value >= 10) {
+        value /= 10;
+        ++digits;
+    }
+    return digits;
+}
+
+} // namespace
+
+LogView::LogView(Frame frame)
+    : frame_(std::move(frame)) {
+}
+
+void LogView::ComputeRequirement() {
+    // Takes whatever space the layout gives it
+    requirement_.min_x = 0;
+    requirement_.min_y = 0;
+    requirement_.flex_grow_x = 1;
+    requirement_.flex_grow_y = 1;
+    requirement_.flex_shrink_x = 1;
+    requirement_.flex_shrink_y = 1;
+}
+
+void LogView::Render(Screen& screen) {
+    TRACE_SCOPE_ARG("LogView::Render", "rows", frame_.rows.size());
+    size_t max_line_number = 0;
+    for (const auto& row : frame_.rows) {
+        max_line_number = std::max(max_line_number, row.line_number);
+    }
+    number_width_ = std::max(MIN_NUMBER_WIDTH, digitCount(max_line_number));
+    source_width_ = sourceWidth(frame_.source_tags);
+
+    size_t row_index = 0;
+    for (int y = box_.y_min; y <= box_.y_max; ++y, ++row_index) {
+        if (row_index < frame_.rows.size()) {
+            renderRow(screen, frame_.rows[row_index], y);
+        } else {
+            for (int x = box_.x_min; x <= box_.x_max; ++x) {
+                paint(screen, x, y, " ", CellStyle{});
+            }
+        }
+    }
+}
+
+int LogView::sourceWidth(std::span<const std::string> tags) {
+    size_t width = 0;
+    for (const auto& tag : tags) {
+        width = std::max(width, tag.size());
+    }
+    return width == 0 ? 0 : static_cast<int>(width) + 1;  // A space before the number
+}
+
+void LogView::renderRow(Screen& screen, const Row& row, int y) {
+    CellStyle base;
+    if (row.selected) {
+        base.background = Color::Blue;
+        base.bold = true;
+    }
+
+    int x = box_.x_min;
+
+    // Gutter: right-aligned line number, formatted without streams
+    char digits[24];
+    auto result = std::to_chars(std::begin(digits), std::end(digits), row.line_number);
+    int length = static_cast<int>(result.ptr - digits);
+
+    if (source_width_ > 0 && row.source >= 0 &&
+        static_cast<size_t>(row.source) < frame_.source_tags.size()) {
+        CellStyle tag = base;
+        tag.foreground = SOURCE_COLORS[static_cast<size_t>(row.source) % std::size(SOURCE_COLORS)];
+        int tag_end = x + source_width_;
+        x = paintText(screen, x, std::min(box_.x_max, tag_end - 1), y,
+                      frame_.source_tags[static_cast<size_t>(row.source)], tag);
+        while (x < tag_end && x <= box_.x_max) {
+            paint(screen, x++, y, " ", tag);
+        }
+    } else {
+        for (int end = x + source_width_; x < end && x <= box_.x_max;) {
+            paint(screen, x++, y, " ", base);
+        }
+    }
+
+    CellStyle gutter = base;
+    gutter.foreground = Color::GreenLight;
+    for (int i = 0; i < number_width_ - length && x <= box_.x_max; ++i) {
+        paint(screen, x++, y, " ", gutter);
+    }
+    for (int i = 0; i < length && x <= box_.x_max; ++i) {
+        paint(screen, x++, y, std::string_view(digits + i, 1), gutter);
+    }
+    x = paintText(screen, x, box_.x_max, y, GUTTER_SEPARATOR, gutter);
+
+    size_t content_start = 0;
+    if (row.fields) {
+        x = renderFields(screen, *row.fields, x, y, row.selected);
+        content_start = row.fields->message;
+    }
+
+    // The first visible column, found through the line's layout
+    std::string_view line = row.text;
+    std::optional<LineLayout> own_layout;
+    const LineLayout* layout = row.layout;
+    if (layout == nullptr) {
+        layout = &own_layout.emplace(line);
+    }
+    size_t first_column = layout->columnAtByte(line, content_start) + frame_.column;
+    LineLayout::Position start = layout->glyphAtColumn(line, first_column);
+    size_t pos = start.byte;
+    if (start.column < first_column) {
+        // A wide glyph cut by the left edge: its visible half is blank
+        Utf8Glyph glyph = decodeGlyph(line, pos);
+        for (size_t column = first_column; column < start.column + glyph.width && x <= box_.x_max; ++column) {
+            paint(screen, x++, y, " ", base);
+        }
+        pos += glyph.length;
+    }
+
+    // Content: walk glyphs, tokens and both match lists together; all are sorted by offset
+    int glyph_x = -1;  // Cell of the last glyph painted, which combining marks join
+    size_t token = 0;
+    size_t styled_token = row.tokens.size();  // Token whose style `token_style` holds
+    SyntaxHighlighter::Style token_style;
+    size_t match = 0;
+    size_t search = 0;
+
+    while (x <= box_.x_max && pos < line.size()) {
+        while (token < row.tokens.size() &&
+               static_cast<size_t>(row.tokens[token].offset) + row.tokens[token].length <= pos) {
+            ++token;
+        }
+        while (match < row.matches.size() &&
+               static_cast<size_t>(row.matches[match].offset) + row.matches[match].length <= pos) {
+            ++match;
+        }
+        while (search < row.search_matches.size() &&
+               static_cast<size_t>(row.search_matches[search].offset) + row.search_matches[search].length <= pos) {
+            ++search;
+        }
+
+        CellStyle style = base;
+        if (token < row.tokens.size() && row.tokens[token].offset <= pos) {
+            if (styled_token != token) {
+                token_style = SyntaxHighlighter::styleFor(line, row.tokens[token]);
+                styled_token = token;
+            }
+            if (token_style.foreground != Color::Default) {
+                style.foreground = token_style.foreground;
+            }
+            style.bold = style.bold || token_style.bold;
+        }
+        if (match < row.matches.size() && row.matches[match].offset <= pos) {
+            style.inverted = true;
+            style.underlined = static_cast<int>(match) == row.current_match;
+        }
+        if (search < row.search_matches.size() && row.search_matches[search].offset <= pos) {
+            // Search hits win over filter matches
+            style.foreground = Color::Black;
+            style.background = Color::Yellow;
+            style.inverted = false;
+            style.underlined = static_cast<int>(search) == row.current_search;
+            style.bold = style.bold || style.underlined;
+        }
+
+        // Cells as the layout counted them; control characters and broken
+        // sequences are replaced
+        Utf8Glyph glyph = decodeGlyph(line, pos);
+        std::string_view text = line.substr(pos, glyph.length);
+        if (glyph.kind == Utf8Glyph::Kind::Invalid) {
+            paint(screen, x++, y, REPLACEMENT_GLYPH, style);
+            glyph_x = -1;
+        } else if (glyph.kind == Utf8Glyph::Kind::Control) {
+            paint(screen, x++, y, " ", style);
+            glyph_x = -1;
+        } else if (glyph.width == 0 && pos > 0) {
+            if (glyph_x >= 0) {
+                screen.PixelAt(glyph_x, y).character.append(text);
+            }
+        } else if (glyph.width == 2) {
+            if (x + 1 > box_.x_max) {
+                paint(screen, x++, y, " ", style);  // Half a glyph does not fit
+            } else {
+                glyph_x = x;
+                paint(screen, x++, y, text, style);
+                paint(screen, x++, y, "", style);  // Covered by the glyph
+            }
+        } else {
+            glyph_x = x;
+            paint(screen, x++, y, text, style);
+        }
+        pos += glyph.length;
+    }
+
+    // Rest of the row keeps the selection background
+    while (x <= box_.x_max) {
+        paint(screen, x++, y, " ", base);
+    }
+}
+
+int LogView::renderFields(Screen& screen, const LineFields& fields, int x, int y, bool selected) {
+    CellStyle base;
+    if (selected) {
+        base.background = Color::Blue;
+        base.bold = true;
+    }
+
+    std::string timestamp = formatTimestamp(fields.timestamp);
+    timestamp.resize(TIMESTAMP_WIDTH, ' ');
+    CellStyle timestamp_style = base;
+    timestamp_style.foreground = Color::GrayLight;
+    x = paintText(screen, x, box_.x_max, y, timestamp, timestamp_style);
+    x = paintText(screen, x, box_.x_max, y, " ", base);
+
+    // Level colours follow the syntax highlighter's
+    CellStyle level_style = base;
+    switch (fields.level) {
+        case LogLevel::Fatal:
+        case LogLevel::Error:
+            level_style.foreground = Color::Red;
+            level_style.bold = true;
+            break;
+        case LogLevel::Warn:
+            level_style.foreground = Color::Yellow;
+            level_style.bold = true;
+            break;
+        case LogLevel::Info:
+            level_style.foreground = Color::Blue;
+            level_style.bold = true;
+            break;
+        default:
+            level_style.foreground = Color::GrayLight;
+            break;
+    }
+    std::string level(levelName(fields.level));
+    level.resize(LEVEL_WIDTH, ' ');
+    x = paintText(screen, x, box_.x_max, y, level, level_style);
+
+    CellStyle separator = base;
+    separator.foreground = Color::GreenLight;
+    return paintText(screen, x, box_.x_max, y, GUTTER_SEPARATOR, separator);
+}
+
+Element logView(LogView::Frame frame) {
+    return std::make_shared<LogView>(std::move(frame));
+}
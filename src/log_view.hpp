@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "ftxui/dom/node.hpp"
+#include "syntax_highlighter.hpp"
+#include "match_index.hpp"
+#include "log_fields.hpp"
+#include "utf8_text.hpp"
+
+// Custom FTXUI node for the whole log area. Instead of an hbox of text
+// elements per token for every row, it writes glyphs and colours straight
+// into the Screen cells, so a frame costs one node regardless of how many
+// tokens are on screen. Lines are painted as the terminal shows them (see
+// utf8_text.hpp): wide glyphs take two cells, combining marks join the
+// cell before, broken sequences show as U+FFFD.
+class LogView : public ftxui::Node {
+public:
+    using Tokens = std::vector<SyntaxHighlighter::Token>;
+
+    // "%8d │ " line number column; widens for files past 99,999,999 lines.
+    // A merged view puts the line's source tag in front ("api     42 │ ").
+    static constexpr int GUTTER_WIDTH = 11;
+
+    // Column view: "2025-11-30 14:00:00.123 ERROR │ " before the message
+    static constexpr int TIMESTAMP_WIDTH = 23;
+    static constexpr int LEVEL_WIDTH = 5;
+    static constexpr int FIELDS_WIDTH = TIMESTAMP_WIDTH + 1 + LEVEL_WIDTH + 3;
+
+    struct Row {
+        size_t line_number;                       // 1-based, shown in the gutter
+        std::string_view text;                    // Whole line (mmap'ed)
+        std::span<const SyntaxHighlighter::Token> tokens;  // Empty: no highlighting
+        std::span<const MatchSpan> matches;       // Filter matches to overlay
+        int current_match = -1;                   // Index into matches, underlined
+        bool selected = false;
+        std::span<const MatchSpan> search_matches;  // Search hits, painted over everything
+        int current_search = -1;                  // Index into search_matches
+        std::optional<LineFields> fields;         // Column view: content starts at the message
+        int source = -1;                          // Merged view: index into Frame::source_tags
+        const LineLayout* layout = nullptr;       // Column positions; null: built while painting
+    };
+
+    // Everything one frame paints. It is painted after the renderer releases
+    // its lock, so the spans in `rows` point only into the reader, the
+    // highlight cache entries kept alive here, or the vectors owned here;
+    // never into the match index, which the filter thread replaces and
+    // appends to meanwhile
+    struct Frame {
+        std::vector<Row> rows;
+        size_t column = 0;  // First visible screen column of every line's content
+        std::vector<std::shared_ptr<const Tokens>> cached_tokens;
+        std::vector<Tokens> window_tokens;  // Long-line windows tokenized this frame
+        std::vector<std::vector<MatchSpan>> match_spans;   // Filter matches copied from the index
+        std::vector<std::vector<MatchSpan>> search_spans;  // Search hits found this frame
+        std::vector<std::shared_ptr<const LineLayout>> cached_layouts;
+        std::span<const std::string> source_tags;  // Merged view: gutter tag of each file
+    };
+
+    // Columns the source tags take in front of the line numbers (0: none)
+    static int sourceWidth(std::span<const std::string> tags);
+
+    explicit LogView(Frame frame);
+
+    void ComputeRequirement() override;
+    void Render(ftxui::Screen& screen) override;
+
+private:
+    void renderRow(ftxui::Screen& screen, const Row& row, int y);
+    int renderFields(ftxui::Screen& screen, const LineFields& fields, int x, int y, bool selected);
+
+    Frame frame_;
+    int number_width_ = GUTTER_WIDTH - 3;  // Digits reserved for line numbers this frame
+    int source_width_ = 0;                 // Source tag column this frame
+};
+
+// Element factory in the style of ftxui::text()/hbox()
+ftxui::Element logView(LogView::Frame frame);
@@ -1,15 +1,30 @@
+#include <algorithm>
 #include <iostream>
 #include <memory>
 #include <string>
+#include <cerrno>
 #include <cstring>
+#include <string_view>
+#include <vector>
 #include "log_reader.hpp"
 #include "filter_engine.hpp"
 #include "syntax_highlighter.hpp"
 #include "tui_display.hpp"
+#include "batch_mode.hpp"
+#include "trace.hpp"
+#include "memory_budget.hpp"
+
+#ifndef _WIN32
+    #include <fcntl.h>
+    #include <unistd.h>
+#endif
 
 void printUsage(const char* program_name) {
     std::cout << "Log Analyzer - High-Performance TUI Log Viewer\n\n";
-    std::cout << "Usage: " << program_name << " <log_file>\n\n";
+    std::cout << "Usage: " << program_name << " <log_file>\n";
+    std::cout << "       " << program_name << " <log_file> <log_file>...   (merged by timestamp)\n";
+    std::cout << "       " << program_name << " --filter PATTERN [--count|--print] [--line-numbers] <log_file>\n";
+    std::cout << "       <command> | " << program_name << " [options] [-]\n\n";
     std::cout << "Description:\n";
     std::cout << "  A fast terminal-based log analyzer for large files (up to 50+ GB)\n";
     std::cout << "  Uses memory-mapped files for instant loading and regex filtering\n\n";
@@ -22,11 +37,109 @@ void printUsage(const char* program_name) {
     std::cout << "  ↑/↓          Navigate lines\n";
     std::cout << "  PgUp/PgDn    Scroll page\n";
     std::cout << "  Home/End     Jump to start/end\n";
+    std::cout << "  Enter/Tab    Leave the filter input and navigate\n";
+    std::cout << "  Tab          Back to the filter input\n";
+    std::cout << "  / or ?       Search forward/backward (less-style)\n";
+    std::cout << "  n/N          Repeat search / reverse (filter matches without one)\n";
+    std::cout << "  ←/→ and 0    Scroll long lines / back to column 1\n";
+    std::cout << "  S            Save the visible lines to a file\n";
+    std::cout << "  O            Sort by line, time or level\n";
+    std::cout << "  C            Toggle the timestamp / level columns\n";
+    std::cout << "  G            Group matching lines by a key (table of counts)\n";
+    std::cout << "  T            Collapse the visible lines into message templates\n";
     std::cout << "  H            Toggle syntax highlighting\n";
+    std::cout << "  P            Toggle the performance overlay\n";
     std::cout << "  Q/Esc        Quit\n\n";
+    std::cout << "Batch mode (no TUI):\n";
+    std::cout << "  --filter PATTERN       Print matching lines (regex or json: query)\n";
+    std::cout << "  -c, --count            Print only the number of matching lines\n";
+    std::cout << "  --print                Print the matching lines (default)\n";
+    std::cout << "  -n, --line-numbers     Prefix lines with their 1-based line number\n";
+    std::cout << "  --group-by KEY [VALUE] Count matching lines per key instead of printing\n";
+    std::cout << "                         them; KEY: $N (capture), level, minute, hour or\n";
+    std::cout << "                         json:PATH; VALUE ($N or json:PATH) adds sum, min,\n";
+    std::cout << "                         max and average of its leading number\n";
+    std::cout << "  --threads N            Scan threads (default: one per core)\n";
+    std::cout << "  -o, --output FILE      Write the lines to FILE instead of stdout\n";
+    std::cout << "                         (without --filter: every line, e.g. to save a pipe)\n";
+    std::cout << "  Exit status: 0 if a line matched, 1 if none, 2 on error\n\n";
+    std::cout << "Input:\n";
+    std::cout << "  --io MODE              How files are loaded: mmap, read (large parallel\n";
+    std::cout << "                         reads with io_uring or pread threads through a few\n";
+    std::cout << "                         fixed buffers, lines shown and filtered as they\n";
+    std::cout << "                         arrive) or auto (default: read on NFS/SMB/FUSE,\n";
+    std::cout << "                         else mmap)\n";
+    std::cout << "  --io-block SIZE        Bytes per read request (default 1M)\n";
+    std::cout << "  --io-depth N           Read requests in flight (default 8); buffers take\n";
+    std::cout << "                         block size x depth bytes while a file is read\n\n";
+    std::cout << "Memory:\n";
+    std::cout << "  --mem-limit SIZE       Budget for the line index, filter results and caches\n";
+    std::cout << "                         (e.g. 512M, 2G); caches shrink first, then filters\n";
+    std::cout << "                         drop match positions and stop early\n\n";
+    std::cout << "Diagnostics:\n";
+    std::cout << "  --trace FILE           Record internal timings and write them to FILE\n";
+    std::cout << "                         on exit (Chrome trace format, open in ui.perfetto.dev)\n\n";
+    std::cout << "Several files:\n";
+    std::cout << "  Given more than one file, the lines of all of them are shown as one log\n";
+    std::cout << "  ordered by their leading timestamps, each tagged with its file in the\n";
+    std::cout << "  gutter. Filters, search and batch mode run over the merged lines.\n\n";
+    std::cout << "Standard input:\n";
+    std::cout << "  Use - as the file, or pipe into the program without one. Lines are\n";
+    std::cout << "  shown and filtered while they arrive; input beyond 1 GB is spooled\n";
+    std::cout << "  to a temporary file in $TMPDIR.\n\n";
     std::cout << "Examples:\n";
     std::cout << "  " << program_name << " /var/log/app.log\n";
-    std::cout << "  " << program_name << " large_file.log\n\n";
+    std::cout << "  " << program_name << " large_file.log\n";
+    std::cout << "  " << program_name << " --filter 'ERROR|FATAL' --count app.log\n";
+    std::cout << "  " << program_name << " --filter 'request_id=42' -o slice.log huge.log\n";
+    std::cout << "  " << program_name << " --filter 'ERROR .*GET (\\S+) .* (\\d+)ms' --group-by '$1 $2' app.log\n";
+    std::cout << "  kubectl logs my-pod | " << program_name << "\n";
+    std::cout << "  " << program_name << " api.log db.log worker.log\n";
+    std::cout << "  zcat app.log.gz | " << program_name << " --filter ERROR -\n\n";
+}
+
+// Open a file, several files merged by timestamp, or start reading standard
+// input when the only file is "-"
+bool openInput(LogReader& reader, const std::vector<std::string>& log_files,
+               const MemoryBudget& budget, size_t threads, ReadOptions read_options) {
+    const std::string& log_file = log_files.front();
+    if (log_files.size() > 1 || log_file != "-") {
+        if (std::find(log_files.begin(), log_files.end(), "-") != log_files.end()) {
+            std::cerr << "Error: standard input cannot be merged with files\n";
+            return false;
+        }
+        bool opened = log_files.size() > 1 ? reader.openMerged(log_files, threads, read_options)
+                                           : reader.open(log_file, read_options);
+        if (!opened) {
+            return false;
+        }
+        if (budget.limited()) {
+            // The index cannot be dropped, only trimmed
+            reader.trimIndex();
+            if (reader.getIndexMemory() > budget.limit()) {
+                std::cerr << "Warning: the line index alone needs "
+                          << formatBytes(reader.getIndexMemory()) << ", more than --mem-limit\n";
+            }
+        }
+        return true;
+    }
+#ifdef _WIN32
+    std::cerr << "Error: reading standard input is not supported on Windows\n";
+    return false;
+#else
+    // The reader gets its own descriptor; fd 0 may be swapped for the terminal
+    int fd = dup(STDIN_FILENO);
+    if (fd == -1) {
+        return false;
+    }
+
+    // Under a limit, spill to the temp file once half of it is buffered
+    size_t spool_memory = StreamSpool::DEFAULT_MEMORY_BUDGET;
+    if (budget.limited()) {
+        spool_memory = std::min(spool_memory, budget.limit() / 2);
+    }
+    return reader.openStream(fd, "<stdin>", spool_memory);
+#endif
 }
 
 void printError(const std::string& message) {
@@ -34,36 +147,188 @@ void printError(const std::string& message) {
     std::cerr << "Use --help for usage information.\n";
 }
 
+void writeTrace(const std::string& trace_file) {
+    std::string error;
+    if (!trace_file.empty() && !Trace::writeChromeJson(trace_file, error)) {
+        std::cerr << "Error: " << error << "\n";
+    }
+}
+
 int main(int argc, char* argv[]) {
+#ifdef _WIN32
+    bool stdin_is_pipe = false;
+#else
+    bool stdin_is_pipe = !isatty(STDIN_FILENO);
+#endif
+
     // Parse command line arguments
-    if (argc < 2) {
+    if (argc < 2 && !stdin_is_pipe) {
         printError("No log file specified");
         printUsage(argv[0]);
         return 1;
     }
 
-    // Check for help flag
-    if (argc == 2 && (std::strcmp(argv[1], "--help") == 0 ||
-                       std::strcmp(argv[1], "-h") == 0)) {
-        printUsage(argv[0]);
-        return 0;
+    std::vector<std::string> log_files;
+    std::string output_file;
+    std::string trace_file;
+    uint64_t memory_limit = 0;
+    ReadOptions read_options;
+    BatchOptions batch;
+    bool batch_mode = false;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string_view arg = argv[i];
+
+        if (arg == "--help" || arg == "-h") {
+            printUsage(argv[0]);
+            return 0;
+        } else if (arg == "--mem-limit") {
+            if (i + 1 >= argc || !parseByteSize(argv[i + 1], memory_limit) || memory_limit == 0) {
+                printError("--mem-limit needs a size such as 512M or 2G");
+                return batch_mode ? BATCH_ERROR : 1;
+            }
+            ++i;
+        } else if (arg == "--io") {
+            if (i + 1 >= argc || !parseReadBackend(argv[i + 1], read_options.backend)) {
+                printError("--io needs auto, mmap or read");
+                return batch_mode ? BATCH_ERROR : 1;
+            }
+            ++i;
+        } else if (arg == "--io-block") {
+            uint64_t block_size = 0;
+            if (i + 1 >= argc || !parseByteSize(argv[i + 1], block_size) || block_size == 0) {
+                printError("--io-block needs a size such as 256K or 4M");
+                return batch_mode ? BATCH_ERROR : 1;
+            }
+            read_options.block_size = static_cast<size_t>(block_size);
+            ++i;
+        } else if (arg == "--io-depth") {
+            size_t depth = i + 1 < argc ? static_cast<size_t>(std::strtoul(argv[i + 1], nullptr, 10)) : 0;
+            if (depth == 0 || depth > ReadOptions::MAX_QUEUE_DEPTH) {
+                printError("--io-depth needs a number from 1 to " + std::to_string(ReadOptions::MAX_QUEUE_DEPTH));
+                return batch_mode ? BATCH_ERROR : 1;
+            }
+            read_options.queue_depth = depth;
+            ++i;
+        } else if (arg == "--trace") {
+            if (i + 1 >= argc) {
+                printError("--trace needs a file");
+                return batch_mode ? BATCH_ERROR : 1;
+            }
+            trace_file = argv[++i];
+        } else if (arg == "--filter" || arg == "--threads" || arg == "--output" || arg == "-o" ||
+                   arg == "--group-by") {
+            if (i + 1 >= argc) {
+                printError(std::string(arg) + " needs a value");
+                return BATCH_ERROR;
+            }
+            if (arg == "--filter") {
+                batch.pattern = argv[++i];
+            } else if (arg == "--output" || arg == "-o") {
+                output_file = argv[++i];
+            } else if (arg == "--group-by") {
+                batch.group_by = argv[++i];
+            } else {
+                batch.threads = static_cast<size_t>(std::strtoul(argv[++i], nullptr, 10));
+            }
+            batch_mode = true;
+        } else if (arg == "--count" || arg == "-c") {
+            batch.count = true;
+            batch_mode = true;
+        } else if (arg == "--print") {
+            batch.count = false;
+            batch_mode = true;
+        } else if (arg == "--line-numbers" || arg == "-n") {
+            batch.line_numbers = true;
+            batch_mode = true;
+        } else if (arg.size() > 1 && arg[0] == '-') {
+            printError("Unknown option: " + std::string(arg));
+            return batch_mode ? BATCH_ERROR : 1;
+        } else {
+            log_files.emplace_back(arg);
+        }
     }
 
-    std::string log_file = argv[1];
+    if (log_files.empty() && stdin_is_pipe) {
+        log_files.emplace_back("-");  // Piped input without a file name
+    }
+    if (log_files.empty()) {
+        printError("No log file specified");
+        return batch_mode ? BATCH_ERROR : 1;
+    }
+
+    auto budget = std::make_shared<MemoryBudget>(static_cast<size_t>(memory_limit));
+
+    std::string reader_name;  // For messages: "a.log, b.log"
+    for (const auto& log_file : log_files) {
+        reader_name += (reader_name.empty() ? "" : ", ") + log_file;
+    }
+
+    if (!trace_file.empty()) {
+        Trace::enable();
+        TRACE_THREAD_NAME("main");
+    }
+
+    if (batch_mode) {
+        // Nothing but results on stdout; grep-style status codes
+        LogReader reader;
+        if (!openInput(reader, log_files, *budget, batch.threads, read_options)) {
+            std::cerr << "Error: Failed to open log file: " << reader_name << "\n";
+            return BATCH_ERROR;
+        }
+        FilterEngine filter;
+        std::string error;
+        int output_fd = output_file.empty() ? 1 : openExportFile(output_file, reader, error);
+        if (output_fd == -1) {
+            std::cerr << "Error: " << error << "\n";
+            return BATCH_ERROR;
+        }
+        int status = runBatch(reader, filter, batch, output_fd, error);
+        if (status == BATCH_ERROR) {
+            std::cerr << "Error: " << error << "\n";
+        }
+        if (output_fd != 1 && !closeExportFile(output_fd) && status != BATCH_ERROR) {
+            std::cerr << "Error: Write failed: " << std::strerror(errno) << "\n";
+            status = BATCH_ERROR;
+        }
+        writeTrace(trace_file);
+        return status;
+    }
 
     // Initialize components
     std::cout << "Log Analyzer v1.0\n";
-    std::cout << "Loading file: " << log_file << "\n";
+    std::cout << "Loading file: " << reader_name << "\n";
 
     auto reader = std::make_shared<LogReader>();
-    if (!reader->open(log_file)) {
-        printError("Failed to open log file: " + log_file);
+    if (!openInput(*reader, log_files, *budget, 0, read_options)) {
+        printError("Failed to open log file: " + reader_name);
         return 1;
     }
 
+#ifndef _WIN32
+    if (reader->isGrowing()) {
+        if (log_files.front() == "-") {
+            // Keyboard input comes from the terminal while the pipe feeds the log
+            int tty = ::open("/dev/tty", O_RDONLY);
+            if (tty == -1 || dup2(tty, STDIN_FILENO) == -1) {
+                printError("Reading from a pipe needs a terminal for the keyboard");
+                return 1;
+            }
+            ::close(tty);
+        }
+
+        // Give format detection a sample before the TUI starts
+        reader->waitForLines(0, std::chrono::milliseconds(1000));
+    }
+#endif
+
     std::cout << "File loaded successfully!\n";
     std::cout << "Total lines: " << reader->getLineCount() << "\n";
     std::cout << "File size: " << (reader->getFileSize() / 1024.0 / 1024.0) << " MB\n";
+    if (reader->getBackend() == ReadBackend::Read) {
+        std::cout << "Reading with " << ioEngineName(reader->getIoEngine())
+                  << (reader->isGrowing() ? ", the rest in the background\n" : "\n");
+    }
     std::cout << "\nStarting TUI...\n";
 
     // Small delay to let user see the info
@@ -74,13 +339,14 @@ int main(int argc, char* argv[]) {
 
     try {
         // Create and run TUI
-        TuiDisplay display(reader, filter, highlighter);
+        TuiDisplay display(reader, filter, highlighter, budget);
         display.run();
     } catch (const std::exception& e) {
         std::cerr << "\nFatal error: " << e.what() << "\n";
         return 1;
     }
 
+    writeTrace(trace_file);
     std::cout << "\nThank you for using Log Analyzer!\n";
     return 0;
 }
@@ -0,0 +1,98 @@
+#include "match_index.hpp"
+#include <algorithm>
+
+void MatchIndex::add(size_t line, std::span<const MatchSpan> spans) {
+    if (spans.empty()) {
+        return;
+    }
+    lines_.push_back(line);
+    first_span_.push_back(static_cast<uint32_t>(spans_.size()));
+    spans_.insert(spans_.end(), spans.begin(), spans.end());
+}
+
+void MatchIndex::clear() {
+    lines_.clear();
+    first_span_.clear();
+    spans_.clear();
+}
+
+std::span<const MatchSpan> MatchIndex::spansFor(size_t line) const {
+    auto it = std::lower_bound(lines_.begin(), lines_.end(), line);
+    if (it == lines_.end() || *it != line) {
+        return {};
+    }
+    size_t entry = static_cast<size_t>(it - lines_.begin());
+    size_t begin = first_span_[entry];
+    size_t end = entry + 1 < first_span_.size() ? first_span_[entry + 1] : spans_.size();
+    return std::span<const MatchSpan>(spans_.data() + begin, end - begin);
+}
+
+MatchIndex::Position MatchIndex::positionAt(size_t entry, size_t span_index) const {
+    return {lines_[entry], span_index, spans_[first_span_[entry] + span_index]};
+}
+
+std::optional<MatchIndex::Position> MatchIndex::next(size_t line, uint32_t offset) const {
+    auto it = std::lower_bound(lines_.begin(), lines_.end(), line);
+    if (it == lines_.end()) {
+        return std::nullopt;
+    }
+
+    size_t entry = static_cast<size_t>(it - lines_.begin());
+    if (*it == line) {
+        auto spans = spansFor(line);
+        for (size_t i = 0; i < spans.size(); ++i) {
+            if (spans[i].offset > offset) {
+                return positionAt(entry, i);
+            }
+        }
+        ++entry;  // No later span on this line
+    }
+
+    if (entry >= lines_.size()) {
+        return std::nullopt;
+    }
+    return positionAt(entry, 0);
+}
+
+std::optional<MatchIndex::Position> MatchIndex::previous(size_t line, uint32_t offset) const {
+    auto it = std::lower_bound(lines_.begin(), lines_.end(), line);
+    size_t entry = static_cast<size_t>(it - lines_.begin());
+
+    if (it != lines_.end() && *it == line) {
+        auto spans = spansFor(line);
+        for (size_t i = spans.size(); i > 0; --i) {
+            if (spans[i - 1].offset < offset) {
+                return positionAt(entry, i - 1);
+            }
+        }
+    }
+
+    if (entry == 0) {
+        return std::nullopt;
+    }
+    --entry;
+    return positionAt(entry, spansFor(lines_[entry]).size() - 1);
+}
+
+std::optional<MatchIndex::Position> MatchIndex::firstFrom(size_t line) const {
+    auto it = std::lower_bound(lines_.begin(), lines_.end(), line);
+    if (it == lines_.end()) {
+        return std::nullopt;
+    }
+    return positionAt(static_cast<size_t>(it - lines_.begin()), 0);
+}
+
+std::optional<MatchIndex::Position> MatchIndex::lastUpTo(size_t line) const {
+    auto it = std::upper_bound(lines_.begin(), lines_.end(), line);
+    if (it == lines_.begin()) {
+        return std::nullopt;
+    }
+    size_t entry = static_cast<size_t>(it - lines_.begin()) - 1;
+    return positionAt(entry, spansFor(lines_[entry]).size() - 1);
+}
+
+size_t MatchIndex::memoryUsage() const {
+    return lines_.capacity() * sizeof(size_t) +
+           first_span_.capacity() * sizeof(uint32_t) +
+           spans_.capacity() * sizeof(MatchSpan);
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <vector>
+
+// Where a filter pattern matched inside a line
+struct MatchSpan {
+    uint32_t offset;
+    uint32_t length;
+
+    bool operator==(const MatchSpan&) const = default;
+};
+
+// Compact side structure with the match spans of every matching line,
+// recorded during the filter scan so rendering never re-runs the regex.
+// Lines must be added in ascending order.
+class MatchIndex {
+public:
+    struct Position {
+        size_t line;        // Line index in the file
+        size_t span_index;  // Index of the span within that line
+        MatchSpan span;
+    };
+
+    void add(size_t line, std::span<const MatchSpan> spans);
+    void add(size_t line, const std::vector<MatchSpan>& spans) { add(line, std::span<const MatchSpan>(spans)); }
+    void clear();
+
+    // Spans recorded for a line (empty if none)
+    std::span<const MatchSpan> spansFor(size_t line) const;
+
+    // First match strictly after / before (line, offset); nullopt when there is none
+    std::optional<Position> next(size_t line, uint32_t offset) const;
+    std::optional<Position> previous(size_t line, uint32_t offset) const;
+
+    // First match on or after `line` / last match on or before `line`
+    std::optional<Position> firstFrom(size_t line) const;
+    std::optional<Position> lastUpTo(size_t line) const;
+
+    size_t lineCount() const { return lines_.size(); }
+    size_t spanCount() const { return spans_.size(); }
+    bool empty() const { return spans_.empty(); }
+    size_t memoryUsage() const;
+
+private:
+    Position positionAt(size_t entry, size_t span_index) const;
+
+    std::vector<size_t> lines_;        // Sorted line indices that have spans
+    std::vector<uint32_t> first_span_; // Start of each line's spans in spans_
+    std::vector<MatchSpan> spans_;
+};
@@ -0,0 +1,68 @@
+#include "memory_budget.hpp"
+#include <charconv>
+#include <cstdint>
+#include <utility>
+
+MemoryBudget::MemoryBudget(size_t limit)
+    : limit_(limit) {
+}
+
+void MemoryBudget::set(Account account, size_t bytes) {
+    used_[static_cast<size_t>(account)].store(bytes, std::memory_order_relaxed);
+}
+
+size_t MemoryBudget::used(Account account) const {
+    return used_[static_cast<size_t>(account)].load(std::memory_order_relaxed);
+}
+
+size_t MemoryBudget::total() const {
+    size_t sum = 0;
+    for (const auto& bytes : used_) {
+        sum += bytes.load(std::memory_order_relaxed);
+    }
+    return sum;
+}
+
+size_t MemoryBudget::headroom(Account account) const {
+    if (!limited()) {
+        return SIZE_MAX;
+    }
+    size_t essential = 0;
+    for (size_t i = 0; i < static_cast<size_t>(account); ++i) {
+        essential += used_[i].load(std::memory_order_relaxed);
+    }
+    return essential < limit_ ? limit_ - essential : 0;
+}
+
+const char* MemoryBudget::name(Account account) {
+    switch (account) {
+        case Account::Index: return "index";
+        case Account::Stream: return "stream";
+        case Account::Results: return "results";
+        case Account::Highlight: return "highlight";
+    }
+    return "?";
+}
+
+bool parseByteSize(std::string_view text, uint64_t& bytes) {
+    uint64_t number = 0;
+    auto result = std::from_chars(text.data(), text.data() + text.size(), number);
+    if (result.ec != std::errc() || result.ptr == text.data()) {
+        return false;
+    }
+    std::string_view suffix(result.ptr, static_cast<size_t>(text.data() + text.size() - result.ptr));
+    static const std::pair<std::string_view, uint64_t> UNITS[] = {
+        {"", 1}, {"K", 1ULL << 10}, {"M", 1ULL << 20}, {"G", 1ULL << 30}, {"T", 1ULL << 40},
+        {"KB", 1ULL << 10}, {"MB", 1ULL << 20}, {"GB", 1ULL << 30}, {"TB", 1ULL << 40},
+    };
+    for (const auto& [name, scale] : UNITS) {
+        if (suffix == name) {
+            if (number > UINT64_MAX / scale) {
+                return false;  // Would wrap around to a small size
+            }
+            bytes = number * scale;
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+// Central account of the viewer's own allocations against an optional
+// global limit (--mem-limit). Subsystems publish their current size to
+// their account; each owner applies its own policy once headroom() runs
+// out. Accounts are ordered by how essential they are: one may use what
+// the accounts before it leave, so the highlight cache gives way to filter
+// results and results give way to the line index. Pages of a mapped file
+// belong to the page cache and are not counted.
+class MemoryBudget {
+public:
+    enum class Account {
+        Index,      // Line offset table
+        Stream,     // Anonymous buffer behind stdin / pipe input, or a file loaded with reads
+        Results,    // Current filter's rows and match spans
+        Highlight,  // Token cache
+    };
+    static constexpr size_t ACCOUNT_COUNT = 4;
+
+    explicit MemoryBudget(size_t limit = 0);  // 0: unlimited
+
+    size_t limit() const { return limit_; }
+    bool limited() const { return limit_ != 0; }
+
+    // Any thread may publish or read
+    void set(Account account, size_t bytes);
+    size_t used(Account account) const;
+    size_t total() const;
+    bool exceeded() const { return limited() && total() > limit_; }
+
+    // Most `account` may hold once everything less essential is dropped;
+    // SIZE_MAX when unlimited
+    size_t headroom(Account account) const;
+
+    static const char* name(Account account);
+
+private:
+    size_t limit_;
+    std::array<std::atomic<size_t>, ACCOUNT_COUNT> used_{};
+};
+
+// Sizes as written on command lines: "1048576", "512K", "2G", "1TB"
+bool parseByteSize(std::string_view text, uint64_t& bytes);
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <thread>
+#include <vector>
+#include "trace.hpp"
+
+// Splitting a range of rows or lines across short-lived worker threads, as
+// the filter scan, field extraction, sorting and template mining do.
+
+// Threads for a job asked to use `threads` (0: one per core)
+inline size_t threadCount(size_t threads) {
+    return threads != 0 ? threads : std::max(1u, std::thread::hardware_concurrency());
+}
+
+// Workers for `items` items: at most threadCount(threads) and at least
+// `min_per_thread` items each, so small ranges stay on one thread
+inline size_t workerCount(size_t items, size_t min_per_thread, size_t threads) {
+    return std::clamp<size_t>(items / min_per_thread, 1, threadCount(threads));
+}
+
+// Run `work(worker, begin, end)` over [0, count) split into `workers`
+// contiguous ranges, in order. The first runs on the calling thread, the
+// others on threads named `name` in traces; returns when all are done.
+template <typename Work>
+void parallelFor(size_t count, size_t workers, const Work& work, [[maybe_unused]] const char* name) {
+    std::vector<std::thread> pool;
+    pool.reserve(workers - 1);
+    for (size_t i = 1; i < workers; ++i) {
+        pool.emplace_back([=, &work]() {
+            TRACE_THREAD_NAME(name);
+            work(i, count * i / workers, count * (i + 1) / workers);
+        });
+    }
+    work(size_t{0}, size_t{0}, count / workers);
+    for (auto& worker : pool) {
+        worker.join();
+    }
+}
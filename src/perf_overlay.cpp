@@ -0,0 +1,111 @@
+#include "perf_overlay.hpp"
+#include "ftxui/dom/elements.hpp"
+#include <cstdio>
+
+using namespace ftxui;
+
+namespace {
+
+// Pass-through node that notes when its subtree finished painting
+class FrameTimer : public Node {
+public:
+    FrameTimer(Element document, FrameTimes& times, std::chrono::steady_clock::time_point started)
+        : Node(Elements{std::move(document)})
+        , times_(times)
+        , started_(started) {
+    }
+
+    void ComputeRequirement() override {
+        children_[0]->ComputeRequirement();
+        requirement_ = children_[0]->requirement();
+    }
+
+    void SetBox(Box box) override {
+        Node::SetBox(box);
+        children_[0]->SetBox(box);
+    }
+
+    void Render(Screen& screen) override {
+        children_[0]->Render(screen);
+        times_.add(std::chrono::steady_clock::now() - started_);
+    }
+
+private:
+    FrameTimes& times_;
+    std::chrono::steady_clock::time_point started_;
+};
+
+std::string formatRate(const ScanRate& rate) {
+    if (!rate.valid()) {
+        return "-";
+    }
+    char buffer[64];
+    std::snprintf(buffer, sizeof(buffer), "%.2f GB/s  %.1f M lines/s",
+                  rate.gigabytesPerSecond(), rate.linesPerSecond() / 1e6);
+    return buffer;
+}
+
+std::string formatPercent(double fraction) {
+    char buffer[16];
+    std::snprintf(buffer, sizeof(buffer), "%3.0f%%", fraction * 100.0);
+    return buffer;
+}
+
+Element row(const std::string& label, const std::string& value) {
+    return hbox({text(label) | color(Color::GrayLight), filler(), text(value)});
+}
+
+} // namespace
+
+std::string formatBytes(size_t bytes) {
+    static const char* const UNITS[] = {"B", "KB", "MB", "GB", "TB"};
+    double value = static_cast<double>(bytes);
+    size_t unit = 0;
+    while (value >= 1024.0 && unit + 1 < sizeof(UNITS) / sizeof(UNITS[0])) {
+        value /= 1024.0;
+        ++unit;
+    }
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), unit == 0 ? "%.0f %s" : "%.1f %s", value, UNITS[unit]);
+    return buffer;
+}
+
+std::string formatDuration(std::chrono::nanoseconds duration) {
+    char buffer[32];
+    double micros = static_cast<double>(duration.count()) / 1e3;
+    if (micros < 1000.0) {
+        std::snprintf(buffer, sizeof(buffer), "%.0f us", micros);
+    } else {
+        std::snprintf(buffer, sizeof(buffer), "%.2f ms", micros / 1e3);
+    }
+    return buffer;
+}
+
+Element perfOverlay(const PerfSnapshot& snapshot) {
+    Elements rows;
+    rows.push_back(text("Performance") | bold | color(Color::Cyan));
+    rows.push_back(row("Frame last ", formatDuration(snapshot.frame_last)));
+    rows.push_back(row("Frame p99  ", formatDuration(snapshot.frame_p99) +
+                                      " (" + std::to_string(snapshot.frame_count) + ")"));
+    std::string index = formatRate(snapshot.index);
+    if (!snapshot.load_engine.empty()) {
+        index += "  " + snapshot.load_engine;
+    }
+    rows.push_back(row("Index      ", index));
+    rows.push_back(row("Filter     ", formatRate(snapshot.filter)));
+    rows.push_back(row("Workers    ", "filter " + formatPercent(snapshot.filter_utilisation) +
+                                      "  search " + formatPercent(snapshot.search_utilisation) +
+                                      "  hl " + formatPercent(snapshot.highlight_utilisation)));
+    rows.push_back(row("RSS        ", formatBytes(snapshot.process.resident_bytes)));
+    rows.push_back(row("Index mem  ", formatBytes(snapshot.index_memory)));
+    rows.push_back(row("Result mem ", formatBytes(snapshot.result_memory)));
+    rows.push_back(row("Cache mem  ", formatBytes(snapshot.highlight_memory)));
+    rows.push_back(row("Major PF   ", std::to_string(snapshot.process.major_faults)));
+
+    return vbox(std::move(rows)) | border | bgcolor(Color::Black) | size(WIDTH, EQUAL, 48);
+}
+
+Element frameTimer(Element document, FrameTimes& times,
+                   std::chrono::steady_clock::time_point started) {
+    return std::make_shared<FrameTimer>(std::move(document), times, started);
+}
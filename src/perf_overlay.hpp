@@ -0,0 +1,41 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <string>
+#include "ftxui/dom/node.hpp"
+#include "perf_stats.hpp"
+
+// Everything the performance overlay shows, gathered once per frame while
+// the overlay is visible
+struct PerfSnapshot {
+    std::chrono::nanoseconds frame_last{0};
+    std::chrono::nanoseconds frame_p99{0};
+    size_t frame_count = 0;
+
+    ScanRate index;   // Line indexing at open
+    std::string load_engine;  // "io_uring" or "pread" when the file was read, not mapped
+    ScanRate filter;  // Last completed filter scan
+
+    // Fraction of wall time each worker was busy since the previous snapshot
+    double filter_utilisation = 0.0;
+    double search_utilisation = 0.0;
+    double highlight_utilisation = 0.0;
+
+    size_t index_memory = 0;      // Line offset table
+    size_t result_memory = 0;     // Visible rows and recorded match spans
+    size_t highlight_memory = 0;  // Token cache
+    ProcessStats process;
+};
+
+// Human readable sizes and durations ("12.5 MB", "3.20 ms")
+std::string formatBytes(size_t bytes);
+std::string formatDuration(std::chrono::nanoseconds duration);
+
+// Panel with the snapshot, drawn over the top right of the log area
+ftxui::Element perfOverlay(const PerfSnapshot& snapshot);
+
+// Wraps a whole frame's document and records into `times` how long the
+// frame took from `started` until the document was painted into the screen
+ftxui::Element frameTimer(ftxui::Element document, FrameTimes& times,
+                          std::chrono::steady_clock::time_point started);
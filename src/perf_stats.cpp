@@ -0,0 +1,91 @@
+#include "perf_stats.hpp"
+#include <algorithm>
+#include <cstdio>
+
+#ifndef _WIN32
+    #include <sys/resource.h>
+    #include <unistd.h>
+#endif
+
+void FrameTimes::add(std::chrono::nanoseconds duration) {
+    samples_[next_] = duration.count();
+    next_ = (next_ + 1) % WINDOW;
+    count_ = std::min(count_ + 1, WINDOW);
+}
+
+std::chrono::nanoseconds FrameTimes::last() const {
+    if (count_ == 0) {
+        return std::chrono::nanoseconds(0);
+    }
+    return std::chrono::nanoseconds(samples_[(next_ + WINDOW - 1) % WINDOW]);
+}
+
+std::chrono::nanoseconds FrameTimes::percentile(double fraction) const {
+    if (count_ == 0) {
+        return std::chrono::nanoseconds(0);
+    }
+
+    // Until the window fills, the samples are the first count_ slots
+    std::array<int64_t, WINDOW> sorted = samples_;
+    size_t rank = static_cast<size_t>(std::clamp(fraction, 0.0, 1.0) * static_cast<double>(count_ - 1) + 0.5);
+    std::nth_element(sorted.begin(), sorted.begin() + rank, sorted.begin() + count_);
+    return std::chrono::nanoseconds(sorted[rank]);
+}
+
+double UtilisationSampler::sample(std::chrono::nanoseconds busy_total,
+                                  std::chrono::steady_clock::time_point now) {
+    double utilisation = 0.0;
+    if (started_ && now > last_sample_) {
+        auto wall = std::chrono::duration_cast<std::chrono::nanoseconds>(now - last_sample_);
+        utilisation = static_cast<double>((busy_total - last_busy_).count()) /
+                      static_cast<double>(wall.count());
+    }
+    last_busy_ = busy_total;
+    last_sample_ = now;
+    started_ = true;
+    return std::clamp(utilisation, 0.0, 1.0);
+}
+
+double ScanRate::gigabytesPerSecond() const {
+    if (!valid()) {
+        return 0.0;
+    }
+    return static_cast<double>(bytes) / static_cast<double>(elapsed.count());  // bytes/ns == GB/s
+}
+
+double ScanRate::linesPerSecond() const {
+    if (!valid()) {
+        return 0.0;
+    }
+    return static_cast<double>(lines) * 1e9 / static_cast<double>(elapsed.count());
+}
+
+ProcessStats ProcessStats::sample() {
+    ProcessStats stats;
+
+#ifndef _WIN32
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == 0) {
+        stats.major_faults = static_cast<uint64_t>(usage.ru_majflt);
+    #if defined(__APPLE__)
+        stats.resident_bytes = static_cast<size_t>(usage.ru_maxrss);  // Bytes, peak
+    #else
+        stats.resident_bytes = static_cast<size_t>(usage.ru_maxrss) * 1024;  // KB, peak
+    #endif
+    }
+
+    // Linux has the current RSS: second field of statm, in pages
+    if (FILE* statm = std::fopen("/proc/self/statm", "r")) {
+        unsigned long size_pages = 0;
+        unsigned long resident_pages = 0;
+        if (std::fscanf(statm, "%lu %lu", &size_pages, &resident_pages) == 2) {
+            stats.resident_bytes = static_cast<size_t>(resident_pages) *
+                                   static_cast<size_t>(sysconf(_SC_PAGESIZE));
+        }
+        std::fclose(statm);
+    }
+#endif
+    // Windows: not collected, the overlay shows zeros
+
+    return stats;
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+// Counters behind the performance overlay. Everything here is cheap enough
+// to record unconditionally (a clock read or an atomic add per batch of
+// work); the expensive parts - percentiles, /proc reads - only run when
+// the overlay asks for a snapshot.
+
+// Rolling window of recent frame times
+class FrameTimes {
+public:
+    static constexpr size_t WINDOW = 256;  // Frames
+
+    void add(std::chrono::nanoseconds duration);
+
+    // Most recent frame; zero before the first one
+    std::chrono::nanoseconds last() const;
+
+    // Nearest-rank percentile over the window (fraction in [0, 1])
+    std::chrono::nanoseconds percentile(double fraction) const;
+
+    size_t count() const { return count_; }
+
+private:
+    std::array<int64_t, WINDOW> samples_{};
+    size_t next_ = 0;
+    size_t count_ = 0;
+};
+
+// Busy time accumulated by a worker thread; any thread may add
+class BusyMeter {
+public:
+    // Adds its own lifetime to the meter
+    class Scope {
+    public:
+        explicit Scope(BusyMeter& meter)
+            : meter_(meter)
+            , started_(std::chrono::steady_clock::now()) {
+        }
+        ~Scope() { meter_.add(std::chrono::steady_clock::now() - started_); }
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        BusyMeter& meter_;
+        std::chrono::steady_clock::time_point started_;
+    };
+
+    void add(std::chrono::nanoseconds busy) {
+        busy_ns_.fetch_add(busy.count(), std::memory_order_relaxed);
+    }
+
+    std::chrono::nanoseconds total() const {
+        return std::chrono::nanoseconds(busy_ns_.load(std::memory_order_relaxed));
+    }
+
+private:
+    std::atomic<int64_t> busy_ns_{0};
+};
+
+// Turns growth of a BusyMeter into a utilisation fraction between samples
+class UtilisationSampler {
+public:
+    // Fraction of wall time spent busy since the previous call (0 on the first)
+    double sample(std::chrono::nanoseconds busy_total,
+                  std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now());
+
+private:
+    std::chrono::nanoseconds last_busy_{0};
+    std::chrono::steady_clock::time_point last_sample_{};
+    bool started_ = false;
+};
+
+// Size and duration of one completed scan over the file
+struct ScanRate {
+    uint64_t bytes = 0;
+    uint64_t lines = 0;
+    std::chrono::nanoseconds elapsed{0};
+
+    bool valid() const { return elapsed.count() > 0; }
+    double gigabytesPerSecond() const;
+    double linesPerSecond() const;
+};
+
+// Memory and paging of this process, read from the OS on demand
+struct ProcessStats {
+    size_t resident_bytes = 0;  // Current RSS (peak where the OS only reports that)
+    uint64_t major_faults = 0;  // Page faults that had to read from disk
+
+    static ProcessStats sample();
+};
@@ -0,0 +1,295 @@
+#include "range_export.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+
+#ifdef _WIN32
+    #include <fcntl.h>
+    #include <io.h>
+#else
+    #include <fcntl.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+#ifdef __linux__
+    #include <sys/sendfile.h>
+#endif
+
+namespace {
+
+// Largest single copy request; the kernel caps transfers near 2 GB anyway
+constexpr size_t MAX_COPY = 1ULL << 30;
+
+const char NEWLINE[] = "\n";
+
+} // namespace
+
+RangeExporter::RangeExporter(const LogReader& reader, int output_fd)
+    : reader_(reader)
+    , output_fd_(output_fd)
+    , source_fd_(reader.getFileDescriptor())
+    , method_(Method::WriteV)
+    , pending_begin_(0)
+    , pending_end_(0)
+    , has_pending_(false)
+    , bytes_written_(0)
+    , ranges_written_(0) {
+#ifdef __linux__
+    if (source_fd_ != -1) {
+        // copy_file_range only takes regular files on both sides
+        struct stat st;
+        bool regular_output = fstat(output_fd_, &st) == 0 && S_ISREG(st.st_mode);
+        method_ = regular_output ? Method::CopyFileRange : Method::SendFile;
+    }
+#endif
+}
+
+RangeExporter::~RangeExporter() {
+    flush();
+}
+
+void RangeExporter::addLine(size_t line) {
+    addLines(line, line + 1);
+}
+
+void RangeExporter::addLines(size_t first, size_t end) {
+    if (first >= end || failed()) {
+        return;
+    }
+
+    if (reader_.isMerged()) {
+        // Neighbouring rows come from different files: line by line
+        for (size_t line = first; line < end && !failed(); ++line) {
+            std::string_view bytes = reader_.getRawLine(line);
+            ++ranges_written_;
+            queueMapped(bytes.data(), bytes.size());
+            if (bytes.empty() || bytes.back() != '\n') {
+                queueMapped(NEWLINE, 1);  // A file's last line without a newline
+            }
+        }
+        return;
+    }
+
+    size_t begin = reader_.getLineOffset(first);
+    size_t stop = reader_.getLineOffset(end);
+    if (has_pending_ && begin == pending_end_) {
+        pending_end_ = stop;  // Adjacent in the file: one range
+        return;
+    }
+
+    emitPending();
+    pending_begin_ = begin;
+    pending_end_ = stop;
+    has_pending_ = true;
+}
+
+bool RangeExporter::flush() {
+    emitPending();
+    writeQueued();
+    return !failed();
+}
+
+void RangeExporter::emitPending() {
+    if (!has_pending_ || failed()) {
+        return;
+    }
+    has_pending_ = false;
+
+    size_t begin = pending_begin_;
+    size_t end = pending_end_;
+    if (begin == end) {
+        return;
+    }
+    ++ranges_written_;
+
+    const char* data = reader_.getData().data();
+    bool add_newline = data[end - 1] != '\n';  // Only the very last line can lack one
+
+    // A syscall per short range would cost more than the copy it saves
+    if (method_ != Method::WriteV && end - begin >= MIN_KERNEL_COPY) {
+        writeQueued();  // Keep the output in order
+        if (copyFromFile(begin, end)) {
+            if (add_newline) {
+                queueMapped(NEWLINE, 1);
+            }
+            return;
+        }
+        if (failed()) {
+            return;
+        }
+        // copyFromFile gave up and switched to writev; it wrote nothing of this range
+    }
+
+    queueMapped(data + begin, end - begin);
+    if (add_newline) {
+        queueMapped(NEWLINE, 1);
+    }
+}
+
+// Kernel-side copy of [begin, end) from the source file. Returns false
+// without writing anything when the method is not supported for these
+// descriptors; later ranges then use writev.
+bool RangeExporter::copyFromFile(size_t begin, size_t end) {
+#ifdef __linux__
+    off_t offset = static_cast<off_t>(begin);
+    while (static_cast<size_t>(offset) < end) {
+        size_t length = std::min(end - static_cast<size_t>(offset), MAX_COPY);
+        ssize_t copied;
+        if (method_ == Method::CopyFileRange) {
+            copied = copy_file_range(source_fd_, &offset, output_fd_, nullptr, length, 0);
+        } else {
+            copied = sendfile(output_fd_, source_fd_, &offset, length);
+        }
+
+        if (copied > 0) {
+            bytes_written_ += static_cast<uint64_t>(copied);
+            continue;
+        }
+        if (copied < 0 && errno == EINTR) {
+            continue;
+        }
+
+        bool unsupported = copied == 0 ||
+            errno == EINVAL || errno == ENOSYS || errno == EXDEV ||
+            errno == EOPNOTSUPP || errno == EBADF;
+        if (!unsupported) {
+            fail(method_ == Method::CopyFileRange ? "copy_file_range" : "sendfile");
+            return false;
+        }
+
+        // Not for these descriptors: copy_file_range -> sendfile -> writev
+        method_ = method_ == Method::CopyFileRange ? Method::SendFile : Method::WriteV;
+        if (static_cast<size_t>(offset) != begin) {
+            // Part of the range is out already; finish it from the mapping
+            queueMapped(reader_.getData().data() + offset, end - static_cast<size_t>(offset));
+            writeQueued();
+            method_ = Method::WriteV;
+            return !failed();
+        }
+        if (method_ == Method::WriteV) {
+            return false;
+        }
+    }
+    return true;
+#else
+    (void)begin;
+    (void)end;
+    method_ = Method::WriteV;
+    return false;
+#endif
+}
+
+void RangeExporter::queueMapped(const char* data, size_t size) {
+#ifdef _WIN32
+    // No gather write: one call per range, still without a staging copy
+    while (size > 0 && !failed()) {
+        int written = _write(output_fd_, data, static_cast<unsigned>(std::min<size_t>(size, INT_MAX)));
+        if (written < 0) {
+            fail("write");
+            return;
+        }
+        bytes_written_ += static_cast<uint64_t>(written);
+        data += written;
+        size -= static_cast<size_t>(written);
+    }
+#else
+    queued_.push_back({const_cast<char*>(data), size});
+    if (queued_.size() >= MAX_IOVECS) {
+        writeQueued();
+    }
+#endif
+}
+
+void RangeExporter::writeQueued() {
+#ifndef _WIN32
+    size_t next = 0;
+    while (next < queued_.size() && !failed()) {
+        int count = static_cast<int>(std::min<size_t>(queued_.size() - next, MAX_IOVECS));
+        ssize_t written = ::writev(output_fd_, queued_.data() + next, count);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            fail("writev");
+            break;
+        }
+        bytes_written_ += static_cast<uint64_t>(written);
+
+        // Skip what went out; a short write leaves a partial iovec
+        size_t remaining = static_cast<size_t>(written);
+        while (next < queued_.size() && remaining >= queued_[next].iov_len) {
+            remaining -= queued_[next].iov_len;
+            ++next;
+        }
+        if (remaining > 0) {
+            queued_[next].iov_base = static_cast<char*>(queued_[next].iov_base) + remaining;
+            queued_[next].iov_len -= remaining;
+        }
+    }
+    queued_.clear();
+#endif
+}
+
+void RangeExporter::fail(const char* what) {
+    if (error_.empty()) {
+        error_ = std::string(what) + " failed: " + std::strerror(errno);
+    }
+}
+
+int openExportFile(const std::string& path, const LogReader& reader, std::string& error) {
+#ifdef _WIN32
+    (void)reader;
+    int fd = _open(path.c_str(), _O_WRONLY | _O_CREAT | _O_TRUNC | _O_BINARY, _S_IREAD | _S_IWRITE);
+#else
+    struct stat output_stat;
+    if (::stat(path.c_str(), &output_stat) == 0) {
+        auto is_output = [&](const LogReader& input) {
+            struct stat input_stat;
+            return input.getFileDescriptor() != -1 && fstat(input.getFileDescriptor(), &input_stat) == 0 &&
+                   output_stat.st_dev == input_stat.st_dev && output_stat.st_ino == input_stat.st_ino;
+        };
+        bool clobbers = is_output(reader);
+        for (size_t source = 0; source < reader.getSourceCount(); ++source) {
+            clobbers = clobbers || is_output(reader.getSource(source));
+        }
+        if (clobbers) {
+            error = "Output file is the input file: " + path;
+            return -1;
+        }
+    }
+    int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+#endif
+    if (fd == -1) {
+        error = "Cannot create " + path + ": " + std::strerror(errno);
+    }
+    return fd;
+}
+
+bool closeExportFile(int fd) {
+#ifdef _WIN32
+    return _close(fd) == 0;
+#else
+    return ::close(fd) == 0;
+#endif
+}
+
+bool exportRows(const LogReader& reader, const RowView& rows, int output_fd,
+                uint64_t& bytes_written, std::string& error) {
+    RangeExporter exporter(reader, output_fd);
+    if (rows.isIdentity()) {
+        exporter.addLines(0, rows.size());
+    } else {
+        for (size_t row = 0; row < rows.size() && !exporter.failed(); ++row) {
+            exporter.addLine(rows.select(row));
+        }
+    }
+
+    bool ok = exporter.flush();
+    bytes_written = exporter.bytesWritten();
+    if (!ok) {
+        error = exporter.getError();
+    }
+    return ok;
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "log_reader.hpp"
+#include "row_view.hpp"
+
+#ifndef _WIN32
+    #include <sys/uio.h>
+#endif
+
+// Writes whole lines of a log to a descriptor without staging them in a
+// user-space buffer. Lines that are adjacent in the file merge into one
+// byte range, and each range moves in as few system calls as the platform
+// allows:
+//   copy_file_range  file to file, in the kernel (reflinks on CoW filesystems)
+//   sendfile         file to anything else (pipes, sockets, ttys)
+//   writev           straight from the mapping, many ranges per call: short
+//                    ranges, streams, and whenever the above are unavailable
+// Output is byte-identical to the input; only a last line without a newline
+// gets one, like the batch printer. Lines of a merged view are gathered one
+// by one from their files' mappings.
+class RangeExporter {
+public:
+    static constexpr size_t MAX_IOVECS = 1024;           // Ranges per writev call
+    static constexpr size_t MIN_KERNEL_COPY = 64 * 1024;  // Shorter ranges are gathered instead
+
+    RangeExporter(const LogReader& reader, int output_fd);
+    ~RangeExporter();
+
+    RangeExporter(const RangeExporter&) = delete;
+    RangeExporter& operator=(const RangeExporter&) = delete;
+
+    // Lines must come in ascending order
+    void addLine(size_t line);
+    void addLines(size_t first, size_t end);  // [first, end)
+
+    // Write out everything added so far; false once any write failed
+    bool flush();
+
+    bool failed() const { return !error_.empty(); }
+    const std::string& getError() const { return error_; }
+
+    uint64_t bytesWritten() const { return bytes_written_; }
+    uint64_t rangesWritten() const { return ranges_written_; }
+
+private:
+    enum class Method { CopyFileRange, SendFile, WriteV };
+
+    // Hand the pending range to the current method
+    void emitPending();
+    bool copyFromFile(size_t begin, size_t end);
+    void queueMapped(const char* data, size_t size);
+    void writeQueued();
+    void fail(const char* what);
+
+    const LogReader& reader_;
+    int output_fd_;
+    int source_fd_;  // -1 when the data only exists in memory
+    Method method_;
+
+    size_t pending_begin_;
+    size_t pending_end_;
+    bool has_pending_;
+
+#ifndef _WIN32
+    std::vector<iovec> queued_;  // Mapped ranges waiting for one writev
+#endif
+
+    uint64_t bytes_written_;
+    uint64_t ranges_written_;
+    std::string error_;
+};
+
+// Create or truncate an export target. Refuses the file(s) `reader` has open,
+// which truncating would destroy under the mapping. -1 and `error` on failure.
+int openExportFile(const std::string& path, const LogReader& reader, std::string& error);
+
+// Close an export target; false if the final write-back failed
+bool closeExportFile(int fd);
+
+// Export every row of a view; on failure `error` says why
+bool exportRows(const LogReader& reader, const RowView& rows, int output_fd,
+                uint64_t& bytes_written, std::string& error);
@@ -0,0 +1,109 @@
+#include "redraw_scheduler.hpp"
+
+RedrawScheduler::RedrawScheduler(Wakeup wakeup, std::chrono::milliseconds interval)
+    : wakeup_(std::move(wakeup))
+    , interval_(interval)
+    , requested_(false)
+    , in_flight_(false)
+    , stop_(false)
+    , wakeups_(0)
+    , last_wakeup_() {
+    thread_ = std::thread([this]() { run(); });
+}
+
+RedrawScheduler::~RedrawScheduler() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    changed_.notify_all();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+void RedrawScheduler::request() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (requested_) {
+            return;  // Already pending: coalesced
+        }
+        requested_ = true;
+    }
+    changed_.notify_one();
+}
+
+void RedrawScheduler::requestAfter(std::chrono::milliseconds delay) {
+    auto due = std::chrono::steady_clock::now() + delay;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (deferred_ && *deferred_ <= due) {
+            return;
+        }
+        deferred_ = due;
+    }
+    changed_.notify_one();
+}
+
+void RedrawScheduler::frameStarted() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    bool was_blocked = in_flight_;
+    requested_ = false;
+    in_flight_ = false;
+    if (was_blocked) {
+        changed_.notify_one();
+    }
+}
+
+size_t RedrawScheduler::wakeupCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return wakeups_;
+}
+
+void RedrawScheduler::run() {
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    auto ready = [this]() { return stop_ || (requested_ && !in_flight_); };
+
+    while (true) {
+        // A deferred request turns into a normal one once due
+        if (deferred_ && std::chrono::steady_clock::now() >= *deferred_) {
+            deferred_.reset();
+            requested_ = true;
+        }
+
+        if (deferred_) {
+            auto due = *deferred_;
+            changed_.wait_until(lock, due, [&]() { return ready() || deferred_ != due; });
+        } else {
+            changed_.wait(lock, [&]() { return ready() || deferred_.has_value(); });
+        }
+        if (stop_) {
+            return;
+        }
+        if (!ready()) {
+            continue;  // Deferred request due or rescheduled
+        }
+
+        // Rate limit: a timed wait only happens while a request is pending
+        auto due = last_wakeup_ + interval_;
+        if (std::chrono::steady_clock::now() < due) {
+            changed_.wait_until(lock, due, [this]() { return stop_; });
+            if (stop_) {
+                return;
+            }
+        }
+        if (!requested_ || in_flight_) {
+            continue;  // A frame started meanwhile and already covered it
+        }
+
+        requested_ = false;
+        in_flight_ = true;
+        last_wakeup_ = std::chrono::steady_clock::now();
+        ++wakeups_;
+
+        lock.unlock();
+        wakeup_();
+        lock.lock();
+    }
+}
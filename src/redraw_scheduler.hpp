@@ -0,0 +1,59 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <thread>
+
+// Update channel from background threads to the UI loop. request() may be
+// called from any thread as often as wanted; bursts are coalesced into at
+// most one wakeup per refresh interval, and no new wakeup is sent while the
+// previous one has not reached a frame yet. When idle the scheduler thread
+// sleeps on a condition variable - nothing polls.
+class RedrawScheduler {
+public:
+    using Wakeup = std::function<void()>;
+
+    static constexpr std::chrono::milliseconds DEFAULT_INTERVAL{16};  // ~60 frames/s
+
+    explicit RedrawScheduler(Wakeup wakeup,
+                             std::chrono::milliseconds interval = DEFAULT_INTERVAL);
+    ~RedrawScheduler();
+
+    RedrawScheduler(const RedrawScheduler&) = delete;
+    RedrawScheduler& operator=(const RedrawScheduler&) = delete;
+
+    // Ask for a frame because shared state changed (any thread)
+    void request();
+
+    // Ask for a frame no earlier than `delay` from now, for views that
+    // refresh on their own (the performance overlay). Of several pending
+    // deferred requests only the earliest is kept.
+    void requestAfter(std::chrono::milliseconds delay);
+
+    // Called by the UI thread before it reads state for a frame: every
+    // request made so far is satisfied by this frame
+    void frameStarted();
+
+    // Number of wakeups actually sent
+    size_t wakeupCount() const;
+
+private:
+    void run();
+
+    Wakeup wakeup_;
+    std::chrono::milliseconds interval_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable changed_;
+    bool requested_;   // State changed since the last frame started
+    bool in_flight_;   // A wakeup was sent and no frame has started since
+    bool stop_;
+    std::optional<std::chrono::steady_clock::time_point> deferred_;
+    size_t wakeups_;
+    std::chrono::steady_clock::time_point last_wakeup_;
+    std::thread thread_;
+};
@@ -0,0 +1,88 @@
+#include "row_view.hpp"
+#include <algorithm>
+
+RowView::RowView()
+    : identity_(false)
+    , file_order_(true)
+    , line_count_(0) {
+}
+
+RowView RowView::identity(size_t line_count) {
+    RowView view;
+    view.identity_ = true;
+    view.line_count_ = line_count;
+    return view;
+}
+
+RowView RowView::fromLines(std::vector<size_t> lines) {
+    RowView view;
+    view.lines_ = std::move(lines);
+    return view;
+}
+
+RowView RowView::fromOrder(std::vector<size_t> lines) {
+    RowView view;
+    view.lines_ = std::move(lines);
+    view.file_order_ = false;
+    view.indexRows(0);
+    return view;
+}
+
+void RowView::indexRows(size_t first) {
+    auto byLine = [this](size_t a, size_t b) { return lines_[a] < lines_[b]; };
+    size_t old_size = rows_by_line_.size();
+    for (size_t row = first; row < lines_.size(); ++row) {
+        rows_by_line_.push_back(row);
+    }
+    auto middle = rows_by_line_.begin() + static_cast<std::ptrdiff_t>(old_size);
+    std::sort(middle, rows_by_line_.end(), byLine);
+
+    // Lines a stream appends come after the others, so this is rarely needed
+    if (middle != rows_by_line_.begin() && middle != rows_by_line_.end() &&
+        byLine(*middle, *(middle - 1))) {
+        std::inplace_merge(rows_by_line_.begin(), middle, rows_by_line_.end(), byLine);
+    }
+}
+
+const size_t* RowView::findRow(size_t line) const {
+    auto it = std::lower_bound(rows_by_line_.begin(), rows_by_line_.end(), line,
+                               [this](size_t row, size_t value) { return lines_[row] < value; });
+    return it != rows_by_line_.end() && lines_[*it] == line ? &*it : nullptr;
+}
+
+size_t RowView::rank(size_t line) const {
+    if (identity_) {
+        return std::min(line, line_count_);
+    }
+    if (!file_order_) {
+        const size_t* row = findRow(line);
+        return row != nullptr ? *row : lines_.size();
+    }
+    return static_cast<size_t>(std::lower_bound(lines_.begin(), lines_.end(), line) - lines_.begin());
+}
+
+void RowView::extendIdentity(size_t line_count) {
+    if (identity_) {
+        line_count_ = std::max(line_count_, line_count);
+    }
+}
+
+void RowView::append(const std::vector<size_t>& lines) {
+    if (!identity_) {
+        size_t first = lines_.size();
+        lines_.insert(lines_.end(), lines.begin(), lines.end());
+        if (!file_order_) {
+            indexRows(first);
+        }
+    }
+}
+
+bool RowView::contains(size_t line) const {
+    if (identity_) {
+        return line < line_count_;
+    }
+    if (!file_order_) {
+        return findRow(line) != nullptr;
+    }
+    return std::binary_search(lines_.begin(), lines_.end(), line);
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+// The rows the log area shows, as a mapping between row numbers and file
+// line indices. Unfiltered it is the identity range 0..N-1 and stores
+// nothing; filtered it holds the sorted matching line indices; sorted by a
+// field it holds lines in any order. Scrolling code goes through select() /
+// rank() and never sees the representation.
+class RowView {
+public:
+    // Empty view
+    RowView();
+
+    // Every line of a file with `line_count` lines, O(1) memory
+    static RowView identity(size_t line_count);
+
+    // The given lines, which must be sorted ascending
+    static RowView fromLines(std::vector<size_t> lines);
+
+    // The given lines in the given order (e.g. sorted by timestamp)
+    static RowView fromOrder(std::vector<size_t> lines);
+
+    // Number of rows
+    size_t size() const { return identity_ ? line_count_ : lines_.size(); }
+    bool empty() const { return size() == 0; }
+    bool isIdentity() const { return identity_; }
+    bool inFileOrder() const { return identity_ || file_order_; }
+
+    // File line shown at `row` (row < size())
+    size_t select(size_t row) const { return identity_ ? row : lines_[row]; }
+
+    // Number of rows whose line is below `line`: the row `line` is shown at,
+    // or would be inserted at when it is not part of the view. Views not in
+    // file order return size() for missing lines. O(log n) for every view.
+    size_t rank(size_t line) const;
+
+    bool contains(size_t line) const;
+
+    // Grow as input arrives: the identity range to `line_count` lines, or a
+    // match set by lines past its last one (sorted ascending; a view in
+    // another order just gets them at the end)
+    void extendIdentity(size_t line_count);
+    void append(const std::vector<size_t>& lines);
+
+    size_t memoryUsage() const {
+        return (lines_.capacity() + rows_by_line_.capacity()) * sizeof(size_t);
+    }
+
+private:
+    // Views not in file order: index of the row holding `line`, if any
+    const size_t* findRow(size_t line) const;
+
+    // Sort the rows from `first` on into rows_by_line_
+    void indexRows(size_t first);
+
+    bool identity_;
+    bool file_order_;            // lines_ is sorted ascending
+    size_t line_count_;          // Identity range only
+    std::vector<size_t> lines_;  // Match set only
+    std::vector<size_t> rows_by_line_;  // Not in file order: rows ordered by their line
+};
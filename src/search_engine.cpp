@@ -0,0 +1,315 @@
+#include "search_engine.hpp"
+#include <algorithm>
+
+void SearchEngine::Matcher::findInLine(std::string_view line, std::vector<MatchSpan>& spans) const {
+    if (literal) {
+        size_t pos = searcher.find(line, 0);
+        while (pos != LiteralSearcher::npos) {
+            spans.push_back({static_cast<uint32_t>(pos), static_cast<uint32_t>(pattern.size())});
+            pos = searcher.find(line, pos + pattern.size());
+        }
+        return;
+    }
+
+    using Iterator = std::regex_iterator<std::string_view::const_iterator>;
+    for (Iterator it(line.begin(), line.end(), regex), end; it != end; ++it) {
+        if (it->length(0) > 0) {
+            spans.push_back({static_cast<uint32_t>(it->position(0)),
+                             static_cast<uint32_t>(it->length(0))});
+        }
+    }
+}
+
+SearchEngine::SearchEngine(std::shared_ptr<LogReader> reader)
+    : reader_(reader) {
+}
+
+bool SearchEngine::setPattern(const std::string& pattern) {
+    auto matcher = std::make_shared<Matcher>();
+    matcher->pattern = pattern;
+    matcher->literal = LiteralSearcher::isLiteralPattern(pattern);
+
+    if (matcher->literal) {
+        matcher->searcher = LiteralSearcher(pattern);
+    } else {
+        try {
+            matcher->regex = std::regex(pattern, std::regex::ECMAScript | std::regex::optimize);
+        } catch (const std::regex_error& e) {
+            error_message_ = e.what();
+            clear();
+            return false;
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    error_message_.clear();
+    matcher_ = pattern.empty() ? nullptr : std::move(matcher);
+    hits_.clear();
+    scanned_.clear();
+    return true;
+}
+
+void SearchEngine::clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    matcher_ = nullptr;
+    hits_.clear();
+    scanned_.clear();
+}
+
+bool SearchEngine::hasPattern() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return matcher_ != nullptr;
+}
+
+bool SearchEngine::isLiteral() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return matcher_ && matcher_->literal;
+}
+
+std::string SearchEngine::getPattern() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return matcher_ ? matcher_->pattern : std::string();
+}
+
+size_t SearchEngine::cachedHitCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return hits_.size();
+}
+
+void SearchEngine::findInLine(std::string_view line, std::vector<MatchSpan>& spans) const {
+    std::shared_ptr<const Matcher> matcher;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        matcher = matcher_;
+    }
+    if (matcher) {
+        matcher->findInLine(line, spans);
+    }
+}
+
+SearchHit SearchEngine::toHit(size_t position, uint32_t length) const {
+    size_t line = reader_->lineAtOffset(position);
+    uint32_t offset = static_cast<uint32_t>(position - reader_->getLineOffset(line));
+    return {line, {offset, length}};
+}
+
+std::optional<SearchEngine::Step> SearchEngine::cachedLocked(size_t from, bool forward,
+                                                            size_t& scan_from) const {
+    const size_t size = reader_->getDataSize();
+    scan_from = from;
+
+    if (forward) {
+        // How far past `from` all hit starts are known
+        size_t known_end = from;
+        auto range = scanned_.upper_bound(from);
+        if (range != scanned_.begin() && std::prev(range)->second > from) {
+            known_end = std::prev(range)->second;
+        }
+
+        auto hit = hits_.lower_bound(from);
+        if (hit != hits_.end() && hit->first < known_end) {
+            return Step{toHit(hit->first, hit->second), false, 0};
+        }
+        if (known_end >= size) {
+            return Step{std::nullopt, true, 0};
+        }
+        scan_from = known_end;
+        return std::nullopt;
+    }
+
+    // Backward: how far before `from` all hit starts are known
+    size_t known_begin = from;
+    auto range = scanned_.lower_bound(from);
+    if (range != scanned_.begin() && std::prev(range)->second >= from) {
+        known_begin = std::prev(range)->first;
+    }
+
+    auto hit = hits_.lower_bound(from);
+    if (hit != hits_.begin() && std::prev(hit)->first >= known_begin) {
+        --hit;
+        return Step{toHit(hit->first, hit->second), false, 0};
+    }
+    if (known_begin == 0) {
+        return Step{std::nullopt, true, 0};
+    }
+    scan_from = known_begin;
+    return std::nullopt;
+}
+
+void SearchEngine::addScannedLocked(size_t begin, size_t end) {
+    if (begin >= end) {
+        return;
+    }
+
+    // Merge with every range touching [begin, end)
+    auto it = scanned_.upper_bound(begin);
+    if (it != scanned_.begin() && std::prev(it)->second >= begin) {
+        --it;
+        begin = std::min(begin, it->first);
+    }
+    while (it != scanned_.end() && it->first <= end) {
+        end = std::max(end, it->second);
+        it = scanned_.erase(it);
+    }
+    scanned_[begin] = end;
+}
+
+SearchEngine::Step SearchEngine::scan(size_t from, bool forward, size_t budget) {
+    std::shared_ptr<const Matcher> matcher;
+    size_t scan_from = from;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!matcher_) {
+            return Step{std::nullopt, true, 0};
+        }
+        if (auto cached = cachedLocked(from, forward, scan_from)) {
+            return *cached;
+        }
+        matcher = matcher_;
+    }
+
+    // Scan without the lock; results are dropped if the pattern changed meanwhile
+    std::vector<std::pair<size_t, uint32_t>> hits;
+    size_t scanned_begin = scan_from;
+    size_t scanned_end = scan_from;
+    // A merged view has no single mapping to run the literal search over
+    Step step = matcher->literal && !reader_->isMerged()
+        ? scanLiteral(*matcher, scan_from, forward, budget, hits, scanned_begin, scanned_end)
+        : scanLines(*matcher, scan_from, forward, budget, hits, scanned_begin, scanned_end);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (matcher_ == matcher) {
+        for (const auto& [position, length] : hits) {
+            hits_[position] = length;
+        }
+        addScannedLocked(scanned_begin, scanned_end);
+
+        // The scan may have started past ground covered by other scans
+        if (!step.hit && !step.exhausted) {
+            size_t resume_from = step.resume;
+            if (auto cached = cachedLocked(step.resume, forward, resume_from)) {
+                return *cached;
+            }
+            step.resume = resume_from;
+        }
+    }
+    return step;
+}
+
+SearchEngine::Step SearchEngine::scanLiteral(const Matcher& matcher, size_t from, bool forward,
+                                             size_t budget,
+                                             std::vector<std::pair<size_t, uint32_t>>& hits,
+                                             size_t& scanned_begin, size_t& scanned_end) const {
+    std::string_view data = reader_->getData();
+    const size_t size = data.size();
+    const size_t length = matcher.pattern.size();
+
+    if (forward) {
+        // Hits may start in [from, end) and reach past `end`
+        size_t end = std::min(size, from + budget);
+        size_t window = std::min(size, end + length - 1);
+        size_t position = matcher.searcher.find(data.substr(0, window), from);
+
+        scanned_begin = from;
+        if (position != LiteralSearcher::npos) {
+            hits.emplace_back(position, static_cast<uint32_t>(length));
+            scanned_end = position + 1;
+            return Step{toHit(position, static_cast<uint32_t>(length)), false, 0};
+        }
+        scanned_end = end;
+        return end >= size ? Step{std::nullopt, true, 0} : Step{std::nullopt, false, end};
+    }
+
+    // Backward: hits may start in [begin, from)
+    from = std::min(from, size);
+    size_t begin = from > budget ? from - budget : 0;
+    size_t window = std::min(size - begin, from - begin + length - 1);
+    size_t position = matcher.searcher.rfind(data.substr(begin, window), from - begin);
+
+    scanned_end = from;
+    if (position != LiteralSearcher::npos) {
+        position += begin;
+        hits.emplace_back(position, static_cast<uint32_t>(length));
+        scanned_begin = position;
+        return Step{toHit(position, static_cast<uint32_t>(length)), false, 0};
+    }
+    scanned_begin = begin;
+    return begin == 0 ? Step{std::nullopt, true, 0} : Step{std::nullopt, false, begin};
+}
+
+SearchEngine::Step SearchEngine::scanLines(const Matcher& matcher, size_t from, bool forward,
+                                           size_t budget,
+                                           std::vector<std::pair<size_t, uint32_t>>& hits,
+                                           size_t& scanned_begin, size_t& scanned_end) const {
+    const size_t size = reader_->getDataSize();
+    const size_t line_count = reader_->getLineCount();
+    if (line_count == 0) {
+        return Step{std::nullopt, true, 0};
+    }
+
+    auto line_end = [&](size_t line) {
+        return line + 1 < line_count ? reader_->getLineOffset(line + 1) : size;
+    };
+
+    // Whole lines are scanned, so every hit on them becomes known
+    std::vector<MatchSpan> spans;
+    size_t scanned_bytes = 0;
+
+    if (forward) {
+        size_t line = reader_->lineAtOffset(std::min(from, size));
+        scanned_begin = reader_->getLineOffset(line);
+        scanned_end = scanned_begin;
+
+        for (; line < line_count && scanned_bytes < budget; ++line) {
+            size_t line_start = reader_->getLineOffset(line);
+            spans.clear();
+            matcher.findInLine(reader_->getLine(line), spans);
+
+            std::optional<SearchHit> found;
+            for (const auto& span : spans) {
+                hits.emplace_back(line_start + span.offset, span.length);
+                if (!found && line_start + span.offset >= from) {
+                    found = SearchHit{line, span};
+                }
+            }
+            scanned_end = line_end(line);
+            scanned_bytes += scanned_end - line_start;
+            if (found) {
+                return Step{found, false, 0};
+            }
+        }
+        return line >= line_count ? Step{std::nullopt, true, 0}
+                                  : Step{std::nullopt, false, reader_->getLineOffset(line)};
+    }
+
+    if (from == 0) {
+        return Step{std::nullopt, true, 0};
+    }
+    size_t line = reader_->lineAtOffset(std::min(from, size) - 1);
+    scanned_end = line_end(line);
+    scanned_begin = scanned_end;
+
+    while (scanned_bytes < budget) {
+        size_t line_start = reader_->getLineOffset(line);
+        spans.clear();
+        matcher.findInLine(reader_->getLine(line), spans);
+
+        std::optional<SearchHit> found;
+        for (const auto& span : spans) {
+            hits.emplace_back(line_start + span.offset, span.length);
+            if (line_start + span.offset < from) {
+                found = SearchHit{line, span};  // Last one before `from` wins
+            }
+        }
+        scanned_begin = line_start;
+        scanned_bytes += line_end(line) - line_start;
+        if (found) {
+            return Step{found, false, 0};
+        }
+        if (line == 0) {
+            return Step{std::nullopt, true, 0};
+        }
+        --line;
+    }
+    return Step{std::nullopt, false, scanned_begin};
+}
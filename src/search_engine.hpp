@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <regex>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "log_reader.hpp"
+#include "literal_search.hpp"
+#include "match_index.hpp"
+
+// One occurrence of the search pattern
+struct SearchHit {
+    size_t line;     // Line index in the file
+    MatchSpan span;  // Position within that line
+};
+
+// less-style search over the whole file, independent of the filter. Scans
+// run over the mapped bytes in bounded steps from a byte position, so far
+// away hits can be searched for in the background and abandoned. Every hit
+// found and every range scanned is remembered, so repeating a search over
+// known ground (n / N) is a map lookup instead of a rescan. A merged view
+// is searched line by line at the offsets of its merged lines.
+class SearchEngine {
+public:
+    // Outcome of one bounded scan step
+    struct Step {
+        std::optional<SearchHit> hit;
+        bool exhausted = false;  // Reached the end (or start) of the file without a hit
+        size_t resume = 0;       // Otherwise: byte position to continue from
+    };
+
+    explicit SearchEngine(std::shared_ptr<LogReader> reader);
+
+    // Patterns without regex metacharacters take the SIMD literal path over
+    // raw bytes; anything else is an ECMAScript regex matched line by line.
+    // Forgets everything cached for the previous pattern.
+    bool setPattern(const std::string& pattern);
+    void clear();
+
+    bool hasPattern() const;
+    bool isLiteral() const;
+    std::string getPattern() const;
+    const std::string& getError() const { return error_message_; }
+
+    // Forward: first hit starting at or after byte `from`. Backward: last hit
+    // starting before `from`. Scans at most about `budget` bytes beyond what
+    // is already known.
+    Step scan(size_t from, bool forward, size_t budget);
+
+    // Every occurrence in one line, for highlighting the visible rows
+    void findInLine(std::string_view line, std::vector<MatchSpan>& spans) const;
+
+    size_t cachedHitCount() const;
+
+private:
+    // Immutable compiled pattern, shared with scans running in the background
+    struct Matcher {
+        std::string pattern;
+        bool literal;
+        LiteralSearcher searcher;
+        std::regex regex;
+
+        void findInLine(std::string_view line, std::vector<MatchSpan>& spans) const;
+    };
+
+    Step scanLiteral(const Matcher& matcher, size_t from, bool forward, size_t budget,
+                     std::vector<std::pair<size_t, uint32_t>>& hits,
+                     size_t& scanned_begin, size_t& scanned_end) const;
+    Step scanLines(const Matcher& matcher, size_t from, bool forward, size_t budget,
+                   std::vector<std::pair<size_t, uint32_t>>& hits,
+                   size_t& scanned_begin, size_t& scanned_end) const;
+
+    // Cache lookups; called with mutex_ held. A miss reports where scanning
+    // has to start because everything before it is known to be empty
+    std::optional<Step> cachedLocked(size_t from, bool forward, size_t& scan_from) const;
+    void addScannedLocked(size_t begin, size_t end);
+    SearchHit toHit(size_t position, uint32_t length) const;
+
+    std::shared_ptr<LogReader> reader_;
+    std::shared_ptr<const Matcher> matcher_;
+    std::string error_message_;
+
+    std::map<size_t, uint32_t> hits_;     // Hit start -> length (global byte offsets)
+    std::map<size_t, size_t> scanned_;    // Disjoint [begin, end) ranges of known hit starts
+    mutable std::mutex mutex_;
+};
@@ -0,0 +1,395 @@
+#include "stream_spool.hpp"
+#include "trace.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+
+#ifndef _WIN32
+    #include <fcntl.h>
+    #include <poll.h>
+    #include <sys/mman.h>
+    #include <unistd.h>
+#endif
+
+StreamSpool::StreamSpool()
+    : fd_(-1)
+    , from_file_(false)
+    , file_size_(0)
+    , io_engine_(IoEngine::PreadPool)
+    , data_(nullptr)
+    , offsets_(nullptr)
+    , memory_budget_(0)
+    , writable_(0)
+    , index_writable_(0)
+    , spill_fd_(-1)
+    , spill_mapped_(0)
+    , bytes_(0)
+    , lines_(0)
+    , finished_(false)
+    , stop_(false) {
+}
+
+StreamSpool::~StreamSpool() {
+    stop_ = true;
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+
+#ifndef _WIN32
+    // Unmapping the reservations also drops every mapping placed inside them
+    if (data_ != nullptr) {
+        munmap(data_, MAX_BYTES);
+    }
+    if (offsets_ != nullptr) {
+        munmap(offsets_, MAX_LINES * sizeof(size_t));
+    }
+    if (spill_fd_ != -1) {
+        ::close(spill_fd_);
+    }
+    if (fd_ != -1) {
+        ::close(fd_);
+    }
+#endif
+}
+
+bool StreamSpool::start(int fd, size_t memory_budget, std::string& error) {
+#ifdef _WIN32
+    (void)fd;
+    (void)memory_budget;
+    error = "reading from a pipe is not supported on Windows";
+    return false;
+#else
+    fd_ = fd;
+
+    // Address space only: nothing is committed until pages are written
+    void* data = mmap(nullptr, MAX_BYTES, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (data == MAP_FAILED) {
+        error = std::string("cannot reserve address space: ") + std::strerror(errno);
+        return false;
+    }
+    data_ = static_cast<char*>(data);
+
+    if (!reserveIndex(error)) {
+        return false;
+    }
+
+    // The temp file part must start on a page boundary
+    size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    memory_budget_ = std::clamp((memory_budget + page - 1) / page * page, page, MAX_BYTES);
+    if (mmap(data_, memory_budget_, PROT_READ | PROT_WRITE,
+             MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_FIXED, -1, 0) == MAP_FAILED) {
+        error = std::string("cannot map the memory budget: ") + std::strerror(errno);
+        return false;
+    }
+    writable_ = memory_budget_;
+
+    thread_ = std::thread([this]() { run(); });
+    return true;
+#endif
+}
+
+bool StreamSpool::startFile(int fd, size_t size, const ReadOptions& options, std::string& error) {
+#ifdef _WIN32
+    (void)fd;
+    (void)size;
+    (void)options;
+    error = "block reads are not supported on Windows";
+    return false;
+#else
+    fd_ = fd;
+    from_file_ = true;
+    file_size_ = size;
+    read_options_ = options;
+    if (!reserveIndex(error)) {
+        return false;
+    }
+
+    started_ = std::chrono::steady_clock::now();
+    thread_ = std::thread([this]() { run(); });
+    return true;
+#endif
+}
+
+bool StreamSpool::reserveIndex(std::string& error) {
+#ifdef _WIN32
+    error = "not supported on Windows";
+    return false;
+#else
+    // Reserved like the data, since strict overcommit ignores MAP_NORESERVE
+    // on writable mappings; the reading thread commits it as lines arrive
+    void* offsets = mmap(nullptr, MAX_LINES * sizeof(size_t), PROT_NONE,
+                         MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (offsets == MAP_FAILED) {
+        error = std::string("cannot reserve the line index: ") + std::strerror(errno);
+        return false;
+    }
+    offsets_ = static_cast<size_t*>(offsets);
+    if (!ensureIndexWritable(INDEX_STEP)) {
+        error = getError();
+        return false;
+    }
+    return true;
+#endif
+}
+
+size_t StreamSpool::spilledBytes() const {
+    size_t bytes = byteCount();
+    return !from_file_ && bytes > memory_budget_ ? bytes - memory_budget_ : 0;
+}
+
+size_t StreamSpool::memoryBytes() const {
+    if (from_file_) {
+        return finished() ? 0 : blockBufferSize(read_options_);
+    }
+    return std::min(byteCount(), memory_budget_);
+}
+
+ScanRate StreamSpool::indexRate() const {
+    ScanRate rate;
+    if (!from_file_) {
+        return rate;  // A pipe delivers at the writer's pace
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    rate.bytes = bytes_.load(std::memory_order_acquire);
+    rate.lines = lines_.load(std::memory_order_acquire);
+    auto end = finished() ? finished_at_ : std::chrono::steady_clock::now();
+    rate.elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(end - started_);
+    return rate;
+}
+
+std::string StreamSpool::getError() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return error_;
+}
+
+size_t StreamSpool::waitForLines(size_t known, std::chrono::milliseconds timeout) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    grown_.wait_for(lock, timeout, [&]() {
+        return lines_.load(std::memory_order_acquire) > known || finished();
+    });
+    return lines_.load(std::memory_order_acquire);
+}
+
+void StreamSpool::setGrowthCallback(std::function<void()> callback) {
+    std::lock_guard<std::mutex> lock(callback_mutex_);
+    on_growth_ = std::move(callback);
+}
+
+bool StreamSpool::ensureWritable(size_t end) {
+#ifdef _WIN32
+    (void)end;
+    return false;
+#else
+    if (end <= writable_) {
+        return true;
+    }
+    if (end > MAX_BYTES) {
+        fail("input larger than the reserved address space");
+        return false;
+    }
+
+    if (spill_fd_ == -1) {
+        const char* dir = std::getenv("TMPDIR");
+        std::string path = std::string(dir != nullptr && *dir != '\0' ? dir : "/tmp") +
+                           "/log_analyzer_spool_XXXXXX";
+        spill_fd_ = mkstemp(path.data());
+        if (spill_fd_ == -1) {
+            fail(std::string("cannot create a spill file: ") + std::strerror(errno));
+            return false;
+        }
+        unlink(path.c_str());  // Gone from the directory; freed when closed
+    }
+
+    while (writable_ < end) {
+        if (ftruncate(spill_fd_, static_cast<off_t>(spill_mapped_ + SPILL_STEP)) == -1 ||
+            mmap(data_ + writable_, SPILL_STEP, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED,
+                 spill_fd_, static_cast<off_t>(spill_mapped_)) == MAP_FAILED) {
+            fail(std::string("cannot grow the spill file: ") + std::strerror(errno));
+            return false;
+        }
+        spill_mapped_ += SPILL_STEP;
+        writable_ += SPILL_STEP;
+    }
+    return true;
+#endif
+}
+
+bool StreamSpool::ensureIndexWritable(size_t entries) {
+#ifdef _WIN32
+    (void)entries;
+    return false;
+#else
+    if (entries <= index_writable_) {
+        return true;
+    }
+    // Whole steps keep every commit page-aligned; run() stays below MAX_LINES
+    size_t committed = std::min((entries + INDEX_STEP - 1) / INDEX_STEP * INDEX_STEP, MAX_LINES);
+    if (mprotect(offsets_ + index_writable_, (committed - index_writable_) * sizeof(size_t),
+                 PROT_READ | PROT_WRITE) == -1) {
+        fail(std::string("cannot grow the line index: ") + std::strerror(errno));
+        return false;
+    }
+    index_writable_ = committed;
+    return true;
+#endif
+}
+
+void StreamSpool::publish(size_t bytes, size_t lines) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        bytes_.store(bytes, std::memory_order_release);
+        lines_.store(lines, std::memory_order_release);
+    }
+    grown_.notify_all();
+    notifyGrowth();
+}
+
+void StreamSpool::notifyGrowth() {
+    // Not under mutex_, so the callback may query the spool
+    std::lock_guard<std::mutex> lock(callback_mutex_);
+    if (on_growth_) {
+        on_growth_();
+    }
+}
+
+void StreamSpool::fail(const std::string& message) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    error_ = message;
+}
+
+void StreamSpool::run() {
+    if (from_file_) {
+        readFile();
+    } else {
+        readPipe();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        finished_at_ = std::chrono::steady_clock::now();
+        finished_.store(true, std::memory_order_release);
+    }
+    grown_.notify_all();
+    notifyGrowth();
+}
+
+void StreamSpool::readPipe() {
+#ifndef _WIN32
+    TRACE_THREAD_NAME("stdin reader");
+    size_t size = 0;
+    size_t lines = 0;
+    offsets_[0] = 0;
+
+    while (!stop_) {
+        // Wake up regularly so close() never waits on a quiet pipe
+        struct pollfd poll_fd = {fd_, POLLIN, 0};
+        int ready = poll(&poll_fd, 1, 100);
+        if (ready < 0 && errno != EINTR) {
+            fail(std::string("poll failed: ") + std::strerror(errno));
+            break;
+        }
+        if (ready <= 0) {
+            continue;
+        }
+
+        if (!ensureWritable(size + READ_CHUNK)) {
+            break;
+        }
+        ssize_t received = ::read(fd_, data_ + size, READ_CHUNK);
+        if (received < 0) {
+            if (errno == EINTR || errno == EAGAIN) {
+                continue;
+            }
+            fail(std::string("read failed: ") + std::strerror(errno));
+            break;
+        }
+        if (received == 0) {
+            break;  // End of input
+        }
+
+        // Index the complete lines that arrived, with room for one entry
+        // per byte and the end of a last partial line
+        if (!ensureIndexWritable(std::min(lines + 2 + static_cast<size_t>(received), MAX_LINES))) {
+            break;
+        }
+        {
+            TRACE_SCOPE_ARG("index chunk", "bytes", received);
+            const char* p = data_ + size;
+            const char* end = p + received;
+            while ((p = static_cast<const char*>(std::memchr(p, '\n', static_cast<size_t>(end - p)))) != nullptr) {
+                ++p;
+                if (lines + 2 >= MAX_LINES) {
+                    break;
+                }
+                offsets_[++lines] = static_cast<size_t>(p - data_);
+            }
+        }
+        size += static_cast<size_t>(received);
+
+        if (lines + 2 >= MAX_LINES) {
+            fail("too many lines");
+            publish(size, lines);
+            break;
+        }
+        publish(size, lines);
+    }
+
+    // A last line without a newline is complete once the input ends
+    if (size > offsets_[lines] && lines + 1 < MAX_LINES) {
+        offsets_[lines + 1] = size;
+        ++lines;
+    }
+    publish(size, lines);
+#endif
+}
+
+void StreamSpool::readFile() {
+    TRACE_THREAD_NAME("file reader");
+    size_t lines = 0;
+    offsets_[0] = 0;
+
+    // Lines of each block are published as soon as it is indexed
+    IoEngine engine = IoEngine::PreadPool;
+    auto index_block = [&](size_t offset, const char* block, size_t length) {
+        if (stop_) {
+            return false;
+        }
+        io_engine_.store(engine, std::memory_order_release);  // Chosen before the first block
+        TRACE_SCOPE_ARG("index block", "bytes", length);
+        const char* p = block;
+        const char* end = block + length;
+        while ((p = static_cast<const char*>(std::memchr(p, '\n', static_cast<size_t>(end - p)))) != nullptr) {
+            ++p;
+            size_t line_end = offset + static_cast<size_t>(p - block);
+            if (line_end == file_size_) {
+                break;  // The last line's end is added below
+            }
+            if (lines + 2 >= MAX_LINES) {
+                fail("too many lines");
+                return false;
+            }
+            if (lines + 2 > index_writable_ && !ensureIndexWritable(lines + 2)) {
+                return false;
+            }
+            offsets_[++lines] = line_end;
+        }
+        publish(offset + length, lines);
+        return true;
+    };
+
+    std::string error;
+    bool read = readBlocks(fd_, file_size_, read_options_, index_block, engine, error);
+    io_engine_.store(engine, std::memory_order_release);
+    if (!read) {
+        fail(error);
+        return;
+    }
+    if (stop_ || !getError().empty()) {
+        return;
+    }
+
+    // The last line ends at the end of the file, with or without a newline
+    offsets_[++lines] = file_size_;
+    publish(file_size_, lines);
+}
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include "block_read.hpp"
+#include "perf_stats.hpp"
+
+// Growable backing store for input that cannot be mmap'ed (stdin, pipes).
+// A background thread reads the descriptor into one contiguous reserved
+// address range: the first `memory_budget` bytes are anonymous memory, the
+// rest is an unlinked temporary file mapped in place, so the kernel can page
+// it out. Addresses never move, so string_views into the data stay valid
+// while it grows.
+//
+// startFile() uses only the growing index, for a regular file the caller
+// has mapped: the thread reads it with readBlocks() and indexes each block
+// from its buffer, so the pages are cached before the mapping touches them.
+//
+// Lines are indexed as they arrive, into a reserved range committed a step
+// at a time. offsets()[i] is the start of line i and offsets()[lineCount()]
+// the end of the last complete line; entries up to the published count never
+// change. POSIX only.
+class StreamSpool {
+public:
+    static constexpr size_t DEFAULT_MEMORY_BUDGET = 1ULL << 30;  // Anonymous memory before spilling
+    static constexpr size_t MAX_BYTES = 1ULL << 40;              // Address space reserved for data
+    static constexpr size_t MAX_LINES = 1ULL << 34;              // Address space reserved for the index
+    static constexpr size_t SPILL_STEP = 64 * 1024 * 1024;       // Temp file growth per mapping
+    static constexpr size_t INDEX_STEP = 1024 * 1024;            // Index entries committed at a time
+    static constexpr size_t READ_CHUNK = 1024 * 1024;
+
+    StreamSpool();
+    ~StreamSpool();
+
+    StreamSpool(const StreamSpool&) = delete;
+    StreamSpool& operator=(const StreamSpool&) = delete;
+
+    // Reserve the address space and start reading `fd`, which the spool
+    // takes ownership of
+    bool start(int fd, size_t memory_budget, std::string& error);
+
+    // Start indexing the `size` bytes of the regular file `fd` (owned by the
+    // spool from then on) with block reads; data() stays null
+    bool startFile(int fd, size_t size, const ReadOptions& options, std::string& error);
+
+    const char* data() const { return data_; }
+    const size_t* offsets() const { return offsets_; }
+
+    // Complete lines published so far
+    const std::atomic<size_t>& lineCount() const { return lines_; }
+
+    // Bytes received so far, and how many of them live in the temp file /
+    // in anonymous memory (for a file: the read buffers while loading)
+    size_t byteCount() const { return bytes_.load(std::memory_order_acquire); }
+    size_t spilledBytes() const;
+    size_t memoryBytes() const;
+
+    // The input ended (or failed; see getError())
+    bool finished() const { return finished_.load(std::memory_order_acquire); }
+    std::string getError() const;
+
+    // startFile(): what carries the reads, and how fast the file was
+    // indexed so far
+    IoEngine ioEngine() const { return io_engine_.load(std::memory_order_acquire); }
+    ScanRate indexRate() const;
+
+    // Block until more than `known` lines exist, the input ends, or the
+    // timeout passes; returns the current line count
+    size_t waitForLines(size_t known, std::chrono::milliseconds timeout);
+
+    // Called on the reading thread after new lines were published. Returns
+    // only once a call already in progress has finished, so the previous
+    // callback's captures may be destroyed afterwards.
+    void setGrowthCallback(std::function<void()> callback);
+
+private:
+    bool reserveIndex(std::string& error);
+    void run();
+    void readPipe();
+    void readFile();
+
+    // Make the data range up to `end` writable, spilling past the budget
+    bool ensureWritable(size_t end);
+
+    // Commit the line index up to `entries` entries
+    bool ensureIndexWritable(size_t entries);
+
+    void publish(size_t bytes, size_t lines);
+    void notifyGrowth();
+    void fail(const std::string& message);
+
+    int fd_;
+    bool from_file_;
+    size_t file_size_;
+    ReadOptions read_options_;
+    std::atomic<IoEngine> io_engine_;
+    std::chrono::steady_clock::time_point started_;
+    std::chrono::steady_clock::time_point finished_at_;  // Under mutex_
+    char* data_;
+    size_t* offsets_;
+    size_t memory_budget_;
+    size_t writable_;     // Bytes of data_ mapped read-write (reader thread only)
+    size_t index_writable_;  // Entries of offsets_ committed (reader thread only)
+    int spill_fd_;
+    size_t spill_mapped_;  // Bytes of the temp file mapped after the budget
+
+    std::atomic<size_t> bytes_;
+    std::atomic<size_t> lines_;
+    std::atomic<bool> finished_;
+    std::atomic<bool> stop_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable grown_;
+    std::mutex callback_mutex_;  // Held across on_growth_ calls
+    std::function<void()> on_growth_;
+    std::string error_;
+    std::thread thread_;
+};
@@ -1,52 +1,149 @@
 #include "syntax_highlighter.hpp"
 #include "ftxui/dom/elements.hpp"
+#include "keyword_table.hpp"
+#include "char_classifier.hpp"
+#include "trace.hpp"
 #include <cctype>
 #include <algorithm>
 
 using namespace ftxui;
 
-SyntaxHighlighter::SyntaxHighlighter()
-    : enabled_(true) {
-
-    // SQL Keywords (расширенный список)
-    sql_keywords_ = {
-        "SELECT", "FROM", "WHERE", "INSERT", "UPDATE", "DELETE",
-        "CREATE", "DROP", "ALTER", "TABLE", "INDEX", "VIEW",
-        "JOIN", "LEFT", "RIGHT", "INNER", "OUTER", "ON",
-        "AND", "OR", "NOT", "IN", "LIKE", "BETWEEN",
-        "ORDER", "BY", "GROUP", "HAVING", "LIMIT", "OFFSET",
-        "AS", "DISTINCT", "COUNT", "SUM", "AVG", "MAX", "MIN",
-        "NULL", "TRUE", "FALSE", "IS", "EXISTS",
-        // Дополнительные SQL ключевые слова
-        "BEGIN", "COMMIT", "ROLLBACK", "TRANSACTION",
-        "PRIMARY", "KEY", "FOREIGN", "REFERENCES", "CONSTRAINT",
-        "UNIQUE", "CHECK", "DEFAULT", "AUTO_INCREMENT",
-        "VARCHAR", "INT", "INTEGER", "TEXT", "BLOB", "DATE", "DATETIME",
-        "CASE", "WHEN", "THEN", "ELSE", "END",
-        "UNION", "ALL", "INTERSECT", "EXCEPT",
-        "GRANT", "REVOKE", "WITH", "USING"
-    };
+namespace {
+
+// Значения в таблице уровней логирования - категория для выбора цвета
+enum LevelSeverity : uint8_t {
+    SEVERITY_ERROR,
+    SEVERITY_WARNING,
+    SEVERITY_INFO,
+    SEVERITY_DEBUG,
+    SEVERITY_SUCCESS
+};
+
+// SQL Keywords (расширенный список); TRUE/FALSE/NULL also cover JSON literals
+constexpr auto SQL_KEYWORDS = makeKeywordTable(std::to_array<KeywordEntry>({
+    {"SELECT", 1}, {"FROM", 1}, {"WHERE", 1}, {"INSERT", 1}, {"UPDATE", 1}, {"DELETE", 1},
+    {"CREATE", 1}, {"DROP", 1}, {"ALTER", 1}, {"TABLE", 1}, {"INDEX", 1}, {"VIEW", 1},
+    {"JOIN", 1}, {"LEFT", 1}, {"RIGHT", 1}, {"INNER", 1}, {"OUTER", 1}, {"ON", 1},
+    {"AND", 1}, {"OR", 1}, {"NOT", 1}, {"IN", 1}, {"LIKE", 1}, {"BETWEEN", 1},
+    {"ORDER", 1}, {"BY", 1}, {"GROUP", 1}, {"HAVING", 1}, {"LIMIT", 1}, {"OFFSET", 1},
+    {"AS", 1}, {"DISTINCT", 1}, {"COUNT", 1}, {"SUM", 1}, {"AVG", 1}, {"MAX", 1}, {"MIN", 1},
+    {"NULL", 1}, {"TRUE", 1}, {"FALSE", 1}, {"IS", 1}, {"EXISTS", 1},
+    // Дополнительные SQL ключевые слова
+    {"BEGIN", 1}, {"COMMIT", 1}, {"ROLLBACK", 1}, {"TRANSACTION", 1},
+    {"PRIMARY", 1}, {"KEY", 1}, {"FOREIGN", 1}, {"REFERENCES", 1}, {"CONSTRAINT", 1},
+    {"UNIQUE", 1}, {"CHECK", 1}, {"DEFAULT", 1}, {"AUTO_INCREMENT", 1},
+    {"VARCHAR", 1}, {"INT", 1}, {"INTEGER", 1}, {"TEXT", 1}, {"BLOB", 1}, {"DATE", 1},
+    {"DATETIME", 1},
+    {"CASE", 1}, {"WHEN", 1}, {"THEN", 1}, {"ELSE", 1}, {"END", 1},
+    {"UNION", 1}, {"ALL", 1}, {"INTERSECT", 1}, {"EXCEPT", 1},
+    {"GRANT", 1}, {"REVOKE", 1}, {"WITH", 1}, {"USING", 1}
+}));
+
+// Log Levels
+constexpr auto LOG_LEVELS = makeKeywordTable(std::to_array<KeywordEntry>({
+    {"ERROR", SEVERITY_ERROR}, {"FATAL", SEVERITY_ERROR},
+    {"CRITICAL", SEVERITY_ERROR}, {"CRIT", SEVERITY_ERROR},
+    {"WARN", SEVERITY_WARNING}, {"WARNING", SEVERITY_WARNING},
+    {"INFO", SEVERITY_INFO}, {"INFORMATION", SEVERITY_INFO},
+    {"DEBUG", SEVERITY_DEBUG}, {"TRACE", SEVERITY_DEBUG},
+    {"SUCCESS", SEVERITY_SUCCESS}, {"OK", SEVERITY_SUCCESS}
+}));
+
+// Network Protocols (для Wireshark)
+constexpr auto PROTOCOLS = makeKeywordTable(std::to_array<KeywordEntry>({
+    {"TCP", 1}, {"UDP", 1}, {"HTTP", 1}, {"HTTPS", 1}, {"FTP", 1}, {"SSH", 1},
+    {"DNS", 1}, {"DHCP", 1}, {"SMTP", 1}, {"POP3", 1}, {"IMAP", 1}, {"TLS", 1},
+    {"SSL", 1}, {"ICMP", 1}, {"ARP", 1}, {"IPv4", 1}, {"IPv6", 1},
+    {"ETHERNET", 1}, {"WEBSOCKET", 1}, {"MQTT", 1}, {"AMQP", 1}
+}));
+
+// JSON literals (compared case-sensitively after the lookup)
+constexpr auto JSON_LITERALS = makeKeywordTable(std::to_array<KeywordEntry>({
+    {"true", 1}, {"false", 1}, {"null", 1}
+}));
+
+inline bool isDigit(char c) {
+    return c >= '0' && c <= '9';
+}
 
-    // JSON Keywords
-    json_keywords_ = {
-        "true", "false", "null"
-    };
+inline bool hasDigit(std::string_view word) {
+    return std::any_of(word.begin(), word.end(), [](char c) { return isDigit(c); });
+}
 
-    // Log Levels
-    log_levels_ = {
-        "ERROR", "FATAL", "CRITICAL", "CRIT",
-        "WARN", "WARNING",
-        "INFO", "INFORMATION",
-        "DEBUG", "TRACE",
-        "SUCCESS", "OK"
-    };
+inline bool isUpperWord(std::string_view word) {
+    return std::none_of(word.begin(), word.end(), [](char c) { return c >= 'a' && c <= 'z'; });
+}
 
-    // Network Protocols (для Wireshark)
-    protocols_ = {
-        "TCP", "UDP", "HTTP", "HTTPS", "FTP", "SSH", "DNS", "DHCP",
-        "SMTP", "POP3", "IMAP", "TLS", "SSL", "ICMP", "ARP",
-        "IPv4", "IPv6", "ETHERNET", "WEBSOCKET", "MQTT", "AMQP"
-    };
+inline bool isLowerWord(std::string_view word) {
+    return std::none_of(word.begin(), word.end(), [](char c) { return c >= 'A' && c <= 'Z'; });
+}
+
+inline bool isWhitespaceToken(std::string_view line, const SyntaxHighlighter::Token& token) {
+    return token.type == SyntaxHighlighter::Token::Type::Normal && token.length == 1 &&
+           std::isspace(static_cast<unsigned char>(line[token.offset]));
+}
+
+// Called right after a ':' (JSON) or '=' (logfmt) token was emitted: the
+// nearest preceding non-whitespace token becomes a key if it has the right shape
+template <LogFormat Format>
+inline void markPrecedingKey(std::string_view line, char separator,
+                             std::vector<SyntaxHighlighter::Token>& tokens) {
+    using Type = SyntaxHighlighter::Token::Type;
+
+    if constexpr (Format == LogFormat::JsonLines || Format == LogFormat::Logfmt) {
+        constexpr char expected = Format == LogFormat::JsonLines ? ':' : '=';
+        if (separator != expected || tokens.size() < 2) {
+            return;
+        }
+
+        size_t i = tokens.size() - 1;  // The separator itself
+        while (i > 0 && isWhitespaceToken(line, tokens[i - 1])) {
+            --i;
+        }
+        if (i == 0) {
+            return;
+        }
+
+        auto& candidate = tokens[i - 1];
+        if constexpr (Format == LogFormat::JsonLines) {
+            if (candidate.type == Type::String) {
+                candidate.type = Type::Key;
+            }
+        } else {
+            // logfmt keys are bare words directly attached to '='
+            if (i == tokens.size() - 1 && candidate.type != Type::String &&
+                candidate.type != Type::Special) {
+                candidate.type = Type::Key;
+            }
+        }
+    }
+}
+
+// Whether tokenizing may stop right before `c`: the tokens already emitted
+// must be final, i.e. `c` cannot be (or lead up to) a separator that retags
+// an earlier token as a key
+template <LogFormat Format>
+inline bool canStopBefore(char c) {
+    if constexpr (Format == LogFormat::JsonLines) {
+        return c != ':' && !std::isspace(static_cast<unsigned char>(c));
+    } else if constexpr (Format == LogFormat::Logfmt) {
+        return c != '=';
+    } else {
+        return true;
+    }
+}
+
+inline bool isSpecialChar(char c) {
+    return c == '{' || c == '}' || c == '[' || c == ']' ||
+           c == '(' || c == ')' || c == ',' || c == ':' ||
+           c == ';' || c == '=';
+}
+
+} // namespace
+
+SyntaxHighlighter::SyntaxHighlighter()
+    : format_(LogFormat::Generic)
+    , enabled_(true) {
 }
 
 ftxui::Element SyntaxHighlighter::highlight(std::string_view line) {
@@ -54,32 +151,181 @@ ftxui::Element SyntaxHighlighter::highlight(std::string_view line) {
         return text(std::string(line));
     }
 
-    auto tokens = tokenize(line);
+    tokenize(line, scratch_tokens_);
+    return render(line, scratch_tokens_);
+}
 
+ftxui::Element SyntaxHighlighter::render(std::string_view line,
+                                         const std::vector<Token>& tokens) const {
     if (tokens.empty()) {
         return text("");
     }
 
     // Build elements
     ftxui::Elements elements;
+    elements.reserve(tokens.size());
+    for (const auto& token : tokens) {
+        elements.push_back(tokenToElement(line, token));
+    }
+
+    return hbox(std::move(elements));
+}
+
+void SyntaxHighlighter::tokenize(std::string_view line, std::vector<Token>& tokens) const {
+    TRACE_SCOPE_ARG("tokenize", "bytes", line.size());
+    switch (format_.load(std::memory_order_relaxed)) {
+        case LogFormat::JsonLines: tokenizeWith<LogFormat::JsonLines>(line, tokens); break;
+        case LogFormat::Logfmt:    tokenizeWith<LogFormat::Logfmt>(line, tokens); break;
+        case LogFormat::Sql:       tokenizeWith<LogFormat::Sql>(line, tokens); break;
+        case LogFormat::PlainText: tokenizeWith<LogFormat::PlainText>(line, tokens); break;
+        case LogFormat::Generic:
+        default:                   tokenizeWith<LogFormat::Generic>(line, tokens); break;
+    }
+}
+
+void SyntaxHighlighter::tokenizeScalar(std::string_view line,
+                                       std::vector<Token>& tokens) const {
+    switch (format_.load(std::memory_order_relaxed)) {
+        case LogFormat::JsonLines: tokenizeScalarWith<LogFormat::JsonLines>(line, tokens); break;
+        case LogFormat::Logfmt:    tokenizeScalarWith<LogFormat::Logfmt>(line, tokens); break;
+        case LogFormat::Sql:       tokenizeScalarWith<LogFormat::Sql>(line, tokens); break;
+        case LogFormat::PlainText: tokenizeScalarWith<LogFormat::PlainText>(line, tokens); break;
+        case LogFormat::Generic:
+        default:                   tokenizeScalarWith<LogFormat::Generic>(line, tokens); break;
+    }
+}
+
+size_t SyntaxHighlighter::tokenizeRange(std::string_view line, size_t from, size_t stop,
+                                        std::vector<Token>& tokens) const {
+    switch (format_.load(std::memory_order_relaxed)) {
+        case LogFormat::JsonLines: return tokenizeRangeWith<LogFormat::JsonLines>(line, from, stop, tokens);
+        case LogFormat::Logfmt:    return tokenizeRangeWith<LogFormat::Logfmt>(line, from, stop, tokens);
+        case LogFormat::Sql:       return tokenizeRangeWith<LogFormat::Sql>(line, from, stop, tokens);
+        case LogFormat::PlainText: return tokenizeRangeWith<LogFormat::PlainText>(line, from, stop, tokens);
+        case LogFormat::Generic:
+        default:                   return tokenizeRangeWith<LogFormat::Generic>(line, from, stop, tokens);
+    }
+}
+
+void SyntaxHighlighter::buildCheckpoints(std::string_view line,
+                                         std::vector<uint32_t>& checkpoints) const {
+    checkpoints.clear();
+    checkpoints.push_back(0);
+
+    // One pass over the line; the chunk's tokens are thrown away
+    std::vector<Token> chunk;
+    size_t boundary = 0;
+    while (boundary < line.size()) {
+        boundary = tokenizeRange(line, boundary, boundary + CHECKPOINT_INTERVAL, chunk);
+        if (boundary < line.size()) {
+            checkpoints.push_back(static_cast<uint32_t>(boundary));
+        }
+    }
+}
+
+void SyntaxHighlighter::tokenizeWindow(std::string_view line,
+                                       std::span<const uint32_t> checkpoints,
+                                       size_t begin, size_t end,
+                                       std::vector<Token>& tokens) const {
+    TRACE_SCOPE_ARG("tokenize window", "bytes", end > begin ? end - begin : 0);
+    begin = std::min(begin, line.size());
+    end = std::min(std::max(end, begin), line.size());
+    if (begin == end) {
+        tokens.clear();
+        return;
+    }
+
+    // Last checkpoint at or before the window
+    auto it = std::upper_bound(checkpoints.begin(), checkpoints.end(), begin);
+    size_t from = it == checkpoints.begin() ? 0 : *(it - 1);
+
+    tokenizeRange(line, from, end, tokens);
+
+    // Drop the tokens past the window (up to the safe stopping boundary) and
+    // those between the checkpoint and the window
+    while (!tokens.empty() && tokens.back().offset >= end) {
+        tokens.pop_back();
+    }
+    auto first_visible = std::find_if(tokens.begin(), tokens.end(), [begin](const Token& token) {
+        return static_cast<size_t>(token.offset) + token.length > begin;
+    });
+    tokens.erase(tokens.begin(), first_visible);
+}
+
+ftxui::Element SyntaxHighlighter::render(std::string_view line,
+                                         const std::vector<Token>& tokens,
+                                         std::span<const MatchSpan> matches,
+                                         int current,
+                                         size_t begin, size_t end) const {
+    if (matches.empty() && begin == 0 && end >= line.size()) {
+        return render(line, tokens);
+    }
+
+    ftxui::Elements elements;
+    elements.reserve(tokens.size() + matches.size() * 2);
+    size_t m = 0;
+
+    // Split tokens at match boundaries; both lists are sorted by offset.
+    // Tokens are clipped to the visible byte window
     for (const auto& token : tokens) {
-        elements.push_back(tokenToElement(token));
+        size_t pos = std::max<size_t>(token.offset, begin);
+        size_t token_end = std::min(static_cast<size_t>(token.offset) + token.length, end);
+
+        while (pos < token_end) {
+            while (m < matches.size() &&
+                   static_cast<size_t>(matches[m].offset) + matches[m].length <= pos) {
+                ++m;
+            }
+
+            size_t match_begin = m < matches.size() ? matches[m].offset : token_end;
+            size_t match_end = m < matches.size()
+                ? static_cast<size_t>(matches[m].offset) + matches[m].length : token_end;
+
+            if (m < matches.size() && match_begin <= pos) {
+                size_t piece_end = std::min(token_end, match_end);
+                Token piece{static_cast<uint32_t>(pos), static_cast<uint32_t>(piece_end - pos),
+                            token.type};
+                auto element = tokenToElement(line, piece) | inverted;
+                if (static_cast<int>(m) == current) {
+                    element = element | underlined;
+                }
+                elements.push_back(element);
+                pos = piece_end;
+            } else {
+                size_t piece_end = std::min(token_end, match_begin);
+                Token piece{static_cast<uint32_t>(pos), static_cast<uint32_t>(piece_end - pos),
+                            token.type};
+                elements.push_back(tokenToElement(line, piece));
+                pos = piece_end;
+            }
+        }
     }
 
+    if (elements.empty()) {
+        return text("");
+    }
     return hbox(std::move(elements));
 }
 
-std::vector<SyntaxHighlighter::Token> SyntaxHighlighter::tokenize(std::string_view line) {
-    std::vector<Token> tokens;
-    std::string current;
+template <LogFormat Format>
+void SyntaxHighlighter::tokenizeScalarWith(std::string_view line,
+                                           std::vector<Token>& tokens) const {
+    tokens.clear();
+
+    auto emit = [&](size_t begin, size_t end, Token::Type type) {
+        tokens.push_back({static_cast<uint32_t>(begin),
+                          static_cast<uint32_t>(end - begin), type});
+    };
 
-    auto flush_current = [&](Token::Type type) {
-        if (!current.empty()) {
-            tokens.push_back({type, current});
-            current.clear();
+    // Words are classified as soon as they end - no second pass over tokens
+    auto flush_word = [&](size_t begin, size_t end) {
+        if (end > begin) {
+            std::string_view word = line.substr(begin, end - begin);
+            emit(begin, end, classifyFor<Format>(word, hasDigit(word)));
         }
     };
 
+    size_t start = 0;  // Start of the token being accumulated
     bool in_string = false;
     char string_delimiter = '\0';
 
@@ -89,123 +335,262 @@ std::vector<SyntaxHighlighter::Token> SyntaxHighlighter::tokenize(std::string_vi
         // Handle strings
         if (c == '"' || c == '\'') {
             if (!in_string) {
-                flush_current(Token::Type::Normal);
+                flush_word(start, i);
                 in_string = true;
                 string_delimiter = c;
-                current += c;
+                start = i;
             } else if (c == string_delimiter) {
-                current += c;
-                flush_current(Token::Type::String);
+                emit(start, i + 1, Token::Type::String);
                 in_string = false;
                 string_delimiter = '\0';
-            } else {
-                current += c;
+                start = i + 1;
             }
             continue;
         }
 
         if (in_string) {
-            current += c;
             continue;
         }
 
         // Handle special characters
-        if (c == '{' || c == '}' || c == '[' || c == ']' ||
-            c == '(' || c == ')' || c == ',' || c == ':' ||
-            c == ';' || c == '=') {
-            flush_current(Token::Type::Normal);
-            tokens.push_back({Token::Type::Special, std::string(1, c)});
+        if (isSpecialChar(c)) {
+            flush_word(start, i);
+            emit(i, i + 1, Token::Type::Special);
+            markPrecedingKey<Format>(line, c, tokens);
+            start = i + 1;
             continue;
         }
 
         // Handle whitespace
-        if (std::isspace(c)) {
-            flush_current(Token::Type::Normal);
-            current += c;
-            flush_current(Token::Type::Normal);
+        if (std::isspace(static_cast<unsigned char>(c))) {
+            flush_word(start, i);
+            emit(i, i + 1, Token::Type::Normal);
+            start = i + 1;
             continue;
         }
-
-        // Accumulate other characters
-        current += c;
     }
 
     // Flush remaining
     if (in_string) {
-        flush_current(Token::Type::String);
+        if (line.size() > start) {
+            emit(start, line.size(), Token::Type::String);
+        }
     } else {
-        flush_current(Token::Type::Normal);
+        flush_word(start, line.size());
     }
+}
+
+template <LogFormat Format>
+void SyntaxHighlighter::tokenizeWith(std::string_view line, std::vector<Token>& tokens) const {
+    if (line.size() < SCALAR_LINE_LIMIT) {
+        tokenizeScalarWith<Format>(line, tokens);
+        return;
+    }
+
+    tokenizeRangeWith<Format>(line, 0, std::string_view::npos, tokens);
+}
+
+template <LogFormat Format>
+size_t SyntaxHighlighter::tokenizeRangeWith(std::string_view line, size_t from, size_t stop,
+                                            std::vector<Token>& tokens) const {
+    tokens.clear();
+
+    auto emit = [&](size_t begin, size_t end, Token::Type type) {
+        tokens.push_back({static_cast<uint32_t>(begin),
+                          static_cast<uint32_t>(end - begin), type});
+    };
+
+    // A boundary is a clean tokenizer state: outside strings, no word pending
+    size_t start = from;         // Start of the token being accumulated
+    bool word_has_digit = false; // Digits seen in earlier blocks of the current word
+    bool in_string = false;
+    char string_delimiter = '\0';
+
+    for (size_t base = from; base < line.size(); base += CharClassifier::BLOCK_SIZE) {
+        size_t block_length = std::min(CharClassifier::BLOCK_SIZE, line.size() - base);
+        CharClassMasks masks = CharClassifier::classify(line.data() + base, block_length);
+        const uint64_t structural = masks.structural();
+
+        auto delimiter_mask = [&]() {
+            return string_delimiter == '"' ? masks.double_quote : masks.single_quote;
+        };
+
+        auto flush_word = [&](size_t end) {
+            if (end > start) {
+                size_t from = start > base ? start - base : 0;
+                bool has_digit = word_has_digit ||
+                                 (masks.digit & bitRange(from, end - base)) != 0;
+                emit(start, end, classifyFor<Format>(line.substr(start, end - start), has_digit));
+            }
+            word_has_digit = false;
+        };
+
+        // Only the bytes that can end the current state are visited
+        uint64_t pending = in_string ? delimiter_mask() : structural;
+
+        while (pending != 0) {
+            int bit = lowestBitIndex(pending);
+            size_t i = base + static_cast<size_t>(bit);
+            char c = line[i];
+
+            if (in_string) {
+                // pending only holds the closing delimiter here
+                emit(start, i + 1, Token::Type::String);
+                in_string = false;
+                string_delimiter = '\0';
+                start = i + 1;
+                pending = structural & bitsAbove(bit);
+                continue;
+            }
+
+            flush_word(i);
 
-    // Post-process to identify keywords, numbers, log levels, etc.
-    for (auto& token : tokens) {
-        if (token.type == Token::Type::Normal) {
-            std::string upper = token.text;
-            std::transform(upper.begin(), upper.end(), upper.begin(), ::toupper);
-
-            if (isLogLevel(upper)) {
-                token.type = Token::Type::LogLevel;
-                token.text = upper;  // Нормализуем к верхнему регистру
-            } else if (isProtocol(upper)) {
-                token.type = Token::Type::Protocol;
-                token.text = upper;
-            } else if (isIPAddress(token.text)) {
-                token.type = Token::Type::IPAddress;
-            } else if (isKeyword(token.text)) {
-                token.type = Token::Type::Keyword;
-            } else if (isNumber(token.text)) {
-                token.type = Token::Type::Number;
+            if (i >= stop && canStopBefore<Format>(c)) {
+                return i;
             }
+
+            if (c == '"' || c == '\'') {
+                in_string = true;
+                string_delimiter = c;
+                start = i;
+                pending = delimiter_mask() & bitsAbove(bit);
+                continue;
+            }
+
+            // Special characters and whitespace are single-byte tokens
+            if ((masks.special >> bit) & 1) {
+                emit(i, i + 1, Token::Type::Special);
+                markPrecedingKey<Format>(line, c, tokens);
+            } else {
+                emit(i, i + 1, Token::Type::Normal);
+            }
+            start = i + 1;
+            pending &= pending - 1;
+        }
+
+        // A word continuing into the next block keeps its digit information
+        if (!in_string && start < base + block_length) {
+            size_t from = start > base ? start - base : 0;
+            word_has_digit = word_has_digit ||
+                             (masks.digit & bitRange(from, block_length)) != 0;
+        }
+    }
+
+    // Flush remaining
+    if (in_string) {
+        if (line.size() > start) {
+            emit(start, line.size(), Token::Type::String);
         }
+    } else if (line.size() > start) {
+        emit(start, line.size(),
+             classifyFor<Format>(line.substr(start), word_has_digit));
     }
+    return line.size();
+}
+
+SyntaxHighlighter::Token::Type SyntaxHighlighter::classifyWord(std::string_view word) {
+    return classifyFor<LogFormat::Generic>(word, hasDigit(word));
+}
+
+template <LogFormat Format>
+SyntaxHighlighter::Token::Type SyntaxHighlighter::classifyFor(std::string_view word,
+                                                              bool has_digit) {
+    // SQL keywords only where queries are expected; in prose "IN"/"ON" stay plain
+    constexpr bool sql_keywords = Format == LogFormat::Generic || Format == LogFormat::Sql;
 
-    return tokens;
+    if (isLogLevel(word)) {
+        // Plain text only trusts upper-case levels ("ok" in a sentence is not one)
+        if (Format != LogFormat::PlainText || isUpperWord(word)) {
+            return Token::Type::LogLevel;
+        }
+    }
+    if (isProtocol(word)) {
+        return Token::Type::Protocol;
+    }
+    if (!has_digit) {
+        // IP addresses and numbers always contain a digit
+        if constexpr (sql_keywords) {
+            return isKeyword(word) ? Token::Type::Keyword : Token::Type::Normal;
+        } else if constexpr (Format == LogFormat::JsonLines) {
+            return JSON_LITERALS.contains(word) && isLowerWord(word) ? Token::Type::Keyword
+                                                                     : Token::Type::Normal;
+        } else {
+            return Token::Type::Normal;
+        }
+    }
+    if (isIPAddress(word)) {
+        return Token::Type::IPAddress;
+    }
+    if constexpr (sql_keywords) {
+        if (isKeyword(word)) {
+            return Token::Type::Keyword;
+        }
+    }
+    if (isNumber(word)) {
+        return Token::Type::Number;
+    }
+    return Token::Type::Normal;
 }
 
-ftxui::Element SyntaxHighlighter::tokenToElement(const Token& token) {
+SyntaxHighlighter::Style SyntaxHighlighter::styleFor(std::string_view line, const Token& token) {
     switch (token.type) {
         case Token::Type::Keyword:
-            return text(token.text) | color(Color::Cyan) | bold;
+            return {Color::Cyan, true};
         case Token::Type::String:
-            return text(token.text) | color(Color::Green);
+            return {Color::Green, false};
         case Token::Type::Number:
-            return text(token.text) | color(Color::Magenta);
+            return {Color::Magenta, false};
         case Token::Type::Special:
-            return text(token.text) | color(Color::Yellow);
+            return {Color::Yellow, false};
         case Token::Type::LogLevel:
             // Разные цвета для разных уровней логирования
-            if (token.text == "ERROR" || token.text == "FATAL" || token.text == "CRITICAL" || token.text == "CRIT") {
-                return text(token.text) | color(Color::Red) | bold;
-            } else if (token.text == "WARN" || token.text == "WARNING") {
-                return text(token.text) | color(Color::Yellow) | bold;
-            } else if (token.text == "INFO" || token.text == "INFORMATION") {
-                return text(token.text) | color(Color::Blue) | bold;
-            } else if (token.text == "DEBUG" || token.text == "TRACE") {
-                return text(token.text) | color(Color::GrayLight);
-            } else if (token.text == "SUCCESS" || token.text == "OK") {
-                return text(token.text) | color(Color::Green) | bold;
+            switch (LOG_LEVELS.find(token.textIn(line))) {
+                case SEVERITY_ERROR:
+                    return {Color::Red, true};
+                case SEVERITY_WARNING:
+                    return {Color::Yellow, true};
+                case SEVERITY_INFO:
+                    return {Color::Blue, true};
+                case SEVERITY_DEBUG:
+                    return {Color::GrayLight, false};
+                case SEVERITY_SUCCESS:
+                    return {Color::Green, true};
+                default:
+                    return {Color::White, false};
             }
-            return text(token.text) | color(Color::White);
         case Token::Type::IPAddress:
-            return text(token.text) | color(Color::CyanLight);
+            return {Color::CyanLight, false};
         case Token::Type::Protocol:
-            return text(token.text) | color(Color::Magenta) | bold;
+            return {Color::Magenta, true};
         case Token::Type::Timestamp:
-            return text(token.text) | color(Color::GrayLight);
+            return {Color::GrayLight, false};
+        case Token::Type::Key:
+            return {Color::BlueLight, false};
         case Token::Type::Normal:
         default:
-            return text(token.text);
+            return {};
     }
 }
 
-bool SyntaxHighlighter::isKeyword(const std::string& word) const {
-    std::string upper = word;
-    std::transform(upper.begin(), upper.end(), upper.begin(), ::toupper);
+ftxui::Element SyntaxHighlighter::tokenToElement(std::string_view line,
+                                                 const Token& token) const {
+    auto element = text(std::string(token.textIn(line)));
+
+    Style style = styleFor(line, token);
+    if (style.foreground != Color::Default) {
+        element = element | color(style.foreground);
+    }
+    if (style.bold) {
+        element = element | bold;
+    }
+    return element;
+}
 
-    return sql_keywords_.count(upper) > 0 || json_keywords_.count(word) > 0;
+bool SyntaxHighlighter::isKeyword(std::string_view word) {
+    return SQL_KEYWORDS.contains(word);
 }
 
-bool SyntaxHighlighter::isNumber(const std::string& word) const {
+bool SyntaxHighlighter::isNumber(std::string_view word) {
     if (word.empty()) return false;
 
     bool has_digit = false;
@@ -214,7 +599,7 @@ bool SyntaxHighlighter::isNumber(const std::string& word) const {
     for (size_t i = 0; i < word.size(); ++i) {
         char c = word[i];
 
-        if (std::isdigit(c)) {
+        if (isDigit(c)) {
             has_digit = true;
         } else if (c == '.' && !has_dot) {
             has_dot = true;
@@ -229,15 +614,15 @@ bool SyntaxHighlighter::isNumber(const std::string& word) const {
     return has_digit;
 }
 
-bool SyntaxHighlighter::isLogLevel(const std::string& word) const {
-    return log_levels_.count(word) > 0;
+bool SyntaxHighlighter::isLogLevel(std::string_view word) {
+    return LOG_LEVELS.contains(word);
 }
 
-bool SyntaxHighlighter::isProtocol(const std::string& word) const {
-    return protocols_.count(word) > 0;
+bool SyntaxHighlighter::isProtocol(std::string_view word) {
+    return PROTOCOLS.contains(word);
 }
 
-bool SyntaxHighlighter::isIPAddress(const std::string& word) const {
+bool SyntaxHighlighter::isIPAddress(std::string_view word) {
     // Простая проверка IPv4 адреса (xxx.xxx.xxx.xxx)
     if (word.empty()) return false;
 
@@ -246,7 +631,7 @@ bool SyntaxHighlighter::isIPAddress(const std::string& word) const {
     int current_value = 0;
 
     for (char c : word) {
-        if (std::isdigit(c)) {
+        if (isDigit(c)) {
             current_value = current_value * 10 + (c - '0');
             digits_in_group++;
             if (current_value > 255 || digits_in_group > 3) {
@@ -1,25 +1,20 @@
 #pragma once
 
+#include <atomic>
 #include <string>
 #include <string_view>
 #include <vector>
-#include <unordered_set>
+#include <cstdint>
 #include "ftxui/dom/elements.hpp"
+#include "format_sniffer.hpp"
+#include "match_index.hpp"
+#include <span>
 
 class SyntaxHighlighter {
 public:
-    SyntaxHighlighter();
-
-    // Highlight a line and return FTXUI element
-    ftxui::Element highlight(std::string_view line);
-
-    // Enable/disable highlighting
-    void setEnabled(bool enabled) { enabled_ = enabled; }
-    bool isEnabled() const { return enabled_; }
-
-private:
+    // A token is a span into the original line, so tokenizing never copies text
     struct Token {
-        enum class Type {
+        enum class Type : uint8_t {
             Normal,
             Keyword,
             String,
@@ -28,24 +23,105 @@ private:
             LogLevel,      // ERROR, WARN, INFO, DEBUG
             IPAddress,     // IP addresses
             Protocol,      // TCP, UDP, HTTP, etc.
-            Timestamp      // Timestamps
+            Timestamp,     // Timestamps
+            Key            // JSON object keys, logfmt field names
         };
 
+        uint32_t offset;
+        uint32_t length;
         Type type;
-        std::string text;
+
+        std::string_view textIn(std::string_view line) const {
+            return line.substr(offset, length);
+        }
+
+        bool operator==(const Token&) const = default;
     };
 
-    std::vector<Token> tokenize(std::string_view line);
-    ftxui::Element tokenToElement(const Token& token);
-    bool isKeyword(const std::string& word) const;
-    bool isNumber(const std::string& word) const;
-    bool isLogLevel(const std::string& word) const;
-    bool isIPAddress(const std::string& word) const;
-    bool isProtocol(const std::string& word) const;
-
-    std::unordered_set<std::string> sql_keywords_;
-    std::unordered_set<std::string> json_keywords_;
-    std::unordered_set<std::string> log_levels_;
-    std::unordered_set<std::string> protocols_;
+    SyntaxHighlighter();
+
+    // Highlight a line and return FTXUI element
+    ftxui::Element highlight(std::string_view line);
+
+    // Split a line into classified spans; reuses the capacity of `tokens`.
+    // Token boundaries come from SIMD character-class bitmasks.
+    void tokenize(std::string_view line, std::vector<Token>& tokens) const;
+
+    // Reference byte-at-a-time tokenizer with identical output (short lines)
+    void tokenizeScalar(std::string_view line, std::vector<Token>& tokens) const;
+
+    // Distance between resume points kept for very long lines
+    static constexpr size_t CHECKPOINT_INTERVAL = 4096;
+
+    // Resumable tokenization for very long lines. `from` must be 0 or a
+    // boundary returned by an earlier call; stops at the first boundary at or
+    // after `stop` that no later token can affect and returns it
+    // (line.size() once the line is exhausted)
+    size_t tokenizeRange(std::string_view line, size_t from, size_t stop,
+                         std::vector<Token>& tokens) const;
+
+    // Resume points about every CHECKPOINT_INTERVAL bytes, starting with 0
+    void buildCheckpoints(std::string_view line, std::vector<uint32_t>& checkpoints) const;
+
+    // Tokens overlapping bytes [begin, end) only, resumed from the nearest
+    // checkpoint so the cost does not depend on where in the line we are
+    void tokenizeWindow(std::string_view line, std::span<const uint32_t> checkpoints,
+                        size_t begin, size_t end, std::vector<Token>& tokens) const;
+
+    // Build the FTXUI element for already tokenized spans of `line`
+    ftxui::Element render(std::string_view line, const std::vector<Token>& tokens) const;
+
+    // Same, with filter matches overlaid in inverse video on top of the token
+    // colours; the match at index `current` is also underlined. Only bytes
+    // [begin, end) are rendered (horizontal scrolling)
+    ftxui::Element render(std::string_view line, const std::vector<Token>& tokens,
+                          std::span<const MatchSpan> matches, int current = -1,
+                          size_t begin = 0, size_t end = std::string_view::npos) const;
+
+    // Colour and weight of a token; shared by the element renderer and LogView
+    struct Style {
+        ftxui::Color foreground = ftxui::Color::Default;
+        bool bold = false;
+    };
+    static Style styleFor(std::string_view line, const Token& token);
+
+    // Classify a single word (no quotes, whitespace or special characters)
+    // with the generic rules
+    static Token::Type classifyWord(std::string_view word);
+
+    // Select the specialised tokenizer for a sniffed file format; may change
+    // while other threads tokenize (a stream is sniffed once lines arrive)
+    void setFormat(LogFormat format) { format_.store(format, std::memory_order_relaxed); }
+    LogFormat getFormat() const { return format_.load(std::memory_order_relaxed); }
+
+    // Enable/disable highlighting
+    void setEnabled(bool enabled) { enabled_ = enabled; }
+    bool isEnabled() const { return enabled_; }
+
+private:
+    // Lines shorter than this are tokenized without building bitmasks
+    static constexpr size_t SCALAR_LINE_LIMIT = 32;
+
+    // One instantiation per format: keyword sets and key rules are fixed at
+    // compile time, so the per-byte loops carry no format branches
+    template <LogFormat Format>
+    void tokenizeWith(std::string_view line, std::vector<Token>& tokens) const;
+    template <LogFormat Format>
+    size_t tokenizeRangeWith(std::string_view line, size_t from, size_t stop,
+                             std::vector<Token>& tokens) const;
+    template <LogFormat Format>
+    void tokenizeScalarWith(std::string_view line, std::vector<Token>& tokens) const;
+    template <LogFormat Format>
+    static Token::Type classifyFor(std::string_view word, bool has_digit);
+
+    ftxui::Element tokenToElement(std::string_view line, const Token& token) const;
+    static bool isKeyword(std::string_view word);
+    static bool isNumber(std::string_view word);
+    static bool isLogLevel(std::string_view word);
+    static bool isIPAddress(std::string_view word);
+    static bool isProtocol(std::string_view word);
+
+    std::vector<Token> scratch_tokens_;  // Reused between highlight() calls
+    std::atomic<LogFormat> format_;
     bool enabled_;
 };
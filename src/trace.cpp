@@ -0,0 +1,216 @@
+#include "trace.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+std::atomic<bool> Trace::enabled_{false};
+
+namespace {
+
+struct Event {
+    const char* name;
+    const char* arg_name;  // nullptr: no argument
+    uint64_t arg;
+    int64_t start;
+    int64_t end;
+};
+
+// One per thread. Only the owner records; the mutex is there for the dump
+// and is never contended while tracing.
+struct ThreadBuffer {
+    std::mutex mutex;
+    std::vector<Event> events;  // Grows to EVENTS_PER_THREAD, then a ring
+    size_t next = 0;            // Oldest event once wrapped
+    bool wrapped = false;
+    int tid = 0;
+    std::string name;
+    bool finished = false;  // The thread ended; guarded by the registry mutex
+};
+
+struct Registry {
+    std::mutex mutex;
+    std::vector<std::shared_ptr<ThreadBuffer>> buffers;  // Oldest thread first
+    int next_tid = 1;
+    int64_t origin = 0;  // Timestamps are written relative to enable()
+};
+
+// Never destroyed: the main thread hands its buffer back after static
+// destructors may already have run
+Registry& registry() {
+    static Registry* instance = new Registry();
+    return *instance;
+}
+
+// Registers the thread's buffer on first use and hands it back when the
+// thread ends: kept for the dump if it recorded anything, dropped if not
+struct BufferHolder {
+    std::shared_ptr<ThreadBuffer> buffer;
+
+    BufferHolder() : buffer(std::make_shared<ThreadBuffer>()) {
+        Registry& reg = registry();
+        std::lock_guard<std::mutex> lock(reg.mutex);
+        buffer->tid = reg.next_tid++;
+        reg.buffers.push_back(buffer);
+    }
+
+    ~BufferHolder() {
+        Registry& reg = registry();
+        std::lock_guard<std::mutex> lock(reg.mutex);
+        bool empty;
+        {
+            std::lock_guard<std::mutex> buffer_lock(buffer->mutex);
+            empty = buffer->events.empty();
+        }
+        buffer->finished = true;
+        if (empty) {
+            std::erase(reg.buffers, buffer);
+        }
+
+        // Only the most recently started of the ended threads are kept
+        size_t finished = static_cast<size_t>(std::count_if(
+            reg.buffers.begin(), reg.buffers.end(), [](const auto& kept) { return kept->finished; }));
+        for (auto it = reg.buffers.begin(); finished > Trace::FINISHED_THREADS_KEPT;) {
+            if ((*it)->finished) {
+                it = reg.buffers.erase(it);
+                --finished;
+            } else {
+                ++it;
+            }
+        }
+    }
+
+    BufferHolder(const BufferHolder&) = delete;
+    BufferHolder& operator=(const BufferHolder&) = delete;
+};
+
+ThreadBuffer& threadBuffer() {
+    thread_local BufferHolder holder;
+    return *holder.buffer;
+}
+
+void writeString(std::FILE* out, const char* text) {
+    std::fputc('"', out);
+    for (const char* p = text; *p != '\0'; ++p) {
+        unsigned char c = static_cast<unsigned char>(*p);
+        if (c == '"' || c == '\\') {
+            std::fputc('\\', out);
+            std::fputc(c, out);
+        } else if (c < 0x20) {
+            std::fprintf(out, "\\u%04x", c);
+        } else {
+            std::fputc(c, out);
+        }
+    }
+    std::fputc('"', out);
+}
+
+} // namespace
+
+void Trace::enable() {
+    Registry& reg = registry();
+    {
+        std::lock_guard<std::mutex> lock(reg.mutex);
+        if (reg.origin == 0) {
+            reg.origin = now();
+        }
+    }
+    enabled_.store(true, std::memory_order_relaxed);
+}
+
+void Trace::setThreadName(const char* name) {
+    if (!enabled()) {
+        return;  // Untraced runs allocate nothing per thread
+    }
+    ThreadBuffer& buffer = threadBuffer();
+    std::lock_guard<std::mutex> lock(buffer.mutex);
+    buffer.name = name;
+}
+
+void Trace::record(const char* name, int64_t start_ns, int64_t end_ns,
+                   const char* arg_name, uint64_t arg) {
+    ThreadBuffer& buffer = threadBuffer();
+    std::lock_guard<std::mutex> lock(buffer.mutex);
+    Event event{name, arg_name, arg, start_ns, end_ns};
+
+    // Short-lived threads (filter slices) only pay for what they record
+    if (!buffer.wrapped && buffer.events.size() < EVENTS_PER_THREAD) {
+        buffer.events.push_back(event);
+        return;
+    }
+    buffer.wrapped = true;
+    buffer.events[buffer.next] = event;
+    buffer.next = (buffer.next + 1) % buffer.events.size();
+}
+
+void Trace::reset() {
+    enabled_.store(false, std::memory_order_relaxed);
+    Registry& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    reg.origin = 0;
+    std::erase_if(reg.buffers, [](const auto& buffer) { return buffer->finished; });
+    for (auto& buffer : reg.buffers) {
+        std::lock_guard<std::mutex> buffer_lock(buffer->mutex);
+        buffer->events.clear();
+        buffer->next = 0;
+        buffer->wrapped = false;
+        buffer->name.clear();
+    }
+}
+
+bool Trace::writeChromeJson(const std::string& path, std::string& error) {
+    std::FILE* out = std::fopen(path.c_str(), "w");
+    if (out == nullptr) {
+        error = "Cannot create " + path + ": " + std::strerror(errno);
+        return false;
+    }
+
+    Registry& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+
+    std::fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n", out);
+    std::fputs("{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,"
+               "\"args\":{\"name\":\"log_analyzer\"}}", out);
+
+    for (auto& buffer : reg.buffers) {
+        std::lock_guard<std::mutex> buffer_lock(buffer->mutex);
+        if (!buffer->name.empty()) {
+            std::fprintf(out, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":",
+                         buffer->tid);
+            writeString(out, buffer->name.c_str());
+            std::fputs("}}", out);
+        }
+
+        // Oldest first: after a wrap the ring starts at `next`
+        size_t count = buffer->events.size();
+        size_t first = buffer->wrapped ? buffer->next : 0;
+        for (size_t i = 0; i < count; ++i) {
+            const Event& event = buffer->events[(first + i) % buffer->events.size()];
+            std::fputs(",\n{\"name\":", out);
+            writeString(out, event.name);
+            std::fprintf(out, ",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f",
+                         buffer->tid, static_cast<double>(event.start - reg.origin) / 1000.0,
+                         static_cast<double>(event.end - event.start) / 1000.0);
+            if (event.arg_name != nullptr) {
+                std::fputs(",\"args\":{", out);
+                writeString(out, event.arg_name);
+                std::fprintf(out, ":%" PRIu64 "}", event.arg);
+            }
+            std::fputc('}', out);
+        }
+    }
+    std::fputs("\n]}\n", out);
+
+    bool ok = std::ferror(out) == 0;
+    if (std::fclose(out) != 0) {
+        ok = false;
+    }
+    if (!ok) {
+        error = "Write failed: " + path;
+    }
+    return ok;
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Scoped tracing of internal work (open, indexing, filter chunks, tokenizing,
+// frames) for slow-case investigations:
+//
+//   TRACE_SCOPE("filter chunk");
+//   TRACE_SCOPE_ARG("tokenize", "bytes", line.size());
+//
+// Each thread records into its own fixed-size ring (the newest events win),
+// and Trace::writeChromeJson() dumps everything in Chrome trace-event
+// format for Perfetto or chrome://tracing. Rings of ended threads are kept
+// for the dump, up to FINISHED_THREADS_KEPT of them; scans start fresh
+// workers every time, so older ones are dropped. Until Trace::enable() a scope
+// costs one relaxed load; building with LOG_ANALYZER_TRACING=0 removes
+// the scopes entirely.
+#ifndef LOG_ANALYZER_TRACING
+    #define LOG_ANALYZER_TRACING 1
+#endif
+
+class Trace {
+public:
+    static constexpr size_t EVENTS_PER_THREAD = 1 << 16;
+    static constexpr size_t FINISHED_THREADS_KEPT = 64;
+
+    // Start recording (e.g. for --trace); no events are kept before this
+    static void enable();
+    static bool enabled() { return enabled_.load(std::memory_order_relaxed); }
+
+    // Label the calling thread in the timeline ("ui", "filter", ...);
+    // ignored before enable()
+    static void setThreadName(const char* name);
+
+    // Write every recorded event as Chrome trace-event JSON
+    static bool writeChromeJson(const std::string& path, std::string& error);
+
+    // Stop recording and drop events, thread names and ended threads (tests)
+    static void reset();
+
+    static int64_t now() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    // Add a finished span; `name` and `arg_name` must be string literals
+    static void record(const char* name, int64_t start_ns, int64_t end_ns,
+                       const char* arg_name, uint64_t arg);
+
+private:
+    static std::atomic<bool> enabled_;
+};
+
+// Records its own lifetime as one span
+class TraceScope {
+public:
+    explicit TraceScope(const char* name, const char* arg_name = nullptr, uint64_t arg = 0)
+        : name_(Trace::enabled() ? name : nullptr)
+        , arg_name_(arg_name)
+        , arg_(arg)
+        , start_(name_ != nullptr ? Trace::now() : 0) {
+    }
+
+    ~TraceScope() {
+        if (name_ != nullptr) {
+            Trace::record(name_, start_, Trace::now(), arg_name_, arg_);
+        }
+    }
+
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+    const char* name_;  // nullptr: tracing was off when the scope began
+    const char* arg_name_;
+    uint64_t arg_;
+    int64_t start_;
+};
+
+#if LOG_ANALYZER_TRACING
+    #define TRACE_CONCAT_INNER(a, b) a##b
+    #define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+    #define TRACE_SCOPE(name) TraceScope TRACE_CONCAT(trace_scope_, __LINE__)(name)
+    #define TRACE_SCOPE_ARG(name, arg_name, arg) \
+        TraceScope TRACE_CONCAT(trace_scope_, __LINE__)(name, arg_name, static_cast<uint64_t>(arg))
+    #define TRACE_THREAD_NAME(name) Trace::setThreadName(name)
+#else
+    #define TRACE_SCOPE(name) ((void)0)
+    #define TRACE_SCOPE_ARG(name, arg_name, arg) ((void)0)
+    #define TRACE_THREAD_NAME(name) ((void)0)
+#endif
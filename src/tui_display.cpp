@@ -1,34 +1,143 @@
 #include "tui_display.hpp"
+#include "parallel.hpp"
+#include "trace.hpp"
 #include "ftxui/component/component.hpp"
 #include "ftxui/component/screen_interactive.hpp"
 #include "ftxui/dom/elements.hpp"
 #include <sstream>
-#include <iomanip>
 #include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstring>
 
 using namespace ftxui;
 
+namespace {
+
+constexpr int GROUP_NUMBER_WIDTH = 12;  // Columns per number in the group table
+
+// Lines the filter hands to FilterEngine::scanLines() between cancellation
+// and memory checks: a full slice for every core
+size_t filterChunkSize() {
+    return threadCount(0) * FilterEngine::MIN_LINES_PER_THREAD;
+}
+
+// `text` cut or padded to `width` screen columns, cut between whole glyphs
+std::string tableCell(std::string_view text, size_t width, bool align_right) {
+    // Keys and templates are log bytes: made safe, then cut to whole glyphs
+    std::string cell = sanitizeUtf8(text);
+    cell.resize(prefixForWidth(cell, width));
+    std::string padding(width - std::min(width, displayWidth(cell)), ' ');
+    return align_right ? padding + cell : cell + padding;
+}
+
+} // namespace
+
 TuiDisplay::TuiDisplay(std::shared_ptr<LogReader> reader,
                        std::shared_ptr<FilterEngine> filter,
-                       std::shared_ptr<SyntaxHighlighter> highlighter)
+                       std::shared_ptr<SyntaxHighlighter> highlighter,
+                       std::shared_ptr<MemoryBudget> budget)
     : reader_(reader)
     , filter_(filter)
     , highlighter_(highlighter)
+    , highlight_cache_(std::make_unique<HighlightCache>(reader, highlighter))
+    , budget_(budget ? budget : std::make_shared<MemoryBudget>())
     , scroll_position_(0)
+    , last_scroll_position_(0)
     , selected_line_(0)
+    , horizontal_offset_(0)
     , highlight_enabled_(true)
     , case_sensitive_(false)
+    , filter_focused_(true)
+    , column_view_(false)
+    , format_sniffed_(false)
     , filter_in_progress_(false)
     , should_exit_(false)
     , filter_generation_(0)
-    , screen_(ScreenInteractive::Fullscreen()) {
+    , sort_field_(SortField::Line)
+    , sort_descending_(false)
+    , sort_generation_(0)
+    , sort_in_progress_(false)
+    , group_prompt_active_(false)
+    , group_column_(GroupColumn::Count)
+    , group_descending_(true)
+    , group_scroll_(0)
+    , templates_visible_(false)
+    , templates_rare_first_(false)
+    , template_selected_(0)
+    , template_scroll_(0)
+    , template_generation_(0)
+    , templates_in_progress_(false)
+    , search_(std::make_unique<SearchEngine>(reader))
+    , search_prompt_active_(false)
+    , search_forward_(true)
+    , search_origin_(0)
+    , search_generation_(0)
+    , search_in_progress_(false)
+    , export_prompt_active_(false)
+    , export_in_progress_(false)
+    , perf_overlay_visible_(false)
+    , pending_line_delta_(0)
+    , pending_page_delta_(0)
+    , screen_(ScreenInteractive::Fullscreen())
+    , redraw_(std::make_unique<RedrawScheduler>([this]() {
+          // Wakes the UI loop; the event itself is ignored by the handlers
+          screen_.PostEvent(Event::Custom);
+      })) {
+
+    // Sample the file and pick the matching tokenizer; streamed input is
+    // sampled again by the renderer once enough lines have arrived
+    sniffFormatLocked();
 
     // Initialize with all lines visible
     updateVisibleLines();
+
+    // Streamed input: repaint as lines arrive (coalesced like any other request)
+    reader_->setGrowthCallback([this]() { redraw_->request(); });
 }
 
 TuiDisplay::~TuiDisplay() {
+    reader_->setGrowthCallback(nullptr);
+    ++filter_generation_;  // A filter following a stream stops at its next check
+    ++search_generation_;  // So does a background search, between chunks
+    ++template_generation_;  // And template mining, every few thousand rows
     stop();
+
+    // Jobs that cannot be cancelled run to completion first: a save in
+    // progress never leaves the file cut short
+    joinBackground();
+}
+
+void TuiDisplay::startBackground(const char* name, std::function<void()> work) {
+    std::lock_guard<std::mutex> lock(background_mutex_);
+    auto finished = std::remove_if(background_threads_.begin(), background_threads_.end(),
+                                   [](BackgroundThread& background) {
+        if (!*background.done) {
+            return false;
+        }
+        background.thread.join();  // Past its last statement: returns at once
+        return true;
+    });
+    background_threads_.erase(finished, background_threads_.end());
+
+    auto done = std::make_shared<std::atomic<bool>>(false);
+    std::thread thread([name, work = std::move(work), done]() {
+        TRACE_THREAD_NAME(name);
+        work();
+        *done = true;
+    });
+    background_threads_.push_back({std::move(thread), std::move(done)});
+}
+
+void TuiDisplay::joinBackground() {
+    std::vector<BackgroundThread> threads;
+    {
+        std::lock_guard<std::mutex> lock(background_mutex_);
+        threads.swap(background_threads_);
+    }
+    for (auto& background : threads) {
+        background.thread.join();
+    }
 }
 
 void TuiDisplay::stop() {
@@ -37,6 +146,7 @@ void TuiDisplay::stop() {
 }
 
 void TuiDisplay::run() {
+    TRACE_THREAD_NAME("ui");
     main_container_ = buildUI();
     screen_.Loop(main_container_);
 }
@@ -47,21 +157,37 @@ Component TuiDisplay::buildUI() {
     input_option.on_change = [this]() {
         applyFilterAsync();
     };
+    input_option.on_enter = [this]() {
+        filter_focused_ = false;
+    };
 
     filter_input_component_ = Input(&filter_input_, "Enter regex pattern...", input_option);
 
     // Main component with custom renderer
     auto main_component = Renderer(filter_input_component_, [this] {
+        // Everything requested so far is drawn by this frame
+        redraw_->frameStarted();
+        TRACE_SCOPE("frame");
+        auto frame_started = std::chrono::steady_clock::now();
+
         std::lock_guard<std::mutex> lock(visible_lines_mutex_);
 
+        // Unfiltered streams show every line received so far
+        bool growing = reader_->isGrowing();
+        visible_rows_.extendIdentity(reader_->getLineCount());
+        sniffFormatLocked();
+        applyPendingScroll();
+        updateMemoryAccounts();
+
         // Header
         auto title = text("Log Analyzer") | bold | color(Color::Cyan);
-        auto file_info = text(" File: " + reader_->getFilename());
+        auto file_info = text(" File: " + reader_->getFilename() + (growing ? " (reading...)" : ""));
 
         std::stringstream info;
-        info << " Lines: " << visible_line_indices_.size()
+        info << " Lines: " << visible_rows_.size()
              << "/" << reader_->getLineCount()
-             << " Size: " << (reader_->getFileSize() / 1024 / 1024) << " MB";
+             << " Size: " << (reader_->getFileSize() / 1024 / 1024) << " MB"
+             << " Format: " << formatName(highlighter_->getFormat());
 
         auto stats = text(info.str()) | color(Color::Yellow);
 
@@ -77,68 +203,106 @@ Component TuiDisplay::buildUI() {
         filter_box_elements.push_back(filter_input_component_->Render() | flex | border);
         auto filter_box = hbox(filter_box_elements);
 
-        // Log display area
-        Elements lines_elements;
+        // Log display area: one node paints every visible row
         int terminal_height = screen_.dimy() - 8;  // Reserve space for header/footer
 
+        // Columns left of the line number gutter (and the field columns)
+        int fields_width = column_view_ ? LogView::FIELDS_WIDTH : 0;
+        size_t content_width = static_cast<size_t>(
+            std::max(1, screen_.dimx() - gutterWidth() - fields_width));
+
         // Calculate visible range
         size_t start = scroll_position_;
-        size_t end = std::min(start + static_cast<size_t>(terminal_height),
-                              visible_line_indices_.size());
+        size_t end = std::min(start + static_cast<size_t>(std::max(0, terminal_height)),
+                              visible_rows_.size());
 
-        for (size_t i = start; i < end; ++i) {
-            size_t line_idx = visible_line_indices_[i];
-            auto line_view = reader_->getLine(line_idx);
-
-            // Line number
-            std::stringstream ss;
-            ss << std::setw(8) << std::right << (line_idx + 1) << " │ ";
-
-            Element line_num = text(ss.str()) | color(Color::GreenLight);
-
-            // Line content
-            Element content;
-            if (highlight_enabled_) {
-                content = highlighter_->highlight(line_view);
-            } else {
-                content = text(std::string(line_view));
-            }
-
-            // Highlight selected line
-            Elements line_parts;
-            line_parts.push_back(line_num);
-            line_parts.push_back(content);
-            auto line_element = hbox(line_parts);
-
-            if (i == static_cast<size_t>(selected_line_ + scroll_position_)) {
-                line_element = line_element | bgcolor(Color::Blue) | bold;
-            }
+        Element log_area;
+        if (templates_visible_) {
+            log_area = templateTableLocked(terminal_height, screen_.dimx());
+        } else if (group_spec_) {
+            log_area = groupTableLocked(terminal_height, screen_.dimx());
+        } else if (start < end) {
+            log_area = logView(buildLogFrame(start, end, content_width));
+        } else {
+            log_area = text("No matching lines") | color(Color::Red) | center;
+        }
 
-            lines_elements.push_back(line_element);
+        if (highlight_enabled_ && terminal_height > 0 && !group_spec_ && !templates_visible_) {
+            prefetchNeighbourPages(start, end, static_cast<size_t>(terminal_height));
         }
 
-        if (lines_elements.empty()) {
-            lines_elements.push_back(text("No matching lines") | color(Color::Red) | center);
+        if (perf_overlay_visible_) {
+            auto overlay = vbox({hbox({filler(), perfOverlay(perfSnapshotLocked())}), filler()});
+            log_area = dbox({log_area, overlay});
+            redraw_->requestAfter(PERF_REFRESH);  // Keep the numbers live while idle
         }
 
-        auto log_area = vbox(lines_elements) | flex;
+        log_area = log_area | flex;
 
         // Status bar
         std::string status = status_message_;
-        if (filter_in_progress_) {
+        if (search_prompt_active_) {
+            status = (search_forward_ ? "/" : "?") + search_input_ + "_";
+        } else if (export_prompt_active_) {
+            status = "Save visible lines to: " + export_input_ + "_";
+        } else if (group_prompt_active_) {
+            status = "Group by: " + group_input_ + "_";
+        } else if (export_in_progress_) {
+            status = "Saving...";
+        } else if (search_in_progress_) {
+            status = "Searching for " + search_->getPattern() + "...";
+        } else if (filter_in_progress_) {
             status = "Filtering...";
+        } else if (sort_in_progress_) {
+            status = "Sorting...";
+        } else if (templates_in_progress_) {
+            status = "Clustering lines into templates...";
         }
 
         Elements status_bar_elements;
         status_bar_elements.push_back(text(" " + status) | color(Color::GreenLight));
         status_bar_elements.push_back(filler());
+        if (horizontal_offset_ > 0) {
+            status_bar_elements.push_back(text(" Col: " + std::to_string(horizontal_offset_ + 1) + " "));
+        }
+        if (sort_field_ != SortField::Line) {
+            status_bar_elements.push_back(text(sort_field_ == SortField::Level ? " Sort: level "
+                                               : sort_descending_ ? " Sort: time ↓ " : " Sort: time ↑ "));
+        }
+        if (column_view_) {
+            status_bar_elements.push_back(text(" [C]olumns "));
+        }
+        if (group_spec_) {
+            status_bar_elements.push_back(text(" [G]roup: " + group_text_ + " "));
+        }
+        if (templates_visible_) {
+            status_bar_elements.push_back(text(" [T]emplates "));
+        } else if (template_base_rows_) {
+            status_bar_elements.push_back(text(" [T]emplate: " + sanitizeUtf8(template_drill_text_.substr(0, prefixForWidth(template_drill_text_, 40))) + " "));
+        }
+        status_bar_elements.push_back(memoryStatus());
         status_bar_elements.push_back(text(highlight_enabled_ ?
             " [H]ighlight: ON " : " [H]ighlight: OFF "));
+        if (perf_overlay_visible_) {
+            status_bar_elements.push_back(text(" [P]erf: ON "));
+        }
         status_bar_elements.push_back(text(" [Q]uit "));
         auto status_bar = hbox(status_bar_elements);
 
         // Help bar
-        auto help = text(" ↑↓: Navigate  PgUp/PgDn: Scroll  H: Toggle highlight  Q: Quit ") |
+        auto help = text(search_prompt_active_
+            ? " Typing search  Enter: Keep  Esc: Cancel "
+            : export_prompt_active_
+            ? " Typing file name  Enter: Save  Esc: Cancel "
+            : group_prompt_active_
+            ? " KEY [VALUE]: $N, level, minute, hour, json:PATH  Enter: Group (empty: off)  Esc: Cancel "
+            : templates_visible_
+            ? " ↑↓/PgUp/PgDn: Select  Enter: Show lines  o: Rare/frequent first  t: Close  Tab: Edit filter  Q: Quit "
+            : group_spec_
+            ? " ↑↓/PgUp/PgDn: Scroll  o: Sort column  g: Change grouping  Tab: Edit filter  Q: Quit "
+            : filter_focused_
+            ? " Typing filter  Enter: Navigate  ↑↓: Move  PgUp/PgDn: Scroll  Esc: Quit "
+            : " ↑↓: Navigate  ←→/0: Scroll columns  PgUp/PgDn: Scroll  /?: Search  n/N: Next/prev  o: Sort  c: Columns  g: Group  t: Templates  S: Save  Tab: Edit filter  H: Toggle highlight  P: Perf  Q: Quit ") |
                     color(Color::GrayDark);
 
         // Main layout
@@ -152,7 +316,8 @@ Component TuiDisplay::buildUI() {
         main_layout.push_back(status_bar | border);
         main_layout.push_back(help);
 
-        return vbox(main_layout);
+        // Timed up to the point the whole document is painted into the screen
+        return frameTimer(vbox(main_layout), frame_times_, frame_started);
     });
 
     // Handle keyboard events
@@ -164,44 +329,57 @@ Component TuiDisplay::buildUI() {
 }
 
 bool TuiDisplay::onEvent(Event event) {
-    int terminal_height = screen_.dimy() - 8;
+    // Any keystroke abandons a search still running in the background
+    if (event != Event::Custom) {
+        cancelSearch();
+    }
 
+    if (search_prompt_active_) {
+        return onSearchPromptEvent(event);
+    }
+
+    if (export_prompt_active_) {
+        return onExportPromptEvent(event);
+    }
+
+    if (group_prompt_active_) {
+        return onGroupPromptEvent(event);
+    }
+
+    if (templates_visible_ && onTemplateTableEvent(event)) {
+        return true;
+    }
+
+    if (group_spec_ && !templates_visible_ && onGroupTableEvent(event)) {
+        return true;
+    }
+
+    // Scroll keys only accumulate here; a burst of queued events is applied
+    // as one step when the next frame is drawn
     if (event == Event::ArrowUp) {
-        if (selected_line_ > 0) {
-            selected_line_--;
-        } else if (scroll_position_ > 0) {
-            scroll_position_--;
-        }
+        pending_line_delta_--;
         return true;
     }
 
     if (event == Event::ArrowDown) {
-        std::lock_guard<std::mutex> lock(visible_lines_mutex_);
-        if (selected_line_ < terminal_height - 1 &&
-            scroll_position_ + selected_line_ + 1 < static_cast<int>(visible_line_indices_.size())) {
-            selected_line_++;
-        } else if (scroll_position_ + terminal_height < static_cast<int>(visible_line_indices_.size())) {
-            scroll_position_++;
-        }
+        pending_line_delta_++;
         return true;
     }
 
     if (event == Event::PageUp) {
-        scroll_position_ = std::max(0, scroll_position_ - terminal_height);
+        pending_page_delta_--;
         return true;
     }
 
     if (event == Event::PageDown) {
-        std::lock_guard<std::mutex> lock(visible_lines_mutex_);
-        scroll_position_ = std::min(
-            static_cast<int>(visible_line_indices_.size()) - terminal_height,
-            scroll_position_ + terminal_height
-        );
-        scroll_position_ = std::max(0, scroll_position_);
+        pending_page_delta_++;
         return true;
     }
 
     if (event == Event::Home) {
+        std::lock_guard<std::mutex> lock(visible_lines_mutex_);
+        pending_line_delta_ = 0;
+        pending_page_delta_ = 0;
         scroll_position_ = 0;
         selected_line_ = 0;
         return true;
@@ -209,8 +387,79 @@ bool TuiDisplay::onEvent(Event event) {
 
     if (event == Event::End) {
         std::lock_guard<std::mutex> lock(visible_lines_mutex_);
+        pending_line_delta_ = 0;
+        pending_page_delta_ = 0;
         scroll_position_ = std::max(0,
-            static_cast<int>(visible_line_indices_.size()) - terminal_height);
+            static_cast<int>(visible_rows_.size()) - pageHeight());
+        return true;
+    }
+
+    if (event == Event::Escape) {
+        stop();
+        return true;
+    }
+
+    // While the filter input has focus, characters belong to the pattern
+    if (filter_focused_) {
+        if (event == Event::Tab) {
+            filter_focused_ = false;
+            return true;
+        }
+        return false;
+    }
+
+    if (event == Event::Tab) {
+        filter_focused_ = true;
+        return true;
+    }
+
+    if (event == Event::Character('/') || event == Event::Character('?')) {
+        openSearchPrompt(event == Event::Character('/'));
+        return true;
+    }
+
+    if (event == Event::ArrowLeft) {
+        horizontal_offset_ -= std::min(horizontal_offset_, HORIZONTAL_STEP);
+        return true;
+    }
+
+    if (event == Event::ArrowRight) {
+        horizontal_offset_ += HORIZONTAL_STEP;
+        return true;
+    }
+
+    if (event == Event::Character('0')) {
+        horizontal_offset_ = 0;
+        return true;
+    }
+
+    // n / N repeat the search like less; without one they walk filter matches
+    if (event == Event::Character('n') || event == Event::Character('N')) {
+        bool same_direction = event == Event::Character('n');
+        if (search_->hasPattern()) {
+            searchAgain(same_direction == search_forward_);
+        } else {
+            jumpToMatch(same_direction);
+        }
+        return true;
+    }
+
+    if (event == Event::Character('s') || event == Event::Character('S')) {
+        if (!export_in_progress_) {
+            export_prompt_active_ = true;
+            export_input_.clear();
+        }
+        return true;
+    }
+
+    if (event == Event::Character('g') || event == Event::Character('G')) {
+        group_prompt_active_ = true;
+        group_input_ = group_text_;
+        return true;
+    }
+
+    if (event == Event::Character('t') || event == Event::Character('T')) {
+        toggleTemplates();
         return true;
     }
 
@@ -221,29 +470,855 @@ bool TuiDisplay::onEvent(Event event) {
         return true;
     }
 
+    if (event == Event::Character('p') || event == Event::Character('P')) {
+        perf_overlay_visible_ = !perf_overlay_visible_;
+        return true;
+    }
+
+    if (event == Event::Character('o') || event == Event::Character('O')) {
+        cycleSortOrder();
+        return true;
+    }
+
+    if (event == Event::Character('c') || event == Event::Character('C')) {
+        column_view_ = !column_view_;
+        horizontal_offset_ = 0;  // Columns now count from the message
+        return true;
+    }
+
     if (event == Event::Character('q') || event == Event::Character('Q')) {
         stop();
         return true;
     }
 
+    // Navigation mode swallows other characters instead of editing the filter
+    return event.is_character();
+}
+
+void TuiDisplay::openSearchPrompt(bool forward) {
+    std::lock_guard<std::mutex> lock(visible_lines_mutex_);
+    applyPendingScroll();
+
+    search_prompt_active_ = true;
+    search_forward_ = forward;
+    search_input_.clear();
+    search_origin_ = selectedLineOffset();
+}
+
+bool TuiDisplay::onSearchPromptEvent(const Event& event) {
+    if (event == Event::Custom) {
+        return false;
+    }
+
+    if (event == Event::Return || event == Event::Escape ||
+        (event == Event::Backspace && search_input_.empty())) {
+        search_prompt_active_ = false;
+        if (event == Event::Return && !search_input_.empty()) {
+            return true;  // Keep the pattern for n / N
+        }
+        search_->clear();
+        std::lock_guard<std::mutex> lock(visible_lines_mutex_);
+        current_search_hit_.reset();
+        status_message_ = "Search cancelled";
+        return true;
+    }
+
+    if (event == Event::Backspace) {
+        // Drop the last UTF-8 character, continuation bytes included
+        size_t length = search_input_.size() - 1;
+        while (length > 0 && (static_cast<unsigned char>(search_input_[length]) & 0xC0) == 0x80) {
+            --length;
+        }
+        search_input_.resize(length);
+    } else if (event.is_character()) {
+        search_input_ += event.character();
+    } else {
+        return true;  // The prompt owns the keyboard until Enter or Esc
+    }
+
+    // Incremental: every edit searches again from where the prompt was opened
+    if (search_input_.empty() || !search_->setPattern(search_input_)) {
+        if (search_input_.empty()) {
+            search_->clear();
+        }
+        std::lock_guard<std::mutex> lock(visible_lines_mutex_);
+        current_search_hit_.reset();
+        status_message_ = search_input_.empty() ? "" : "Invalid regex: " + search_->getError();
+        return true;
+    }
+
+    runSearch(search_origin_, search_forward_);
+    return true;
+}
+
+bool TuiDisplay::onExportPromptEvent(const Event& event) {
+    if (event == Event::Custom) {
+        return false;
+    }
+
+    if (event == Event::Escape || (event == Event::Backspace && export_input_.empty())) {
+        export_prompt_active_ = false;
+        std::lock_guard<std::mutex> lock(visible_lines_mutex_);
+        status_message_ = "Save cancelled";
+        return true;
+    }
+
+    if (event == Event::Return) {
+        export_prompt_active_ = false;
+        if (!export_input_.empty()) {
+            exportVisibleLines(export_input_);
+        }
+        return true;
+    }
+
+    if (event == Event::Backspace) {
+        size_t length = export_input_.size() - 1;
+        while (length > 0 && (static_cast<unsigned char>(export_input_[length]) & 0xC0) == 0x80) {
+            --length;
+        }
+        export_input_.resize(length);
+    } else if (event.is_character()) {
+        export_input_ += event.character();
+    }
+    return true;  // The prompt owns the keyboard until Enter or Esc
+}
+
+void TuiDisplay::exportVisibleLines(const std::string& path) {
+    // A snapshot: the view may change (new filter, streamed lines) meanwhile.
+    // It is as large as the rows, so like a sort it has to fit the limit
+    RowView rows;
+    {
+        std::lock_guard<std::mutex> lock(visible_lines_mutex_);
+        size_t needed = budget_->used(MemoryBudget::Account::Results) + visible_rows_.memoryUsage();
+        if (needed > budget_->headroom(MemoryBudget::Account::Results)) {
+            status_message_ = "Not enough memory under --mem-limit to save " +
+                              std::to_string(visible_rows_.size()) + " lines";
+            return;
+        }
+        rows = visible_rows_;
+    }
+
+    std::string error;
+    int fd = openExportFile(path, *reader_, error);
+    if (fd == -1) {
+        std::lock_guard<std::mutex> lock(visible_lines_mutex_);
+        status_message_ = "Save failed: " + error;
+        return;
+    }
+
+    export_in_progress_ = true;
+    startBackground("export", [this, path, fd, rows = std::move(rows)]() {
+        TRACE_SCOPE_ARG("export", "rows", rows.size());
+        uint64_t bytes = 0;
+        std::string error;
+        bool ok = exportRows(*reader_, rows, fd, bytes, error);
+        if (!closeExportFile(fd) && ok) {
+            ok = false;
+            error = std::string("close failed: ") + std::strerror(errno);
+        }
+
+        std::lock_guard<std::mutex> lock(visible_lines_mutex_);
+        std::stringstream ss;
+        if (ok) {
+            ss << "Saved " << rows.size() << " lines (" << formatBytes(bytes) << ") to " << path;
+        } else {
+            ss << "Save failed: " << error;
+        }
+        status_message_ = ss.str();
+        export_in_progress_ = false;
+        redraw_->request();
+    });
+}
+
+void TuiDisplay::runSearch(size_t from, bool forward) {
+    uint64_t generation = ++search_generation_;
+
+    // Nearby and already-known hits resolve right here
+    auto step = search_->scan(from, forward, SEARCH_SYNC_BUDGET);
+    if (step.hit || step.exhausted) {
+        std::lock_guard<std::mutex> lock(visible_lines_mutex_);
+        showSearchResultLocked(step, forward);
+        return;
+    }
+
+    // Far away: keep scanning in the background until found or cancelled
+    search_in_progress_ = true;
+    startBackground("search", [this, resume = step.resume, forward, generation]() mutable {
+        while (search_generation_ == generation) {
+            BusyMeter::Scope busy(search_busy_);  // Per step, so utilisation is live
+            TRACE_SCOPE("search step");
+            auto next = search_->scan(resume, forward, SEARCH_CHUNK_SIZE);
+            if (next.hit || next.exhausted) {
+                std::lock_guard<std::mutex> lock(visible_lines_mutex_);
+                if (search_generation_ == generation) {
+                    showSearchResultLocked(next, forward);
+                    search_in_progress_ = false;
+                    redraw_->request();
+                }
+                return;
+            }
+            resume = next.resume;
+        }
+    });
+}
+
+void TuiDisplay::searchAgain(bool forward) {
+    size_t from;
+    {
+        std::lock_guard<std::mutex> lock(visible_lines_mutex_);
+        applyPendingScroll();
+
+        // Continue from the current hit while it is on screen, else from the selection
+        size_t first = static_cast<size_t>(scroll_position_);
+        size_t last = first + static_cast<size_t>(pageHeight());
+        size_t hit_row = current_search_hit_ ? visible_rows_.rank(current_search_hit_->line) : 0;
+        if (current_search_hit_ && hit_row >= first && hit_row < last) {
+            size_t hit_start = reader_->getLineOffset(current_search_hit_->line) +
+                               current_search_hit_->span.offset;
+            from = forward ? hit_start + 1 : hit_start;
+        } else {
+            from = selectedLineOffset();
+        }
+    }
+    runSearch(from, forward);
+}
+
+void TuiDisplay::cancelSearch() {
+    if (search_in_progress_) {
+        ++search_generation_;
+        search_in_progress_ = false;
+    }
+}
+
+// Called with visible_lines_mutex_ held
+void TuiDisplay::showSearchResultLocked(const SearchEngine::Step& step, bool forward) {
+    if (!step.hit) {
+        status_message_ = "Pattern not found";
+        if (current_search_hit_) {
+            status_message_ += forward ? " below" : " above";
+        }
+        return;
+    }
+
+    const SearchHit& hit = *step.hit;
+    current_search_hit_ = hit;
+
+    std::stringstream ss;
+    if (visible_rows_.contains(hit.line)) {
+        scrollToLine(hit.line);
+        scrollToColumn(hit.line, hit.span);
+        ss << "Match at line " << (hit.line + 1) << ", column " << (hit.span.offset + 1);
+    } else {
+        ss << "Match at line " << (hit.line + 1) << " is hidden by the filter";
+    }
+    status_message_ = ss.str();
+}
+
+void TuiDisplay::cycleSortOrder() {
+    {
+        std::lock_guard<std::mutex> lock(visible_lines_mutex_);
+        if (sort_field_ == SortField::Line) {
+            sort_field_ = SortField::Timestamp;
+            sort_descending_ = false;
+        } else if (sort_field_ == SortField::Timestamp && !sort_descending_) {
+            sort_descending_ = true;
+        } else if (sort_field_ == SortField::Timestamp) {
+            sort_field_ = SortField::Level;  // Most severe first
+        } else {
+            sort_field_ = SortField::Line;
+            sort_descending_ = false;
+        }
+        if (sort_field_ == SortField::Level) {
+            sort_descending_ = true;
+        }
+    }
+    applySortAsync();
+}
+
+void TuiDisplay::applySortAsync() {
+    uint64_t filter_generation = filter_generation_;
+    uint64_t sort_generation = ++sort_generation_;
+    sort_in_progress_ = true;
+    startBackground("sort", [this, filter_generation, sort_generation]() {
+        sortVisibleRows(filter_generation, sort_generation);
+    });
+}
+
+void TuiDisplay::sortVisibleRows(uint64_t filter_generation, uint64_t sort_generation) {
+    RowView rows;
+    SortField field;
+    bool descending;
+    size_t selected_line = 0;
+    bool has_selection = false;
+    {
+        std::lock_guard<std::mutex> lock(visible_lines_mutex_);
+        if (filter_generation_ != filter_generation || sort_generation_ != sort_generation) {
+            return;
+        }
+        sort_in_progress_ = true;
+        rows = visible_rows_;
+        field = sort_field_;
+        descending = sort_descending_;
+        size_t selected = static_cast<size_t>(scroll_position_ + selected_line_);
+        if (selected < rows.size()) {
+            selected_line = rows.select(selected);
+            has_selection = true;
+        }
+    }
+
+    // For a moment there are keys (16 bytes), field columns (13), the
+    // snapshot and the result (8 each) per row
+    constexpr size_t SORT_BYTES_PER_ROW = 48;
+    size_t needed = budget_->used(MemoryBudget::Account::Results) + rows.size() * SORT_BYTES_PER_ROW;
+    bool fits = needed <= budget_->headroom(MemoryBudget::Account::Results);
+
+    TRACE_SCOPE_ARG("sort rows", "rows", rows.size());
+    auto started = std::chrono::steady_clock::now();
+    RowView sorted = fits ? sortRows(*reader_, rows, field, descending) : RowView();
+    auto elapsed = std::chrono::steady_clock::now() - started;
+
+    std::lock_guard<std::mutex> lock(visible_lines_mutex_);
+    if (sort_generation_ != sort_generation) {
+        return;  // A newer sort owns sort_in_progress_
+    }
+    sort_in_progress_ = false;
+    if (filter_generation_ != filter_generation) {
+        return;
+    }
+    if (!fits) {
+        status_message_ = "Not enough memory under --mem-limit to sort " +
+                          std::to_string(rows.size()) + " lines";
+        redraw_->request();
+        return;
+    }
+
+    visible_rows_ = std::move(sorted);
+    budget_->set(MemoryBudget::Account::Results,
+                 rowMemoryLocked() + match_index_.memoryUsage() + groups_.memoryUsage());
+    scroll_position_ = 0;
+    selected_line_ = 0;
+    if (has_selection) {
+        scrollToLine(selected_line);  // Keep the selected line in view
+    }
+
+    std::stringstream ss;
+    ss << "Sorted " << visible_rows_.size() << " lines by "
+       << (field == SortField::Line ? "line" : field == SortField::Level ? "level" : "time")
+       << " in " << formatDuration(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed));
+    status_message_ = ss.str();
+    redraw_->request();
+}
+
+bool TuiDisplay::onGroupPromptEvent(const Event& event) {
+    if (event == Event::Custom) {
+        return false;
+    }
+
     if (event == Event::Escape) {
-        stop();
+        group_prompt_active_ = false;
+        return true;
+    }
+
+    if (event == Event::Return) {
+        group_prompt_active_ = false;
+        setGrouping(group_input_);
         return true;
     }
 
-    return false;
+    if (event == Event::Backspace) {
+        if (!group_input_.empty()) {
+            size_t length = group_input_.size() - 1;
+            while (length > 0 && (static_cast<unsigned char>(group_input_[length]) & 0xC0) == 0x80) {
+                --length;
+            }
+            group_input_.resize(length);
+        }
+    } else if (event.is_character()) {
+        group_input_ += event.character();
+    }
+    return true;  // The prompt owns the keyboard until Enter or Esc
 }
 
-void TuiDisplay::updateVisibleLines() {
+void TuiDisplay::setGrouping(const std::string& text) {
+    GroupSpec spec;
+    std::string error;
+    bool off = text.find_first_not_of(" \t") == std::string::npos;
+    if (!off && !parseGroupSpec(text, spec, error)) {
+        std::lock_guard<std::mutex> lock(visible_lines_mutex_);
+        status_message_ = error;
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(visible_lines_mutex_);
+        groups_.clear();
+        group_rows_.clear();
+        group_scroll_ = 0;
+        if (off) {
+            // A scan still running keeps its lines but drops its groups
+            group_spec_.reset();
+            group_text_.clear();
+            budget_->set(MemoryBudget::Account::Results,
+                         rowMemoryLocked() + match_index_.memoryUsage());
+            status_message_ = "Grouping off";
+            return;
+        }
+        group_spec_ = spec;
+        group_text_ = text;
+        if (!spec.hasValue() && group_column_ != GroupColumn::Key) {
+            group_column_ = GroupColumn::Count;
+            group_descending_ = true;
+        }
+    }
+
+    // Groups come from the same scan as the filter's lines
+    applyFilterAsync();
+}
+
+bool TuiDisplay::onGroupTableEvent(const Event& event) {
+    int delta = 0;
+    if (event == Event::ArrowUp) {
+        delta = -1;
+    } else if (event == Event::ArrowDown) {
+        delta = 1;
+    } else if (event == Event::PageUp) {
+        delta = -pageHeight();
+    } else if (event == Event::PageDown) {
+        delta = pageHeight();
+    } else if (event == Event::Home) {
+        delta = INT_MIN / 2;
+    } else if (event == Event::End) {
+        delta = INT_MAX / 2;
+    } else if (!filter_focused_ && (event == Event::Character('o') || event == Event::Character('O'))) {
+        cycleGroupColumn();
+        return true;
+    } else {
+        return false;
+    }
+
     std::lock_guard<std::mutex> lock(visible_lines_mutex_);
+    int rows = static_cast<int>(group_rows_.size());
+    int page = pageHeight() - 1;  // Less the header row
+    group_scroll_ = std::clamp(group_scroll_ + delta, 0, std::max(0, rows - page));
+    return true;
+}
+
+void TuiDisplay::cycleGroupColumn() {
+    std::lock_guard<std::mutex> lock(visible_lines_mutex_);
+    bool values = group_spec_ && group_spec_->hasValue();
+
+    // Count, key, then the value columns, largest first
+    switch (group_column_) {
+        case GroupColumn::Count:
+            group_column_ = GroupColumn::Key;
+            break;
+        case GroupColumn::Key:
+            group_column_ = values ? GroupColumn::Sum : GroupColumn::Count;
+            break;
+        case GroupColumn::Sum:
+            group_column_ = GroupColumn::Average;
+            break;
+        case GroupColumn::Average:
+            group_column_ = GroupColumn::Max;
+            break;
+        case GroupColumn::Max:
+        case GroupColumn::Min:
+            group_column_ = GroupColumn::Count;
+            break;
+    }
+    group_descending_ = group_column_ != GroupColumn::Key;
+    group_scroll_ = 0;
+    sortGroupRowsLocked();
+}
 
-    visible_line_indices_.clear();
-    visible_line_indices_.reserve(reader_->getLineCount());
+// Called with visible_lines_mutex_ held
+void TuiDisplay::sortGroupRowsLocked() {
+    group_rows_ = groups_.rows(group_column_, group_descending_);
+    int page = pageHeight() - 1;
+    group_scroll_ = std::clamp(group_scroll_, 0, std::max(0, static_cast<int>(group_rows_.size()) - page));
+}
 
-    for (size_t i = 0; i < reader_->getLineCount(); ++i) {
-        visible_line_indices_.push_back(i);
+// Called from the renderer with visible_lines_mutex_ held
+Element TuiDisplay::groupTableLocked(int height, int width) {
+    bool values = group_spec_->hasValue();
+    struct Column {
+        const char* title;
+        GroupColumn column;
+    };
+    std::vector<Column> columns = {{"Count", GroupColumn::Count}};
+    if (values) {
+        columns.insert(columns.end(), {{"Sum", GroupColumn::Sum}, {"Min", GroupColumn::Min},
+                                       {"Max", GroupColumn::Max}, {"Avg", GroupColumn::Average}});
     }
 
+    int numbers_width = static_cast<int>(columns.size()) * GROUP_NUMBER_WIDTH;
+    size_t key_width = static_cast<size_t>(std::max(8, width - numbers_width - 1));
+    // The sort column is marked with an arrow
+    auto title = [this](const char* name, GroupColumn column, size_t cell_width, bool align_right) {
+        if (column != group_column_) {
+            return tableCell(name, cell_width, align_right);
+        }
+        return tableCell(std::string(name) + (group_descending_ ? " ↓" : " ↑"), cell_width, align_right);
+    };
+
+    std::string header = title("Key", GroupColumn::Key, key_width, false);
+    for (const auto& column : columns) {
+        header += title(column.title, column.column, GROUP_NUMBER_WIDTH, true);
+    }
+
+    Elements rows;
+    rows.push_back(text(header) | bold | color(Color::Cyan));
+    size_t first = static_cast<size_t>(group_scroll_);
+    size_t last = std::min(group_rows_.size(), first + static_cast<size_t>(std::max(0, height - 1)));
+    for (size_t i = first; i < last; ++i) {
+        const auto& row = group_rows_[i];
+        std::string line = tableCell(row.key.empty() ? "(no key)" : row.key, key_width, false);
+        line += tableCell(std::to_string(row.stats.count), GROUP_NUMBER_WIDTH, true);
+        if (values) {
+            bool any = row.stats.values > 0;
+            for (double value : {row.stats.sum, row.stats.min, row.stats.max, row.stats.average()}) {
+                line += tableCell(any ? formatGroupNumber(value) : "-", GROUP_NUMBER_WIDTH, true);
+            }
+        }
+        rows.push_back(row.key.empty() ? text(line) | color(Color::GrayDark) : text(line));
+    }
+    if (group_rows_.empty()) {
+        rows.push_back(text(filter_in_progress_ ? "Grouping..." : "No groups") | color(Color::Red) | center);
+    }
+    return vbox(rows);
+}
+
+void TuiDisplay::toggleTemplates() {
+    RowView rows;
+    uint64_t generation = 0;
+    {
+        std::lock_guard<std::mutex> lock(visible_lines_mutex_);
+        if (template_base_rows_) {
+            // Back from a template's lines to the table
+            visible_rows_ = std::move(*template_base_rows_);
+            template_base_rows_.reset();
+            template_drill_text_.clear();
+            templates_visible_ = true;
+            scroll_position_ = 0;
+            selected_line_ = 0;
+            return;
+        }
+        if (templates_visible_) {
+            templates_visible_ = false;
+            return;
+        }
+        templates_visible_ = true;
+        if (!templates_.empty() || templates_in_progress_) {
+            return;  // Still describe the current rows
+        }
+        rows = visible_rows_;
+        generation = ++template_generation_;
+        templates_in_progress_ = true;
+    }
+
+    startBackground("templates", [this, rows = std::move(rows), generation]() {
+        auto started = std::chrono::steady_clock::now();
+        auto templates = mineTemplates(*reader_, rows, *highlighter_, 0,
+                                       [this, generation]() { return template_generation_ != generation; });
+        auto elapsed = std::chrono::steady_clock::now() - started;
+
+        std::lock_guard<std::mutex> lock(visible_lines_mutex_);
+        if (template_generation_ != generation) {
+            return;  // The rows changed meanwhile; a newer run owns the flag
+        }
+        templates_ = std::move(templates);
+        if (templates_rare_first_) {
+            std::reverse(templates_.begin(), templates_.end());
+        }
+        template_selected_ = 0;
+        template_scroll_ = 0;
+        templates_in_progress_ = false;
+
+        std::stringstream ss;
+        ss << rows.size() << " lines in " << templates_.size() << " templates ("
+           << formatDuration(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed)) << ")";
+        status_message_ = ss.str();
+        redraw_->request();
+    });
+}
+
+bool TuiDisplay::onTemplateTableEvent(const Event& event) {
+    int delta = 0;
+    if (event == Event::ArrowUp) {
+        delta = -1;
+    } else if (event == Event::ArrowDown) {
+        delta = 1;
+    } else if (event == Event::PageUp) {
+        delta = -pageHeight();
+    } else if (event == Event::PageDown) {
+        delta = pageHeight();
+    } else if (event == Event::Home) {
+        delta = INT_MIN / 2;
+    } else if (event == Event::End) {
+        delta = INT_MAX / 2;
+    } else if (!filter_focused_ && event == Event::Return) {
+        drillIntoTemplate();
+        return true;
+    } else if (!filter_focused_ && (event == Event::Character('o') || event == Event::Character('O'))) {
+        std::lock_guard<std::mutex> lock(visible_lines_mutex_);
+        templates_rare_first_ = !templates_rare_first_;
+        std::reverse(templates_.begin(), templates_.end());
+        template_selected_ = 0;
+        template_scroll_ = 0;
+        status_message_ = templates_rare_first_ ? "Rare templates first" : "Frequent templates first";
+        return true;
+    } else {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(visible_lines_mutex_);
+    int rows = static_cast<int>(templates_.size());
+    int page = pageHeight() - 1;  // Less the header row
+    template_selected_ = std::clamp(template_selected_ + delta, 0, std::max(0, rows - 1));
+    if (template_selected_ < template_scroll_) {
+        template_scroll_ = template_selected_;
+    } else if (template_selected_ >= template_scroll_ + page) {
+        template_scroll_ = template_selected_ - page + 1;
+    }
+    return true;
+}
+
+void TuiDisplay::drillIntoTemplate() {
+    RowView rows;
+    LogTemplate selected;
+    uint64_t generation = 0;
+    {
+        std::lock_guard<std::mutex> lock(visible_lines_mutex_);
+        if (templates_in_progress_ || template_selected_ >= static_cast<int>(templates_.size())) {
+            return;
+        }
+        rows = visible_rows_;
+        selected = templates_[static_cast<size_t>(template_selected_)];
+        generation = ++template_generation_;
+        templates_in_progress_ = true;
+    }
+
+    startBackground("templates", [this, rows = std::move(rows), selected = std::move(selected), generation]() {
+        RowView matching = templateRows(*reader_, rows, *highlighter_, selected, 0,
+                                        [this, generation]() { return template_generation_ != generation; });
+
+        std::lock_guard<std::mutex> lock(visible_lines_mutex_);
+        if (template_generation_ != generation) {
+            return;
+        }
+        templates_in_progress_ = false;
+        template_base_rows_ = std::move(visible_rows_);
+        visible_rows_ = std::move(matching);
+        template_drill_text_ = selected.text();
+        templates_visible_ = false;
+        scroll_position_ = 0;
+        selected_line_ = 0;
+        budget_->set(MemoryBudget::Account::Results,
+                     rowMemoryLocked() + match_index_.memoryUsage() + groups_.memoryUsage());
+        status_message_ = std::to_string(visible_rows_.size()) + " lines of the template (t: back to templates)";
+        redraw_->request();
+    });
+}
+
+// Called with visible_lines_mutex_ held
+void TuiDisplay::resetTemplatesLocked() {
+    ++template_generation_;
+    templates_in_progress_ = false;
+    templates_.clear();
+    templates_visible_ = false;
+    template_selected_ = 0;
+    template_scroll_ = 0;
+    if (template_base_rows_) {
+        visible_rows_ = std::move(*template_base_rows_);
+        template_base_rows_.reset();
+        template_drill_text_.clear();
+    }
+}
+
+// Called with visible_lines_mutex_ held
+size_t TuiDisplay::rowMemoryLocked() const {
+    return visible_rows_.memoryUsage() + (template_base_rows_ ? template_base_rows_->memoryUsage() : 0);
+}
+
+// Called from the renderer with visible_lines_mutex_ held
+Element TuiDisplay::templateTableLocked(int height, int width) {
+    size_t text_width = static_cast<size_t>(std::max(8, width - GROUP_NUMBER_WIDTH - 2));
+    std::string header = tableCell(templates_rare_first_ ? "Count ↑" : "Count ↓", GROUP_NUMBER_WIDTH, true) +
+                         "  " + tableCell("Template", text_width, false);
+
+    Elements rows;
+    rows.push_back(text(header) | bold | color(Color::Cyan));
+    size_t first = static_cast<size_t>(template_scroll_);
+    size_t last = std::min(templates_.size(), first + static_cast<size_t>(std::max(0, height - 1)));
+    for (size_t i = first; i < last; ++i) {
+        std::string line = tableCell(std::to_string(templates_[i].count), GROUP_NUMBER_WIDTH, true) +
+                           "  " + tableCell(templates_[i].text(), text_width, false);
+        auto row = text(line);
+        if (static_cast<int>(i) == template_selected_) {
+            row = row | bgcolor(Color::Blue) | bold;
+        }
+        rows.push_back(row);
+    }
+    if (templates_.empty()) {
+        rows.push_back(text(templates_in_progress_ ? "Clustering..." : "No lines") | color(Color::Red) | center);
+    }
+    return vbox(rows);
+}
+
+// Called from the renderer, once per frame
+void TuiDisplay::updateMemoryAccounts() {
+    budget_->set(MemoryBudget::Account::Index, reader_->getIndexMemory());
+    budget_->set(MemoryBudget::Account::Stream, reader_->getStreamMemory());
+
+    // The cache gets whatever the index and results leave
+    if (budget_->limited()) {
+        highlight_cache_->setMemoryLimit(budget_->headroom(MemoryBudget::Account::Highlight));
+    }
+    budget_->set(MemoryBudget::Account::Highlight, highlight_cache_->memoryUsage());
+}
+
+Element TuiDisplay::memoryStatus() const {
+    using Account = MemoryBudget::Account;
+    std::string status = " Mem: idx " + formatBytes(budget_->used(Account::Index));
+    if (reader_->getStreamMemory() > 0) {
+        status += " buf " + formatBytes(budget_->used(Account::Stream));
+    }
+    status += " res " + formatBytes(budget_->used(Account::Results)) +
+              " hl " + formatBytes(budget_->used(Account::Highlight));
+    if (!budget_->limited()) {
+        return text(status + " ");
+    }
+    status += " / " + formatBytes(budget_->limit()) + " ";
+    return budget_->exceeded() ? text(status) | color(Color::Red) : text(status);
+}
+
+// Called from the renderer with visible_lines_mutex_ held
+PerfSnapshot TuiDisplay::perfSnapshotLocked() {
+    PerfSnapshot snapshot;
+    snapshot.frame_last = frame_times_.last();
+    snapshot.frame_p99 = frame_times_.percentile(0.99);
+    snapshot.frame_count = frame_times_.count();
+
+    snapshot.index = reader_->getIndexRate();
+    if (reader_->getBackend() == ReadBackend::Read) {
+        snapshot.load_engine = ioEngineName(reader_->getIoEngine());
+    }
+    snapshot.filter = filter_rate_;
+
+    auto now = std::chrono::steady_clock::now();
+    snapshot.filter_utilisation = filter_utilisation_.sample(filter_busy_.total(), now);
+    snapshot.search_utilisation = search_utilisation_.sample(search_busy_.total(), now);
+    snapshot.highlight_utilisation =
+        highlight_utilisation_.sample(highlight_cache_->workerBusy().total(), now);
+
+    snapshot.index_memory = reader_->getIndexMemory();
+    snapshot.result_memory = rowMemoryLocked() + match_index_.memoryUsage() +
+                             groups_.memoryUsage();
+    snapshot.highlight_memory = budget_->used(MemoryBudget::Account::Highlight);
+    snapshot.process = ProcessStats::sample();
+    return snapshot;
+}
+
+// Called with visible_lines_mutex_ held
+size_t TuiDisplay::selectedLineOffset() const {
+    size_t selected = static_cast<size_t>(scroll_position_ + selected_line_);
+    if (selected >= visible_rows_.size()) {
+        return 0;
+    }
+    return reader_->getLineOffset(visible_rows_.select(selected));
+}
+
+void TuiDisplay::jumpToMatch(bool forward) {
+    std::lock_guard<std::mutex> lock(visible_lines_mutex_);
+    applyPendingScroll();  // Start from where queued scroll keys lead
+
+    if (match_index_.empty()) {
+        status_message_ = "No recorded matches";
+        return;
+    }
+
+    // Continue from the current match, or start from the selected line
+    std::optional<MatchIndex::Position> target;
+    if (current_match_) {
+        target = forward
+            ? match_index_.next(current_match_->line, current_match_->span.offset)
+            : match_index_.previous(current_match_->line, current_match_->span.offset);
+    } else {
+        size_t selected = static_cast<size_t>(scroll_position_ + selected_line_);
+        size_t line = selected < visible_rows_.size() ? visible_rows_.select(selected) : 0;
+        target = forward ? match_index_.firstFrom(line) : match_index_.lastUpTo(line);
+    }
+
+    if (!target) {
+        status_message_ = forward ? "No more matches below" : "No more matches above";
+        return;
+    }
+
+    current_match_ = target;
+    scrollToLine(target->line);
+    scrollToColumn(target->line, target->span);
+
+    std::stringstream ss;
+    ss << "Match at line " << (target->line + 1) << ", column " << (target->span.offset + 1);
+    status_message_ = ss.str();
+}
+
+int TuiDisplay::pageHeight() const {
+    return std::max(1, screen_.dimy() - 8);  // Reserve space for header/footer
+}
+
+// Called with visible_lines_mutex_ held
+void TuiDisplay::applyPendingScroll() {
+    int total = static_cast<int>(visible_rows_.size());
+    int page = pageHeight();
+
+    if (pending_page_delta_ != 0) {
+        scroll_position_ = std::clamp(scroll_position_ + pending_page_delta_ * page,
+                                      0, std::max(0, total - page));
+        pending_page_delta_ = 0;
+    }
+
+    if (pending_line_delta_ != 0) {
+        // Move the selection; scroll only once it leaves the page
+        int selected = std::clamp(scroll_position_ + selected_line_ + pending_line_delta_,
+                                  0, std::max(0, total - 1));
+        if (selected < scroll_position_) {
+            scroll_position_ = selected;
+        } else if (selected >= scroll_position_ + page) {
+            scroll_position_ = selected - page + 1;
+        }
+        selected_line_ = selected - scroll_position_;
+        pending_line_delta_ = 0;
+    }
+}
+
+// Called with visible_lines_mutex_ held
+void TuiDisplay::scrollToLine(size_t line_idx) {
+    size_t rank = visible_rows_.rank(line_idx);
+    if (rank >= visible_rows_.size()) {
+        return;
+    }
+
+    int row = static_cast<int>(rank);
+    int terminal_height = pageHeight();
+
+    if (row < scroll_position_ || row >= scroll_position_ + terminal_height) {
+        // Put the target a third of the way down the page for context
+        scroll_position_ = std::max(0, row - terminal_height / 3);
+    }
+    selected_line_ = row - scroll_position_;
+}
+
+void TuiDisplay::updateVisibleLines() {
+    std::lock_guard<std::mutex> lock(visible_lines_mutex_);
+
+    // Unfiltered: an identity range, no per-line storage
+    visible_rows_ = RowView::identity(reader_->getLineCount());
+
+    match_index_ = MatchIndex();  // Releases the spans, unlike clear()
+    current_match_.reset();
+    budget_->set(MemoryBudget::Account::Results, 0);
+
     // Reset scroll position
     scroll_position_ = 0;
     selected_line_ = 0;
@@ -257,77 +1332,405 @@ void TuiDisplay::applyFilterAsync() {
     // Increment generation to cancel any ongoing filtering
     uint64_t current_generation = ++filter_generation_;
 
+    // Templates describe the rows being replaced
+    {
+        std::lock_guard<std::mutex> lock(visible_lines_mutex_);
+        resetTemplatesLocked();
+    }
+
+    // Grouping without a filter still scans, for the groups only
+    std::optional<GroupSpec> group = group_spec_;
+
     // If pattern is empty, reset to show all lines
-    if (pattern.empty()) {
+    if (pattern.empty() && !group) {
         filter_in_progress_ = false;
         updateVisibleLines();
+        if (sort_field_ != SortField::Line) {
+            applySortAsync();
+        }
         return;
     }
 
     filter_in_progress_ = true;
 
-    // Launch async filter
-    std::thread([this, pattern, current_generation]() {
+    // Launch async filter; following a stream keeps it alive until the
+    // destructor bumps the generation and joins it
+    startBackground("filter", [this, pattern, group, current_generation]() {
+        auto started = std::chrono::steady_clock::now();
+
         // Set pattern
         if (!filter_->setPattern(pattern)) {
             // Only update if this filter is still current
             if (filter_generation_ == current_generation) {
+                std::lock_guard<std::mutex> lock(visible_lines_mutex_);
                 status_message_ = "Invalid regex: " + filter_->getError();
                 filter_in_progress_ = false;
+                redraw_->request();
+            }
+            return;
+        }
+        if (group && group->maxCapture() > filter_->captureCount()) {
+            if (filter_generation_ == current_generation) {
+                std::lock_guard<std::mutex> lock(visible_lines_mutex_);
+                status_message_ = "Group by $" + std::to_string(group->maxCapture()) +
+                                  ": the filter has " + std::to_string(filter_->captureCount()) +
+                                  " capture groups";
+                groups_.clear();
+                group_rows_.clear();
+                filter_in_progress_ = false;
+                redraw_->request();
             }
             return;
         }
 
+        // Without a pattern every line matches; only the groups are kept
+        bool collect = !pattern.empty();
+        GroupTable groups;
+
         // Process lines in chunks to allow cancellation
-        const size_t CHUNK_SIZE = 10000;
+        const size_t chunk_size = filterChunkSize();
         size_t total_lines = reader_->getLineCount();
         std::vector<size_t> matching_indices;
         matching_indices.reserve(total_lines / 10);  // Estimate
 
-        for (size_t chunk_start = 0; chunk_start < total_lines; chunk_start += CHUNK_SIZE) {
+        // Record match spans while the matcher already has them
+        MatchIndex match_index;
+
+        // Over the memory limit the spans go first, then the scan stops
+        // with what it found so far
+        bool record_spans = true;
+        size_t scanned = total_lines;
+
+        for (size_t chunk_start = 0; chunk_start < total_lines; chunk_start += chunk_size) {
             // Check if this filter was cancelled
             if (filter_generation_ != current_generation) {
                 return;  // This filter is obsolete, exit silently
             }
 
-            size_t chunk_end = std::min(chunk_start + CHUNK_SIZE, total_lines);
+            size_t chunk_end = std::min(chunk_start + chunk_size, total_lines);
+            BusyMeter::Scope busy(filter_busy_);  // Per chunk, so utilisation is live
+            TRACE_SCOPE_ARG("filter chunk", "lines", chunk_end - chunk_start);
 
-            // Process chunk
-            for (size_t i = chunk_start; i < chunk_end; ++i) {
-                auto line = reader_->getLine(i);
-                if (filter_->matches(line)) {
-                    matching_indices.push_back(i);
+            // Process chunk: split across the cores, each with its own groups
+            auto found = filter_->scanLines(*reader_, chunk_start, chunk_end,
+                                            group ? &*group : nullptr);
+            if (collect) {
+                matching_indices.insert(matching_indices.end(), found.lines.begin(), found.lines.end());
+                if (record_spans) {
+                    for (size_t match = 0; match < found.lines.size(); ++match) {
+                        match_index.add(found.lines[match], found.spansOf(match));
+                    }
                 }
             }
+            groups.merge(found.groups);
+
+            // Touched bytes, not the speculative reserve above
+            size_t result_bytes = matching_indices.size() * sizeof(size_t) + match_index.memoryUsage() +
+                                  groups.memoryUsage();
+            budget_->set(MemoryBudget::Account::Results, result_bytes);
+            if (result_bytes <= budget_->headroom(MemoryBudget::Account::Results)) {
+                continue;
+            }
+            if (record_spans) {
+                record_spans = false;
+                match_index = MatchIndex();
+                result_bytes = matching_indices.size() * sizeof(size_t) + groups.memoryUsage();
+                budget_->set(MemoryBudget::Account::Results, result_bytes);
+            }
+            if (result_bytes > budget_->headroom(MemoryBudget::Account::Results)) {
+                scanned = chunk_end;
+                break;
+            }
         }
 
         // Update visible lines only if this filter is still current
         if (filter_generation_ == current_generation) {
             std::lock_guard<std::mutex> lock(visible_lines_mutex_);
-            visible_line_indices_ = std::move(matching_indices);
+            visible_rows_ = collect ? RowView::fromLines(std::move(matching_indices))
+                                    : RowView::identity(total_lines);
+            match_index_ = std::move(match_index);
+            if (group && group_spec_) {
+                groups_ = std::move(groups);
+                sortGroupRowsLocked();
+            }
+            budget_->set(MemoryBudget::Account::Results,
+                         rowMemoryLocked() + match_index_.memoryUsage() + groups_.memoryUsage());
+            if (scanned == total_lines) {
+                filter_rate_ = {reader_->getFileSize(), total_lines,
+                                std::chrono::steady_clock::now() - started};
+            }
+            current_match_.reset();
             scroll_position_ = 0;
             selected_line_ = 0;
 
             std::stringstream ss;
-            ss << "Found " << visible_line_indices_.size() << " matching lines";
+            if (group) {
+                ss << "Grouped " << groups_.totalCount() << " lines into " << groups_.size() << " groups";
+            } else {
+                ss << "Found " << visible_rows_.size() << " matching lines";
+            }
+            if (scanned < total_lines) {
+                ss << " in the first " << scanned << " of " << total_lines
+                   << " (stopped at the memory limit)";
+            } else if (!record_spans) {
+                ss << " (match positions dropped at the memory limit)";
+            }
             status_message_ = ss.str();
 
             filter_in_progress_ = false;
+            redraw_->request();
         }
-    }).detach();
+
+        // Shown in file order first; a sort order is applied on top
+        bool sorted;
+        {
+            std::lock_guard<std::mutex> lock(visible_lines_mutex_);
+            sorted = sort_field_ != SortField::Line;
+        }
+        if (sorted) {
+            sortVisibleRows(current_generation, sort_generation_);
+        }
+
+        if (scanned == total_lines) {
+            followFilter(total_lines, current_generation, record_spans, group, collect);
+        }
+    });
 }
 
-Element TuiDisplay::renderLine(size_t visible_index) {
-    if (visible_index >= visible_line_indices_.size()) {
-        return text("");
+void TuiDisplay::followFilter(size_t scanned, uint64_t generation, bool record_spans,
+                              const std::optional<GroupSpec>& group, bool collect) {
+    const size_t chunk_size = filterChunkSize();
+
+    while (filter_generation_ == generation) {
+        // Check for the end first so the last lines are never missed
+        bool growing = reader_->isGrowing();
+        size_t available = reader_->getLineCount();
+        if (scanned == available) {
+            if (!growing) {
+                return;
+            }
+            reader_->waitForLines(scanned, std::chrono::milliseconds(200));
+            continue;
+        }
+
+        // A large backlog is scanned a chunk at a time, checking in between
+        size_t chunk_end = std::min(available, scanned + chunk_size);
+        FilterEngine::ScanResult found;
+        {
+            BusyMeter::Scope busy(filter_busy_);
+            TRACE_SCOPE_ARG("filter chunk", "lines", chunk_end - scanned);
+            found = filter_->scanLines(*reader_, scanned, chunk_end, group ? &*group : nullptr);
+        }
+        scanned = chunk_end;
+        if (!collect) {
+            found.lines.clear();
+        }
+
+        if (found.lines.empty() && found.groups.empty()) {
+            continue;
+        }
+
+        std::lock_guard<std::mutex> lock(visible_lines_mutex_);
+        if (filter_generation_ != generation) {
+            return;
+        }
+        if (record_spans) {
+            for (size_t match = 0; match < found.lines.size(); ++match) {
+                match_index_.add(found.lines[match], found.spansOf(match));
+            }
+        }
+        // While a template's lines are shown, new matches go to the rows behind them
+        (template_base_rows_ ? *template_base_rows_ : visible_rows_).append(found.lines);
+        if (group && group_spec_) {
+            groups_.merge(found.groups);
+            sortGroupRowsLocked();
+        }
+
+        // Same policy as the first pass: drop the spans, then stop following
+        size_t result_bytes = rowMemoryLocked() + match_index_.memoryUsage() + groups_.memoryUsage();
+        if (record_spans && result_bytes > budget_->headroom(MemoryBudget::Account::Results)) {
+            record_spans = false;
+            match_index_ = MatchIndex();
+            current_match_.reset();
+            result_bytes = rowMemoryLocked() + groups_.memoryUsage();
+        }
+        budget_->set(MemoryBudget::Account::Results, result_bytes);
+
+        std::stringstream ss;
+        if (group) {
+            ss << "Grouped " << groups_.totalCount() << " lines into " << groups_.size() << " groups";
+        } else {
+            ss << "Found " << visible_rows_.size() << " matching lines";
+        }
+        bool stop = result_bytes > budget_->headroom(MemoryBudget::Account::Results);
+        if (stop) {
+            ss << " (stopped following the input at the memory limit)";
+        }
+        status_message_ = ss.str();
+        redraw_->request();
+        if (stop) {
+            return;
+        }
     }
+}
 
-    size_t line_idx = visible_line_indices_[visible_index];
-    auto line_view = reader_->getLine(line_idx);
+// Called from the renderer with visible_lines_mutex_ held
+void TuiDisplay::prefetchNeighbourPages(size_t start, size_t end, size_t page_size) {
+    size_t total = visible_rows_.size();
+    std::vector<size_t> lines;
+    lines.reserve(page_size * 2);
 
-    if (highlight_enabled_) {
-        return highlighter_->highlight(line_view);
+    auto add_below = [&]() {
+        for (size_t i = end; i < std::min(end + page_size, total); ++i) {
+            lines.push_back(visible_rows_.select(i));
+        }
+    };
+    auto add_above = [&]() {
+        // Nearest to the viewport first
+        for (size_t i = start; i > start - std::min(start, page_size); --i) {
+            lines.push_back(visible_rows_.select(i - 1));
+        }
+    };
+
+    if (scroll_position_ < last_scroll_position_) {
+        add_above();
+        add_below();
     } else {
-        return text(std::string(line_view));
+        add_below();
+        add_above();
+    }
+    last_scroll_position_ = scroll_position_;
+
+    highlight_cache_->prefetch(std::move(lines));
+}
+
+// Called from the renderer with visible_lines_mutex_ held
+void TuiDisplay::sniffFormatLocked() {
+    if (format_sniffed_) {
+        return;
+    }
+    bool growing = reader_->isGrowing();
+    if (growing && reader_->getLineCount() < FORMAT_SAMPLE_LINES) {
+        return;
+    }
+    format_sniffed_ = true;
+
+    LogFormat format = detectFormat(*reader_);
+    if (format != highlighter_->getFormat()) {
+        highlighter_->setFormat(format);
+        highlight_cache_->invalidate();
+    }
+}
+
+// Called from the renderer with visible_lines_mutex_ held
+LogView::Frame TuiDisplay::buildLogFrame(size_t start, size_t end, size_t width) {
+    LogView::Frame frame;
+    frame.column = horizontal_offset_;
+    frame.rows.reserve(end - start);
+    frame.source_tags = reader_->getSourceTags();
+
+    for (size_t i = start; i < end; ++i) {
+        size_t line_idx = visible_rows_.select(i);
+        auto line = reader_->getLine(line_idx);
+
+        LogView::Row row;
+        if (reader_->isMerged()) {
+            // The line's own file and line number, not its merged position
+            LineSource from = reader_->getLineSource(line_idx);
+            row.line_number = from.line + 1;
+            row.source = static_cast<int>(from.source);
+        } else {
+            row.line_number = line_idx + 1;
+        }
+        row.text = line;
+        row.selected = i == static_cast<size_t>(selected_line_ + scroll_position_);
+
+        // Fields are parsed for the rows on screen only
+        size_t content_start = 0;
+        if (column_view_) {
+            row.fields = parseLineFields(line);
+            content_start = row.fields->message;
+        }
+
+        // Bytes under the visible columns, through the cached layout
+        auto layout = highlight_cache_->layout(line_idx);
+        row.layout = layout.get();
+        size_t first_column = layout->columnAtByte(line, content_start) + horizontal_offset_;
+        size_t first_byte = layout->glyphAtColumn(line, first_column).byte;
+        size_t last_byte = layout->glyphAtColumn(line, first_column + width).byte;
+        frame.cached_layouts.push_back(std::move(layout));
+
+        // Filter matches are overlaid from a copy of the recorded spans
+        auto recorded = match_index_.spansFor(line_idx);
+        if (!recorded.empty()) {
+            auto& spans = frame.match_spans.emplace_back(recorded.begin(), recorded.end());
+            row.matches = spans;
+        }
+        if (current_match_ && current_match_->line == line_idx) {
+            row.current_match = static_cast<int>(current_match_->span_index);
+        }
+
+        // Search hits are found per visible row; on long lines only around the window
+        if (search_->hasPattern()) {
+            auto& spans = frame.search_spans.emplace_back();
+            size_t begin = 0;
+            std::string_view haystack = line;
+            if (HighlightCache::isLongLine(line)) {
+                begin = std::min(first_byte, line.size());
+                haystack = line.substr(begin, last_byte - begin + SEARCH_WINDOW_SLACK);
+            }
+            search_->findInLine(haystack, spans);
+            for (size_t s = 0; s < spans.size(); ++s) {
+                spans[s].offset += static_cast<uint32_t>(begin);
+                if (current_search_hit_ && current_search_hit_->line == line_idx &&
+                    spans[s].offset == current_search_hit_->span.offset) {
+                    row.current_search = static_cast<int>(s);
+                }
+            }
+            row.search_matches = spans;
+        }
+
+        if (highlight_enabled_) {
+            if (HighlightCache::isLongLine(line)) {
+                // Tokenize just the window, resuming from the nearest checkpoint
+                size_t begin = std::min(first_byte, line.size());
+                auto checkpoints = highlight_cache_->checkpoints(line_idx);
+                auto& window = frame.window_tokens.emplace_back();
+                highlighter_->tokenizeWindow(line, *checkpoints, begin, std::max(begin, last_byte), window);
+                row.tokens = window;
+            } else {
+                // Token spans come from the cache, not a re-tokenize
+                auto tokens = highlight_cache_->get(line_idx);
+                row.tokens = *tokens;
+                frame.cached_tokens.push_back(std::move(tokens));
+            }
+        }
+
+        frame.rows.push_back(row);
+    }
+
+    return frame;
+}
+
+int TuiDisplay::gutterWidth() const {
+    return LogView::GUTTER_WIDTH + LogView::sourceWidth(reader_->getSourceTags());
+}
+
+// Called with visible_lines_mutex_ held
+void TuiDisplay::scrollToColumn(size_t line_idx, const MatchSpan& span) {
+    int fields_width = column_view_ ? LogView::FIELDS_WIDTH : 0;
+    size_t width = static_cast<size_t>(std::max(1, screen_.dimx() - gutterWidth() - fields_width));
+
+    // In screen columns; the column view scrolls the message, not the whole line
+    std::string_view line = reader_->getLine(line_idx);
+    auto layout = highlight_cache_->layout(line_idx);
+    size_t origin = layout->columnAtByte(line, column_view_ ? parseLineFields(line).message : 0);
+    size_t begin = layout->columnAtByte(line, span.offset);
+    size_t offset = begin > origin ? begin - origin : 0;
+    size_t span_end = offset + layout->columnAtByte(line, span.offset + span.length) - begin;
+
+    if (offset < horizontal_offset_ || span_end > horizontal_offset_ + width) {
+        // Keep some context to the left of the match
+        horizontal_offset_ = offset > width / 3 ? offset - width / 3 : 0;
     }
 }
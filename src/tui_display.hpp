@@ -4,19 +4,46 @@
 #include <vector>
 #include <memory>
 #include <atomic>
+#include <functional>
 #include <thread>
 #include <mutex>
+#include <optional>
 #include "ftxui/component/component.hpp"
 #include "ftxui/component/screen_interactive.hpp"
 #include "log_reader.hpp"
 #include "filter_engine.hpp"
 #include "syntax_highlighter.hpp"
+#include "highlight_cache.hpp"
+#include "log_view.hpp"
+#include "redraw_scheduler.hpp"
+#include "row_view.hpp"
+#include "search_engine.hpp"
+#include "perf_overlay.hpp"
+#include "range_export.hpp"
+#include "memory_budget.hpp"
+#include "log_fields.hpp"
+#include "group_by.hpp"
+#include "log_templates.hpp"
+#include "utf8_text.hpp"
 
 class TuiDisplay {
 public:
+    static constexpr size_t HORIZONTAL_STEP = 8;  // Columns per ←/→ press
+
+    // Bytes a search may scan on the UI thread before moving to the background,
+    // and per background step between cancellation checks
+    static constexpr size_t SEARCH_SYNC_BUDGET = 4 * 1024 * 1024;
+    static constexpr size_t SEARCH_CHUNK_SIZE = 32 * 1024 * 1024;
+    static constexpr size_t SEARCH_WINDOW_SLACK = 256;  // Bytes past the window searched on long lines
+
+    // How often the performance overlay refreshes while nothing else redraws
+    static constexpr std::chrono::milliseconds PERF_REFRESH{500};
+
+    // Without a budget memory is accounted for but not limited
     TuiDisplay(std::shared_ptr<LogReader> reader,
                std::shared_ptr<FilterEngine> filter,
-               std::shared_ptr<SyntaxHighlighter> highlighter);
+               std::shared_ptr<SyntaxHighlighter> highlighter,
+               std::shared_ptr<MemoryBudget> budget = nullptr);
     ~TuiDisplay();
 
     // Run the TUI
@@ -26,43 +53,250 @@ public:
     void stop();
 
 private:
+    // Tests drive the filter and build frames without a terminal
+    friend class TuiDisplayTest;
+
     // Build UI components
     ftxui::Component buildUI();
 
     // Update visible lines based on current filter
     void updateVisibleLines();
 
-    // Render a single line
-    ftxui::Element renderLine(size_t visible_index);
+    // Pick the tokenizer from a sample of the lines once there are enough of
+    // them (a stream or a file still being read starts out empty); cached
+    // tokens of another format are dropped
+    void sniffFormatLocked();
+
+    // Collect rows [start, end) of the visible lines for the LogView node
+    LogView::Frame buildLogFrame(size_t start, size_t end, size_t width);
 
     // Apply filter asynchronously
     void applyFilterAsync();
 
+    // Keep filtering lines a stream delivers after the first pass, until
+    // the input ends, a newer filter starts or results hit the memory
+    // limit (filter thread). `collect`: keep the matching lines, not only
+    // their groups
+    void followFilter(size_t scanned, uint64_t generation, bool record_spans,
+                      const std::optional<GroupSpec>& group, bool collect);
+
+    // Move to the next/previous recorded filter match (n / N)
+    void jumpToMatch(bool forward);
+
+    // Step to the next sort order (o): file, time ascending, time
+    // descending, level; sorting runs in the background
+    void cycleSortOrder();
+    void applySortAsync();
+
+    // Order the visible rows by the sort field and show them, unless a newer
+    // filter or sort started meanwhile (any background thread)
+    void sortVisibleRows(uint64_t filter_generation, uint64_t sort_generation);
+
+    // Turn grouping on with a spec typed at the G prompt, or off when empty;
+    // the groups are filled by the next filter scan
+    void setGrouping(const std::string& text);
+
+    // Keys typed into the G prompt
+    bool onGroupPromptEvent(const ftxui::Event& event);
+
+    // Scrolling and column sorting while the group table is shown
+    bool onGroupTableEvent(const ftxui::Event& event);
+
+    // Step to the next sort column of the group table (o)
+    void cycleGroupColumn();
+
+    // Rebuild group_rows_ from groups_ (visible_lines_mutex_ held)
+    void sortGroupRowsLocked();
+
+    // The group table in place of the log lines
+    ftxui::Element groupTableLocked(int height, int width);
+
+    // Show the message templates of the visible rows (t), mined in the
+    // background; from the lines of a template, go back to the table
+    void toggleTemplates();
+
+    // Selection, ordering and drill-down while the template table is shown
+    bool onTemplateTableEvent(const ftxui::Event& event);
+
+    // Show only the rows of the selected template (Enter)
+    void drillIntoTemplate();
+
+    // Forget the templates and any drill-down (a new filter replaced the rows)
+    void resetTemplatesLocked();
+
+    // Bytes of the shown rows plus, during a drill-down, the rows behind them
+    size_t rowMemoryLocked() const;
+
+    // The template table in place of the log lines
+    ftxui::Element templateTableLocked(int height, int width);
+
+    // Open the / (forward) or ? (backward) search prompt
+    void openSearchPrompt(bool forward);
+
+    // Keys typed into the search prompt; every edit searches again
+    bool onSearchPromptEvent(const ftxui::Event& event);
+
+    // Search from a byte position; far hits are looked for in the background
+    void runSearch(size_t from, bool forward);
+
+    // Repeat the search from the current hit (n / N)
+    void searchAgain(bool forward);
+
+    // Abandon a background search (any new keystroke)
+    void cancelSearch();
+
+    // Show the outcome of a finished search step
+    void showSearchResultLocked(const SearchEngine::Step& step, bool forward);
+
+    // Keys typed into the S (save) prompt
+    bool onExportPromptEvent(const ftxui::Event& event);
+
+    // Write the visible lines to a file in the background
+    void exportVisibleLines(const std::string& path);
+
+    // Byte offset of the selected line
+    size_t selectedLineOffset() const;
+
+    // Publish index, stream and cache sizes; shrink the cache to its headroom
+    void updateMemoryAccounts();
+
+    // Per-account memory for the status bar
+    ftxui::Element memoryStatus() const;
+
+    // Numbers for the performance overlay
+    PerfSnapshot perfSnapshotLocked();
+
+    // Rows of the log area
+    int pageHeight() const;
+
+    // Apply the scroll keys queued since the last frame in one step
+    void applyPendingScroll();
+
+    // Scroll so that the given file line is visible and selected
+    void scrollToLine(size_t line_idx);
+
+    // Columns before a line's content: line numbers and any source tags
+    int gutterWidth() const;
+
+    // Scroll horizontally so that a match on a long line is on screen
+    void scrollToColumn(size_t line_idx, const MatchSpan& span);
+
+    // Queue pre-tokenization of the page(s) next to the viewport
+    void prefetchNeighbourPages(size_t start, size_t end, size_t page_size);
+
     // Handle key events
     bool onEvent(ftxui::Event event);
 
+    // Run `work` on a thread the display owns: it is joined in the
+    // destructor, so no background job outlives the members it uses.
+    // Threads that finished are joined on the next start.
+    void startBackground(const char* name, std::function<void()> work);
+    void joinBackground();
+
     std::shared_ptr<LogReader> reader_;
     std::shared_ptr<FilterEngine> filter_;
     std::shared_ptr<SyntaxHighlighter> highlighter_;
+    std::unique_ptr<HighlightCache> highlight_cache_;
+    std::shared_ptr<MemoryBudget> budget_;
 
     // UI state
     std::string filter_input_;
     std::string status_message_;
     int scroll_position_;
+    int last_scroll_position_;  // Scroll direction for prefetching
     int selected_line_;
+    size_t horizontal_offset_;  // First visible column of line content
     bool highlight_enabled_;
     bool case_sensitive_;
+    bool filter_focused_;  // Keys go to the filter input; Enter switches to navigation
+    bool column_view_;     // Timestamp and level in columns, then the message
+    bool format_sniffed_;  // The tokenizer was picked from a full sample
 
     // Visible lines after filtering
-    std::vector<size_t> visible_line_indices_;
+    RowView visible_rows_;
+    MatchIndex match_index_;  // Where the filter matched, recorded during the scan
+    std::optional<MatchIndex::Position> current_match_;
     std::mutex visible_lines_mutex_;
     std::atomic<bool> filter_in_progress_;
     std::atomic<bool> should_exit_;
     std::atomic<uint64_t> filter_generation_;  // Track filter version to cancel old filters
 
+    // Row order; a sorted view holds its lines in that order. Guarded by
+    // visible_lines_mutex_
+    SortField sort_field_;
+    bool sort_descending_;
+    std::atomic<uint64_t> sort_generation_;
+    std::atomic<bool> sort_in_progress_;
+
+    // Group-by table (G): the filter scan aggregates the matching lines by
+    // group_spec_. Guarded by visible_lines_mutex_; the spec only changes on
+    // the UI thread
+    std::optional<GroupSpec> group_spec_;
+    std::string group_text_;   // The spec as typed
+    std::string group_input_;
+    bool group_prompt_active_;
+    GroupTable groups_;
+    std::vector<GroupTable::Row> group_rows_;  // groups_ in table order
+    GroupColumn group_column_;
+    bool group_descending_;
+    int group_scroll_;
+
+    // Templates view (t). Guarded by visible_lines_mutex_
+    bool templates_visible_;
+    std::vector<LogTemplate> templates_;  // Most frequent first, or reversed
+    bool templates_rare_first_;
+    int template_selected_;  // Row of the table
+    int template_scroll_;
+    std::optional<RowView> template_base_rows_;  // Rows before drilling into a template
+    std::string template_drill_text_;            // The template being shown
+    std::atomic<uint64_t> template_generation_;  // Cancels mining and drill-downs
+    std::atomic<bool> templates_in_progress_;
+
+    // less-style search, independent of the filter
+    std::unique_ptr<SearchEngine> search_;
+    std::string search_input_;
+    bool search_prompt_active_;
+    bool search_forward_;
+    size_t search_origin_;  // Where the prompt was opened; incremental search restarts here
+    std::optional<SearchHit> current_search_hit_;
+    std::atomic<uint64_t> search_generation_;  // Cancels background searches
+    std::atomic<bool> search_in_progress_;
+
+    // Saving the visible lines (S)
+    std::string export_input_;
+    bool export_prompt_active_;
+    std::atomic<bool> export_in_progress_;
+
+    // Performance overlay. Counters are recorded all the time (a clock read
+    // per frame or scan); sampling and formatting happen only while shown
+    bool perf_overlay_visible_;
+    FrameTimes frame_times_;  // UI thread only
+    ScanRate filter_rate_;    // Last completed filter scan
+    BusyMeter filter_busy_;
+    BusyMeter search_busy_;
+    UtilisationSampler filter_utilisation_;
+    UtilisationSampler search_utilisation_;
+    UtilisationSampler highlight_utilisation_;
+
+    // Scroll keys received since the last frame (UI thread only)
+    int pending_line_delta_;
+    int pending_page_delta_;
+
+    // Jobs started by startBackground()
+    struct BackgroundThread {
+        std::thread thread;
+        std::shared_ptr<std::atomic<bool>> done;
+    };
+    std::mutex background_mutex_;
+    std::vector<BackgroundThread> background_threads_;
+
     // Screen
     ftxui::ScreenInteractive screen_;
 
+    // Background threads ask for frames through this; declared after
+    // screen_ so it stops before the screen goes away
+    std::unique_ptr<RedrawScheduler> redraw_;
+
     // UI Components
     ftxui::Component main_container_;
     ftxui::Component filter_input_component_;
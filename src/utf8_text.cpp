@@ -0,0 +1,301 @@
+#include "utf8_text.hpp"
+#include "char_classifier.hpp"
+#include <algorithm>
+#include <cstring>
+
+#if defined(__AVX2__)
+    #include <immintrin.h>
+    #define UTF8_TEXT_AVX2 1
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #include <emmintrin.h>
+    #define UTF8_TEXT_SSE2 1
+#endif
+
+namespace {
+
+struct Range {
+    char32_t first;
+    char32_t last;
+};
+
+// Combining marks, zero-width spaces and joiners, variation selectors,
+// emoji modifiers, tags; sorted
+constexpr Range ZERO_WIDTH[] = {
+    {0x0300, 0x036F}, {0x0483, 0x0489}, {0x0591, 0x05BD}, {0x05BF, 0x05BF},
+    {0x05C1, 0x05C2}, {0x05C4, 0x05C5}, {0x05C7, 0x05C7}, {0x0610, 0x061A},
+    {0x064B, 0x065F}, {0x0670, 0x0670}, {0x06D6, 0x06DC}, {0x06DF, 0x06E4},
+    {0x06E7, 0x06E8}, {0x06EA, 0x06ED}, {0x0711, 0x0711}, {0x0730, 0x074A},
+    {0x0900, 0x0902}, {0x093C, 0x093C}, {0x0941, 0x0948}, {0x094D, 0x094D},
+    {0x0E31, 0x0E31}, {0x0E34, 0x0E3A}, {0x0E47, 0x0E4E}, {0x1160, 0x11FF},
+    {0x1AB0, 0x1AFF}, {0x1DC0, 0x1DFF}, {0x200B, 0x200F}, {0x202A, 0x202E},
+    {0x2060, 0x2064}, {0x20D0, 0x20FF}, {0xFE00, 0xFE0F}, {0xFE20, 0xFE2F},
+    {0xFEFF, 0xFEFF}, {0x1F3FB, 0x1F3FF}, {0xE0001, 0xE0001}, {0xE0020, 0xE007F},
+    {0xE0100, 0xE01EF},
+};
+
+// East Asian Wide and Fullwidth, and emoji presented as such; sorted
+constexpr Range WIDE[] = {
+    {0x1100, 0x115F}, {0x231A, 0x231B}, {0x2329, 0x232A}, {0x23E9, 0x23EC},
+    {0x23F0, 0x23F0}, {0x23F3, 0x23F3}, {0x25FD, 0x25FE}, {0x2614, 0x2615},
+    {0x2648, 0x2653}, {0x267F, 0x267F}, {0x2693, 0x2693}, {0x26A1, 0x26A1},
+    {0x26AA, 0x26AB}, {0x26BD, 0x26BE}, {0x26C4, 0x26C5}, {0x26CE, 0x26CE},
+    {0x26D4, 0x26D4}, {0x26EA, 0x26EA}, {0x26F2, 0x26F3}, {0x26F5, 0x26F5},
+    {0x26FA, 0x26FA}, {0x26FD, 0x26FD}, {0x2705, 0x2705}, {0x270A, 0x270B},
+    {0x2728, 0x2728}, {0x274C, 0x274C}, {0x274E, 0x274E}, {0x2753, 0x2755},
+    {0x2757, 0x2757}, {0x2795, 0x2797}, {0x27B0, 0x27B0}, {0x27BF, 0x27BF},
+    {0x2B1B, 0x2B1C}, {0x2B50, 0x2B50}, {0x2B55, 0x2B55}, {0x2E80, 0x303E},
+    {0x3041, 0x33FF}, {0x3400, 0x4DBF}, {0x4E00, 0x9FFF}, {0xA000, 0xA4CF},
+    {0xA960, 0xA97F}, {0xAC00, 0xD7A3}, {0xF900, 0xFAFF}, {0xFE10, 0xFE19},
+    {0xFE30, 0xFE6F}, {0xFF00, 0xFF60}, {0xFFE0, 0xFFE6}, {0x16FE0, 0x16FE4},
+    {0x17000, 0x18CFF}, {0x1B000, 0x1B2FF}, {0x1F004, 0x1F004}, {0x1F0CF, 0x1F0CF},
+    {0x1F18E, 0x1F18E}, {0x1F191, 0x1F19A}, {0x1F200, 0x1F202}, {0x1F210, 0x1F23B},
+    {0x1F240, 0x1F248}, {0x1F250, 0x1F251}, {0x1F260, 0x1F265}, {0x1F300, 0x1F320},
+    {0x1F32D, 0x1F335}, {0x1F337, 0x1F37C}, {0x1F37E, 0x1F393}, {0x1F3A0, 0x1F3CA},
+    {0x1F3CF, 0x1F3D3}, {0x1F3E0, 0x1F3F0}, {0x1F3F4, 0x1F3F4}, {0x1F3F8, 0x1F43E},
+    {0x1F440, 0x1F440}, {0x1F442, 0x1F4FC}, {0x1F4FF, 0x1F53D}, {0x1F54B, 0x1F54E},
+    {0x1F550, 0x1F567}, {0x1F57A, 0x1F57A}, {0x1F595, 0x1F596}, {0x1F5A4, 0x1F5A4},
+    {0x1F5FB, 0x1F64F}, {0x1F680, 0x1F6C5}, {0x1F6CC, 0x1F6CC}, {0x1F6D0, 0x1F6D2},
+    {0x1F6D5, 0x1F6D7}, {0x1F6DC, 0x1F6DF}, {0x1F6EB, 0x1F6EC}, {0x1F6F4, 0x1F6FC},
+    {0x1F7E0, 0x1F7EB}, {0x1F7F0, 0x1F7F0}, {0x1F90C, 0x1F93A}, {0x1F93C, 0x1F945},
+    {0x1F947, 0x1F9FF}, {0x1FA70, 0x1FAFF}, {0x20000, 0x2FFFD}, {0x30000, 0x3FFFD},
+};
+
+template <size_t N>
+bool inRanges(const Range (&ranges)[N], char32_t codepoint) {
+    auto it = std::upper_bound(std::begin(ranges), std::end(ranges), codepoint,
+                               [](char32_t value, const Range& range) { return value < range.first; });
+    return it != std::begin(ranges) && codepoint <= std::prev(it)->last;
+}
+
+// Cells a glyph takes at byte `pos`; a combining mark with nothing before
+// it gets a cell of its own
+inline size_t cellsOf(const Utf8Glyph& glyph, size_t pos) {
+    return glyph.width == 0 && pos == 0 ? 1 : glyph.width;
+}
+
+constexpr std::string_view REPLACEMENT = "\xEF\xBF\xBD";  // U+FFFD
+
+} // namespace
+
+Utf8Glyph decodeGlyph(std::string_view text, size_t pos) {
+    auto byte = [&](size_t i) { return static_cast<unsigned char>(text[i]); };
+    unsigned char lead = byte(pos);
+    if (lead < 0x80) {
+        bool control = lead < 0x20 || lead == 0x7F;
+        return {1, 1, control ? Utf8Glyph::Kind::Control : Utf8Glyph::Kind::Text};
+    }
+
+    // Continuation bytes allowed after the lead (RFC 3629 table): excludes
+    // overlong forms, surrogates and code points past U+10FFFF
+    uint32_t continuations;
+    unsigned char low = 0x80;
+    unsigned char high = 0xBF;
+    char32_t codepoint;
+    if (lead >= 0xC2 && lead <= 0xDF) {
+        continuations = 1;
+        codepoint = lead & 0x1F;
+    } else if (lead >= 0xE0 && lead <= 0xEF) {
+        continuations = 2;
+        codepoint = lead & 0x0F;
+        low = lead == 0xE0 ? 0xA0 : 0x80;
+        high = lead == 0xED ? 0x9F : 0xBF;
+    } else if (lead >= 0xF0 && lead <= 0xF4) {
+        continuations = 3;
+        codepoint = lead & 0x07;
+        low = lead == 0xF0 ? 0x90 : 0x80;
+        high = lead == 0xF4 ? 0x8F : 0xBF;
+    } else {
+        return {1, 1, Utf8Glyph::Kind::Invalid};
+    }
+
+    for (uint32_t i = 1; i <= continuations; ++i) {
+        if (pos + i >= text.size() || byte(pos + i) < low || byte(pos + i) > high) {
+            return {i, 1, Utf8Glyph::Kind::Invalid};  // The bytes that did fit
+        }
+        codepoint = (codepoint << 6) | (byte(pos + i) & 0x3F);
+        low = 0x80;
+        high = 0xBF;
+    }
+
+    if (codepoint < 0xA0) {
+        return {continuations + 1, 1, Utf8Glyph::Kind::Control};  // C1
+    }
+    return {continuations + 1, static_cast<uint8_t>(codepointWidth(codepoint)), Utf8Glyph::Kind::Text};
+}
+
+int codepointWidth(char32_t codepoint) {
+    if (codepoint < 0x300) {
+        return 1;
+    }
+    if (inRanges(ZERO_WIDTH, codepoint)) {
+        return 0;
+    }
+    return inRanges(WIDE, codepoint) ? 2 : 1;
+}
+
+size_t asciiPrefix(std::string_view text) {
+    const char* data = text.data();
+    const size_t size = text.size();
+    size_t i = 0;
+
+    // Any byte with the high bit set ends the run
+#if defined(UTF8_TEXT_AVX2)
+    for (; i + 32 <= size; i += 32) {
+        __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+        uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(chunk));
+        if (mask != 0) {
+            return i + static_cast<size_t>(lowestBitIndex(mask));
+        }
+    }
+#elif defined(UTF8_TEXT_SSE2)
+    for (; i + 16 <= size; i += 16) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(chunk));
+        if (mask != 0) {
+            return i + static_cast<size_t>(lowestBitIndex(mask));
+        }
+    }
+#endif
+    for (; i + 8 <= size; i += 8) {
+        uint64_t word;
+        std::memcpy(&word, data + i, sizeof(word));
+        if ((word & 0x8080808080808080ULL) != 0) {
+            break;
+        }
+    }
+    while (i < size && static_cast<unsigned char>(data[i]) < 0x80) {
+        ++i;
+    }
+    return i;
+}
+
+std::string sanitizeUtf8(std::string_view text) {
+    std::string result;
+    result.reserve(text.size());
+    for (size_t pos = 0; pos < text.size();) {
+        Utf8Glyph glyph = decodeGlyph(text, pos);
+        switch (glyph.kind) {
+            case Utf8Glyph::Kind::Text:
+                result.append(text.substr(pos, glyph.length));
+                break;
+            case Utf8Glyph::Kind::Control:
+                result += ' ';
+                break;
+            case Utf8Glyph::Kind::Invalid:
+                result.append(REPLACEMENT);
+                break;
+        }
+        pos += glyph.length;
+    }
+    return result;
+}
+
+size_t displayWidth(std::string_view text) {
+    size_t ascii = asciiPrefix(text);
+    size_t width = ascii;
+    for (size_t pos = ascii; pos < text.size();) {
+        Utf8Glyph glyph = decodeGlyph(text, pos);
+        width += cellsOf(glyph, pos);
+        pos += glyph.length;
+    }
+    return width;
+}
+
+size_t prefixForWidth(std::string_view text, size_t width) {
+    size_t cells = 0;
+    size_t pos = 0;
+    while (pos < text.size()) {
+        Utf8Glyph glyph = decodeGlyph(text, pos);
+        cells += cellsOf(glyph, pos);
+        if (cells > width) {
+            break;
+        }
+        pos += glyph.length;
+    }
+    return pos;
+}
+
+LineLayout::LineLayout(std::string_view line)
+    : ascii_(false)
+    , columns_(0) {
+    size_t pos = asciiPrefix(line);
+    if (pos == line.size()) {
+        ascii_ = true;
+        columns_ = line.size();
+        return;
+    }
+
+    // Checkpoints for the multiples of COLUMN_STEP in [column, column + cells)
+    auto add_run = [this](size_t byte, size_t column, size_t length) {
+        for (size_t target = checkpoints_.size() * COLUMN_STEP; target < column + length;
+             target += COLUMN_STEP) {
+            checkpoints_.push_back({static_cast<uint32_t>(byte + target - column),
+                                    static_cast<uint32_t>(target)});
+        }
+    };
+    auto add_glyph = [this](size_t byte, size_t column, size_t cells) {
+        while (checkpoints_.size() * COLUMN_STEP < column + cells) {
+            checkpoints_.push_back({static_cast<uint32_t>(byte), static_cast<uint32_t>(column)});
+        }
+    };
+
+    size_t column = pos;  // The ASCII prefix: one column per byte
+    add_run(0, 0, pos);
+    while (pos < line.size()) {
+        Utf8Glyph glyph = decodeGlyph(line, pos);
+        size_t cells = cellsOf(glyph, pos);
+        add_glyph(pos, column, cells);
+        column += cells;
+        pos += glyph.length;
+
+        size_t run = asciiPrefix(line.substr(pos));
+        add_run(pos, column, run);
+        column += run;
+        pos += run;
+    }
+    columns_ = column;
+    checkpoints_.shrink_to_fit();
+}
+
+LineLayout::Position LineLayout::glyphAtColumn(std::string_view line, size_t column) const {
+    if (column >= columns_) {
+        return {line.size(), columns_};
+    }
+    if (ascii_) {
+        return {column, column};
+    }
+
+    const Checkpoint& checkpoint = checkpoints_[column / COLUMN_STEP];
+    Position position{checkpoint.byte, checkpoint.column};
+    while (true) {
+        Utf8Glyph glyph = decodeGlyph(line, position.byte);
+        size_t cells = cellsOf(glyph, position.byte);
+        if (column < position.column + cells) {
+            return position;
+        }
+        position.byte += glyph.length;
+        position.column += cells;
+    }
+}
+
+size_t LineLayout::columnAtByte(std::string_view line, size_t byte) const {
+    if (byte >= line.size()) {
+        return columns_;
+    }
+    if (ascii_) {
+        return byte;
+    }
+
+    // Last checkpoint at or before the byte (the first one is at byte 0)
+    auto it = std::upper_bound(checkpoints_.begin(), checkpoints_.end(), byte,
+                               [](size_t value, const Checkpoint& checkpoint) { return value < checkpoint.byte; });
+    Position position{std::prev(it)->byte, std::prev(it)->column};
+    while (true) {
+        Utf8Glyph glyph = decodeGlyph(line, position.byte);
+        if (byte < position.byte + glyph.length) {
+            return position.column;
+        }
+        position.column += cellsOf(glyph, position.byte);
+        position.byte += glyph.length;
+    }
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// UTF-8 as the terminal shows it. Log lines are arbitrary bytes: every
+// invalid sequence becomes one U+FFFD cell, control characters become
+// blanks, East Asian wide characters and emoji take two cells and combining
+// marks none. Pure-ASCII runs, by far the common case, are found with SIMD
+// and skip decoding altogether.
+
+struct Utf8Glyph {
+    enum class Kind : uint8_t {
+        Text,     // Valid, printable
+        Control,  // C0, DEL or C1: painted blank
+        Invalid   // Broken sequence (maximal invalid subpart): painted U+FFFD
+    };
+
+    uint32_t length;  // Bytes, at least 1
+    uint8_t width;    // Cells: 0 (combining), 1 or 2
+    Kind kind;
+};
+
+// The glyph starting at byte `pos` (< text.size())
+Utf8Glyph decodeGlyph(std::string_view text, size_t pos);
+
+// Cells a code point takes (wcwidth without the locale): 0, 1 or 2
+int codepointWidth(char32_t codepoint);
+
+// Length of the leading run of ASCII bytes (SSE2/AVX2 when available)
+size_t asciiPrefix(std::string_view text);
+
+inline bool isAscii(std::string_view text) { return asciiPrefix(text) == text.size(); }
+
+// `text` made safe to hand to a text element: invalid sequences replaced by
+// U+FFFD, control characters by spaces
+std::string sanitizeUtf8(std::string_view text);
+
+// Cells `text` takes on screen
+size_t displayWidth(std::string_view text);
+
+// Bytes of the longest prefix of `text` that fits in `width` cells, cut
+// between glyphs
+size_t prefixForWidth(std::string_view text, size_t width);
+
+// Where each screen column of one line starts in its bytes. ASCII lines store
+// nothing (column == byte); others keep a checkpoint every COLUMN_STEP
+// columns, so finding the byte under any column walks at most that many
+// glyphs. Built once per line and cached with its tokens.
+class LineLayout {
+public:
+    static constexpr size_t COLUMN_STEP = 64;
+
+    // A glyph start: byte offset and the first column it covers
+    struct Position {
+        size_t byte;
+        size_t column;
+    };
+
+    explicit LineLayout(std::string_view line);
+
+    bool isAscii() const { return ascii_; }
+    size_t columns() const { return columns_; }
+
+    // The glyph covering `column` (a wide glyph may start one column before
+    // it); {line.size(), columns()} past the end. `line` is the one the
+    // layout was built from.
+    Position glyphAtColumn(std::string_view line, size_t column) const;
+
+    // First column of the glyph containing byte `byte`; columns() past the end
+    size_t columnAtByte(std::string_view line, size_t byte) const;
+
+    // Approximate heap bytes held
+    size_t memoryUsage() const { return checkpoints_.capacity() * sizeof(Checkpoint); }
+
+private:
+    struct Checkpoint {
+        uint32_t byte;    // Glyph covering column k * COLUMN_STEP
+        uint32_t column;  // Its first column
+    };
+
+    bool ascii_;
+    size_t columns_;
+    std::vector<Checkpoint> checkpoints_;
+};
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include "../src/log_reader.hpp"
+
+#ifdef _WIN32
+    #include <process.h>
+#else
+    #include <unistd.h>
+#endif
+
+// A log file for one test: `name` inside a directory private to this test
+// process (so parallel ctest runs never share a file), removed again with
+// the helper. Declare it before the LogReader that opens it, so the reader
+// is closed first.
+class TempLogFile {
+public:
+    explicit TempLogFile(const std::string& name) {
+#ifdef _WIN32
+        int pid = _getpid();
+#else
+        int pid = static_cast<int>(getpid());
+#endif
+        directory_ = std::filesystem::temp_directory_path() /
+                     ("log_analyzer_tests_" + std::to_string(pid));
+        std::filesystem::create_directories(directory_);
+        path_ = (directory_ / name).string();
+    }
+
+    ~TempLogFile() {
+        std::error_code ignored;
+        std::filesystem::remove(path_, ignored);
+        std::filesystem::remove(directory_, ignored);  // Only once it is empty
+    }
+
+    TempLogFile(const TempLogFile&) = delete;
+    TempLogFile& operator=(const TempLogFile&) = delete;
+
+    const std::string& path() const { return path_; }
+
+    // Replace the file's content, byte for byte
+    void write(std::string_view content) const {
+        std::ofstream ofs(path_, std::ios::binary | std::ios::trunc);
+        ofs.write(content.data(), static_cast<std::streamsize>(content.size()));
+    }
+
+    // Replace the content and (re)open `reader` on the file
+    bool writeAndOpen(LogReader& reader, std::string_view content) const {
+        reader.close();
+        write(content);
+        return reader.open(path_);
+    }
+
+private:
+    std::filesystem::path directory_;
+    std::string path_;
+};
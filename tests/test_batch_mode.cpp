@@ -0,0 +1,121 @@
+#include <gtest/gtest.h>
+#include "../src/batch_mode.hpp"
+#include "temp_log_file.hpp"
+#include <cstdio>
+
+class BatchModeTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        writeLog("INFO start\n"
+                 "ERROR disk full\n"
+                 "ERROR retry\r\n"
+                 "INFO ok\n"
+                 "ERROR last");  // No trailing newline
+    }
+
+    void writeLog(const std::string& content) {
+        ASSERT_TRUE(log_.writeAndOpen(reader_, content));
+    }
+
+    // Run a batch into a temporary file and return what was written
+    std::string run(const BatchOptions& options, int& status) {
+        std::FILE* out = std::tmpfile();
+        EXPECT_NE(out, nullptr);
+        FilterEngine filter;
+        std::string error;
+        status = runBatch(reader_, filter, options, fileno(out), error);
+
+        std::string result;
+        std::rewind(out);
+        char buffer[4096];
+        size_t n;
+        while ((n = std::fread(buffer, 1, sizeof(buffer), out)) > 0) {
+            result.append(buffer, n);
+        }
+        std::fclose(out);
+        return result;
+    }
+
+    TempLogFile log_{"batch_mode_test.log"};
+    LogReader reader_;
+};
+
+TEST_F(BatchModeTest, PrintsMatchingLinesByteForByte) {
+    BatchOptions options;
+    options.pattern = "ERROR";
+    int status = -1;
+    EXPECT_EQ(run(options, status), "ERROR disk full\nERROR retry\r\nERROR last\n");
+    EXPECT_EQ(status, BATCH_MATCHED);
+}
+
+TEST_F(BatchModeTest, LineNumbers) {
+    BatchOptions options;
+    options.pattern = "ERROR";
+    options.line_numbers = true;
+    int status = -1;
+    EXPECT_EQ(run(options, status), "2:ERROR disk full\n3:ERROR retry\r\n5:ERROR last\n");
+}
+
+TEST_F(BatchModeTest, Count) {
+    BatchOptions options;
+    options.pattern = "INFO";
+    options.count = true;
+    int status = -1;
+    EXPECT_EQ(run(options, status), "2\n");
+    EXPECT_EQ(status, BATCH_MATCHED);
+}
+
+TEST_F(BatchModeTest, NoMatchAndErrorStatus) {
+    BatchOptions options;
+    options.pattern = "WARN";
+    int status = -1;
+    EXPECT_EQ(run(options, status), "");
+    EXPECT_EQ(status, BATCH_NO_MATCH);
+
+    options.count = true;
+    EXPECT_EQ(run(options, status), "0\n");
+    EXPECT_EQ(status, BATCH_NO_MATCH);
+
+    options.pattern = "[unclosed";
+    run(options, status);
+    EXPECT_EQ(status, BATCH_ERROR);
+}
+
+TEST_F(BatchModeTest, EmptyPatternMatchesEverything) {
+    BatchOptions options;
+    int status = -1;
+    EXPECT_EQ(run(options, status),
+              "INFO start\nERROR disk full\nERROR retry\r\nINFO ok\nERROR last\n");
+}
+
+TEST_F(BatchModeTest, OutputLargerThanBuffer) {
+    std::string content;
+    for (int i = 0; i < 100000; ++i) {
+        content += "ERROR line " + std::to_string(i) + "\n";
+    }
+    writeLog(content);
+
+    BatchOptions options;
+    options.pattern = "ERROR";
+    int status = -1;
+    EXPECT_EQ(run(options, status), content);
+    EXPECT_EQ(status, BATCH_MATCHED);
+}
+
+TEST_F(BatchModeTest, GroupByPrintsOneRowPerKey) {
+    writeLog("GET /api 45ms\n"
+             "GET /login 120ms\n"
+             "GET /api 15ms\n"
+             "POST /api 1ms\n");
+    BatchOptions options;
+    options.pattern = "GET (\\S+) (\\d+)ms";
+    options.group_by = "$1 $2";
+    int status = -1;
+    EXPECT_EQ(run(options, status), "/api\t2\t60\t15\t45\t30\n"
+                                    "/login\t1\t120\t120\t120\t120\n");
+    EXPECT_EQ(status, BATCH_MATCHED);
+
+    options.group_by = "$3";
+    EXPECT_EQ(run(options, status), "");
+    EXPECT_EQ(status, BATCH_ERROR);
+}
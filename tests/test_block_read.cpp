@@ -0,0 +1,201 @@
+#include <gtest/gtest.h>
+#include "../src/batch_mode.hpp"
+#include "../src/block_read.hpp"
+#include "../src/filter_engine.hpp"
+#include "../src/log_reader.hpp"
+#include "temp_log_file.hpp"
+#include <cstdio>
+#include <set>
+
+#ifndef _WIN32
+
+class BlockReadTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        // Lines of varying length, so block edges fall inside lines
+        for (int i = 0; i < 5000; ++i) {
+            content_ += "2025-01-01 10:00:00 " + std::string(i % 3 == 0 ? "ERROR" : "INFO") +
+                        " request " + std::to_string(i) + std::string(i % 17, '.') +
+                        (i % 5 == 0 ? "\r\n" : "\n");
+        }
+        content_ += "last line without newline";
+        log_.write(content_);
+    }
+
+    // The blocks readBlocks() hands over, checking they arrive in order and
+    // whole, in at most queue_depth buffers
+    std::string readAll(const ReadOptions& options, IoEngine& engine) {
+        int fd = ::open(path_.c_str(), O_RDONLY);
+        EXPECT_NE(fd, -1);
+        std::string data;
+        std::set<const char*> buffers;
+        std::string error;
+        bool ok = readBlocks(fd, content_.size(), options,
+                             [&](size_t offset, const char* block, size_t length) {
+                                 EXPECT_EQ(offset, data.size());
+                                 data.append(block, length);
+                                 buffers.insert(block);
+                                 return true;
+                             },
+                             engine, error);
+        ::close(fd);
+        EXPECT_TRUE(ok) << error;
+        EXPECT_LE(buffers.size(), options.queue_depth);
+        return data;
+    }
+
+    // Until a reader opened with ReadBackend::Read has every line
+    static void waitForLoad(LogReader& reader) {
+        while (reader.isGrowing()) {
+            reader.waitForLines(reader.getLineCount(), std::chrono::milliseconds(50));
+        }
+    }
+
+    TempLogFile log_{"block_read_test.log"};
+    const std::string& path_ = log_.path();
+    std::string content_;
+};
+
+TEST_F(BlockReadTest, ThreadPoolReadsEveryBlockInOrder) {
+    ReadOptions options;
+    options.block_size = 4096;
+    options.queue_depth = 3;
+    options.use_io_uring = false;
+    IoEngine engine = IoEngine::IoUring;
+    EXPECT_EQ(readAll(options, engine), content_);
+    EXPECT_EQ(engine, IoEngine::PreadPool);
+}
+
+TEST_F(BlockReadTest, IoUringOrFallbackReadsTheSameBytes) {
+    ReadOptions options;
+    options.block_size = 5000;  // Rounded up to whole pages
+    options.queue_depth = 4;
+    IoEngine engine;
+    EXPECT_EQ(readAll(options, engine), content_);
+}
+
+TEST_F(BlockReadTest, FailsWhenTheFileIsShorterThanAsked) {
+    int fd = ::open(path_.c_str(), O_RDONLY);
+    ASSERT_NE(fd, -1);
+    for (bool use_io_uring : {true, false}) {
+        ReadOptions options;
+        options.block_size = 4096;
+        options.use_io_uring = use_io_uring;
+        IoEngine engine;
+        std::string error;
+        EXPECT_FALSE(readBlocks(fd, content_.size() + 10000, options,
+                                [](size_t, const char*, size_t) { return true; }, engine, error));
+        EXPECT_FALSE(error.empty());
+    }
+    ::close(fd);
+}
+
+TEST_F(BlockReadTest, StopsWhenTheCallbackSaysSo) {
+    int fd = ::open(path_.c_str(), O_RDONLY);
+    ASSERT_NE(fd, -1);
+    for (bool use_io_uring : {true, false}) {
+        ReadOptions options;
+        options.block_size = 4096;
+        options.queue_depth = 2;
+        options.use_io_uring = use_io_uring;
+        size_t blocks = 0;
+        IoEngine engine;
+        std::string error;
+        EXPECT_TRUE(readBlocks(fd, content_.size(), options,
+                               [&](size_t, const char*, size_t) { return ++blocks < 3; }, engine, error))
+            << error;
+        EXPECT_EQ(blocks, 3u);
+    }
+    ::close(fd);
+}
+
+TEST_F(BlockReadTest, ReaderIndexesTheSameLinesAsMmap) {
+    LogReader mapped;
+    ReadOptions options;
+    options.backend = ReadBackend::Mmap;
+    ASSERT_TRUE(mapped.open(path_, options));
+    EXPECT_EQ(mapped.getBackend(), ReadBackend::Mmap);
+    EXPECT_EQ(mapped.getStreamMemory(), 0u);
+
+    LogReader read;
+    options.backend = ReadBackend::Read;
+    options.block_size = 4096;
+    ASSERT_TRUE(read.open(path_, options));
+    EXPECT_EQ(read.getBackend(), ReadBackend::Read);
+    EXPECT_EQ(read.getFileSize(), content_.size());
+    EXPECT_NE(read.getFileDescriptor(), -1);  // Still there for exports
+    waitForLoad(read);
+    EXPECT_TRUE(read.getReadError().empty()) << read.getReadError();
+    EXPECT_EQ(read.getStreamMemory(), 0u);  // The buffers are gone once it is read
+    EXPECT_EQ(read.getIndexRate().bytes, content_.size());
+
+    ASSERT_EQ(read.getLineCount(), mapped.getLineCount());
+    EXPECT_EQ(read.getData(), mapped.getData());
+    for (size_t line = 0; line <= read.getLineCount(); ++line) {
+        ASSERT_EQ(read.getLineOffset(line), mapped.getLineOffset(line)) << line;
+    }
+    EXPECT_EQ(read.getLine(5), mapped.getLine(5));
+    EXPECT_EQ(read.getLine(read.getLineCount() - 1), "last line without newline");
+
+    // The parallel filter runs over the read bytes unchanged
+    FilterEngine filter;
+    ASSERT_TRUE(filter.setPattern("ERROR"));
+    EXPECT_EQ(filter.filterLines(read, 0, read.getLineCount(), 4),
+              filter.filterLines(mapped, 0, mapped.getLineCount(), 4));
+}
+
+TEST_F(BlockReadTest, BatchModeFiltersWhileTheFileIsRead) {
+    // Ends with a newline: no empty line after it
+    TempLogFile log{"block_read_batch.log"};
+    std::string content;
+    for (int i = 0; i < 20000; ++i) {
+        content += (i % 7 == 0 ? "ERROR " : "INFO ") + std::to_string(i) + "\n";
+    }
+    log.write(content);
+
+    LogReader mapped;
+    ASSERT_TRUE(mapped.open(log.path()));
+    ReadOptions options;
+    options.backend = ReadBackend::Read;
+    options.block_size = 4096;
+    options.queue_depth = 2;
+    LogReader read;
+    ASSERT_TRUE(read.open(log.path(), options));
+
+    BatchOptions batch;
+    batch.pattern = "ERROR";
+    batch.count = true;
+    std::FILE* out = std::tmpfile();
+    ASSERT_NE(out, nullptr);
+    FilterEngine filter;
+    std::string error;
+    EXPECT_EQ(runBatch(read, filter, batch, fileno(out), error), BATCH_MATCHED) << error;
+    char buffer[64] = {};
+    std::rewind(out);
+    size_t n = std::fread(buffer, 1, sizeof(buffer) - 1, out);
+    std::fclose(out);
+    EXPECT_EQ(std::string(buffer, n), std::to_string((20000 + 6) / 7) + "\n");
+
+    EXPECT_FALSE(read.isGrowing());  // Batch mode followed it to the end
+    EXPECT_EQ(read.getLineCount(), mapped.getLineCount());
+    EXPECT_EQ(read.getLineOffset(read.getLineCount()), content.size());
+}
+
+TEST_F(BlockReadTest, AutoMapsLocalFiles) {
+    int fd = ::open(path_.c_str(), O_RDONLY);
+    ASSERT_NE(fd, -1);
+    ReadOptions options;
+    if (remoteFilesystem(fd).empty()) {
+        EXPECT_EQ(chooseBackend(fd, options), ReadBackend::Mmap);
+    }
+    options.backend = ReadBackend::Read;
+    EXPECT_EQ(chooseBackend(fd, options), ReadBackend::Read);
+    ::close(fd);
+
+    ReadBackend backend;
+    EXPECT_TRUE(parseReadBackend("read", backend));
+    EXPECT_EQ(backend, ReadBackend::Read);
+    EXPECT_FALSE(parseReadBackend("uring", backend));
+}
+
+#endif
@@ -1,5 +1,6 @@
 #include <gtest/gtest.h>
 #include "../src/filter_engine.hpp"
+#include "temp_log_file.hpp"
 #include <string_view>
 #include <vector>
 
@@ -126,3 +127,74 @@ TEST_F(FilterEngineTest, ComplexRegexPattern) {
     EXPECT_EQ(indices[1], 3); // ERROR: Invalid input
     EXPECT_EQ(indices[2], 4); // WARNING: Low memory
 }
+
+TEST_F(FilterEngineTest, JsonQueryPattern) {
+    FilterEngine engine;
+    ASSERT_TRUE(engine.setPattern(R"(json: endpoint == "/api/users" && body.age > 25)"));
+    EXPECT_EQ(engine.getMode(), FilterEngine::Mode::JsonQuery);
+
+    std::vector<std::string_view> lines = {
+        R"(INFO: {"endpoint": "/api/users", "body": {"age": 30}})",
+        R"(INFO: {"endpoint": "/api/users", "body": {"age": 20}})",
+        R"(INFO: endpoint /api/users age 30)"
+    };
+    auto indices = engine.filter(lines);
+    ASSERT_EQ(indices.size(), 1);
+    EXPECT_EQ(indices[0], 0);
+}
+
+TEST_F(FilterEngineTest, InvalidJsonQueryPattern) {
+    FilterEngine engine;
+    EXPECT_FALSE(engine.setPattern("json: age >"));
+    EXPECT_FALSE(engine.hasValidPattern());
+    EXPECT_FALSE(engine.getError().empty());
+}
+
+TEST_F(FilterEngineTest, FindMatchesReportsSpans) {
+    FilterEngine engine;
+    ASSERT_TRUE(engine.setPattern("in"));
+
+    std::vector<MatchSpan> spans;
+    EXPECT_TRUE(engine.findMatches("ERROR: Invalid input", spans));
+    ASSERT_EQ(spans.size(), 1u);
+    EXPECT_EQ(spans[0], (MatchSpan{15, 2}));
+
+    spans.clear();
+    EXPECT_FALSE(engine.findMatches("DEBUG: Queue empty", spans));
+    EXPECT_TRUE(spans.empty());
+}
+
+TEST_F(FilterEngineTest, FindMatchesJsonQueryReportsKeys) {
+    FilterEngine engine;
+    ASSERT_TRUE(engine.setPattern(R"(json: status == "ok")"));
+
+    std::string_view line = R"(INFO: {"id": 1, "status": "ok"})";
+    std::vector<MatchSpan> spans;
+    EXPECT_TRUE(engine.findMatches(line, spans));
+    ASSERT_EQ(spans.size(), 1u);
+    EXPECT_EQ(line.substr(spans[0].offset, spans[0].length), "\"status\"");
+}
+
+TEST_F(FilterEngineTest, FilterLinesParallelMatchesSequential) {
+    std::string content;
+    for (size_t i = 0; i < 5 * FilterEngine::MIN_LINES_PER_THREAD; ++i) {
+        content += std::string(i % 7 == 0 ? "ERROR" : "INFO") + " request " + std::to_string(i) + "\n";
+    }
+    TempLogFile log("filter_lines_test.log");
+    LogReader reader;
+    ASSERT_TRUE(log.writeAndOpen(reader, content));
+
+    FilterEngine engine;
+    ASSERT_TRUE(engine.setPattern("ERROR"));
+
+    auto sequential = engine.filterLines(reader, 0, reader.getLineCount(), 1);
+    auto parallel = engine.filterLines(reader, 0, reader.getLineCount(), 4);
+    EXPECT_EQ(parallel, sequential);
+    ASSERT_FALSE(parallel.empty());
+    EXPECT_EQ(parallel.front(), 0u);
+    EXPECT_EQ(parallel.size(), (reader.getLineCount() + 6) / 7);
+
+    // Sub-ranges report absolute line indices
+    auto window = engine.filterLines(reader, 10, 30, 4);
+    EXPECT_EQ(window, (std::vector<size_t>{14, 21, 28}));
+}
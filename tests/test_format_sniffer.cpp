@@ -0,0 +1,62 @@
+#include <gtest/gtest.h>
+#include "../src/format_sniffer.hpp"
+#include "../src/log_reader.hpp"
+#include "temp_log_file.hpp"
+
+class FormatSnifferTest : public ::testing::Test {
+protected:
+    TempLogFile log_{"format_sniffer_test.log"};
+};
+
+TEST_F(FormatSnifferTest, DetectJsonLines) {
+    std::vector<std::string_view> sample = {
+        R"([2025-11-30 14:00:00] INFO: API Request received: {"method": "POST", "endpoint": "/api/users"})",
+        R"([2025-11-30 14:00:02] INFO: User created: {"id": 12345, "status": "active"})",
+        R"([2025-11-30 14:00:10] ERROR: JSON parse error at line 5)"
+    };
+    EXPECT_EQ(detectFormat(sample), LogFormat::JsonLines);
+}
+
+TEST_F(FormatSnifferTest, DetectLogfmt) {
+    std::vector<std::string_view> sample = {
+        R"(ts=2025-11-30T14:00:00Z level=info msg="request done" path=/api status=200)",
+        R"(ts=2025-11-30T14:00:01Z level=warn msg="slow" duration=2.5s)",
+    };
+    EXPECT_EQ(detectFormat(sample), LogFormat::Logfmt);
+}
+
+TEST_F(FormatSnifferTest, DetectSql) {
+    std::vector<std::string_view> sample = {
+        "[2025-11-30 14:00:00] INFO: Database connection established",
+        "[2025-11-30 14:00:01] DEBUG: Executing query: SELECT * FROM users WHERE id = 123",
+        "[2025-11-30 14:00:02] INFO: Query executed successfully in 45ms, returned 1 rows",
+    };
+    EXPECT_EQ(detectFormat(sample), LogFormat::Sql);
+}
+
+TEST_F(FormatSnifferTest, DetectPlainText) {
+    std::vector<std::string_view> sample = {
+        "[2025-11-30 10:00:00] INFO: Application started successfully",
+        "[2025-11-30 10:00:03] WARN: Configuration file missing, using defaults",
+        "[2025-11-30 10:00:04] ERROR: Failed to select a plugin in the folder",
+    };
+    EXPECT_EQ(detectFormat(sample), LogFormat::PlainText);
+}
+
+TEST_F(FormatSnifferTest, EmptySampleIsGeneric) {
+    EXPECT_EQ(detectFormat(std::vector<std::string_view>{}), LogFormat::Generic);
+    EXPECT_EQ(detectFormat(std::vector<std::string_view>{"", ""}), LogFormat::Generic);
+}
+
+TEST_F(FormatSnifferTest, DetectFromReader) {
+    std::string content;
+    for (int i = 0; i < 1000; ++i) {
+        content += R"({"level": "info", "seq": )" + std::to_string(i) + "}\n";
+    }
+    log_.write(content);
+
+    LogReader reader;
+    ASSERT_TRUE(reader.open(log_.path()));
+    EXPECT_EQ(detectFormat(reader), LogFormat::JsonLines);
+    EXPECT_EQ(formatName(LogFormat::JsonLines), "JSON");
+}
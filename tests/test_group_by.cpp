@@ -0,0 +1,227 @@
+#include <gtest/gtest.h>
+#include "../src/filter_engine.hpp"
+#include "../src/group_by.hpp"
+#include "temp_log_file.hpp"
+
+TEST(GroupSpecTest, ParsesKeysAndValues) {
+    GroupSpec spec;
+    std::string error;
+
+    ASSERT_TRUE(parseGroupSpec("$1 $2", spec, error)) << error;
+    EXPECT_EQ(spec.key.kind, GroupField::Kind::Capture);
+    EXPECT_EQ(spec.key.capture, 1u);
+    EXPECT_EQ(spec.value.capture, 2u);
+    EXPECT_EQ(spec.maxCapture(), 2u);
+
+    ASSERT_TRUE(parseGroupSpec("  json:request.path   json:ms ", spec, error)) << error;
+    EXPECT_EQ(spec.key.kind, GroupField::Kind::Json);
+    EXPECT_EQ(spec.key.path, (std::vector<std::string>{"request", "path"}));
+    EXPECT_TRUE(spec.hasValue());
+    EXPECT_EQ(spec.maxCapture(), 0u);
+
+    ASSERT_TRUE(parseGroupSpec("minute", spec, error));
+    EXPECT_EQ(spec.key.kind, GroupField::Kind::Minute);
+    EXPECT_FALSE(spec.hasValue());
+
+    for (const char* bad : {"", "$0", "$x", "host", "$1 level", "$1 $2 $3", "json:", "json:a..b", "json:a."}) {
+        error.clear();
+        EXPECT_FALSE(parseGroupSpec(bad, spec, error)) << bad;
+        EXPECT_FALSE(error.empty()) << bad;
+    }
+}
+
+TEST(GroupSpecTest, LeadingNumbers) {
+    double value = 0;
+    EXPECT_TRUE(parseLeadingNumber("45ms", value));
+    EXPECT_DOUBLE_EQ(value, 45.0);
+    EXPECT_TRUE(parseLeadingNumber("-0.5s", value));
+    EXPECT_DOUBLE_EQ(value, -0.5);
+    EXPECT_TRUE(parseLeadingNumber("+3", value));
+    EXPECT_DOUBLE_EQ(value, 3.0);
+    EXPECT_FALSE(parseLeadingNumber("ms", value));
+    EXPECT_FALSE(parseLeadingNumber("", value));
+
+    EXPECT_EQ(formatGroupNumber(1234.0), "1234");
+    EXPECT_EQ(formatGroupNumber(2.5), "2.50");
+}
+
+TEST(GroupTableTest, AggregatesMergesAndSorts) {
+    GroupTable first;
+    GroupTable second;
+    double ms[] = {10, 30, 5, 7};
+    first.add("/api", &ms[0]);
+    first.add("/api", &ms[1]);
+    first.add("/health", nullptr);
+    second.add("/api", &ms[2]);
+    second.add("/login", &ms[3]);
+    second.add("/health", nullptr);
+
+    first.merge(second);
+    EXPECT_EQ(first.size(), 3u);
+    EXPECT_EQ(first.totalCount(), 6u);
+    EXPECT_GT(first.memoryUsage(), 0u);
+
+    const GroupStats* api = first.find("/api");
+    ASSERT_NE(api, nullptr);
+    EXPECT_EQ(api->count, 3u);
+    EXPECT_EQ(api->values, 3u);
+    EXPECT_DOUBLE_EQ(api->sum, 45.0);
+    EXPECT_DOUBLE_EQ(api->min, 5.0);
+    EXPECT_DOUBLE_EQ(api->max, 30.0);
+    EXPECT_DOUBLE_EQ(api->average(), 15.0);
+    EXPECT_EQ(first.find("/health")->values, 0u);
+
+    auto keys = [](const std::vector<GroupTable::Row>& rows) {
+        std::vector<std::string> result;
+        for (const auto& row : rows) {
+            result.push_back(row.key);
+        }
+        return result;
+    };
+    // Equal counts are ordered by key
+    EXPECT_EQ(keys(first.rows(GroupColumn::Count, true)),
+              (std::vector<std::string>{"/api", "/health", "/login"}));
+    EXPECT_EQ(keys(first.rows(GroupColumn::Key, true)),
+              (std::vector<std::string>{"/login", "/health", "/api"}));
+    EXPECT_EQ(keys(first.rows(GroupColumn::Max, false)),
+              (std::vector<std::string>{"/health", "/login", "/api"}));
+
+    first.clear();
+    EXPECT_TRUE(first.empty());
+    EXPECT_EQ(first.totalCount(), 0u);
+}
+
+class GroupScanTest : public ::testing::Test {
+protected:
+    void write(const std::string& content) {
+        ASSERT_TRUE(log_.writeAndOpen(reader_, content));
+    }
+
+    GroupSpec spec(const char* text) {
+        GroupSpec result;
+        std::string error;
+        EXPECT_TRUE(parseGroupSpec(text, result, error)) << error;
+        return result;
+    }
+
+    TempLogFile log_{"group_scan_test.log"};
+    LogReader reader_;
+    FilterEngine filter_;
+};
+
+TEST_F(GroupScanTest, CapturesBecomeKeysAndValues) {
+    write("[2025-01-01 10:00:01] INFO GET /api 45ms\n"
+          "[2025-01-01 10:00:30] ERROR GET /login 120ms\n"
+          "[2025-01-01 10:01:02] INFO GET /api 15ms\n"
+          "[2025-01-01 10:01:09] INFO POST /api 99ms\n"
+          "no timestamp here\n");
+
+    ASSERT_TRUE(filter_.setPattern("GET (\\S+) (\\d+)ms"));
+    EXPECT_EQ(filter_.captureCount(), 2u);
+    GroupTable groups;
+    EXPECT_EQ(filter_.groupLines(reader_, 0, reader_.getLineCount(), spec("$1 $2"), groups), 3u);
+    EXPECT_EQ(groups.size(), 2u);
+    EXPECT_EQ(groups.find("/api")->count, 2u);
+    EXPECT_DOUBLE_EQ(groups.find("/api")->sum, 60.0);
+    EXPECT_DOUBLE_EQ(groups.find("/login")->max, 120.0);
+
+    // Plain words have no captures; field keys still work, missing ones group as ""
+    ASSERT_TRUE(filter_.setPattern("GET"));
+    EXPECT_EQ(filter_.captureCount(), 0u);
+    filter_.clearPattern();
+    GroupTable minutes;
+    filter_.groupLines(reader_, 0, reader_.getLineCount(), spec("minute"), minutes);
+    EXPECT_EQ(minutes.find("2025-01-01 10:00")->count, 2u);
+    EXPECT_EQ(minutes.find("2025-01-01 10:01")->count, 2u);
+    EXPECT_EQ(minutes.find("")->count, 1u);
+
+    GroupTable levels;
+    filter_.groupLines(reader_, 0, reader_.getLineCount(), spec("level"), levels);
+    EXPECT_EQ(levels.find("INFO")->count, 3u);
+    EXPECT_EQ(levels.find("ERROR")->count, 1u);
+}
+
+TEST_F(GroupScanTest, FindMatchesGroupsWhileRecordingSpans) {
+    write("{\"endpoint\":\"/a\",\"ms\":12}\n");
+    ASSERT_TRUE(filter_.setPattern("json: ms > 10"));
+
+    GroupTable groups;
+    std::vector<MatchSpan> spans;
+    EXPECT_TRUE(filter_.findMatches(reader_.getLine(0), spans, spec("json:endpoint json:ms"), groups));
+    EXPECT_FALSE(spans.empty());
+    ASSERT_NE(groups.find("/a"), nullptr);
+    EXPECT_DOUBLE_EQ(groups.find("/a")->sum, 12.0);
+
+    spans.clear();
+    EXPECT_FALSE(filter_.findMatches("{\"ms\":3}", spans, spec("json:endpoint"), groups));
+    EXPECT_EQ(groups.totalCount(), 1u);
+
+    // The key comes from the object that has it, not from an empty one before it
+    spans.clear();
+    EXPECT_TRUE(filter_.findMatches("msg={} {\"endpoint\":\"/b\",\"ms\":20}", spans, spec("json:endpoint"), groups));
+    ASSERT_NE(groups.find("/b"), nullptr);
+    EXPECT_EQ(groups.totalCount(), 2u);
+}
+
+TEST_F(GroupScanTest, ParallelScanMatchesSingleThread) {
+    std::string content;
+    const size_t count = 4 * FilterEngine::MIN_LINES_PER_THREAD + 123;
+    for (size_t i = 0; i < count; ++i) {
+        content += "host=h" + std::to_string(i % 37) + " took " + std::to_string(i % 1000) + "ms\n";
+    }
+    write(content);
+    ASSERT_TRUE(filter_.setPattern("host=(\\w+) took (\\d+)ms"));
+
+    GroupTable one;
+    GroupTable four;
+    EXPECT_EQ(filter_.groupLines(reader_, 0, count, spec("$1 $2"), one, 1), count);
+    EXPECT_EQ(filter_.groupLines(reader_, 0, count, spec("$1 $2"), four, 4), count);
+
+    auto serial = one.rows(GroupColumn::Key, false);
+    auto parallel = four.rows(GroupColumn::Key, false);
+    ASSERT_EQ(serial.size(), 37u);
+    ASSERT_EQ(serial.size(), parallel.size());
+    for (size_t i = 0; i < serial.size(); ++i) {
+        EXPECT_EQ(serial[i].key, parallel[i].key);
+        EXPECT_EQ(serial[i].stats.count, parallel[i].stats.count);
+        EXPECT_DOUBLE_EQ(serial[i].stats.sum, parallel[i].stats.sum);
+        EXPECT_DOUBLE_EQ(serial[i].stats.max, parallel[i].stats.max);
+    }
+}
+
+TEST_F(GroupScanTest, ScanLinesKeepsSpansAndGroupsInFileOrder) {
+    std::string content;
+    const size_t count = 4 * FilterEngine::MIN_LINES_PER_THREAD + 77;
+    for (size_t i = 0; i < count; ++i) {
+        content += i % 3 == 0 ? "GET /a " + std::to_string(i % 500) + "ms GET\n" : "idle\n";
+    }
+    write(content);
+    ASSERT_TRUE(filter_.setPattern("GET (\\S+) (\\d+)ms"));
+    GroupSpec by_path = spec("$1 $2");
+
+    auto one = filter_.scanLines(reader_, 0, count, &by_path, 1);
+    auto four = filter_.scanLines(reader_, 0, count, &by_path, 4);
+    ASSERT_EQ(one.lines.size(), (count + 2) / 3);
+    EXPECT_EQ(four.lines, one.lines);
+    EXPECT_EQ(four.spans, one.spans);
+    EXPECT_EQ(four.first_span, one.first_span);
+
+    // Spans are those findMatches() reports for the same line
+    for (size_t match : {size_t{0}, four.lines.size() / 2, four.lines.size() - 1}) {
+        std::vector<MatchSpan> spans;
+        ASSERT_TRUE(filter_.findMatches(reader_.getLine(four.lines[match]), spans));
+        auto scanned = four.spansOf(match);
+        EXPECT_EQ(std::vector<MatchSpan>(scanned.begin(), scanned.end()), spans);
+    }
+
+    GroupTable grouped;
+    filter_.groupLines(reader_, 0, count, by_path, grouped, 1);
+    ASSERT_NE(four.groups.find("/a"), nullptr);
+    EXPECT_EQ(four.groups.find("/a")->count, grouped.find("/a")->count);
+    EXPECT_DOUBLE_EQ(four.groups.find("/a")->sum, grouped.find("/a")->sum);
+
+    // Without a spec nothing is grouped; sub-ranges report absolute indices
+    auto window = filter_.scanLines(reader_, 10, 20);
+    EXPECT_EQ(window.lines, (std::vector<size_t>{12, 15, 18}));
+    EXPECT_TRUE(window.groups.empty());
+}
@@ -0,0 +1,122 @@
+#include <gtest/gtest.h>
+#include "../src/highlight_cache.hpp"
+#include "temp_log_file.hpp"
+#include <chrono>
+#include <thread>
+
+class HighlightCacheTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        std::string content;
+        for (int i = 0; i < 100; ++i) {
+            content += "[2025-11-30 14:00:00] INFO: request " + std::to_string(i) +
+                       R"( {"status": "ok", "id": )" + std::to_string(i) + "}\n";
+        }
+        log_.write(content);
+
+        reader_ = std::make_shared<LogReader>();
+        ASSERT_TRUE(reader_->open(log_.path()));
+        highlighter_ = std::make_shared<SyntaxHighlighter>();
+    }
+
+    TempLogFile log_{"highlight_cache_test.log"};
+    std::shared_ptr<LogReader> reader_;
+    std::shared_ptr<SyntaxHighlighter> highlighter_;
+};
+
+TEST_F(HighlightCacheTest, GetMatchesTokenize) {
+    HighlightCache cache(reader_, highlighter_);
+
+    std::vector<SyntaxHighlighter::Token> expected;
+    highlighter_->tokenize(reader_->getLine(7), expected);
+
+    auto tokens = cache.get(7);
+    ASSERT_NE(tokens, nullptr);
+    EXPECT_EQ(*tokens, expected);
+    EXPECT_EQ(cache.get(7), tokens);  // Second call is a hit
+}
+
+TEST_F(HighlightCacheTest, FindDoesNotTokenize) {
+    HighlightCache cache(reader_, highlighter_);
+    EXPECT_EQ(cache.find(3), nullptr);
+    cache.get(3);
+    EXPECT_NE(cache.find(3), nullptr);
+}
+
+TEST_F(HighlightCacheTest, EvictsLeastRecentlyUsed) {
+    HighlightCache cache(reader_, highlighter_, 3);
+    cache.get(0);
+    cache.get(1);
+    cache.get(2);
+    cache.get(0);  // 1 is now the least recently used
+    cache.get(3);
+
+    EXPECT_EQ(cache.size(), 3u);
+    EXPECT_EQ(cache.find(1), nullptr);
+    EXPECT_NE(cache.find(0), nullptr);
+    EXPECT_NE(cache.find(3), nullptr);
+}
+
+TEST_F(HighlightCacheTest, PrefetchTokenizesInBackground) {
+    HighlightCache cache(reader_, highlighter_);
+    cache.prefetch({10, 11, 12});
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (cache.size() < 3 && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    EXPECT_NE(cache.find(10), nullptr);
+    EXPECT_NE(cache.find(11), nullptr);
+    EXPECT_NE(cache.find(12), nullptr);
+}
+
+TEST_F(HighlightCacheTest, InvalidateClearsEntries) {
+    HighlightCache cache(reader_, highlighter_);
+    cache.get(1);
+    cache.get(2);
+    cache.invalidate();
+    EXPECT_EQ(cache.size(), 0u);
+    EXPECT_EQ(cache.find(1), nullptr);
+}
+
+TEST_F(HighlightCacheTest, LongLinesAreCheckpointed) {
+    HighlightCache cache(reader_, highlighter_);
+
+    std::vector<uint32_t> expected;
+    highlighter_->buildCheckpoints(reader_->getLine(5), expected);
+
+    auto checkpoints = cache.checkpoints(5);
+    ASSERT_NE(checkpoints, nullptr);
+    EXPECT_EQ(*checkpoints, expected);
+    EXPECT_EQ(cache.checkpoints(5), checkpoints);  // Second call is a hit
+    EXPECT_EQ(cache.find(5), nullptr);             // No full token list was built
+}
+
+TEST_F(HighlightCacheTest, TracksAndLimitsMemory) {
+    HighlightCache cache(reader_, highlighter_);
+    EXPECT_EQ(cache.memoryUsage(), 0u);
+    for (size_t i = 0; i < 20; ++i) {
+        cache.get(i);
+    }
+    size_t full = cache.memoryUsage();
+    EXPECT_GT(full, 0u);
+
+    // Shrinking evicts the least recently used lines at once
+    cache.setMemoryLimit(full / 2);
+    EXPECT_LE(cache.memoryUsage(), full / 2);
+    EXPECT_LT(cache.size(), 20u);
+    EXPECT_NE(cache.find(19), nullptr);
+    EXPECT_EQ(cache.find(0), nullptr);
+
+    // With no room at all lines are still tokenized, just not kept
+    cache.setMemoryLimit(0);
+    EXPECT_EQ(cache.size(), 0u);
+    auto tokens = cache.get(5);
+    ASSERT_NE(tokens, nullptr);
+    EXPECT_FALSE(tokens->empty());
+    EXPECT_EQ(cache.memoryUsage(), 0u);
+
+    cache.invalidate();
+    EXPECT_EQ(cache.memoryUsage(), 0u);
+}
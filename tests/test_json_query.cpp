@@ -0,0 +1,169 @@
+#include <gtest/gtest.h>
+#include "../src/json_query.hpp"
+#include <algorithm>
+#include <string>
+#include <string_view>
+
+class JsonQueryTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        request_line_ = R"([2025-11-30 14:00:00] INFO: API Request received: {"method": "POST", "endpoint": "/api/users", "body": {"name": "John Doe", "email": "john@example.com", "age": 30}})";
+        created_line_ = R"([2025-11-30 14:00:02] INFO: User created successfully: {"id": 12345, "name": "John Doe", "created_at": "2025-11-30T14:00:02Z", "status": "active"})";
+        plain_line_ = "[2025-11-30 14:00:10] ERROR: JSON parse error at line 5";
+    }
+
+    std::string request_line_;
+    std::string created_line_;
+    std::string plain_line_;
+};
+
+TEST_F(JsonQueryTest, FindTopLevelField) {
+    auto json = JsonScanner::payload(request_line_);
+    auto value = JsonScanner::find(json, {"endpoint"});
+    EXPECT_EQ(value.type, JsonScanner::ValueType::String);
+    EXPECT_EQ(value.raw, "/api/users");
+}
+
+TEST_F(JsonQueryTest, FindNestedField) {
+    auto json = JsonScanner::payload(request_line_);
+    auto value = JsonScanner::find(json, {"body", "age"});
+    EXPECT_EQ(value.type, JsonScanner::ValueType::Number);
+    EXPECT_EQ(value.raw, "30");
+}
+
+TEST_F(JsonQueryTest, FindMissingField) {
+    auto json = JsonScanner::payload(request_line_);
+    EXPECT_EQ(JsonScanner::find(json, {"age"}).type, JsonScanner::ValueType::None);
+    EXPECT_EQ(JsonScanner::find(json, {"body", "phone"}).type, JsonScanner::ValueType::None);
+}
+
+TEST_F(JsonQueryTest, SkipsNestedContainersAndEscapes) {
+    std::string line = R"({"a": {"x": [1, {"y": "}]"}], "z": "q\"}"}, "b": true})";
+    auto value = JsonScanner::find(line, {"b"});
+    EXPECT_EQ(value.type, JsonScanner::ValueType::True);
+}
+
+TEST_F(JsonQueryTest, SkipsLongStrings) {
+    std::string line = "{\"payload\": \"" + std::string(1000, 'x') + "\", \"level\": 3}";
+    auto value = JsonScanner::find(line, {"level"});
+    EXPECT_EQ(value.type, JsonScanner::ValueType::Number);
+    EXPECT_EQ(value.raw, "3");
+}
+
+TEST_F(JsonQueryTest, UnterminatedStringsAreNoValue) {
+    EXPECT_EQ(JsonScanner::find(R"({"a": "abc)", {"a"}).type, JsonScanner::ValueType::None);
+
+    // A view ending in a backslash inside a string: the quote after it is
+    // outside the view and must not be seen
+    std::string buffer = R"({"a": "x\"})";
+    std::string_view json(buffer.data(), buffer.find('\\') + 1);
+    EXPECT_EQ(JsonScanner::find(json, {"a"}).type, JsonScanner::ValueType::None);
+
+    auto value = JsonScanner::find(R"({"a": "x\"y", "b": 1})", {"a"});
+    EXPECT_EQ(value.type, JsonScanner::ValueType::String);
+    EXPECT_EQ(value.raw, R"(x\"y)");
+}
+
+TEST_F(JsonQueryTest, PayloadSkipsBracesInPlainText) {
+    EXPECT_EQ(JsonScanner::payload(R"(INFO ctx={id=42, user=bob} {"status": 500})"), R"({"status": 500})");
+    EXPECT_EQ(JsonScanner::payload("INFO msg={} done"), "{} done");
+    EXPECT_EQ(JsonScanner::payload(R"(INFO { "spaced": 1 })"), R"({ "spaced": 1 })");
+    EXPECT_TRUE(JsonScanner::payload("WARN state={x=1}").empty());
+
+    JsonQuery query;
+    ASSERT_TRUE(query.compile("status >= 500"));
+    EXPECT_TRUE(query.matches(R"(INFO ctx={id=42} {"status": 503})"));
+}
+
+TEST_F(JsonQueryTest, QueryTriesEveryObjectInTheLine) {
+    std::string_view line = R"(INFO msg={} {"status": 500, "ctx": {"id": 7}} {"id": 9})";
+    auto json = JsonScanner::payload(line);
+    EXPECT_EQ(json, line.substr(9));
+    json = JsonScanner::nextPayload(line, json);
+    EXPECT_EQ(json, line.substr(12));
+    json = JsonScanner::nextPayload(line, json);  // Past the nested {"id": 7}
+    EXPECT_EQ(json, R"({"id": 9})");
+    EXPECT_TRUE(JsonScanner::nextPayload(line, json).empty());
+
+    EXPECT_EQ(JsonScanner::findInLine(line, {"status"}).raw, "500");
+    EXPECT_EQ(JsonScanner::findInLine(line, {"id"}).raw, "9");
+    EXPECT_EQ(JsonScanner::findInLine(line, {"missing"}).type, JsonScanner::ValueType::None);
+
+    JsonQuery query;
+    ASSERT_TRUE(query.compile("status == 500"));
+    EXPECT_TRUE(query.matches(line));
+    ASSERT_TRUE(query.compile("id == 7"));
+    EXPECT_FALSE(query.matches(line));  // Only inside ctx, not a top-level object
+}
+
+TEST_F(JsonQueryTest, StringEquality) {
+    JsonQuery query;
+    ASSERT_TRUE(query.compile(R"(endpoint == "/api/users")"));
+    EXPECT_TRUE(query.matches(request_line_));
+    EXPECT_FALSE(query.matches(created_line_));
+}
+
+TEST_F(JsonQueryTest, NumericComparison) {
+    JsonQuery query;
+    ASSERT_TRUE(query.compile("body.age > 25"));
+    EXPECT_TRUE(query.matches(request_line_));
+
+    ASSERT_TRUE(query.compile("body.age >= 31"));
+    EXPECT_FALSE(query.matches(request_line_));
+}
+
+TEST_F(JsonQueryTest, LogicalOperators) {
+    JsonQuery query;
+    ASSERT_TRUE(query.compile(R"(endpoint == "/api/users" && body.age > 25)"));
+    EXPECT_TRUE(query.matches(request_line_));
+    EXPECT_FALSE(query.matches(created_line_));
+
+    ASSERT_TRUE(query.compile(R"(status == "active" || method == "POST")"));
+    EXPECT_TRUE(query.matches(request_line_));
+    EXPECT_TRUE(query.matches(created_line_));
+
+    ASSERT_TRUE(query.compile(R"(!(status == "active"))"));
+    EXPECT_TRUE(query.matches(request_line_));
+    EXPECT_FALSE(query.matches(created_line_));
+}
+
+TEST_F(JsonQueryTest, FieldExistence) {
+    JsonQuery query;
+    ASSERT_TRUE(query.compile("created_at"));
+    EXPECT_FALSE(query.matches(request_line_));
+    EXPECT_TRUE(query.matches(created_line_));
+}
+
+TEST_F(JsonQueryTest, LinesWithoutJsonNeverMatch) {
+    JsonQuery query;
+    ASSERT_TRUE(query.compile("id != 1"));
+    EXPECT_FALSE(query.matches(plain_line_));
+}
+
+TEST_F(JsonQueryTest, EscapedStringComparison) {
+    JsonQuery query;
+    ASSERT_TRUE(query.compile(R"(path == "C:\\logs")"));
+    EXPECT_TRUE(query.matches(R"({"path": "C:\\logs"})"));
+    EXPECT_FALSE(query.matches(R"({"path": "C:/logs"})"));
+}
+
+TEST_F(JsonQueryTest, RequiredLiteralsPrefilter) {
+    JsonQuery query;
+    ASSERT_TRUE(query.compile(R"(endpoint == "/api/users" && body.age > 25)"));
+    const auto& literals = query.requiredLiterals();
+    EXPECT_NE(std::find(literals.begin(), literals.end(), "\"endpoint\""), literals.end());
+    EXPECT_NE(std::find(literals.begin(), literals.end(), "\"age\""), literals.end());
+
+    // Keys that only one side of an OR needs are not required
+    ASSERT_TRUE(query.compile(R"(status == "active" || method == "POST")"));
+    EXPECT_TRUE(query.requiredLiterals().empty());
+}
+
+TEST_F(JsonQueryTest, InvalidExpressions) {
+    JsonQuery query;
+    EXPECT_FALSE(query.compile(R"(endpoint == )"));
+    EXPECT_FALSE(query.getError().empty());
+    EXPECT_FALSE(query.compile(R"((age > 1)"));
+    EXPECT_FALSE(query.compile(R"(name == "unterminated)"));
+    EXPECT_FALSE(query.isValid());
+}
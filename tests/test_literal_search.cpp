@@ -0,0 +1,58 @@
+#include <gtest/gtest.h>
+#include "../src/literal_search.hpp"
+#include <random>
+
+TEST(LiteralSearchTest, FindsFirstOccurrence) {
+    LiteralSearcher searcher("ERROR");
+    std::string_view text = "INFO ok\nERROR first\nWARN x\nERROR second\n";
+
+    EXPECT_EQ(searcher.find(text), text.find("ERROR"));
+    EXPECT_EQ(searcher.find(text, 9), text.find("ERROR", 9));
+    EXPECT_EQ(searcher.find(text, text.size()), LiteralSearcher::npos);
+}
+
+TEST(LiteralSearchTest, FindsLastOccurrenceBefore) {
+    LiteralSearcher searcher("ERROR");
+    std::string_view text = "INFO ok\nERROR first\nWARN x\nERROR second\n";
+    size_t second = text.rfind("ERROR");
+
+    EXPECT_EQ(searcher.rfind(text), second);
+    EXPECT_EQ(searcher.rfind(text, second), text.find("ERROR"));
+    EXPECT_EQ(searcher.rfind(text, text.find("ERROR")), LiteralSearcher::npos);
+}
+
+TEST(LiteralSearchTest, NeedleLongerThanHaystack) {
+    LiteralSearcher searcher("a much longer needle than the text");
+    EXPECT_EQ(searcher.find("short"), LiteralSearcher::npos);
+    EXPECT_EQ(searcher.rfind("short"), LiteralSearcher::npos);
+}
+
+// Positions around the 16/32-byte blocks and the scalar tail must agree
+// with std::string_view for every needle length
+TEST(LiteralSearchTest, MatchesStringViewOnRandomInput) {
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<int> letter('a', 'c');  // Small alphabet: many partial matches
+
+    for (int round = 0; round < 300; ++round) {
+        std::string haystack(rng() % 200, ' ');
+        for (auto& c : haystack) {
+            c = static_cast<char>(letter(rng));
+        }
+        std::string needle(1 + rng() % 6, ' ');
+        for (auto& c : needle) {
+            c = static_cast<char>(letter(rng));
+        }
+
+        LiteralSearcher searcher(needle);
+        std::string_view view = haystack;
+        for (size_t from = 0; from <= haystack.size() + 1; from += 1 + rng() % 7) {
+            ASSERT_EQ(searcher.find(view, from), view.find(needle, from))
+                << "needle=" << needle << " from=" << from << " haystack=" << haystack;
+
+            // rfind(before) is the last start < before
+            size_t expected = from == 0 ? std::string_view::npos : view.rfind(needle, from - 1);
+            ASSERT_EQ(searcher.rfind(view, from), expected)
+                << "needle=" << needle << " before=" << from << " haystack=" << haystack;
+        }
+    }
+}
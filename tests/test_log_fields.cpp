@@ -0,0 +1,128 @@
+#include <gtest/gtest.h>
+#include "../src/log_fields.hpp"
+#include "temp_log_file.hpp"
+
+TEST(LogFieldsTest, ParsesBracketedTimestampAndLevel) {
+    std::string_view line = "[2025-11-30 14:00:00.123] ERROR: disk full";
+    LineFields fields = parseLineFields(line);
+    EXPECT_EQ(fields.level, LogLevel::Error);
+    EXPECT_EQ(line.substr(fields.message), "disk full");
+    EXPECT_EQ(formatTimestamp(fields.timestamp), "2025-11-30 14:00:00.123");
+
+    char buffer[TIMESTAMP_BUFFER_SIZE];
+    size_t length = formatTimestamp(fields.timestamp, buffer);
+    EXPECT_EQ(std::string_view(buffer, length), "2025-11-30 14:00:00.123");
+    EXPECT_EQ(formatTimestamp(LineFields::NO_TIMESTAMP, buffer), 0u);
+}
+
+TEST(LogFieldsTest, ParsesIsoTimestampsWithOffsets) {
+    LineFields utc = parseLineFields("2025-11-30T14:00:00Z [warn] slow");
+    LineFields plus_two = parseLineFields("2025-11-30T16:00:00.5+02:00 INFO start");
+    EXPECT_EQ(utc.level, LogLevel::Warn);
+    EXPECT_EQ(plus_two.level, LogLevel::Info);
+    EXPECT_EQ(plus_two.timestamp - utc.timestamp, 500000);  // Microseconds
+    EXPECT_EQ(formatTimestamp(utc.timestamp), "2025-11-30 14:00:00.000");
+
+    // 1970-01-01 is the epoch; dates before it are negative
+    EXPECT_EQ(parseLineFields("1970-01-01 00:00:01 x").timestamp, 1000000);
+    EXPECT_EQ(formatTimestamp(parseLineFields("1969-12-31 23:59:59.250 x").timestamp),
+              "1969-12-31 23:59:59.250");
+}
+
+TEST(LogFieldsTest, MissingFields) {
+    std::string_view no_timestamp = "WARNING: low memory";
+    LineFields fields = parseLineFields(no_timestamp);
+    EXPECT_EQ(fields.timestamp, LineFields::NO_TIMESTAMP);
+    EXPECT_EQ(fields.level, LogLevel::Warn);
+    EXPECT_EQ(no_timestamp.substr(fields.message), "low memory");
+
+    std::string_view no_level = "[2025-01-01 00:00:00] INFORMATION follows";
+    fields = parseLineFields(no_level);
+    EXPECT_NE(fields.timestamp, LineFields::NO_TIMESTAMP);
+    EXPECT_EQ(fields.level, LogLevel::None);
+    EXPECT_EQ(no_level.substr(fields.message), "INFORMATION follows");
+
+    fields = parseLineFields("    at com.example.Main.run(Main.java:42)");
+    EXPECT_EQ(fields.timestamp, LineFields::NO_TIMESTAMP);
+    EXPECT_EQ(fields.level, LogLevel::None);
+    EXPECT_EQ(fields.message, 0u);
+
+    EXPECT_EQ(parseLineFields("2025-13-01 00:00:00 bad month").timestamp, LineFields::NO_TIMESTAMP);
+    EXPECT_EQ(parseLineFields("[2025-01-01").timestamp, LineFields::NO_TIMESTAMP);
+}
+
+class LogFieldsFileTest : public ::testing::Test {
+protected:
+    void write(const std::string& content) {
+        ASSERT_TRUE(log_.writeAndOpen(reader_, content));
+    }
+
+    static std::vector<size_t> lines(const RowView& view) {
+        std::vector<size_t> result;
+        for (size_t row = 0; row < view.size(); ++row) {
+            result.push_back(view.select(row));
+        }
+        return result;
+    }
+
+    TempLogFile log_{"log_fields_test.log"};
+    LogReader reader_;
+};
+
+TEST_F(LogFieldsFileTest, SortsByTimestampAndLevel) {
+    write("[2025-01-01 00:00:03] INFO: c\n"
+          "[2025-01-01 00:00:01] ERROR: a\n"
+          "continuation without fields\n"
+          "[2025-01-01 00:00:02] DEBUG: b\n"
+          "[2025-01-01 00:00:01] WARN: a2\n");
+    auto all = RowView::identity(reader_.getLineCount());
+
+    // Equal timestamps keep file order; lines without one go last
+    auto by_time = sortRows(reader_, all, SortField::Timestamp, false);
+    EXPECT_FALSE(by_time.inFileOrder());
+    EXPECT_EQ(lines(by_time), (std::vector<size_t>{1, 4, 3, 0, 2}));
+
+    auto newest_first = sortRows(reader_, all, SortField::Timestamp, true);
+    EXPECT_EQ(lines(newest_first), (std::vector<size_t>{0, 3, 1, 4, 2}));
+
+    auto by_level = sortRows(reader_, all, SortField::Level, true);
+    EXPECT_EQ(lines(by_level), (std::vector<size_t>{1, 4, 0, 3, 2}));
+
+    // Back to file order gives the identity again, or a match set
+    EXPECT_TRUE(sortRows(reader_, by_time, SortField::Line, false).isIdentity());
+    auto subset = sortRows(reader_, RowView::fromOrder({3, 0, 1}), SortField::Line, false);
+    EXPECT_TRUE(subset.inFileOrder());
+    EXPECT_EQ(lines(subset), (std::vector<size_t>{0, 1, 3}));
+}
+
+TEST_F(LogFieldsFileTest, ParallelSortMatchesSingleThread) {
+    // Enough rows for several workers; timestamps repeat so ties matter
+    std::string content;
+    const size_t count = 3 * MIN_ROWS_PER_THREAD + 17;
+    for (size_t i = 0; i < count; ++i) {
+        size_t second = (i * 7919) % 3600;
+        char line[64];
+        std::snprintf(line, sizeof(line), "[2025-01-01 %02zu:%02zu:%02zu] INFO: %zu\n",
+                      second / 3600, second / 60 % 60, second % 60, i);
+        content += line;
+    }
+    write(content);
+    auto all = RowView::identity(reader_.getLineCount());
+
+    FieldColumns serial;
+    FieldColumns parallel;
+    serial.extract(reader_, all, 1);
+    parallel.extract(reader_, all, 4);
+    EXPECT_EQ(serial.timestamps, parallel.timestamps);
+    EXPECT_EQ(serial.messages, parallel.messages);
+
+    auto one = lines(sortRows(reader_, all, SortField::Timestamp, false, 1));
+    auto four = lines(sortRows(reader_, all, SortField::Timestamp, false, 4));
+    auto three = lines(sortRows(reader_, all, SortField::Timestamp, false, 3));
+    EXPECT_EQ(one, four);
+    EXPECT_EQ(one, three);
+    ASSERT_EQ(one.size(), count);
+    for (size_t i = 1; i < one.size(); ++i) {
+        ASSERT_LE(serial.timestamps[one[i - 1]], serial.timestamps[one[i]]);
+    }
+}
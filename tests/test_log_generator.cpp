@@ -0,0 +1,113 @@
+#include <gtest/gtest.h>
+#include "../src/log_generator.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <string>
+
+class LogGeneratorTest : public ::testing::Test {
+protected:
+    // Generate into a temporary file and return its contents
+    static std::string generate(const GeneratorOptions& options, GeneratorResult& result) {
+        std::FILE* out = std::tmpfile();
+        EXPECT_NE(out, nullptr);
+        std::string error;
+        EXPECT_TRUE(LogGenerator(options).write(fileno(out), result, error)) << error;
+
+        std::string content;
+        std::rewind(out);
+        char buffer[65536];
+        size_t n;
+        while ((n = std::fread(buffer, 1, sizeof(buffer), out)) > 0) {
+            content.append(buffer, n);
+        }
+        std::fclose(out);
+        return content;
+    }
+
+    static GeneratorOptions smallOptions() {
+        GeneratorOptions options;
+        options.size = 3 * 1024 * 1024;
+        options.format = LogFormat::Generic;
+        options.seed = 7;
+        return options;
+    }
+};
+
+TEST_F(LogGeneratorTest, StopsAtTheFirstLineEndPastTheSize) {
+    GeneratorOptions options = smallOptions();
+    GeneratorResult result;
+    std::string content = generate(options, result);
+
+    EXPECT_EQ(content.size(), result.bytes);
+    EXPECT_GE(content.size(), options.size);
+    EXPECT_EQ(content.back(), '\n');
+    EXPECT_EQ(content.rfind('\n', content.size() - 2) < options.size, true);
+    EXPECT_EQ(static_cast<uint64_t>(std::count(content.begin(), content.end(), '\n')), result.lines);
+}
+
+TEST_F(LogGeneratorTest, SameOutputForAnyThreadCount) {
+    GeneratorOptions options = smallOptions();
+    options.threads = 1;
+    GeneratorResult single;
+    std::string expected = generate(options, single);
+
+    options.threads = 4;
+    GeneratorResult parallel;
+    EXPECT_EQ(generate(options, parallel), expected);
+
+    options.seed = 8;
+    EXPECT_NE(generate(options, parallel), expected);
+}
+
+TEST_F(LogGeneratorTest, ReportsNeedlePositions) {
+    GeneratorOptions options = smallOptions();
+    options.needle_every = 5000;
+    options.needle = "NEEDLE";
+    GeneratorResult result;
+    std::string content = generate(options, result);
+
+    ASSERT_EQ(result.needles.size(), result.lines / 5000);
+    for (size_t i = 0; i < result.needles.size(); ++i) {
+        const NeedleLine& needle = result.needles[i];
+        EXPECT_EQ(needle.line, (i + 1) * 5000 - 1);
+        size_t end = content.find('\n', needle.offset);
+        std::string line = content.substr(needle.offset, end - needle.offset);
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        std::string tag = "NEEDLE#" + std::to_string(i + 1);
+        EXPECT_EQ(line.substr(line.size() - tag.size()), tag);
+    }
+    EXPECT_EQ(content.find("NEEDLE#" + std::to_string(result.needles.size() + 1)), std::string::npos);
+}
+
+TEST_F(LogGeneratorTest, ProducesCrlfAndLongLines) {
+    GeneratorOptions options = smallOptions();
+    options.format = LogFormat::JsonLines;
+    options.crlf_ratio = 1.0;
+    options.long_line_ratio = 0.01;
+    options.long_line_bytes = 64 * 1024;
+    GeneratorResult result;
+    std::string content = generate(options, result);
+
+    size_t long_lines = 0;
+    size_t start = 0;
+    for (size_t end; (end = content.find('\n', start)) != std::string::npos; start = end + 1) {
+        ASSERT_GT(end, start);
+        EXPECT_EQ(content[end - 1], '\r');
+        long_lines += end - start > options.long_line_bytes;
+    }
+    EXPECT_GT(long_lines, 0u);
+}
+
+TEST_F(LogGeneratorTest, FollowsTheLevelMix) {
+    GeneratorOptions options = smallOptions();
+    options.format = LogFormat::PlainText;
+    options.level_weights = {0, 0, 0, 1};
+    GeneratorResult result;
+    std::string content = generate(options, result);
+
+    EXPECT_EQ(content.find("] INFO: "), std::string::npos);
+    EXPECT_NE(content.find("] ERROR: "), std::string::npos);
+    EXPECT_EQ(content.compare(0, 26, "[2025-01-01 00:00:00.000] "), 0);
+}
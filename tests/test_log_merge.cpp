@@ -0,0 +1,163 @@
+#include <gtest/gtest.h>
+#include "../src/log_merge.hpp"
+#include "../src/log_fields.hpp"
+#include "../src/log_reader.hpp"
+#include "../src/batch_mode.hpp"
+#include "../src/range_export.hpp"
+#include "../src/search_engine.hpp"
+#include "temp_log_file.hpp"
+#include <cstdio>
+#include <filesystem>
+
+class LogMergeTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        api_.write("2025-01-01 10:00:00 INFO api started\n"
+                   "2025-01-01 10:00:02 ERROR api timeout\n"
+                   "  at handler.cpp:42\n"
+                   "2025-01-01 10:00:04 INFO api ok\n");
+        db_.write("2025-01-01 10:00:01 INFO db ready\n"
+                  "2025-01-01 10:00:02 WARN db slow query\r\n"
+                  "2025-01-01 10:00:05 INFO db done");  // No trailing newline
+    }
+
+    // Everything written to a temporary file by `write_to`
+    template <typename Write>
+    static std::string capture(const Write& write_to) {
+        std::FILE* out = std::tmpfile();
+        EXPECT_NE(out, nullptr);
+        write_to(fileno(out));
+
+        std::string result;
+        std::rewind(out);
+        char buffer[4096];
+        size_t n;
+        while ((n = std::fread(buffer, 1, sizeof(buffer), out)) > 0) {
+            result.append(buffer, n);
+        }
+        std::fclose(out);
+        return result;
+    }
+
+    TempLogFile api_{"merge_api.log"};
+    TempLogFile db_{"merge_db.log"};
+};
+
+TEST_F(LogMergeTest, MergeByKeyInterleavesAndKeepsSourceOrder) {
+    std::vector<std::vector<int64_t>> keys = {
+        {1, 3, 2, 7},  // Goes back in time: still read in order
+        {2, 3, 8},
+        {},
+    };
+    auto merged = mergeByKey(keys);
+
+    std::vector<std::pair<size_t, size_t>> order;
+    for (uint64_t entry : merged) {
+        LineSource from = unpackLineSource(entry);
+        order.emplace_back(from.source, from.line);
+    }
+    std::vector<std::pair<size_t, size_t>> expected = {
+        {0, 0}, {1, 0}, {0, 1}, {0, 2}, {1, 1}, {0, 3}, {1, 2}};
+    EXPECT_EQ(order, expected);
+}
+
+TEST_F(LogMergeTest, LinesWithoutTimestampFollowTheirMessage) {
+    TempLogFile trace("merge_trace.log");
+    LogReader reader;
+    ASSERT_TRUE(trace.writeAndOpen(reader,
+                                   "preamble\n"
+                                   "2025-01-01 10:00:00 ERROR boom\n"
+                                   "  at main.cpp:1\n"));
+
+    auto keys = mergeKeys(reader);
+    ASSERT_EQ(keys.size(), 3u);
+    EXPECT_EQ(keys[0], LineFields::NO_TIMESTAMP);
+    EXPECT_NE(keys[1], LineFields::NO_TIMESTAMP);
+    EXPECT_EQ(keys[2], keys[1]);
+}
+
+TEST_F(LogMergeTest, SourceTagsUseFileStems) {
+    EXPECT_EQ(sourceTags({"/var/log/api.log", "db.log"}), (std::vector<std::string>{"api", "db"}));
+    EXPECT_EQ(sourceTags({"a/app.log", "b/app.txt", "worker.log"}),
+              (std::vector<std::string>{"app.log", "app.txt", "worker"}));
+    EXPECT_EQ(sourceTags({"a/api.log", "b/api.log", "db.log"}),
+              (std::vector<std::string>{"a/api.log", "b/api.log", "db"}));
+    EXPECT_EQ(sourceTags({"x/log/api.log", "y/log/api.log"}),
+              (std::vector<std::string>{"log/api.lo#1", "log/api.lo#2"}));
+    EXPECT_EQ(sourceTags({"a_very_long_service_name.log"}).front().size(), MAX_SOURCE_TAG);
+}
+
+TEST_F(LogMergeTest, ReaderShowsMergedLines) {
+    LogReader reader;
+    ASSERT_TRUE(reader.openMerged({api_.path(), db_.path()}, 2));
+    EXPECT_TRUE(reader.isMerged());
+    EXPECT_EQ(reader.getFilename(), api_.path() + ", " + db_.path());
+    EXPECT_EQ(reader.getSourceTags(), (std::vector<std::string>{"merge_api", "merge_db"}));
+    ASSERT_EQ(reader.getLineCount(), 7u);
+
+    EXPECT_EQ(reader.getLine(0), "2025-01-01 10:00:00 INFO api started");
+    EXPECT_EQ(reader.getLine(1), "2025-01-01 10:00:01 INFO db ready");
+    EXPECT_EQ(reader.getLine(2), "2025-01-01 10:00:02 ERROR api timeout");
+    EXPECT_EQ(reader.getLine(3), "  at handler.cpp:42");
+    EXPECT_EQ(reader.getLine(4), "2025-01-01 10:00:02 WARN db slow query");
+    EXPECT_EQ(reader.getLine(6), "2025-01-01 10:00:05 INFO db done");
+
+    LineSource from = reader.getLineSource(4);
+    EXPECT_EQ(from.source, 1u);
+    EXPECT_EQ(from.line, 1u);
+    EXPECT_EQ(reader.getRawLine(4), "2025-01-01 10:00:02 WARN db slow query\r\n");
+
+    // Offsets behave like one file of the merged lines
+    EXPECT_TRUE(reader.getData().empty());
+    EXPECT_EQ(reader.getDataSize(), std::filesystem::file_size(api_.path()) +
+                                    std::filesystem::file_size(db_.path()));
+    EXPECT_EQ(reader.lineAtOffset(reader.getLineOffset(3) + 2), 3u);
+    EXPECT_EQ(reader.getFileDescriptor(), -1);
+}
+
+TEST_F(LogMergeTest, SearchAndExportRunOverTheMergedView) {
+    auto reader = std::make_shared<LogReader>();
+    ASSERT_TRUE(reader->openMerged({api_.path(), db_.path()}));
+
+    SearchEngine search(reader);
+    ASSERT_TRUE(search.setPattern("db"));
+    ASSERT_TRUE(search.isLiteral());
+    auto step = search.scan(reader->getLineOffset(2), true, 1 << 20);
+    ASSERT_TRUE(step.hit.has_value());
+    EXPECT_EQ(step.hit->line, 4u);
+    EXPECT_EQ(step.hit->span.offset, 25u);
+
+    std::string exported = capture([&](int fd) {
+        uint64_t bytes = 0;
+        std::string error;
+        EXPECT_TRUE(exportRows(*reader, RowView::fromLines({4, 5, 6}), fd, bytes, error));
+    });
+    EXPECT_EQ(exported, "2025-01-01 10:00:02 WARN db slow query\r\n"
+                        "2025-01-01 10:00:04 INFO api ok\n"
+                        "2025-01-01 10:00:05 INFO db done\n");
+
+    std::string error;
+    EXPECT_EQ(openExportFile(db_.path(), *reader, error), -1);
+}
+
+TEST_F(LogMergeTest, BatchNumbersLinesByFile) {
+    LogReader reader;
+    ASSERT_TRUE(reader.openMerged({api_.path(), db_.path()}));
+
+    BatchOptions options;
+    options.pattern = "INFO";
+    options.line_numbers = true;
+    int status = -1;
+    std::string output = capture([&](int fd) {
+        FilterEngine filter;
+        std::string error;
+        status = runBatch(reader, filter, options, fd, error);
+    });
+    EXPECT_EQ(status, BATCH_MATCHED);
+    const std::string& api = api_.path();
+    const std::string& db = db_.path();
+    EXPECT_EQ(output, api + ":1:2025-01-01 10:00:00 INFO api started\n" +
+                      db + ":1:2025-01-01 10:00:01 INFO db ready\n" +
+                      api + ":4:2025-01-01 10:00:04 INFO api ok\n" +
+                      db + ":3:2025-01-01 10:00:05 INFO db done\n");
+}
@@ -76,6 +76,15 @@ TEST_F(LogReaderTest, GetFileSize) {
     EXPECT_EQ(reader.getFileSize(), expected_size);
 }
 
+TEST_F(LogReaderTest, IndexStats) {
+    LogReader reader;
+    ASSERT_TRUE(reader.open(test_file_));
+
+    EXPECT_EQ(reader.getIndexRate().bytes, reader.getFileSize());
+    EXPECT_EQ(reader.getIndexRate().lines, 5u);
+    EXPECT_GE(reader.getIndexMemory(), 5 * sizeof(size_t));
+}
+
 TEST_F(LogReaderTest, CloseFile) {
     LogReader reader;
     ASSERT_TRUE(reader.open(test_file_));
@@ -0,0 +1,130 @@
+#include <gtest/gtest.h>
+#include "../src/log_templates.hpp"
+#include "temp_log_file.hpp"
+
+class LogTemplatesTest : public ::testing::Test {
+protected:
+    void write(const std::string& content) {
+        ASSERT_TRUE(log_.writeAndOpen(reader_, content));
+    }
+
+    static std::vector<std::string> texts(const std::vector<LogTemplate>& templates) {
+        std::vector<std::string> result;
+        for (const auto& log_template : templates) {
+            result.push_back(std::to_string(log_template.count) + " " + log_template.text());
+        }
+        return result;
+    }
+
+    TempLogFile log_{"log_templates_test.log"};
+    LogReader reader_;
+    SyntaxHighlighter highlighter_;
+};
+
+TEST_F(LogTemplatesTest, MasksNumbersAddressesAndIds) {
+    TemplateMiner miner(highlighter_);
+    std::string buffer;
+    std::vector<SyntaxHighlighter::Token> tokens;
+    std::vector<std::string_view> words;
+    miner.maskLine("user 42 from 10.0.0.1 id=0x1f3a req a3f9c2e1 took 45ms, user7 ok",
+                   buffer, tokens, words);
+
+    std::vector<std::string_view> expected = {"user", "<*>", "from", "<*>", "id=<*>", "req", "<*>",
+                                              "took", "<*>,", "user7", "ok"};
+    EXPECT_EQ(words, expected);
+}
+
+TEST_F(LogTemplatesTest, ClustersSimilarLines) {
+    TemplateMiner miner(highlighter_);
+    miner.add("session opened for user alice by admin");
+    miner.add("session opened for user bob by admin");
+    miner.add("Connection 17 closed");
+    miner.add("session opened for user carol by admin");
+    miner.add("Connection 3 closed");
+    miner.add("disk /dev/sda1 is full");
+    miner.add("");
+
+    EXPECT_EQ(miner.lineCount(), 7u);
+    EXPECT_GT(miner.memoryUsage(), 0u);
+    EXPECT_EQ(texts(miner.templates()), (std::vector<std::string>{
+        "3 session opened for user <*> by admin",
+        "2 Connection <*> closed",
+        "1 disk /dev/sda1 is full",
+        "1 ",
+    }));
+
+    // Lines with a different word count never share a template
+    miner.add("session opened for user dave");
+    EXPECT_EQ(miner.size(), 5u);
+}
+
+TEST_F(LogTemplatesTest, MergedMinersMatchOneMiner) {
+    const char* lines[] = {
+        "GET /api/users 200 12ms", "GET /api/orders 200 8ms", "worker 3 started",
+        "GET /api/users 500 30ms", "worker 9 started", "cache miss for key user:1",
+    };
+    TemplateMiner whole(highlighter_);
+    TemplateMiner first(highlighter_);
+    TemplateMiner second(highlighter_);
+    for (size_t i = 0; i < std::size(lines); ++i) {
+        whole.add(lines[i]);
+        (i < 3 ? first : second).add(lines[i]);
+    }
+    first.merge(second);
+    EXPECT_EQ(texts(first.templates()), texts(whole.templates()));
+    EXPECT_EQ(first.lineCount(), whole.lineCount());
+}
+
+TEST_F(LogTemplatesTest, ParallelMiningAndDrillDown) {
+    std::string content;
+    const size_t count = 4 * MIN_TEMPLATE_ROWS_PER_THREAD + 11;
+    for (size_t i = 0; i < count; ++i) {
+        if (i % 1000 == 999) {
+            content += "ERROR checksum mismatch in block " + std::to_string(i) + "\n";
+        } else if (i % 2 == 0) {
+            content += "INFO request " + std::to_string(i) + " served in " + std::to_string(i % 97) + "ms\n";
+        } else {
+            content += "DEBUG cache hit for 10.0." + std::to_string(i % 200) + ".1\n";
+        }
+    }
+    write(content);
+    auto all = RowView::identity(reader_.getLineCount());
+
+    auto one = mineTemplates(reader_, all, highlighter_, 1);
+    auto four = mineTemplates(reader_, all, highlighter_, 4);
+    EXPECT_EQ(texts(one), texts(four));
+    ASSERT_EQ(one.size(), 3u);
+    EXPECT_EQ(one.back().text(), "ERROR checksum mismatch in block <*>");
+    EXPECT_EQ(one.back().count, count / 1000);
+
+    // The rare template's lines, in the order of the rows given
+    auto rare = templateRows(reader_, all, highlighter_, one.back(), 4);
+    ASSERT_EQ(rare.size(), count / 1000);
+    EXPECT_EQ(rare.select(0), 999u);
+    EXPECT_TRUE(rare.inFileOrder());
+
+    auto reversed = templateRows(reader_, RowView::fromOrder({2999, 5, 999}), highlighter_, one.back());
+    ASSERT_EQ(reversed.size(), 2u);
+    EXPECT_EQ(reversed.select(0), 2999u);
+    EXPECT_EQ(reversed.select(1), 999u);
+}
+
+TEST_F(LogTemplatesTest, StopsWhenCancelled) {
+    std::string content;
+    for (size_t i = 0; i < 3 * TEMPLATE_CANCEL_CHECK_ROWS; ++i) {
+        content += "INFO request " + std::to_string(i) + " served\n";
+    }
+    write(content);
+    auto all = RowView::identity(reader_.getLineCount());
+
+    // Stop at the second check: only the first rows are mined
+    size_t checks = 0;
+    auto partial = mineTemplates(reader_, all, highlighter_, 1, [&checks]() { return ++checks > 1; });
+    ASSERT_EQ(partial.size(), 1u);
+    EXPECT_EQ(partial[0].count, TEMPLATE_CANCEL_CHECK_ROWS);
+    EXPECT_EQ(checks, 2u);
+
+    auto none = templateRows(reader_, all, highlighter_, partial[0], 1, []() { return true; });
+    EXPECT_EQ(none.size(), 0u);
+    EXPECT_EQ(templateRows(reader_, all, highlighter_, partial[0], 1).size(), all.size());
+}
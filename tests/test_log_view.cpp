@@ -0,0 +1,179 @@
+#include <gtest/gtest.h>
+#include "../src/log_view.hpp"
+#include "ftxui/dom/elements.hpp"
+#include "ftxui/screen/screen.hpp"
+
+using namespace ftxui;
+
+class LogViewTest : public ::testing::Test {
+protected:
+    // Text of one screen row, one glyph per cell
+    static std::string rowText(Screen& screen, int y) {
+        std::string result;
+        for (int x = 0; x < screen.dimx(); ++x) {
+            result += screen.PixelAt(x, y).character;
+        }
+        return result;
+    }
+
+    SyntaxHighlighter highlighter_;
+};
+
+TEST_F(LogViewTest, PaintsGutterAndContent) {
+    std::string line = "ERROR: Connection failed";
+    std::vector<SyntaxHighlighter::Token> tokens;
+    highlighter_.tokenize(line, tokens);
+
+    LogView::Frame frame;
+    frame.rows.push_back({42, line, tokens, {}, -1, false, {}, -1, std::nullopt, -1, nullptr});
+
+    auto screen = Screen::Create(Dimension::Fixed(40), Dimension::Fixed(2));
+    Render(screen, logView(std::move(frame)));
+
+    EXPECT_EQ(rowText(screen, 0), "      42 │ ERROR: Connection failed     ");
+    EXPECT_EQ(screen.PixelAt(11, 0).foreground_color, Color(Color::Red));
+    EXPECT_TRUE(screen.PixelAt(11, 0).bold);
+
+    // Rows past the frame are blanked
+    EXPECT_EQ(rowText(screen, 1), std::string(40, ' '));
+}
+
+TEST_F(LogViewTest, AppliesColumnOffsetAndClipsToWidth) {
+    std::string line = "0123456789abcdefghijklmnopqrstuvwxyz";
+
+    LogView::Frame frame;
+    frame.column = 10;
+    frame.rows.push_back({1, line, {}, {}, -1, false, {}, -1, std::nullopt, -1, nullptr});
+
+    auto screen = Screen::Create(Dimension::Fixed(20), Dimension::Fixed(1));
+    Render(screen, logView(std::move(frame)));
+
+    EXPECT_EQ(rowText(screen, 0), "       1 │ abcdefghi");
+}
+
+TEST_F(LogViewTest, OverlaysMatchesAndSelection) {
+    std::string line = "request timeout";
+    std::vector<MatchSpan> matches = {{8, 7}};
+
+    LogView::Frame frame;
+    frame.rows.push_back({1, line, {}, matches, 0, true, {}, -1, std::nullopt, -1, nullptr});
+
+    auto screen = Screen::Create(Dimension::Fixed(30), Dimension::Fixed(1));
+    Render(screen, logView(std::move(frame)));
+
+    const int content = LogView::GUTTER_WIDTH;
+    EXPECT_FALSE(screen.PixelAt(content + 7, 0).inverted);
+    EXPECT_TRUE(screen.PixelAt(content + 8, 0).inverted);
+    EXPECT_TRUE(screen.PixelAt(content + 8, 0).underlined);
+
+    // The selection background covers the whole row, gutter included
+    EXPECT_EQ(screen.PixelAt(0, 0).background_color, Color(Color::Blue));
+    EXPECT_EQ(screen.PixelAt(29, 0).background_color, Color(Color::Blue));
+}
+
+TEST_F(LogViewTest, PaintsSearchHitsOverFilterMatches) {
+    std::string line = "disk full, disk ok";
+    std::vector<MatchSpan> matches = {{0, 4}};
+    std::vector<MatchSpan> hits = {{0, 4}, {11, 4}};
+
+    LogView::Frame frame;
+    frame.rows.push_back({1, line, {}, matches, -1, false, hits, 1, std::nullopt});
+
+    auto screen = Screen::Create(Dimension::Fixed(40), Dimension::Fixed(1));
+    Render(screen, logView(std::move(frame)));
+
+    const int content = LogView::GUTTER_WIDTH;
+    EXPECT_EQ(screen.PixelAt(content, 0).background_color, Color(Color::Yellow));
+    EXPECT_FALSE(screen.PixelAt(content, 0).inverted);
+    EXPECT_FALSE(screen.PixelAt(content, 0).underlined);
+    EXPECT_EQ(screen.PixelAt(content + 4, 0).background_color, Color(Color::Default));
+
+    // The current hit is underlined as well
+    EXPECT_EQ(screen.PixelAt(content + 11, 0).background_color, Color(Color::Yellow));
+    EXPECT_TRUE(screen.PixelAt(content + 11, 0).underlined);
+}
+
+TEST_F(LogViewTest, KeepsUtf8SequencesInOneCell) {
+    std::string line = "ошибка\tok";
+
+    LogView::Frame frame;
+    frame.rows.push_back({1, line, {}, {}, -1, false, {}, -1, std::nullopt, -1, nullptr});
+
+    auto screen = Screen::Create(Dimension::Fixed(25), Dimension::Fixed(1));
+    Render(screen, logView(std::move(frame)));
+
+    const int content = LogView::GUTTER_WIDTH;
+    EXPECT_EQ(screen.PixelAt(content, 0).character, "о");
+    EXPECT_EQ(screen.PixelAt(content + 5, 0).character, "а");
+    EXPECT_EQ(screen.PixelAt(content + 6, 0).character, " ");  // Tab
+    EXPECT_EQ(screen.PixelAt(content + 7, 0).character, "o");
+}
+
+TEST_F(LogViewTest, ColumnViewPaintsFieldsThenMessage) {
+    std::string line = "[2025-11-30 14:00:00.123] WARN: slow query";
+
+    LogView::Frame frame;
+    frame.rows.push_back({7, line, {}, {}, -1, false, {}, -1, parseLineFields(line), -1, nullptr});
+
+    auto screen = Screen::Create(Dimension::Fixed(55), Dimension::Fixed(1));
+    Render(screen, logView(std::move(frame)));
+
+    EXPECT_EQ(rowText(screen, 0), "       7 │ 2025-11-30 14:00:00.123 WARN  │ slow query  ");
+    EXPECT_EQ(screen.PixelAt(35, 0).foreground_color, Color(Color::Yellow));
+}
+
+TEST_F(LogViewTest, MergedViewTagsRowsWithTheirSource) {
+    std::string api = "GET /users";
+    std::string db = "SELECT 1";
+    std::vector<std::string> tags = {"api", "worker"};
+
+    LogView::Frame frame;
+    frame.source_tags = tags;
+    frame.rows.push_back({12, api, {}, {}, -1, false, {}, -1, std::nullopt, 0, nullptr});
+    frame.rows.push_back({3, db, {}, {}, -1, false, {}, -1, std::nullopt, 1, nullptr});
+
+    auto screen = Screen::Create(Dimension::Fixed(30), Dimension::Fixed(2));
+    Render(screen, logView(std::move(frame)));
+
+    EXPECT_EQ(LogView::sourceWidth(tags), 7);
+    EXPECT_EQ(rowText(screen, 0), "api          12 │ GET /users  ");
+    EXPECT_EQ(rowText(screen, 1), "worker        3 │ SELECT 1    ");
+    EXPECT_NE(screen.PixelAt(0, 0).foreground_color, screen.PixelAt(0, 1).foreground_color);
+}
+
+TEST_F(LogViewTest, WideGlyphsTakeTwoCellsAndBrokenBytesOne) {
+    std::string line = "中x\xFFy e\xCC\x81!";
+
+    LogView::Frame frame;
+    frame.rows.push_back({1, line, {}, {}, -1, false, {}, -1, std::nullopt, -1, nullptr});
+
+    auto screen = Screen::Create(Dimension::Fixed(25), Dimension::Fixed(1));
+    Render(screen, logView(std::move(frame)));
+
+    const int content = LogView::GUTTER_WIDTH;
+    EXPECT_EQ(screen.PixelAt(content, 0).character, "中");
+    EXPECT_EQ(screen.PixelAt(content + 1, 0).character, "");  // Covered by the wide glyph
+    EXPECT_EQ(screen.PixelAt(content + 2, 0).character, "x");
+    EXPECT_EQ(screen.PixelAt(content + 3, 0).character, "\xEF\xBF\xBD");
+    EXPECT_EQ(screen.PixelAt(content + 4, 0).character, "y");
+    EXPECT_EQ(screen.PixelAt(content + 6, 0).character, "e\xCC\x81");  // Mark joins its letter
+    EXPECT_EQ(screen.PixelAt(content + 7, 0).character, "!");
+}
+
+TEST_F(LogViewTest, ScrollsByScreenColumns) {
+    std::string line = "日本語 text";
+    LineLayout layout(line);
+
+    LogView::Frame frame;
+    frame.column = 3;  // Inside 本
+    frame.rows.push_back({1, line, {}, {}, -1, false, {}, -1, std::nullopt, -1, &layout});
+
+    auto screen = Screen::Create(Dimension::Fixed(20), Dimension::Fixed(1));
+    Render(screen, logView(std::move(frame)));
+
+    const int content = LogView::GUTTER_WIDTH;
+    EXPECT_EQ(screen.PixelAt(content, 0).character, " ");  // The cut half of 本
+    EXPECT_EQ(screen.PixelAt(content + 1, 0).character, "語");
+    EXPECT_EQ(screen.PixelAt(content + 3, 0).character, " ");
+    EXPECT_EQ(screen.PixelAt(content + 4, 0).character, "t");
+}
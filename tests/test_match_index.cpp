@@ -0,0 +1,71 @@
+#include <gtest/gtest.h>
+#include "../src/match_index.hpp"
+
+class MatchIndexTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        index_.add(2, {{0, 5}, {10, 3}});
+        index_.add(7, {{4, 2}});
+        index_.add(9, {{1, 1}, {8, 1}, {20, 4}});
+    }
+
+    MatchIndex index_;
+};
+
+TEST_F(MatchIndexTest, SpansForLine) {
+    auto spans = index_.spansFor(9);
+    ASSERT_EQ(spans.size(), 3u);
+    EXPECT_EQ(spans[2], (MatchSpan{20, 4}));
+    EXPECT_TRUE(index_.spansFor(3).empty());
+    EXPECT_EQ(index_.lineCount(), 3u);
+    EXPECT_EQ(index_.spanCount(), 6u);
+}
+
+TEST_F(MatchIndexTest, EmptySpansAreNotRecorded) {
+    index_.add(12, std::vector<MatchSpan>{});
+    EXPECT_EQ(index_.lineCount(), 3u);
+}
+
+TEST_F(MatchIndexTest, NextWalksWithinAndAcrossLines) {
+    auto pos = index_.next(2, 0);
+    ASSERT_TRUE(pos);
+    EXPECT_EQ(pos->line, 2u);
+    EXPECT_EQ(pos->span.offset, 10u);
+
+    pos = index_.next(pos->line, pos->span.offset);
+    ASSERT_TRUE(pos);
+    EXPECT_EQ(pos->line, 7u);
+
+    EXPECT_FALSE(index_.next(9, 20));
+}
+
+TEST_F(MatchIndexTest, PreviousWalksWithinAndAcrossLines) {
+    auto pos = index_.previous(9, 8);
+    ASSERT_TRUE(pos);
+    EXPECT_EQ(pos->line, 9u);
+    EXPECT_EQ(pos->span_index, 0u);
+
+    pos = index_.previous(9, 1);
+    ASSERT_TRUE(pos);
+    EXPECT_EQ(pos->line, 7u);
+
+    pos = index_.previous(5, 0);
+    ASSERT_TRUE(pos);
+    EXPECT_EQ(pos->line, 2u);
+    EXPECT_EQ(pos->span.offset, 10u);
+
+    EXPECT_FALSE(index_.previous(2, 0));
+}
+
+TEST_F(MatchIndexTest, FirstFromAndLastUpTo) {
+    auto first = index_.firstFrom(3);
+    ASSERT_TRUE(first);
+    EXPECT_EQ(first->line, 7u);
+
+    auto last = index_.lastUpTo(9);
+    ASSERT_TRUE(last);
+    EXPECT_EQ(last->span.offset, 20u);
+
+    EXPECT_FALSE(index_.firstFrom(10));
+    EXPECT_FALSE(index_.lastUpTo(1));
+}
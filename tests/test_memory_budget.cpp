@@ -0,0 +1,60 @@
+#include <gtest/gtest.h>
+#include "../src/memory_budget.hpp"
+#include <cstdint>
+
+using Account = MemoryBudget::Account;
+
+TEST(MemoryBudgetTest, UnlimitedOnlyAccounts) {
+    MemoryBudget budget;
+    EXPECT_FALSE(budget.limited());
+    budget.set(Account::Index, 1000);
+    budget.set(Account::Highlight, 500);
+    EXPECT_EQ(budget.total(), 1500u);
+    EXPECT_FALSE(budget.exceeded());
+    EXPECT_EQ(budget.headroom(Account::Highlight), SIZE_MAX);
+}
+
+TEST(MemoryBudgetTest, LaterAccountsGiveWay) {
+    MemoryBudget budget(1000);
+    budget.set(Account::Index, 300);
+    budget.set(Account::Results, 200);
+    budget.set(Account::Highlight, 900);
+
+    // Each account may use what the more essential ones leave
+    EXPECT_EQ(budget.headroom(Account::Index), 1000u);
+    EXPECT_EQ(budget.headroom(Account::Results), 700u);
+    EXPECT_EQ(budget.headroom(Account::Highlight), 500u);
+    EXPECT_TRUE(budget.exceeded());
+
+    budget.set(Account::Highlight, 500);
+    EXPECT_FALSE(budget.exceeded());
+    EXPECT_EQ(budget.used(Account::Highlight), 500u);
+}
+
+TEST(MemoryBudgetTest, HeadroomBottomsOutAtZero) {
+    MemoryBudget budget(100);
+    budget.set(Account::Index, 150);
+    EXPECT_EQ(budget.headroom(Account::Results), 0u);
+    EXPECT_EQ(budget.headroom(Account::Highlight), 0u);
+}
+
+TEST(MemoryBudgetTest, ParsesSizes) {
+    uint64_t bytes = 0;
+    EXPECT_TRUE(parseByteSize("4096", bytes));
+    EXPECT_EQ(bytes, 4096u);
+    EXPECT_TRUE(parseByteSize("512M", bytes));
+    EXPECT_EQ(bytes, 512ULL << 20);
+    EXPECT_TRUE(parseByteSize("2GB", bytes));
+    EXPECT_EQ(bytes, 2ULL << 30);
+
+    EXPECT_FALSE(parseByteSize("", bytes));
+    EXPECT_FALSE(parseByteSize("M", bytes));
+    EXPECT_FALSE(parseByteSize("12X", bytes));
+
+    // Too large to represent, rather than wrapped around
+    EXPECT_TRUE(parseByteSize("16777215T", bytes));
+    EXPECT_EQ(bytes, 16777215ULL << 40);
+    EXPECT_FALSE(parseByteSize("16777216T", bytes));
+    EXPECT_FALSE(parseByteSize("99999999999T", bytes));
+    EXPECT_FALSE(parseByteSize("99999999999999999999", bytes));
+}
@@ -0,0 +1,79 @@
+#include <gtest/gtest.h>
+#include "../src/perf_stats.hpp"
+#include "../src/perf_overlay.hpp"
+#include <vector>
+
+using namespace std::chrono_literals;
+
+TEST(PerfStatsTest, FrameTimesLastAndPercentile) {
+    FrameTimes times;
+    EXPECT_EQ(times.last(), 0ns);
+    EXPECT_EQ(times.percentile(0.99), 0ns);
+
+    for (int i = 1; i <= 100; ++i) {
+        times.add(std::chrono::milliseconds(i));
+    }
+    EXPECT_EQ(times.count(), 100u);
+    EXPECT_EQ(times.last(), 100ms);
+    EXPECT_EQ(times.percentile(0.0), 1ms);
+    EXPECT_EQ(times.percentile(0.5), 51ms);
+    EXPECT_EQ(times.percentile(0.99), 99ms);
+    EXPECT_EQ(times.percentile(1.0), 100ms);
+}
+
+TEST(PerfStatsTest, FrameTimesKeepOnlyTheWindow) {
+    FrameTimes times;
+    times.add(1s);  // Slow frame that falls out of the window
+    for (size_t i = 0; i < FrameTimes::WINDOW; ++i) {
+        times.add(2ms);
+    }
+    EXPECT_EQ(times.count(), FrameTimes::WINDOW);
+    EXPECT_EQ(times.percentile(1.0), 2ms);
+}
+
+TEST(PerfStatsTest, UtilisationFromBusyGrowth) {
+    UtilisationSampler sampler;
+    auto start = std::chrono::steady_clock::time_point{} + 1s;
+
+    EXPECT_DOUBLE_EQ(sampler.sample(0ns, start), 0.0);
+    EXPECT_DOUBLE_EQ(sampler.sample(250ms, start + 1s), 0.25);
+    EXPECT_DOUBLE_EQ(sampler.sample(250ms, start + 2s), 0.0);
+    EXPECT_DOUBLE_EQ(sampler.sample(5s, start + 3s), 1.0);  // Clamped (several workers)
+}
+
+TEST(PerfStatsTest, BusyScopeAddsItsLifetime) {
+    BusyMeter meter;
+    {
+        BusyMeter::Scope scope(meter);
+        auto until = std::chrono::steady_clock::now() + 2ms;
+        while (std::chrono::steady_clock::now() < until) {
+        }
+    }
+    EXPECT_GE(meter.total(), 2ms);
+}
+
+TEST(PerfStatsTest, ScanRate) {
+    ScanRate rate;
+    EXPECT_FALSE(rate.valid());
+    EXPECT_EQ(rate.gigabytesPerSecond(), 0.0);
+
+    rate = {2'000'000'000, 10'000'000, 1s};
+    EXPECT_DOUBLE_EQ(rate.gigabytesPerSecond(), 2.0);
+    EXPECT_DOUBLE_EQ(rate.linesPerSecond(), 1e7);
+}
+
+#ifdef __linux__
+TEST(PerfStatsTest, ProcessStatsSeesThisProcess) {
+    std::vector<char> touched(8 * 1024 * 1024, 1);
+    auto stats = ProcessStats::sample();
+    EXPECT_GE(stats.resident_bytes, touched.size());
+}
+#endif
+
+TEST(PerfStatsTest, Formatting) {
+    EXPECT_EQ(formatBytes(512), "512 B");
+    EXPECT_EQ(formatBytes(1536), "1.5 KB");
+    EXPECT_EQ(formatBytes(3ULL * 1024 * 1024 * 1024), "3.0 GB");
+    EXPECT_EQ(formatDuration(250us), "250 us");
+    EXPECT_EQ(formatDuration(std::chrono::microseconds(16'600)), "16.60 ms");
+}
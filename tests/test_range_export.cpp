@@ -0,0 +1,141 @@
+#include <gtest/gtest.h>
+#include "../src/range_export.hpp"
+#include "temp_log_file.hpp"
+#include <cstdio>
+
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+class RangeExportTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        ASSERT_TRUE(log_.writeAndOpen(reader_, "line 0\n"
+                                                "line 1\r\n"
+                                                "line 2\n"
+                                                "line 3\n"
+                                                "line 4"));  // No trailing newline
+    }
+
+    static std::string readAll(std::FILE* file) {
+        std::string result;
+        std::rewind(file);
+        char buffer[4096];
+        size_t n;
+        while ((n = std::fread(buffer, 1, sizeof(buffer), file)) > 0) {
+            result.append(buffer, n);
+        }
+        return result;
+    }
+
+    TempLogFile log_{"range_export_test.log"};
+    LogReader reader_;
+};
+
+TEST_F(RangeExportTest, CoalescesAdjacentLines) {
+    std::FILE* out = std::tmpfile();
+    ASSERT_NE(out, nullptr);
+
+    RangeExporter exporter(reader_, fileno(out));
+    exporter.addLine(0);
+    exporter.addLine(1);
+    exporter.addLine(2);
+    exporter.addLine(4);
+    ASSERT_TRUE(exporter.flush()) << exporter.getError();
+
+    EXPECT_EQ(exporter.rangesWritten(), 2u);
+    EXPECT_EQ(readAll(out), "line 0\nline 1\r\nline 2\nline 4\n");
+    EXPECT_EQ(exporter.bytesWritten(), 29u);
+    std::fclose(out);
+}
+
+TEST_F(RangeExportTest, ExportsAnIdentityViewAsOneRange) {
+    std::FILE* out = std::tmpfile();
+    ASSERT_NE(out, nullptr);
+
+    uint64_t bytes = 0;
+    std::string error;
+    ASSERT_TRUE(exportRows(reader_, RowView::identity(reader_.getLineCount()), fileno(out), bytes, error))
+        << error;
+    EXPECT_EQ(readAll(out), "line 0\nline 1\r\nline 2\nline 3\nline 4\n");
+    std::fclose(out);
+}
+
+TEST_F(RangeExportTest, ExportsAFilteredView) {
+    std::FILE* out = std::tmpfile();
+    ASSERT_NE(out, nullptr);
+
+    uint64_t bytes = 0;
+    std::string error;
+    ASSERT_TRUE(exportRows(reader_, RowView::fromLines({1, 3}), fileno(out), bytes, error)) << error;
+    EXPECT_EQ(readAll(out), "line 1\r\nline 3\n");
+    EXPECT_EQ(bytes, 15u);
+    std::fclose(out);
+}
+
+TEST_F(RangeExportTest, CopiesLongRangesInTheKernel) {
+    // Ranges above MIN_KERNEL_COPY go through copy_file_range / sendfile
+    std::string content;
+    for (int i = 0; content.size() < 3 * RangeExporter::MIN_KERNEL_COPY; ++i) {
+        content += "entry " + std::to_string(i) + "\n";
+    }
+    ASSERT_TRUE(log_.writeAndOpen(reader_, content));
+
+    std::FILE* out = std::tmpfile();
+    ASSERT_NE(out, nullptr);
+    RangeExporter exporter(reader_, fileno(out));
+    exporter.addLine(0);
+    exporter.addLines(2, reader_.getLineCount());
+    ASSERT_TRUE(exporter.flush()) << exporter.getError();
+
+    EXPECT_EQ(readAll(out), "entry 0\n" + content.substr(reader_.getLineOffset(2)));
+    std::fclose(out);
+}
+
+TEST_F(RangeExportTest, RefusesToOverwriteTheInput) {
+    std::string error;
+    EXPECT_EQ(openExportFile(log_.path(), reader_, error), -1);
+    EXPECT_FALSE(error.empty());
+    EXPECT_EQ(reader_.getLine(4), "line 4");
+}
+
+#ifndef _WIN32
+TEST_F(RangeExportTest, WritesToAPipe) {
+    int fds[2];
+    ASSERT_EQ(pipe(fds), 0);
+
+    RangeExporter exporter(reader_, fds[1]);
+    exporter.addLines(2, 5);
+    ASSERT_TRUE(exporter.flush()) << exporter.getError();
+    ::close(fds[1]);
+
+    char buffer[64];
+    ssize_t size = ::read(fds[0], buffer, sizeof(buffer));
+    ::close(fds[0]);
+    ASSERT_GT(size, 0);
+    EXPECT_EQ(std::string(buffer, static_cast<size_t>(size)), "line 2\nline 3\nline 4\n");
+}
+
+TEST_F(RangeExportTest, ExportsFromAStream) {
+    int fds[2];
+    ASSERT_EQ(pipe(fds), 0);
+
+    LogReader stream;
+    ASSERT_TRUE(stream.openStream(fds[0], "<stdin>"));
+    const std::string input = "a\nb\nc\nd";
+    ASSERT_EQ(::write(fds[1], input.data(), input.size()), static_cast<ssize_t>(input.size()));
+    ::close(fds[1]);
+    while (stream.isGrowing()) {
+        stream.waitForLines(stream.getLineCount(), std::chrono::milliseconds(50));
+    }
+    EXPECT_EQ(stream.getFileDescriptor(), -1);
+
+    std::FILE* out = std::tmpfile();
+    ASSERT_NE(out, nullptr);
+    uint64_t bytes = 0;
+    std::string error;
+    ASSERT_TRUE(exportRows(stream, RowView::fromLines({0, 2, 3}), fileno(out), bytes, error)) << error;
+    EXPECT_EQ(readAll(out), "a\nc\nd\n");
+    std::fclose(out);
+}
+#endif
@@ -0,0 +1,103 @@
+#include <gtest/gtest.h>
+#include "../src/redraw_scheduler.hpp"
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+using namespace std::chrono_literals;
+
+class RedrawSchedulerTest : public ::testing::Test {
+protected:
+    // Wait (bounded) until `count` wakeups arrived
+    bool waitForWakeups(size_t count) {
+        for (int i = 0; i < 200 && wakeups_ < count; ++i) {
+            std::this_thread::sleep_for(5ms);
+        }
+        return wakeups_ >= count;
+    }
+
+    std::atomic<size_t> wakeups_{0};
+};
+
+TEST_F(RedrawSchedulerTest, BurstCoalescesIntoOneWakeup) {
+    RedrawScheduler scheduler([this]() { ++wakeups_; }, 10ms);
+
+    for (int i = 0; i < 1000; ++i) {
+        scheduler.request();
+    }
+    ASSERT_TRUE(waitForWakeups(1));
+
+    // Without a frame in between, further requests do not wake the UI again
+    scheduler.request();
+    std::this_thread::sleep_for(50ms);
+    EXPECT_EQ(wakeups_, 1u);
+    EXPECT_EQ(scheduler.wakeupCount(), 1u);
+}
+
+TEST_F(RedrawSchedulerTest, NextRequestAfterFrameWakesAgain) {
+    RedrawScheduler scheduler([this]() { ++wakeups_; }, 1ms);
+
+    scheduler.request();
+    ASSERT_TRUE(waitForWakeups(1));
+
+    scheduler.frameStarted();
+    scheduler.request();
+    EXPECT_TRUE(waitForWakeups(2));
+}
+
+TEST_F(RedrawSchedulerTest, PendingRequestIsSentOnceFrameStarts) {
+    RedrawScheduler scheduler([this]() { ++wakeups_; }, 1ms);
+
+    scheduler.request();
+    ASSERT_TRUE(waitForWakeups(1));
+    scheduler.request();  // Held back: the first wakeup has not been drawn yet
+
+    // A frame covers the request, so nothing more is sent
+    scheduler.frameStarted();
+    std::this_thread::sleep_for(30ms);
+    EXPECT_EQ(wakeups_, 1u);
+}
+
+TEST_F(RedrawSchedulerTest, RateLimitedToInterval) {
+    RedrawScheduler scheduler([this]() { ++wakeups_; }, 50ms);
+
+    auto start = std::chrono::steady_clock::now();
+    scheduler.request();
+    ASSERT_TRUE(waitForWakeups(1));
+    scheduler.frameStarted();
+    scheduler.request();
+    ASSERT_TRUE(waitForWakeups(2));
+
+    EXPECT_GE(std::chrono::steady_clock::now() - start, 50ms);
+}
+
+TEST_F(RedrawSchedulerTest, IdleSendsNothing) {
+    RedrawScheduler scheduler([this]() { ++wakeups_; }, 1ms);
+    std::this_thread::sleep_for(30ms);
+    EXPECT_EQ(wakeups_, 0u);
+}
+
+TEST_F(RedrawSchedulerTest, DeferredRequestWaitsForItsDelay) {
+    RedrawScheduler scheduler([this]() { ++wakeups_; }, 1ms);
+
+    auto start = std::chrono::steady_clock::now();
+    scheduler.requestAfter(40ms);
+    scheduler.requestAfter(500ms);  // Later one is dropped: the earliest is kept
+    std::this_thread::sleep_for(10ms);
+    EXPECT_EQ(wakeups_, 0u);
+
+    ASSERT_TRUE(waitForWakeups(1));
+    EXPECT_GE(std::chrono::steady_clock::now() - start, 40ms);
+    EXPECT_LT(std::chrono::steady_clock::now() - start, 500ms);
+}
+
+TEST_F(RedrawSchedulerTest, EarlierDeferredRequestReschedules) {
+    RedrawScheduler scheduler([this]() { ++wakeups_; }, 1ms);
+
+    auto start = std::chrono::steady_clock::now();
+    scheduler.requestAfter(5s);
+    scheduler.requestAfter(20ms);
+    ASSERT_TRUE(waitForWakeups(1));
+    EXPECT_LT(std::chrono::steady_clock::now() - start, 1s);
+}
@@ -0,0 +1,100 @@
+#include <gtest/gtest.h>
+#include "../src/row_view.hpp"
+
+TEST(RowViewTest, EmptyByDefault) {
+    RowView view;
+    EXPECT_TRUE(view.empty());
+    EXPECT_EQ(view.rank(5), 0u);
+    EXPECT_FALSE(view.contains(0));
+}
+
+TEST(RowViewTest, IdentityStoresNothing) {
+    auto view = RowView::identity(600'000'000);
+    EXPECT_TRUE(view.isIdentity());
+    EXPECT_EQ(view.size(), 600'000'000u);
+    EXPECT_EQ(view.memoryUsage(), 0u);
+
+    EXPECT_EQ(view.select(123'456'789), 123'456'789u);
+    EXPECT_EQ(view.rank(42), 42u);
+    EXPECT_EQ(view.rank(700'000'000), 600'000'000u);
+    EXPECT_TRUE(view.contains(599'999'999));
+    EXPECT_FALSE(view.contains(600'000'000));
+}
+
+TEST(RowViewTest, MatchSetSelectAndRank) {
+    auto view = RowView::fromLines({3, 10, 11, 40});
+    EXPECT_FALSE(view.isIdentity());
+    ASSERT_EQ(view.size(), 4u);
+
+    EXPECT_EQ(view.select(0), 3u);
+    EXPECT_EQ(view.select(3), 40u);
+
+    EXPECT_EQ(view.rank(3), 0u);
+    EXPECT_EQ(view.rank(10), 1u);
+    EXPECT_EQ(view.rank(12), 3u);   // Not in the view: where it would go
+    EXPECT_EQ(view.rank(100), 4u);
+
+    EXPECT_TRUE(view.contains(11));
+    EXPECT_FALSE(view.contains(12));
+}
+
+TEST(RowViewTest, SelectInvertsRank) {
+    auto view = RowView::fromLines({0, 2, 4, 8, 16, 32});
+    for (size_t row = 0; row < view.size(); ++row) {
+        EXPECT_EQ(view.rank(view.select(row)), row);
+    }
+}
+
+TEST(RowViewTest, GrowsWithTheInput) {
+    auto all = RowView::identity(10);
+    all.extendIdentity(25);
+    EXPECT_EQ(all.size(), 25u);
+    EXPECT_EQ(all.select(24), 24u);
+
+    auto matches = RowView::fromLines({2, 7});
+    matches.append({12, 30});
+    ASSERT_EQ(matches.size(), 4u);
+    EXPECT_EQ(matches.select(3), 30u);
+    EXPECT_EQ(matches.rank(12), 2u);
+
+    matches.extendIdentity(100);  // Only the identity range grows that way
+    EXPECT_EQ(matches.size(), 4u);
+}
+
+TEST(RowViewTest, OrderedViewKeepsItsOrder) {
+    auto view = RowView::fromOrder({40, 3, 11, 10});
+    EXPECT_FALSE(view.isIdentity());
+    EXPECT_FALSE(view.inFileOrder());
+    ASSERT_EQ(view.size(), 4u);
+
+    EXPECT_EQ(view.select(0), 40u);
+    EXPECT_EQ(view.select(3), 10u);
+
+    // Rank is the row a line is shown at; missing lines rank past the end
+    EXPECT_EQ(view.rank(11), 2u);
+    EXPECT_EQ(view.rank(12), 4u);
+    EXPECT_TRUE(view.contains(3));
+    EXPECT_FALSE(view.contains(12));
+
+    view.append({50, 41});
+    EXPECT_EQ(view.select(4), 50u);
+    EXPECT_EQ(view.rank(41), 5u);
+    EXPECT_EQ(view.rank(40), 0u);
+    EXPECT_FALSE(view.contains(42));
+}
+
+TEST(RowViewTest, OrderedViewRanksEveryRow) {
+    // A shuffled permutation: rank must invert select for all of it
+    std::vector<size_t> lines(1000);
+    for (size_t i = 0; i < lines.size(); ++i) {
+        lines[i] = (i * 7919) % lines.size() * 2;  // Even lines only
+    }
+    auto view = RowView::fromOrder(lines);
+    view.append({5001, 2001, 3});  // Out of order, between existing lines
+    for (size_t row = 0; row < view.size(); ++row) {
+        EXPECT_EQ(view.rank(view.select(row)), row);
+        EXPECT_TRUE(view.contains(view.select(row)));
+    }
+    EXPECT_FALSE(view.contains(1));
+    EXPECT_EQ(view.rank(1), view.size());
+}
@@ -0,0 +1,148 @@
+#include <gtest/gtest.h>
+#include "../src/search_engine.hpp"
+#include "temp_log_file.hpp"
+
+class SearchEngineTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        std::string content;
+        for (int i = 0; i < 1000; ++i) {
+            if (i == 10 || i == 500 || i == 990) {
+                content += "[2025-11-30 14:00:00] ERROR: disk full on node-" + std::to_string(i) + "\n";
+            } else {
+                content += "[2025-11-30 14:00:00] INFO: request " + std::to_string(i) + " ok\n";
+            }
+        }
+        log_.write(content);
+
+        reader_ = std::make_shared<LogReader>();
+        ASSERT_TRUE(reader_->open(log_.path()));
+    }
+
+    // Scan until a hit or the end, like the background search loop
+    SearchEngine::Step scanAll(SearchEngine& engine, size_t from, bool forward, size_t budget) {
+        auto step = engine.scan(from, forward, budget);
+        while (!step.hit && !step.exhausted) {
+            step = engine.scan(step.resume, forward, budget);
+        }
+        return step;
+    }
+
+    TempLogFile log_{"search_engine_test.log"};
+    std::shared_ptr<LogReader> reader_;
+};
+
+TEST_F(SearchEngineTest, ClassifiesPatterns) {
+    SearchEngine engine(reader_);
+    EXPECT_FALSE(engine.hasPattern());
+
+    ASSERT_TRUE(engine.setPattern("disk full"));
+    EXPECT_TRUE(engine.isLiteral());
+
+    ASSERT_TRUE(engine.setPattern("node-[0-9]+"));
+    EXPECT_FALSE(engine.isLiteral());
+
+    EXPECT_FALSE(engine.setPattern("[unclosed"));
+    EXPECT_FALSE(engine.getError().empty());
+    EXPECT_FALSE(engine.hasPattern());
+}
+
+TEST_F(SearchEngineTest, LiteralForwardAndBackward) {
+    SearchEngine engine(reader_);
+    ASSERT_TRUE(engine.setPattern("ERROR"));
+
+    auto step = engine.scan(0, true, 1 << 20);
+    ASSERT_TRUE(step.hit);
+    EXPECT_EQ(step.hit->line, 10u);
+    EXPECT_EQ(step.hit->span.offset, 22u);
+    EXPECT_EQ(step.hit->span.length, 5u);
+
+    // Strictly after the first hit
+    size_t first = reader_->getLineOffset(10) + 22;
+    step = engine.scan(first + 1, true, 1 << 20);
+    ASSERT_TRUE(step.hit);
+    EXPECT_EQ(step.hit->line, 500u);
+
+    // Backward from the end finds the last one
+    step = engine.scan(reader_->getFileSize(), false, 1 << 20);
+    ASSERT_TRUE(step.hit);
+    EXPECT_EQ(step.hit->line, 990u);
+
+    step = engine.scan(first, false, 1 << 20);
+    EXPECT_FALSE(step.hit);
+    EXPECT_TRUE(step.exhausted);
+}
+
+TEST_F(SearchEngineTest, RegexFindsSpanWithinLine) {
+    SearchEngine engine(reader_);
+    ASSERT_TRUE(engine.setPattern("node-[0-9]+"));
+
+    auto step = scanAll(engine, reader_->getLineOffset(11), true, 1 << 20);
+    ASSERT_TRUE(step.hit);
+    EXPECT_EQ(step.hit->line, 500u);
+    std::string_view line = reader_->getLine(500);
+    EXPECT_EQ(line.substr(step.hit->span.offset, step.hit->span.length), "node-500");
+
+    step = scanAll(engine, reader_->getLineOffset(500), false, 1 << 20);
+    ASSERT_TRUE(step.hit);
+    EXPECT_EQ(step.hit->line, 10u);
+}
+
+TEST_F(SearchEngineTest, SmallBudgetResumesUntilFound) {
+    for (const char* pattern : {"disk full", "disk f[u]ll"}) {
+        SearchEngine engine(reader_);
+        ASSERT_TRUE(engine.setPattern(pattern));
+
+        auto step = engine.scan(reader_->getLineOffset(11), true, 256);
+        EXPECT_FALSE(step.hit) << pattern;
+        EXPECT_FALSE(step.exhausted) << pattern;
+        EXPECT_GT(step.resume, reader_->getLineOffset(11)) << pattern;
+
+        step = scanAll(engine, step.resume, true, 256);
+        ASSERT_TRUE(step.hit) << pattern;
+        EXPECT_EQ(step.hit->line, 500u) << pattern;
+
+        step = scanAll(engine, reader_->getLineOffset(989), false, 256);
+        ASSERT_TRUE(step.hit) << pattern;
+        EXPECT_EQ(step.hit->line, 500u) << pattern;
+    }
+}
+
+TEST_F(SearchEngineTest, RepeatedSearchUsesCache) {
+    SearchEngine engine(reader_);
+    ASSERT_TRUE(engine.setPattern("ERROR"));
+
+    auto step = scanAll(engine, 0, true, 1 << 20);
+    ASSERT_TRUE(step.hit);
+    size_t hits_after_first = engine.cachedHitCount();
+    EXPECT_GE(hits_after_first, 1u);
+
+    // Back over known ground: answered without scanning (a budget of zero
+    // would otherwise make no progress)
+    size_t hit = reader_->getLineOffset(10) + 22;
+    step = engine.scan(hit + 1, false, 0);
+    ASSERT_TRUE(step.hit);
+    EXPECT_EQ(step.hit->line, 10u);
+
+    step = engine.scan(0, true, 0);
+    ASSERT_TRUE(step.hit);
+    EXPECT_EQ(step.hit->line, 10u);
+
+    // A new pattern forgets everything
+    ASSERT_TRUE(engine.setPattern("WARN"));
+    EXPECT_EQ(engine.cachedHitCount(), 0u);
+    step = scanAll(engine, 0, true, 1 << 20);
+    EXPECT_FALSE(step.hit);
+    EXPECT_TRUE(step.exhausted);
+}
+
+TEST_F(SearchEngineTest, FindInLineReturnsEveryOccurrence) {
+    SearchEngine engine(reader_);
+    ASSERT_TRUE(engine.setPattern("0"));
+
+    std::vector<MatchSpan> spans;
+    engine.findInLine("10 20 30", spans);
+    ASSERT_EQ(spans.size(), 3u);
+    EXPECT_EQ(spans[0].offset, 1u);
+    EXPECT_EQ(spans[2].offset, 7u);
+}
@@ -0,0 +1,207 @@
+#include <gtest/gtest.h>
+#include "../src/stream_spool.hpp"
+#include "../src/log_reader.hpp"
+#include "../src/batch_mode.hpp"
+#include <atomic>
+#include <string>
+#include <thread>
+
+#ifndef _WIN32
+#include <unistd.h>
+
+namespace {
+
+constexpr std::chrono::milliseconds WAIT{2000};
+
+void writeAll(int fd, const std::string& data) {
+    size_t done = 0;
+    while (done < data.size()) {
+        ssize_t written = ::write(fd, data.data() + done, data.size() - done);
+        ASSERT_GT(written, 0);
+        done += static_cast<size_t>(written);
+    }
+}
+
+// Wait until the spool has read everything and seen end of input
+void waitForEnd(StreamSpool& spool) {
+    for (int i = 0; i < 100 && !spool.finished(); ++i) {
+        spool.waitForLines(spool.lineCount(), std::chrono::milliseconds(50));
+    }
+    ASSERT_TRUE(spool.finished());
+}
+
+} // namespace
+
+TEST(StreamSpoolTest, IndexesLinesAsTheyArrive) {
+    int fds[2];
+    ASSERT_EQ(pipe(fds), 0);
+
+    StreamSpool spool;
+    std::string error;
+    ASSERT_TRUE(spool.start(fds[0], StreamSpool::DEFAULT_MEMORY_BUDGET, error)) << error;
+
+    writeAll(fds[1], "first\nsec");
+    EXPECT_EQ(spool.waitForLines(0, WAIT), 1u);
+    EXPECT_FALSE(spool.finished());
+    EXPECT_EQ(spool.offsets()[0], 0u);
+    EXPECT_EQ(spool.offsets()[1], 6u);
+
+    // The second line is only complete once its newline arrives
+    writeAll(fds[1], "ond\n");
+    EXPECT_EQ(spool.waitForLines(1, WAIT), 2u);
+    EXPECT_EQ(std::string(spool.data() + spool.offsets()[1], spool.data() + spool.offsets()[2]),
+              "second\n");
+
+    ::close(fds[1]);
+    waitForEnd(spool);
+    EXPECT_EQ(spool.lineCount(), 2u);
+    EXPECT_EQ(spool.byteCount(), 13u);
+    EXPECT_TRUE(spool.getError().empty());
+}
+
+TEST(StreamSpoolTest, PartialLastLineCompletesAtEnd) {
+    int fds[2];
+    ASSERT_EQ(pipe(fds), 0);
+
+    StreamSpool spool;
+    std::string error;
+    ASSERT_TRUE(spool.start(fds[0], StreamSpool::DEFAULT_MEMORY_BUDGET, error)) << error;
+
+    writeAll(fds[1], "a\nno newline");
+    ::close(fds[1]);
+    waitForEnd(spool);
+
+    ASSERT_EQ(spool.lineCount(), 2u);
+    EXPECT_EQ(spool.offsets()[2], 12u);
+}
+
+TEST(StreamSpoolTest, SpillsPastTheMemoryBudget) {
+    int fds[2];
+    ASSERT_EQ(pipe(fds), 0);
+
+    StreamSpool spool;
+    std::string error;
+    ASSERT_TRUE(spool.start(fds[0], 64 * 1024, error)) << error;
+
+    // 3 MB of numbered lines, well past the budget
+    std::string expected;
+    for (int i = 0; i < 100000; ++i) {
+        expected += "line " + std::to_string(i) + " " + std::string(20, 'x') + "\n";
+    }
+    writeAll(fds[1], expected);
+    ::close(fds[1]);
+    waitForEnd(spool);
+
+    ASSERT_TRUE(spool.getError().empty()) << spool.getError();
+    EXPECT_EQ(spool.lineCount(), 100000u);
+    EXPECT_EQ(spool.byteCount(), expected.size());
+    EXPECT_GT(spool.spilledBytes(), 0u);
+    EXPECT_EQ(std::string(spool.data(), spool.byteCount()), expected);
+}
+
+TEST(StreamSpoolTest, CommitsTheLineIndexAsItGrows) {
+    int fds[2];
+    ASSERT_EQ(pipe(fds), 0);
+
+    StreamSpool spool;
+    std::string error;
+    ASSERT_TRUE(spool.start(fds[0], StreamSpool::DEFAULT_MEMORY_BUDGET, error)) << error;
+
+    // Short lines, enough to need several index steps
+    const size_t count = StreamSpool::INDEX_STEP * 5 / 2;
+    std::string input;
+    for (size_t i = 0; i < count; ++i) {
+        input += i % 2 == 0 ? "a\n" : "bc\n";
+    }
+    writeAll(fds[1], input);
+    ::close(fds[1]);
+    waitForEnd(spool);
+
+    ASSERT_TRUE(spool.getError().empty()) << spool.getError();
+    ASSERT_EQ(spool.lineCount(), count);
+    EXPECT_EQ(spool.offsets()[count], input.size());
+    EXPECT_EQ(spool.offsets()[count - 1], input.size() - 3);
+}
+
+TEST(StreamSpoolTest, ClearingTheCallbackWaitsForARunningCall) {
+    int fds[2];
+    ASSERT_EQ(pipe(fds), 0);
+
+    StreamSpool spool;
+    std::string error;
+    ASSERT_TRUE(spool.start(fds[0], StreamSpool::DEFAULT_MEMORY_BUDGET, error)) << error;
+
+    std::atomic<bool> entered{false};
+    std::atomic<bool> returned{false};
+    spool.setGrowthCallback([&]() {
+        entered = true;
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        returned = true;
+    });
+    writeAll(fds[1], "line\n");
+    for (int i = 0; i < 200 && !entered; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    ASSERT_TRUE(entered);
+
+    // The display clears it in its destructor before its state goes away
+    spool.setGrowthCallback(nullptr);
+    EXPECT_TRUE(returned);
+    ::close(fds[1]);
+}
+
+TEST(StreamSpoolTest, LogReaderReadsAStream) {
+    int fds[2];
+    ASSERT_EQ(pipe(fds), 0);
+
+    LogReader reader;
+    ASSERT_TRUE(reader.openStream(fds[0], "<stdin>"));
+    EXPECT_TRUE(reader.isOpen());
+    EXPECT_EQ(reader.getFilename(), "<stdin>");
+    EXPECT_TRUE(reader.isGrowing());
+
+    writeAll(fds[1], "INFO start\r\nERROR failed\n");
+    EXPECT_EQ(reader.waitForLines(0, WAIT) >= 1, true);
+    while (reader.getLineCount() < 2) {
+        reader.waitForLines(reader.getLineCount(), WAIT);
+    }
+    EXPECT_EQ(reader.getLine(0), "INFO start");
+    EXPECT_EQ(reader.getLine(1), "ERROR failed");
+    EXPECT_EQ(reader.getData(), "INFO start\r\nERROR failed\n");
+
+    writeAll(fds[1], "tail");
+    ::close(fds[1]);
+    while (reader.isGrowing()) {
+        reader.waitForLines(reader.getLineCount(), std::chrono::milliseconds(50));
+    }
+    ASSERT_EQ(reader.getLineCount(), 3u);
+    EXPECT_EQ(reader.getLine(2), "tail");
+    EXPECT_EQ(reader.lineAtOffset(13), 1u);
+}
+
+TEST(StreamSpoolTest, BatchModeFollowsTheStream) {
+    int input[2];
+    int output[2];
+    ASSERT_EQ(pipe(input), 0);
+    ASSERT_EQ(pipe(output), 0);
+
+    LogReader reader;
+    ASSERT_TRUE(reader.openStream(input[0], "<stdin>"));
+    writeAll(input[1], "ERROR one\nINFO two\nERROR three");
+    ::close(input[1]);
+
+    FilterEngine filter;
+    BatchOptions options;
+    options.pattern = "ERROR";
+    std::string error;
+    EXPECT_EQ(runBatch(reader, filter, options, output[1], error), BATCH_MATCHED);
+    ::close(output[1]);
+
+    char buffer[256];
+    ssize_t size = ::read(output[0], buffer, sizeof(buffer));
+    ::close(output[0]);
+    ASSERT_GT(size, 0);
+    EXPECT_EQ(std::string(buffer, static_cast<size_t>(size)), "ERROR one\nERROR three\n");
+}
+
+#endif
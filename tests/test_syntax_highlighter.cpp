@@ -1,6 +1,36 @@
 #include <gtest/gtest.h>
 #include "../src/syntax_highlighter.hpp"
+#include "../src/keyword_table.hpp"
 #include <string_view>
+#include <cstdlib>
+#include <new>
+
+// Count heap allocations made by the current thread (for the zero-allocation tests)
+#if defined(__GNUC__) && !defined(__clang__)
+    #pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+namespace {
+thread_local size_t allocation_count = 0;
+}
+
+void* operator new(std::size_t size) {
+    ++allocation_count;
+    if (void* ptr = std::malloc(size ? size : 1)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept {
+    std::free(ptr);
+}
+
+using TokenType = SyntaxHighlighter::Token::Type;
 
 class SyntaxHighlighterTest : public ::testing::Test {
 protected:
@@ -89,3 +119,262 @@ TEST_F(SyntaxHighlighterTest, HighlightUnicodeCharacters) {
     auto element = highlighter_->highlight(line);
     EXPECT_NE(element, nullptr);
 }
+
+TEST_F(SyntaxHighlighterTest, TokensAreSpansIntoLine) {
+    std::string_view line = R"(ERROR: "failed" on 192.168.1.1)";
+    std::vector<SyntaxHighlighter::Token> tokens;
+    highlighter_->tokenize(line, tokens);
+
+    std::string rebuilt;
+    for (const auto& token : tokens) {
+        rebuilt += token.textIn(line);
+    }
+    EXPECT_EQ(rebuilt, line);
+
+    ASSERT_GE(tokens.size(), 7u);
+    EXPECT_EQ(tokens[0].textIn(line), "ERROR");
+    EXPECT_EQ(tokens[0].type, TokenType::LogLevel);
+    EXPECT_EQ(tokens[1].type, TokenType::Special);   // ':'
+    EXPECT_EQ(tokens[3].textIn(line), "\"failed\"");
+    EXPECT_EQ(tokens[3].type, TokenType::String);
+    EXPECT_EQ(tokens.back().textIn(line), "192.168.1.1");
+    EXPECT_EQ(tokens.back().type, TokenType::IPAddress);
+}
+
+TEST_F(SyntaxHighlighterTest, ClassifyWordsCaseInsensitively) {
+    EXPECT_EQ(SyntaxHighlighter::classifyWord("select"), TokenType::Keyword);
+    EXPECT_EQ(SyntaxHighlighter::classifyWord("Where"), TokenType::Keyword);
+    EXPECT_EQ(SyntaxHighlighter::classifyWord("true"), TokenType::Keyword);
+    EXPECT_EQ(SyntaxHighlighter::classifyWord("warning"), TokenType::LogLevel);
+    EXPECT_EQ(SyntaxHighlighter::classifyWord("https"), TokenType::Protocol);
+    EXPECT_EQ(SyntaxHighlighter::classifyWord("-12.5"), TokenType::Number);
+    EXPECT_EQ(SyntaxHighlighter::classifyWord("10.0.0.1"), TokenType::IPAddress);
+    EXPECT_EQ(SyntaxHighlighter::classifyWord("SELECTED"), TokenType::Normal);
+    EXPECT_EQ(SyntaxHighlighter::classifyWord("users"), TokenType::Normal);
+}
+
+TEST_F(SyntaxHighlighterTest, UnterminatedStringRunsToEndOfLine) {
+    std::string_view line = R"(msg="never closed)";
+    std::vector<SyntaxHighlighter::Token> tokens;
+    highlighter_->tokenize(line, tokens);
+
+    ASSERT_EQ(tokens.size(), 3u);
+    EXPECT_EQ(tokens[2].textIn(line), R"("never closed)");
+    EXPECT_EQ(tokens[2].type, TokenType::String);
+}
+
+TEST_F(SyntaxHighlighterTest, KeywordTableLookup) {
+    constexpr auto table = makeKeywordTable(std::to_array<KeywordEntry>({
+        {"alpha", 1}, {"beta", 2}, {"gamma", 3}
+    }));
+    static_assert(table.find("ALPHA") == 1);
+    static_assert(table.find("Gamma") == 3);
+    static_assert(!table.contains("delta"));
+    EXPECT_EQ(table.find("beta"), 2);
+    EXPECT_EQ(table.find(""), KeywordTable<8>::NOT_FOUND);
+}
+
+TEST_F(SyntaxHighlighterTest, TokenizeDoesNotAllocate) {
+    std::string_view line = R"([2025-11-30 14:00:01] DEBUG: Executing query: SELECT * FROM users WHERE id = 123 {"status": "ok", "ip": "10.0.0.1"})";
+    std::vector<SyntaxHighlighter::Token> tokens;
+    highlighter_->tokenize(line, tokens);  // Warm up the token buffer
+
+    size_t before = allocation_count;
+    for (int i = 0; i < 100; ++i) {
+        highlighter_->tokenize(line, tokens);
+    }
+    EXPECT_EQ(allocation_count - before, 0u);
+}
+
+TEST_F(SyntaxHighlighterTest, SimdTokenizerMatchesScalar) {
+    // Alphabet biased towards characters that start or end tokens
+    const std::string alphabet =
+        "ab ERROR INFO select on 0123456789..--\"\"''{}[](),:;=\t\r\v\f\n\x80\xd0\xff";
+    uint32_t state = 12345;
+    auto next_random = [&state]() {
+        state = state * 1103515245u + 12345u;
+        return state >> 8;
+    };
+
+    std::vector<SyntaxHighlighter::Token> simd_tokens;
+    std::vector<SyntaxHighlighter::Token> scalar_tokens;
+
+    for (int iteration = 0; iteration < 2000; ++iteration) {
+        std::string line;
+        size_t length = next_random() % 400;
+        for (size_t i = 0; i < length; ++i) {
+            line += alphabet[next_random() % alphabet.size()];
+        }
+
+        highlighter_->tokenize(line, simd_tokens);
+        highlighter_->tokenizeScalar(line, scalar_tokens);
+        ASSERT_EQ(simd_tokens, scalar_tokens) << "line: " << line;
+    }
+}
+
+TEST_F(SyntaxHighlighterTest, SimdTokenizerOnLongPayload) {
+    std::string line = R"([2025-11-30 14:00:05] WARN: Large JSON response detected (2.5MB): {"users": [)";
+    for (int i = 0; i < 200; ++i) {
+        line += R"({"id": )" + std::to_string(i) + R"(, "ip": "10.0.0.)" + std::to_string(i % 250) +
+                R"(", "note": "it's ok"}, )";
+    }
+    line += R"(], "total": 50000, "page": 1})";
+
+    std::vector<SyntaxHighlighter::Token> simd_tokens;
+    std::vector<SyntaxHighlighter::Token> scalar_tokens;
+    highlighter_->tokenize(line, simd_tokens);
+    highlighter_->tokenizeScalar(line, scalar_tokens);
+    EXPECT_EQ(simd_tokens, scalar_tokens);
+}
+
+TEST_F(SyntaxHighlighterTest, PlainTextFormatSkipsSqlKeywords) {
+    highlighter_->setFormat(LogFormat::PlainText);
+    std::string_view line = "INFO: user logged in on mobile, status ok";
+    std::vector<SyntaxHighlighter::Token> tokens;
+    highlighter_->tokenize(line, tokens);
+
+    for (const auto& token : tokens) {
+        EXPECT_NE(token.type, TokenType::Keyword) << token.textIn(line);
+        if (token.textIn(line) == "ok") {
+            EXPECT_EQ(token.type, TokenType::Normal);
+        }
+    }
+    EXPECT_EQ(tokens[0].type, TokenType::LogLevel);
+}
+
+TEST_F(SyntaxHighlighterTest, JsonFormatMarksKeys) {
+    highlighter_->setFormat(LogFormat::JsonLines);
+    std::string_view line = R"(INFO: {"active" : true, "name": "in", "count": 3, "v": NULL})";
+    std::vector<SyntaxHighlighter::Token> tokens;
+    highlighter_->tokenize(line, tokens);
+
+    auto type_of = [&](std::string_view text) {
+        for (const auto& token : tokens) {
+            if (token.textIn(line) == text) {
+                return token.type;
+            }
+        }
+        return TokenType::Timestamp;  // Not found
+    };
+    EXPECT_EQ(type_of(R"("active")"), TokenType::Key);
+    EXPECT_EQ(type_of(R"("name")"), TokenType::Key);
+    EXPECT_EQ(type_of(R"("in")"), TokenType::String);
+    EXPECT_EQ(type_of("true"), TokenType::Keyword);
+    EXPECT_EQ(type_of("NULL"), TokenType::Normal);
+    EXPECT_EQ(type_of("3"), TokenType::Number);
+}
+
+TEST_F(SyntaxHighlighterTest, LogfmtFormatMarksKeys) {
+    highlighter_->setFormat(LogFormat::Logfmt);
+    std::string_view line = R"(level=error msg="select failed" host=10.0.0.1 took=45)";
+    std::vector<SyntaxHighlighter::Token> tokens;
+    highlighter_->tokenize(line, tokens);
+
+    ASSERT_GE(tokens.size(), 3u);
+    EXPECT_EQ(tokens[0].textIn(line), "level");
+    EXPECT_EQ(tokens[0].type, TokenType::Key);
+    EXPECT_EQ(tokens[2].textIn(line), "error");
+    EXPECT_EQ(tokens[2].type, TokenType::LogLevel);
+    EXPECT_EQ(tokens.back().type, TokenType::Number);
+}
+
+TEST_F(SyntaxHighlighterTest, EveryFormatMatchesScalar) {
+    std::string line = R"(ts=1 level=info msg="a b" {"k": "v", "n": [1, 2, null]} SELECT id FROM t WHERE x IN (1, 2) ok)";
+    line += line;
+    line += line;
+
+    for (LogFormat format : {LogFormat::Generic, LogFormat::JsonLines, LogFormat::Logfmt,
+                             LogFormat::Sql, LogFormat::PlainText}) {
+        highlighter_->setFormat(format);
+        std::vector<SyntaxHighlighter::Token> simd_tokens;
+        std::vector<SyntaxHighlighter::Token> scalar_tokens;
+        highlighter_->tokenize(line, simd_tokens);
+        highlighter_->tokenizeScalar(line, scalar_tokens);
+        EXPECT_EQ(simd_tokens, scalar_tokens) << formatName(format);
+    }
+}
+
+TEST_F(SyntaxHighlighterTest, RenderWithMatchOverlay) {
+    std::string_view line = "ERROR: Connection failed to 10.0.0.1";
+    std::vector<SyntaxHighlighter::Token> tokens;
+    highlighter_->tokenize(line, tokens);
+
+    std::vector<MatchSpan> matches = {{3, 10}, {28, 4}};
+    auto element = highlighter_->render(line, tokens, matches, 1);
+    EXPECT_NE(element, nullptr);
+}
+
+namespace {
+
+std::string makeLargeJsonLine(int entries) {
+    std::string line = R"([2025-11-30 14:00:05] WARN: Large JSON response detected (2.5MB): {"users": [)";
+    for (int i = 0; i < entries; ++i) {
+        line += R"({"id": )" + std::to_string(i) + R"(, "ip": "10.0.0.)" + std::to_string(i % 250) +
+                R"(", "note" : "it's ok", "tags": [ "a b", 'c' ]}, )";
+    }
+    line += R"(], "total": 50000, "page": 1})";
+    return line;
+}
+
+} // namespace
+
+TEST_F(SyntaxHighlighterTest, ResumedRangesMatchFullTokenization) {
+    std::string line = makeLargeJsonLine(300);
+
+    for (auto format : {LogFormat::Generic, LogFormat::JsonLines, LogFormat::Logfmt,
+                        LogFormat::Sql, LogFormat::PlainText}) {
+        highlighter_->setFormat(format);
+
+        std::vector<SyntaxHighlighter::Token> full;
+        highlighter_->tokenize(line, full);
+
+        // Resuming at every returned boundary reproduces the same tokens
+        std::vector<SyntaxHighlighter::Token> chunked;
+        std::vector<SyntaxHighlighter::Token> chunk;
+        size_t boundary = 0;
+        while (boundary < line.size()) {
+            size_t next = highlighter_->tokenizeRange(line, boundary, boundary + 1000, chunk);
+            ASSERT_GT(next, boundary);
+            chunked.insert(chunked.end(), chunk.begin(), chunk.end());
+            boundary = next;
+        }
+        EXPECT_EQ(chunked, full) << formatName(format);
+    }
+}
+
+TEST_F(SyntaxHighlighterTest, WindowMatchesFullTokenization) {
+    std::string line = makeLargeJsonLine(2000);
+    highlighter_->setFormat(LogFormat::JsonLines);
+
+    std::vector<SyntaxHighlighter::Token> full;
+    highlighter_->tokenize(line, full);
+
+    std::vector<uint32_t> checkpoints;
+    highlighter_->buildCheckpoints(line, checkpoints);
+    ASSERT_FALSE(checkpoints.empty());
+    EXPECT_EQ(checkpoints.front(), 0u);
+    EXPECT_GE(checkpoints.size(), line.size() / SyntaxHighlighter::CHECKPOINT_INTERVAL);
+
+    std::vector<SyntaxHighlighter::Token> window;
+    for (size_t begin : {size_t{0}, size_t{4095}, size_t{50000}, line.size() - 100}) {
+        size_t end = std::min(begin + 200, line.size());
+        highlighter_->tokenizeWindow(line, checkpoints, begin, end, window);
+
+        std::vector<SyntaxHighlighter::Token> expected;
+        for (const auto& token : full) {
+            if (token.offset + token.length > begin && token.offset < end) {
+                expected.push_back(token);
+            }
+        }
+        EXPECT_EQ(window, expected) << "window at " << begin;
+    }
+}
+
+TEST_F(SyntaxHighlighterTest, RenderClipsToWindow) {
+    std::string line = makeLargeJsonLine(50);
+    std::vector<SyntaxHighlighter::Token> tokens;
+    highlighter_->tokenize(line, tokens);
+
+    EXPECT_NE(highlighter_->render(line, tokens, {}, -1, 100, 300), nullptr);
+    EXPECT_NE(highlighter_->render(line, tokens, {}, -1, line.size(), line.size()), nullptr);
+}
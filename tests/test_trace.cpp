@@ -0,0 +1,123 @@
+#include <gtest/gtest.h>
+#include "../src/trace.hpp"
+#include "temp_log_file.hpp"
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+class TraceTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        Trace::reset();
+    }
+
+    void TearDown() override {
+        Trace::reset();
+    }
+
+    std::string dump() {
+        std::string error;
+        EXPECT_TRUE(Trace::writeChromeJson(trace_file_.path(), error)) << error;
+        std::ifstream ifs(trace_file_.path());
+        std::stringstream ss;
+        ss << ifs.rdbuf();
+        return ss.str();
+    }
+
+    static size_t count(const std::string& text, const std::string& needle) {
+        size_t found = 0;
+        for (size_t pos = text.find(needle); pos != std::string::npos; pos = text.find(needle, pos + 1)) {
+            ++found;
+        }
+        return found;
+    }
+
+    TempLogFile trace_file_{"trace_test.json"};
+};
+
+TEST_F(TraceTest, RecordsNothingUntilEnabled) {
+    {
+        TraceScope scope("before enable");
+    }
+    Trace::enable();
+    {
+        TraceScope scope("after enable");
+    }
+
+    std::string json = dump();
+    EXPECT_EQ(json.find("before enable"), std::string::npos);
+    EXPECT_NE(json.find("\"after enable\""), std::string::npos);
+}
+
+TEST_F(TraceTest, WritesSpansWithArgumentsAndThreadNames) {
+    Trace::enable();
+    Trace::setThreadName("tester");
+    {
+        TraceScope scope("tokenize", "bytes", 42);
+    }
+
+    std::string json = dump();
+    EXPECT_EQ(json.rfind("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[", 0), 0u);
+    EXPECT_NE(json.find("\"ph\":\"X\""), std::string::npos);
+    EXPECT_NE(json.find("\"args\":{\"bytes\":42}"), std::string::npos);
+    EXPECT_NE(json.find("\"thread_name\""), std::string::npos);
+    EXPECT_NE(json.find("\"tester\""), std::string::npos);
+}
+
+TEST_F(TraceTest, GivesEachThreadItsOwnTrack) {
+    Trace::enable();
+    {
+        TraceScope scope("main span");
+    }
+    std::thread([]() {
+        Trace::setThreadName("worker");
+        TraceScope scope("worker span");
+    }).join();
+
+    // The worker's buffer outlives the thread
+    std::string json = dump();
+    size_t main_span = json.find("\"main span\"");
+    size_t worker_span = json.find("\"worker span\"");
+    ASSERT_NE(main_span, std::string::npos);
+    ASSERT_NE(worker_span, std::string::npos);
+
+    auto tidOf = [&](size_t pos) {
+        size_t tid = json.find("\"tid\":", pos);
+        return json.substr(tid, json.find(',', tid) - tid);
+    };
+    EXPECT_NE(tidOf(main_span), tidOf(worker_span));
+}
+
+TEST_F(TraceTest, KeepsTheNewestEventsWhenTheRingIsFull) {
+    Trace::enable();
+    int64_t now = Trace::now();
+    Trace::record("oldest", now, now, nullptr, 0);
+    for (size_t i = 0; i < Trace::EVENTS_PER_THREAD; ++i) {
+        Trace::record("filler", now, now, nullptr, 0);
+    }
+    Trace::record("newest", now, now, nullptr, 0);
+
+    std::string json = dump();
+    EXPECT_EQ(json.find("\"oldest\""), std::string::npos);
+    EXPECT_NE(json.find("\"newest\""), std::string::npos);
+    EXPECT_EQ(count(json, "\"filler\""), Trace::EVENTS_PER_THREAD - 1);
+}
+
+TEST_F(TraceTest, DropsTheOldestBuffersOfEndedThreads) {
+    Trace::enable();
+    constexpr size_t THREADS = Trace::FINISHED_THREADS_KEPT + 8;
+    for (size_t i = 0; i < THREADS; ++i) {
+        std::thread([i]() {
+            TraceScope scope("worker span", "worker", i);
+        }).join();
+    }
+    std::thread([]() {
+        Trace::setThreadName("idle");  // Recorded nothing: released at once
+    }).join();
+
+    std::string json = dump();
+    EXPECT_EQ(count(json, "\"worker span\""), Trace::FINISHED_THREADS_KEPT);
+    EXPECT_EQ(json.find("\"worker\":0}"), std::string::npos);
+    EXPECT_NE(json.find("\"worker\":" + std::to_string(THREADS - 1) + "}"), std::string::npos);
+    EXPECT_EQ(json.find("\"idle\""), std::string::npos);
+}
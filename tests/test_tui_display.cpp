@@ -0,0 +1,184 @@
+#include <gtest/gtest.h>
+#include "../src/tui_display.hpp"
+#include "temp_log_file.hpp"
+#include "ftxui/dom/elements.hpp"
+#include "ftxui/screen/screen.hpp"
+#include <filesystem>
+#include <numeric>
+#include <string>
+#include <thread>
+
+#ifndef _WIN32
+#include <unistd.h>
+
+using namespace ftxui;
+
+class TuiDisplayTest : public ::testing::Test {
+protected:
+    static void writeAll(int fd, const std::string& data) {
+        size_t done = 0;
+        while (done < data.size()) {
+            ssize_t written = ::write(fd, data.data() + done, data.size() - done);
+            ASSERT_GT(written, 0);
+            done += static_cast<size_t>(written);
+        }
+    }
+
+    std::unique_ptr<TuiDisplay> display(std::shared_ptr<LogReader> reader,
+                                        std::shared_ptr<MemoryBudget> budget = nullptr) {
+        return std::make_unique<TuiDisplay>(reader, std::make_shared<FilterEngine>(),
+                                            std::make_shared<SyntaxHighlighter>(), budget);
+    }
+
+    // As a finished filter leaves them
+    static void showRows(TuiDisplay& tui, RowView rows) {
+        std::lock_guard<std::mutex> lock(tui.visible_lines_mutex_);
+        tui.visible_rows_ = std::move(rows);
+        tui.budget_->set(MemoryBudget::Account::Results, tui.visible_rows_.memoryUsage());
+    }
+
+    static void save(TuiDisplay& tui, const std::string& path) {
+        tui.exportVisibleLines(path);
+    }
+
+    static std::string status(TuiDisplay& tui) {
+        std::lock_guard<std::mutex> lock(tui.visible_lines_mutex_);
+        return tui.status_message_;
+    }
+
+    // What typing the pattern into the filter box does
+    static void filter(TuiDisplay& tui, const std::string& pattern) {
+        tui.filter_input_ = pattern;
+        tui.applyFilterAsync();
+    }
+
+    static size_t visibleRows(TuiDisplay& tui) {
+        std::lock_guard<std::mutex> lock(tui.visible_lines_mutex_);
+        return tui.visible_rows_.size();
+    }
+
+    // What every frame does before painting
+    static LogFormat sniff(TuiDisplay& tui) {
+        std::lock_guard<std::mutex> lock(tui.visible_lines_mutex_);
+        tui.sniffFormatLocked();
+        return tui.highlighter_->getFormat();
+    }
+
+    static HighlightCache& cache(TuiDisplay& tui) {
+        return *tui.highlight_cache_;
+    }
+
+    static void waitForLines(LogReader& reader, size_t count) {
+        for (int i = 0; i < 100 && reader.getLineCount() < count; ++i) {
+            reader.waitForLines(reader.getLineCount(), std::chrono::milliseconds(50));
+        }
+        ASSERT_GE(reader.getLineCount(), count);
+    }
+
+    // Like the renderer: the frame is built under the lock and painted after it
+    static void paint(TuiDisplay& tui, Screen& screen) {
+        Element view;
+        {
+            std::lock_guard<std::mutex> lock(tui.visible_lines_mutex_);
+            size_t rows = std::min<size_t>(tui.visible_rows_.size(), screen.dimy());
+            if (rows == 0) {
+                return;
+            }
+            view = logView(tui.buildLogFrame(0, rows, screen.dimx()));
+        }
+        Render(screen, view);
+    }
+};
+
+TEST_F(TuiDisplayTest, FollowsAStreamWhileFramesArePainted) {
+    int fds[2];
+    ASSERT_EQ(pipe(fds), 0);
+
+    auto reader = std::make_shared<LogReader>();
+    ASSERT_TRUE(reader->openStream(fds[0], "<stdin>"));
+    auto tui = display(reader);
+    filter(*tui, "ERROR");
+
+    // Every batch grows the match index under the frames being painted
+    constexpr int BATCHES = 200;
+    constexpr int LINES_PER_BATCH = 50;
+    std::thread writer([&]() {
+        for (int batch = 0; batch < BATCHES; ++batch) {
+            std::string lines;
+            for (int i = 0; i < LINES_PER_BATCH; ++i) {
+                lines += "ERROR disk " + std::to_string(batch) + "\nINFO ok\n";
+            }
+            writeAll(fds[1], lines);
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+        }
+        ::close(fds[1]);
+    });
+
+    auto screen = Screen::Create(Dimension::Fixed(60), Dimension::Fixed(20));
+    constexpr size_t EXPECTED = BATCHES * LINES_PER_BATCH;
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (visibleRows(*tui) < EXPECTED && std::chrono::steady_clock::now() < deadline) {
+        paint(*tui, screen);
+    }
+    writer.join();
+
+    ASSERT_EQ(visibleRows(*tui), EXPECTED);
+
+    // The last frame still overlays the recorded matches
+    paint(*tui, screen);
+    const int content = LogView::GUTTER_WIDTH;
+    EXPECT_TRUE(screen.PixelAt(content, 1).inverted);
+    EXPECT_FALSE(screen.PixelAt(content + 6, 1).inverted);
+}
+
+TEST_F(TuiDisplayTest, SniffsAStreamOnceEnoughLinesArrive) {
+    int fds[2];
+    ASSERT_EQ(pipe(fds), 0);
+
+    auto reader = std::make_shared<LogReader>();
+    ASSERT_TRUE(reader->openStream(fds[0], "<stdin>"));
+    auto tui = display(reader);
+
+    const std::string line = R"({"level":"info","msg":"request served","status":200})" "\n";
+    writeAll(fds[1], line);
+    waitForLines(*reader, 1);
+    EXPECT_EQ(sniff(*tui), LogFormat::Generic);  // Too few lines to tell yet
+    cache(*tui).get(0);
+
+    std::string more;
+    for (size_t i = 1; i < FORMAT_SAMPLE_LINES; ++i) {
+        more += line;
+    }
+    writeAll(fds[1], more);
+    waitForLines(*reader, FORMAT_SAMPLE_LINES);
+    EXPECT_EQ(sniff(*tui), LogFormat::JsonLines);
+    EXPECT_EQ(cache(*tui).size(), 0u);  // Tokens of the generic tokenizer are gone
+
+    ::close(fds[1]);
+}
+
+TEST_F(TuiDisplayTest, SaveRefusesASnapshotOverTheMemoryLimit) {
+    TempLogFile log("save_limit.log");
+    TempLogFile saved("save_limit_out.log");
+    std::string text;
+    for (int i = 0; i < 1000; ++i) {
+        text += "ERROR line " + std::to_string(i) + "\n";
+    }
+    log.write(text);
+
+    auto reader = std::make_shared<LogReader>();
+    ASSERT_TRUE(reader->open(log.path()));
+    std::vector<size_t> lines(1000);
+    std::iota(lines.begin(), lines.end(), 0);
+    size_t rows_bytes = lines.size() * sizeof(size_t);
+
+    // The rows fit, a second copy of them does not
+    auto tui = display(reader, std::make_shared<MemoryBudget>(rows_bytes * 3 / 2));
+    showRows(*tui, RowView::fromLines(std::move(lines)));
+    save(*tui, saved.path());
+
+    EXPECT_EQ(status(*tui), "Not enough memory under --mem-limit to save 1000 lines");
+    EXPECT_FALSE(std::filesystem::exists(saved.path()));
+}
+
+#endif
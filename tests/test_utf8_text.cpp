@@ -0,0 +1,122 @@
+#include <gtest/gtest.h>
+#include "../src/utf8_text.hpp"
+
+TEST(Utf8TextTest, DecodesValidSequences) {
+    std::string text = "aЖ中😀";
+    Utf8Glyph glyph = decodeGlyph(text, 0);
+    EXPECT_EQ(glyph.length, 1u);
+    EXPECT_EQ(glyph.width, 1);
+
+    glyph = decodeGlyph(text, 1);
+    EXPECT_EQ(glyph.length, 2u);
+    EXPECT_EQ(glyph.width, 1);
+    EXPECT_EQ(glyph.kind, Utf8Glyph::Kind::Text);
+
+    glyph = decodeGlyph(text, 3);
+    EXPECT_EQ(glyph.length, 3u);
+    EXPECT_EQ(glyph.width, 2);
+
+    glyph = decodeGlyph(text, 6);
+    EXPECT_EQ(glyph.length, 4u);
+    EXPECT_EQ(glyph.width, 2);
+}
+
+TEST(Utf8TextTest, RejectsBrokenSequences) {
+    auto kind_and_length = [](std::string text) {
+        Utf8Glyph glyph = decodeGlyph(text, 0);
+        return std::make_pair(glyph.kind, glyph.length);
+    };
+    using Kind = Utf8Glyph::Kind;
+    EXPECT_EQ(kind_and_length("\x80"), std::make_pair(Kind::Invalid, 1u));          // Lone continuation
+    EXPECT_EQ(kind_and_length("\xC0\x80"), std::make_pair(Kind::Invalid, 1u));      // Overlong
+    EXPECT_EQ(kind_and_length("\xED\xA0\x80"), std::make_pair(Kind::Invalid, 1u));  // Surrogate
+    EXPECT_EQ(kind_and_length("\xF4\x90\x80\x80"), std::make_pair(Kind::Invalid, 1u));  // Past U+10FFFF
+    EXPECT_EQ(kind_and_length("\xE4\xB8"), std::make_pair(Kind::Invalid, 2u));      // Truncated
+    EXPECT_EQ(kind_and_length("\xE4\xB8x"), std::make_pair(Kind::Invalid, 2u));
+    EXPECT_EQ(kind_and_length("\x1B"), std::make_pair(Kind::Control, 1u));
+    EXPECT_EQ(kind_and_length("\xC2\x85"), std::make_pair(Kind::Control, 2u));      // C1 NEL
+}
+
+TEST(Utf8TextTest, CodepointWidths) {
+    EXPECT_EQ(codepointWidth(U'a'), 1);
+    EXPECT_EQ(codepointWidth(U'é'), 1);
+    EXPECT_EQ(codepointWidth(0x0301), 0);  // Combining acute accent
+    EXPECT_EQ(codepointWidth(0x200D), 0);  // Zero-width joiner
+    EXPECT_EQ(codepointWidth(U'中'), 2);
+    EXPECT_EQ(codepointWidth(U'한'), 2);
+    EXPECT_EQ(codepointWidth(0x1F600), 2);
+    EXPECT_EQ(codepointWidth(U'→'), 1);
+}
+
+TEST(Utf8TextTest, AsciiPrefixFindsTheFirstHighByte) {
+    // Every position across the vector block boundaries
+    for (size_t length : {0u, 1u, 15u, 16u, 31u, 32u, 33u, 100u}) {
+        std::string text(length, 'x');
+        EXPECT_EQ(asciiPrefix(text), length);
+        for (size_t at = 0; at < length; ++at) {
+            std::string broken = text;
+            broken[at] = '\xC3';
+            EXPECT_EQ(asciiPrefix(broken), at) << length << " " << at;
+        }
+    }
+    EXPECT_TRUE(isAscii("plain line"));
+    EXPECT_FALSE(isAscii("ошибка"));
+}
+
+TEST(Utf8TextTest, SanitizesAndMeasures) {
+    EXPECT_EQ(sanitizeUtf8("ok\tgo\xFF!"), "ok go\xEF\xBF\xBD!");
+    EXPECT_EQ(displayWidth("日本 ok"), 7u);
+    EXPECT_EQ(displayWidth("e\xCC\x81"), 1u);  // e + combining acute
+    EXPECT_EQ(prefixForWidth("日本語", 5), 6u);  // Two glyphs; the third would need a sixth cell
+    EXPECT_EQ(prefixForWidth("abc", 5), 3u);
+}
+
+TEST(Utf8TextTest, LayoutMapsColumnsAndBytes) {
+    LineLayout ascii("plain");
+    EXPECT_TRUE(ascii.isAscii());
+    EXPECT_EQ(ascii.columns(), 5u);
+    EXPECT_EQ(ascii.glyphAtColumn("plain", 3).byte, 3u);
+
+    std::string line = "a中b\xFF" "c";
+    LineLayout layout(line);
+    EXPECT_FALSE(layout.isAscii());
+    EXPECT_EQ(layout.columns(), 6u);  // a, 中 (2), b, U+FFFD, c
+
+    auto position = layout.glyphAtColumn(line, 2);  // Second half of 中
+    EXPECT_EQ(position.byte, 1u);
+    EXPECT_EQ(position.column, 1u);
+    EXPECT_EQ(layout.glyphAtColumn(line, 3).byte, 4u);
+    EXPECT_EQ(layout.glyphAtColumn(line, 5).byte, 6u);
+    EXPECT_EQ(layout.glyphAtColumn(line, 6).byte, line.size());
+
+    EXPECT_EQ(layout.columnAtByte(line, 2), 1u);  // Inside 中
+    EXPECT_EQ(layout.columnAtByte(line, 5), 4u);
+    EXPECT_EQ(layout.columnAtByte(line, line.size()), 6u);
+}
+
+TEST(Utf8TextTest, LayoutCheckpointsMatchAFullWalk) {
+    // Long enough for many checkpoints, with wide glyphs across their columns
+    std::string line;
+    for (int i = 0; i < 300; ++i) {
+        line += i % 7 == 0 ? "中" : (i % 11 == 0 ? "ж" : "x");
+        if (i % 13 == 0) {
+            line += "\xCC\x81";  // Combining mark
+        }
+    }
+    LineLayout layout(line);
+
+    size_t column = 0;
+    for (size_t pos = 0; pos < line.size();) {
+        Utf8Glyph glyph = decodeGlyph(line, pos);
+        EXPECT_EQ(layout.columnAtByte(line, pos), column);
+        for (size_t cell = 0; cell < glyph.width; ++cell) {
+            auto position = layout.glyphAtColumn(line, column + cell);
+            EXPECT_EQ(position.byte, pos);
+            EXPECT_EQ(position.column, column);
+        }
+        column += glyph.width;
+        pos += glyph.length;
+    }
+    EXPECT_EQ(layout.columns(), column);
+    EXPECT_GT(layout.memoryUsage(), 0u);
+}
@@ -0,0 +1,218 @@
+#include <charconv>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include "../src/log_generator.hpp"
+#include "../src/memory_budget.hpp"
+
+#ifdef _WIN32
+    #include <fcntl.h>
+    #include <io.h>
+#else
+    #include <fcntl.h>
+    #include <unistd.h>
+#endif
+
+namespace {
+
+void printUsage(const char* program_name) {
+    std::cout << "Synthetic log generator for Log Analyzer performance tests\n\n";
+    std::cout << "Usage: " << program_name << " --size SIZE [options] [-o FILE]\n\n";
+    std::cout << "Options:\n";
+    std::cout << "  --size SIZE              Bytes to generate, with K/M/G/T suffixes (e.g. 50G)\n";
+    std::cout << "  -o, --output FILE        Write to FILE (default: stdout)\n";
+    std::cout << "  --seed N                 Seed; the same seed and options give the same file (default: 1)\n";
+    std::cout << "  --format NAME            text, json, sql, logfmt or mixed (default: text)\n";
+    std::cout << "  --line-length MIN-MAX    Message bytes, log-uniform (default: 20-200)\n";
+    std::cout << "  --levels D,I,W,E         Weights of DEBUG/INFO/WARN/ERROR (default: 15,70,10,5)\n";
+    std::cout << "  --payload MIN-MAX        JSON payload bytes for --format json (default: 40-400)\n";
+    std::cout << "  --needle-every N         Every Nth line carries a unique needle (default: off)\n";
+    std::cout << "  --needle TEXT            Needle text, numbered as TEXT#1, TEXT#2... (default: NEEDLE)\n";
+    std::cout << "  --needles-out FILE       Write \"line offset\" of each needle (1-based line)\n";
+    std::cout << "  --crlf RATIO             Fraction of lines ending in CRLF (default: 0)\n";
+    std::cout << "  --long-lines RATIO       Fraction of lines with a huge JSON dump (default: 0)\n";
+    std::cout << "  --long-line-bytes SIZE   Size of those dumps (default: 1M)\n";
+    std::cout << "  --threads N              Generator threads (default: one per core)\n\n";
+    std::cout << "Example:\n";
+    std::cout << "  " << program_name << " --size 50G --format mixed --needle-every 10000000 --crlf 0.01 -o big.log\n";
+}
+
+bool parseRange(std::string_view text, size_t& low, size_t& high) {
+    size_t dash = text.find('-');
+    if (dash == std::string_view::npos) {
+        return false;
+    }
+    uint64_t a = 0;
+    uint64_t b = 0;
+    if (!parseByteSize(text.substr(0, dash), a) || !parseByteSize(text.substr(dash + 1), b) || a > b) {
+        return false;
+    }
+    low = static_cast<size_t>(a);
+    high = static_cast<size_t>(b);
+    return true;
+}
+
+bool parseWeights(std::string_view text, std::array<unsigned, 4>& weights) {
+    for (size_t i = 0; i < weights.size(); ++i) {
+        size_t comma = text.find(',');
+        std::string_view part = text.substr(0, comma);
+        auto result = std::from_chars(part.data(), part.data() + part.size(), weights[i]);
+        if (result.ec != std::errc() || result.ptr != part.data() + part.size()) {
+            return false;
+        }
+        if ((comma == std::string_view::npos) != (i + 1 == weights.size())) {
+            return false;
+        }
+        text.remove_prefix(comma == std::string_view::npos ? text.size() : comma + 1);
+    }
+    return true;
+}
+
+bool parseRatio(const char* text, double& ratio) {
+    char* end = nullptr;
+    ratio = std::strtod(text, &end);
+    return end != text && *end == '\0' && ratio >= 0.0 && ratio <= 1.0;
+}
+
+bool parseFormat(std::string_view name, LogFormat& format) {
+    if (name == "text") {
+        format = LogFormat::PlainText;
+    } else if (name == "json") {
+        format = LogFormat::JsonLines;
+    } else if (name == "sql") {
+        format = LogFormat::Sql;
+    } else if (name == "logfmt") {
+        format = LogFormat::Logfmt;
+    } else if (name == "mixed") {
+        format = LogFormat::Generic;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    GeneratorOptions options;
+    std::string output_file;
+    std::string needles_file;
+    bool has_size = false;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string_view arg = argv[i];
+        if (arg == "--help" || arg == "-h") {
+            printUsage(argv[0]);
+            return 0;
+        }
+        if (i + 1 >= argc) {
+            std::cerr << "Error: " << arg << " needs a value (see --help)\n";
+            return 2;
+        }
+
+        const char* value = argv[++i];
+        uint64_t number = 0;
+        bool ok = true;
+        if (arg == "--size") {
+            ok = parseByteSize(value, options.size) && options.size > 0;
+            has_size = true;
+        } else if (arg == "-o" || arg == "--output") {
+            output_file = value;
+        } else if (arg == "--seed") {
+            ok = parseByteSize(value, options.seed);
+        } else if (arg == "--format") {
+            ok = parseFormat(value, options.format);
+        } else if (arg == "--line-length") {
+            ok = parseRange(value, options.min_message, options.max_message);
+        } else if (arg == "--levels") {
+            ok = parseWeights(value, options.level_weights);
+        } else if (arg == "--payload") {
+            ok = parseRange(value, options.min_payload, options.max_payload);
+        } else if (arg == "--needle-every") {
+            ok = parseByteSize(value, options.needle_every);
+        } else if (arg == "--needle") {
+            options.needle = value;
+            ok = !options.needle.empty();
+        } else if (arg == "--needles-out") {
+            needles_file = value;
+        } else if (arg == "--crlf") {
+            ok = parseRatio(value, options.crlf_ratio);
+        } else if (arg == "--long-lines") {
+            ok = parseRatio(value, options.long_line_ratio);
+        } else if (arg == "--long-line-bytes") {
+            ok = parseByteSize(value, number);
+            options.long_line_bytes = static_cast<size_t>(number);
+        } else if (arg == "--threads") {
+            ok = parseByteSize(value, number);
+            options.threads = static_cast<size_t>(number);
+        } else {
+            std::cerr << "Error: Unknown option: " << arg << " (see --help)\n";
+            return 2;
+        }
+        if (!ok) {
+            std::cerr << "Error: Invalid value for " << arg << ": " << value << "\n";
+            return 2;
+        }
+    }
+
+    if (!has_size) {
+        std::cerr << "Error: --size is required (see --help)\n";
+        return 2;
+    }
+
+    int fd = 1;
+    if (!output_file.empty()) {
+#ifdef _WIN32
+        fd = _open(output_file.c_str(), _O_WRONLY | _O_CREAT | _O_TRUNC | _O_BINARY, 0644);
+#else
+        fd = ::open(output_file.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+#endif
+        if (fd == -1) {
+            std::cerr << "Error: Cannot create " << output_file << ": " << std::strerror(errno) << "\n";
+            return 2;
+        }
+    }
+#ifdef _WIN32
+    else {
+        _setmode(1, _O_BINARY);  // Keep LF and CRLF exactly as generated
+    }
+#endif
+
+    auto started = std::chrono::steady_clock::now();
+    LogGenerator generator(options);
+    GeneratorResult result;
+    std::string error;
+    bool ok = generator.write(fd, result, error);
+#ifdef _WIN32
+    if (fd != 1 && _close(fd) != 0) {
+#else
+    if (fd != 1 && ::close(fd) != 0) {
+#endif
+        ok = false;
+        error = std::string("close failed: ") + std::strerror(errno);
+    }
+    if (!ok) {
+        std::cerr << "Error: " << error << "\n";
+        return 1;
+    }
+
+    if (!needles_file.empty()) {
+        std::ofstream needles(needles_file);
+        for (const NeedleLine& needle : result.needles) {
+            needles << (needle.line + 1) << ' ' << needle.offset << '\n';
+        }
+        if (!needles) {
+            std::cerr << "Error: Cannot write " << needles_file << "\n";
+            return 1;
+        }
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    std::cerr << "Generated " << result.bytes << " bytes, " << result.lines << " lines, "
+              << result.needles.size() << " needles in " << seconds << " s ("
+              << (seconds > 0 ? result.bytes / seconds / (1 << 20) : 0.0) << " MB/s)\n";
+    return 0;
+}